@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+namespace {
+    QString unitName( K3b::Bench::Unit unit )
+    {
+        return unit == K3b::Bench::Bytes ? QLatin1String( "bytes" ) : QLatin1String( "items" );
+    }
+}
+
+
+double K3b::Bench::Result::throughput() const
+{
+    if( skipped || medianNs <= 0 )
+        return 0.0;
+    return double( work ) * 1e9 / double( medianNs );
+}
+
+
+double K3b::Bench::Result::latency() const
+{
+    if( skipped || work == 0 )
+        return 0.0;
+    return double( medianNs ) / double( work );
+}
+
+
+K3b::Bench::Bench()
+    : m_iterations( 5 ),
+      m_warmup( 1 )
+{
+}
+
+
+bool K3b::Bench::wants( const QString& name ) const
+{
+    return m_filter.pattern().isEmpty() || m_filter.match( name ).hasMatch();
+}
+
+
+void K3b::Bench::run( const QString& name, Unit unit,
+                      const std::function<quint64()>& body )
+{
+    run( name, unit, std::function<void()>(), body );
+}
+
+
+void K3b::Bench::run( const QString& name, Unit unit,
+                      const std::function<void()>& setup,
+                      const std::function<quint64()>& body )
+{
+    if( !wants( name ) )
+        return;
+
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.iterations = 0;
+    result.work = 0;
+    result.minNs = result.medianNs = result.meanNs = result.maxNs = 0;
+    result.skipped = false;
+
+    for( int i = 0; i < m_warmup; ++i ) {
+        if( setup )
+            setup();
+        body();
+    }
+
+    QVector<qint64> times;
+    QElapsedTimer timer;
+    for( int i = 0; i < qMax( 1, m_iterations ); ++i ) {
+        if( setup )
+            setup();
+
+        timer.start();
+        const quint64 work = body();
+        const qint64 ns = timer.nsecsElapsed();
+
+        // a changing amount of work means the body is broken
+        if( i > 0 && work != result.work )
+            qWarning() << "(K3b::Bench)" << name << "processed" << work << "instead of" << result.work;
+        result.work = work;
+        times.append( ns );
+    }
+
+    std::sort( times.begin(), times.end() );
+    qint64 sum = 0;
+    Q_FOREACH( qint64 t, times )
+        sum += t;
+
+    result.iterations = times.count();
+    result.minNs = times.first();
+    result.maxNs = times.last();
+    result.medianNs = times[times.count()/2];
+    result.meanNs = sum / times.count();
+
+    if( result.work == 0 ) {
+        result.skipped = true;
+        result.note = QLatin1String( "no work done" );
+    }
+
+    QTextStream( stderr ) << QString::fromLatin1( "%1: %2 %3/s, %4 ns/%5\n" )
+        .arg( name, -40 )
+        .arg( result.throughput(), 0, 'f', 0 )
+        .arg( unitName( unit ) )
+        .arg( result.latency(), 0, 'f', 2 )
+        .arg( unit == Bytes ? QLatin1String( "byte" ) : QLatin1String( "item" ) );
+
+    m_results.append( result );
+}
+
+
+void K3b::Bench::skip( const QString& name, const QString& reason )
+{
+    if( !wants( name ) )
+        return;
+
+    Result result;
+    result.name = name;
+    result.unit = Items;
+    result.iterations = 0;
+    result.work = 0;
+    result.minNs = result.medianNs = result.meanNs = result.maxNs = 0;
+    result.skipped = true;
+    result.note = reason;
+
+    QTextStream( stderr ) << QString::fromLatin1( "%1: skipped (%2)\n" ).arg( name, -40 ).arg( reason );
+
+    m_results.append( result );
+}
+
+
+QJsonObject K3b::Bench::toJson() const
+{
+    QJsonArray results;
+    Q_FOREACH( const Result& result, m_results ) {
+        QJsonObject o;
+        o.insert( QLatin1String( "name" ), result.name );
+        if( result.skipped ) {
+            o.insert( QLatin1String( "skipped" ), true );
+            o.insert( QLatin1String( "note" ), result.note );
+        }
+        else {
+            o.insert( QLatin1String( "unit" ), unitName( result.unit ) );
+            o.insert( QLatin1String( "iterations" ), result.iterations );
+            o.insert( QLatin1String( "work" ), double( result.work ) );
+            o.insert( QLatin1String( "min_ns" ), double( result.minNs ) );
+            o.insert( QLatin1String( "median_ns" ), double( result.medianNs ) );
+            o.insert( QLatin1String( "mean_ns" ), double( result.meanNs ) );
+            o.insert( QLatin1String( "max_ns" ), double( result.maxNs ) );
+            o.insert( QLatin1String( "throughput_per_s" ), result.throughput() );
+            o.insert( QLatin1String( "ns_per_unit" ), result.latency() );
+        }
+        results.append( o );
+    }
+
+    QJsonObject o;
+    o.insert( QLatin1String( "iterations" ), m_iterations );
+    o.insert( QLatin1String( "warmup" ), m_warmup );
+    o.insert( QLatin1String( "results" ), results );
+    return o;
+}
+
+
+QStringList K3b::Bench::compare( const QJsonObject& baseline, double maxRegression ) const
+{
+    QHash<QString, double> baselineLatency;
+    Q_FOREACH( const QJsonValue& value, baseline.value( QLatin1String( "results" ) ).toArray() ) {
+        const QJsonObject o = value.toObject();
+        if( !o.value( QLatin1String( "skipped" ) ).toBool() )
+            baselineLatency.insert( o.value( QLatin1String( "name" ) ).toString(),
+                                    o.value( QLatin1String( "ns_per_unit" ) ).toDouble() );
+    }
+
+    QStringList regressions;
+    Q_FOREACH( const Result& result, m_results ) {
+        if( result.skipped || !baselineLatency.contains( result.name ) )
+            continue;
+
+        const double before = baselineLatency.value( result.name );
+        const double now = result.latency();
+        if( before > 0.0 && now > before * ( 1.0 + maxRegression/100.0 ) ) {
+            regressions.append( QString::fromLatin1( "%1: %2 ns/unit -> %3 ns/unit (+%4%)" )
+                                .arg( result.name )
+                                .arg( before, 0, 'f', 2 )
+                                .arg( now, 0, 'f', 2 )
+                                .arg( ( now/before - 1.0 ) * 100.0, 0, 'f', 1 ) );
+        }
+    }
+
+    return regressions;
+}
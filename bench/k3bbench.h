@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_BENCH_H_
+#define _K3B_BENCH_H_
+
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+
+namespace K3b {
+    /**
+     * The benchmark runner of k3b-bench.
+     *
+     * Each benchmark body processes a fixed amount of work and returns it,
+     * either in bytes or in items. The runner does the warmup runs, times
+     * the remaining iterations and keeps the statistics which are finally
+     * written as JSON. Setup code which should not be timed goes into the
+     * optional setup function which is called before each run.
+     *
+     * \code
+     * bench.run( "pipe/active", Bench::Bytes, [&]() {
+     *     return copyAll();
+     * } );
+     * \endcode
+     */
+    class Bench
+    {
+    public:
+        enum Unit {
+            Bytes,
+            Items
+        };
+
+        struct Result {
+            QString name;
+            Unit unit;
+            int iterations;
+            quint64 work;      // per iteration
+            qint64 minNs;
+            qint64 medianNs;
+            qint64 meanNs;
+            qint64 maxNs;
+            bool skipped;
+            QString note;
+
+            /**
+             * Work units per second based on the median run.
+             */
+            double throughput() const;
+
+            /**
+             * Nanoseconds per work unit based on the median run.
+             */
+            double latency() const;
+        };
+
+        Bench();
+
+        void setIterations( int n ) { m_iterations = n; }
+        int iterations() const { return m_iterations; }
+
+        void setWarmup( int n ) { m_warmup = n; }
+        int warmup() const { return m_warmup; }
+
+        void setFilter( const QRegularExpression& rx ) { m_filter = rx; }
+
+        /**
+         * Directory for temporary files.
+         */
+        void setTempDir( const QString& dir ) { m_tempDir = dir; }
+        QString tempDir() const { return m_tempDir; }
+
+        /**
+         * \return true if the benchmark \p name is selected by the filter.
+         * Use it to avoid expensive preparation of unselected benchmarks.
+         */
+        bool wants( const QString& name ) const;
+
+        void run( const QString& name, Unit unit,
+                  const std::function<quint64()>& body );
+        void run( const QString& name, Unit unit,
+                  const std::function<void()>& setup,
+                  const std::function<quint64()>& body );
+
+        /**
+         * Record a benchmark which could not be run, for example due to
+         * missing sample files.
+         */
+        void skip( const QString& name, const QString& reason );
+
+        const QVector<Result>& results() const { return m_results; }
+
+        QJsonObject toJson() const;
+
+        /**
+         * Compare the results against a previous JSON result file.
+         *
+         * A benchmark regressed if its median time per work unit grew by
+         * more than \p maxRegression percent.
+         *
+         * \return The names of the regressed benchmarks, each with a short
+         *         description.
+         */
+        QStringList compare( const QJsonObject& baseline, double maxRegression ) const;
+
+    private:
+        QVector<Result> m_results;
+        QRegularExpression m_filter;
+        QString m_tempDir;
+        int m_iterations;
+        int m_warmup;
+    };
+
+    void benchPipes( Bench& bench );
+    void benchAudio( Bench& bench, const QStringList& audioFiles );
+    void benchResampler( Bench& bench );
+    void benchProcessOutput( Bench& bench );
+    void benchDataDoc( Bench& bench, const QList<int>& itemCounts );
+    /**
+     * The device benchmarks run on VirtualDrives which add \p latency
+     * microseconds to each command and transfer at most \p throughput KB/s
+     * (0 for unlimited).
+     */
+    void benchDevice( Bench& bench, int latency, int throughput );
+    void benchIso9660( Bench& bench, const QStringList& images, int latency, int throughput );
+    void benchMpegInfo( Bench& bench, const QStringList& mpegFiles );
+}
+
+#endif
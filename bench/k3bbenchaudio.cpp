@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3baudiodecoder.h"
+#include "k3bcore.h"
+#include "k3bplugin.h"
+#include "k3bpluginmanager.h"
+#include "k3bwavefilewriter.h"
+
+#include <KPluginInfo>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+
+
+namespace {
+    // one minute of CD audio
+    const int s_waveSeconds = 60;
+    const int s_waveChunk = 2352*10;
+}
+
+
+void K3b::benchAudio( Bench& bench, const QStringList& audioFiles )
+{
+    //
+    // Decoding includes the resampling to 44.1 kHz stereo which the decoder
+    // does for all files not already in CD format.
+    //
+    QList<AudioDecoderFactory*> factories;
+    Q_FOREACH( Plugin* plugin, k3bcore->pluginManager()->plugins( QLatin1String( "AudioDecoder" ) ) ) {
+        if( AudioDecoderFactory* f = dynamic_cast<AudioDecoderFactory*>( plugin ) )
+            factories.append( f );
+    }
+
+    if( audioFiles.isEmpty() )
+        bench.skip( QLatin1String( "audiodecoder" ), QLatin1String( "no audio files given" ) );
+    else if( factories.isEmpty() )
+        bench.skip( QLatin1String( "audiodecoder" ), QLatin1String( "no decoder plugins found" ) );
+
+    Q_FOREACH( const QString& file, audioFiles ) {
+        const QUrl url = QUrl::fromLocalFile( file );
+        Q_FOREACH( AudioDecoderFactory* factory, factories ) {
+            if( !factory->canDecode( url ) )
+                continue;
+
+            const QString name = QString::fromLatin1( "audiodecoder/%1/%2" )
+                                 .arg( factory->pluginInfo().pluginName() )
+                                 .arg( QFileInfo( file ).fileName() );
+            if( !bench.wants( name ) )
+                continue;
+
+            AudioDecoder* decoder = factory->createDecoder();
+            decoder->setFilename( file );
+            if( !decoder->analyseFile() ) {
+                bench.skip( name, QLatin1String( "analysing the file failed" ) );
+                delete decoder;
+                continue;
+            }
+
+            QByteArray buffer( s_waveChunk, '\0' );
+            bench.run( name, Bench::Bytes,
+                       [&]() {
+                           decoder->initDecoder();
+                       },
+                       [&]() {
+                           quint64 bytes = 0;
+                           int r = 0;
+                           while( ( r = decoder->decode( buffer.data(), buffer.size() ) ) > 0 )
+                               bytes += r;
+                           return r < 0 ? quint64( 0 ) : bytes;
+                       } );
+
+            decoder->cleanup();
+            delete decoder;
+        }
+    }
+
+    const QString wavePath = QDir( bench.tempDir() ).filePath( QLatin1String( "k3b-bench.wav" ) );
+    QByteArray samples( s_waveChunk, '\0' );
+    for( int i = 0; i < samples.size(); ++i )
+        samples[i] = char( i*31 );
+
+    bench.run( QLatin1String( "wavefilewriter" ), Bench::Bytes, [&]() {
+        WaveFileWriter writer;
+        if( !writer.open( wavePath ) )
+            return quint64( 0 );
+
+        quint64 bytes = 0;
+        const quint64 total = quint64( 44100*4 ) * s_waveSeconds;
+        while( bytes < total ) {
+            writer.write( samples.constData(), samples.size(), WaveFileWriter::LittleEndian );
+            bytes += samples.size();
+        }
+        writer.close();
+        return bytes;
+    } );
+
+    QFile::remove( wavePath );
+}
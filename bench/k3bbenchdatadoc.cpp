@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bglobals.h"
+
+#include <QCoreApplication>
+#include <QFile>
+
+
+namespace {
+    const int s_filesPerDir = 1000;
+
+    /**
+     * Add a synthetic tree of \p count files to \p doc. All items share a
+     * single stat result so no disk access is measured, only the unique
+     * inode keeps the size handler from treating them as hard links.
+     */
+    quint64 buildTree( K3b::DataDoc& doc, const k3b_struct_stat& stat, int count )
+    {
+        const QString localDir = QLatin1String( "/bench/source/" );
+        k3b_struct_stat itemStat = stat;
+
+        quint64 items = 0;
+        for( int dirIndex = 0; items < quint64( count ); ++dirIndex ) {
+            K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "dir%1" ).arg( dirIndex, 5, 10, QLatin1Char( '0' ) ) );
+            doc.root()->addDataItem( dir );
+            ++items;
+
+            K3b::DirItem::Children files;
+            for( int i = 0; i < s_filesPerDir && items < quint64( count ); ++i, ++items ) {
+                // every tenth name is too long for Joliet to exercise the cutting
+                QString name = QString::fromLatin1( "file %1.dat" ).arg( i, 6, 10, QLatin1Char( '0' ) );
+                if( i % 10 == 0 )
+                    name.prepend( QString( 70, QLatin1Char( 'x' ) ) );
+
+                itemStat.st_ino = items;
+                files.append( new K3b::FileItem( &itemStat, &itemStat, localDir + name, doc, name ) );
+            }
+            dir->addDataItems( files );
+        }
+
+        return items;
+    }
+}
+
+
+void K3b::benchDataDoc( Bench& bench, const QList<int>& itemCounts )
+{
+    k3b_struct_stat stat;
+    if( k3b_stat( QFile::encodeName( QCoreApplication::applicationFilePath() ), &stat ) ) {
+        bench.skip( QLatin1String( "datadoc" ), QLatin1String( "stat failed" ) );
+        return;
+    }
+
+    Q_FOREACH( int count, itemCounts ) {
+        const QString addName = QString::fromLatin1( "datadoc/add/%1" ).arg( count );
+        const QString prepareName = QString::fromLatin1( "datadoc/prepareFilenames/%1" ).arg( count );
+        if( !bench.wants( addName ) && !bench.wants( prepareName ) )
+            continue;
+
+        DataDoc doc;
+        doc.newDocument();
+
+        bench.run( addName, Bench::Items,
+                   [&]() {
+                       doc.newDocument();
+                   },
+                   [&]() {
+                       return buildTree( doc, stat, count );
+                   } );
+
+        // the tree of the last add run stays for the filename preparation
+        if( !bench.wants( addName ) )
+            buildTree( doc, stat, count );
+
+        bench.run( prepareName, Bench::Items, [&]() {
+            doc.prepareFilenames();
+            return quint64( count );
+        } );
+    }
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3bcore.h"
+#include "k3bdatatrackreader.h"
+#include "k3bdevice.h"
+#include "k3bdevicemanager.h"
+#include "k3bjobhandler.h"
+#include "k3bmedium.h"
+#include "k3bmsf.h"
+#include "k3btoc.h"
+#include "k3bverificationjob.h"
+#include "k3bvirtualdrive.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QIODevice>
+
+
+namespace {
+    const int s_dataSectors = 32*1024;   // 64 MB
+    const int s_audioTracks = 4;
+    const int s_audioTrackSectors = 30*75;
+    const int s_mediumUpdates = 20;
+
+    /**
+     * Answers all requests right away as the virtual media are always there.
+     */
+    class BenchJobHandler : public K3b::JobHandler
+    {
+    public:
+        K3b::Device::MediaType waitForMedium( K3b::Device::Device* dev,
+                                              K3b::Device::MediaStates,
+                                              K3b::Device::MediaTypes,
+                                              const K3b::Msf&,
+                                              const QString& ) override {
+            return dev->diskInfo().mediaType();
+        }
+
+        bool questionYesNo( const QString&, const QString&, const KGuiItem&, const KGuiItem& ) override {
+            return false;
+        }
+
+        void blockingInformation( const QString&, const QString& ) override {
+        }
+    };
+
+
+    class NullDevice : public QIODevice
+    {
+    public:
+        bool isSequential() const override { return true; }
+
+    protected:
+        qint64 readData( char*, qint64 ) override {
+            return -1;
+        }
+
+        qint64 writeData( const char*, qint64 len ) override {
+            return len;
+        }
+    };
+
+
+    bool runJob( K3b::Job* job )
+    {
+        bool success = false;
+        QEventLoop loop;
+        QObject::connect( job, &K3b::Job::finished, &loop, [&]( bool b ) {
+            success = b;
+            loop.quit();
+        } );
+        job->start();
+        if( job->active() )
+            loop.exec();
+        return success;
+    }
+
+
+    bool writeImage( const QString& path, int sectors, int sectorSize, QByteArray* md5 = 0 )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::WriteOnly|QIODevice::Truncate ) )
+            return false;
+
+        QCryptographicHash hash( QCryptographicHash::Md5 );
+        QByteArray sector( sectorSize, '\0' );
+        for( int i = 0; i < sectors; ++i ) {
+            for( int j = 0; j < sectorSize; ++j )
+                sector[j] = char( i + j*7 );
+            if( f.write( sector ) != sectorSize )
+                return false;
+            hash.addData( sector );
+        }
+
+        if( md5 )
+            *md5 = hash.result().toHex();
+        return true;
+    }
+}
+
+
+void K3b::benchDevice( Bench& bench, int latency, int throughput )
+{
+    // creating the images takes a while
+    if( !bench.wants( QLatin1String( "device/datatrackreader" ) ) &&
+        !bench.wants( QLatin1String( "device/verification" ) ) &&
+        !bench.wants( QLatin1String( "device/medium_update" ) ) &&
+        !bench.wants( QLatin1String( "device/indexscan" ) ) )
+        return;
+
+    const QDir tempDir( bench.tempDir() );
+    const QString dataImage = tempDir.filePath( QLatin1String( "k3b-bench-data.img" ) );
+    QStringList audioImages;
+    for( int i = 0; i < s_audioTracks; ++i )
+        audioImages << tempDir.filePath( QString::fromLatin1( "k3b-bench-audio%1.raw" ).arg( i ) );
+
+    QByteArray dataMd5;
+    bool ok = writeImage( dataImage, s_dataSectors, 2048, &dataMd5 );
+    Q_FOREACH( const QString& image, audioImages )
+        ok = ok && writeImage( image, s_audioTrackSectors, 2352 );
+
+    // the devices are owned by the device manager, the drives by the devices
+    Device::Device* dataDev = 0;
+    Device::Device* audioDev = 0;
+    if( ok ) {
+        Device::VirtualDrive* dataDrive = new Device::VirtualDrive();
+        dataDrive->addTrack( dataImage, Device::Track::TYPE_DATA );
+        dataDrive->setLatency( latency );
+        dataDrive->setThroughput( throughput );
+        dataDev = k3bcore->deviceManager()->addVirtualDevice( QLatin1String( "virtual:bench-data" ), dataDrive );
+
+        Device::VirtualDrive* audioDrive = new Device::VirtualDrive();
+        Q_FOREACH( const QString& image, audioImages )
+            audioDrive->addTrack( image, Device::Track::TYPE_AUDIO );
+        audioDrive->setLatency( latency );
+        audioDrive->setThroughput( throughput );
+        audioDev = k3bcore->deviceManager()->addVirtualDevice( QLatin1String( "virtual:bench-audio" ), audioDrive );
+    }
+
+    if( !dataDev || !audioDev ) {
+        bench.skip( QLatin1String( "device" ), QLatin1String( "unable to set up the virtual drives" ) );
+    }
+    else {
+        BenchJobHandler handler;
+
+        bench.run( QLatin1String( "device/datatrackreader" ), Bench::Bytes, [&]() {
+            NullDevice sink;
+            sink.open( QIODevice::WriteOnly );
+            DataTrackReader reader( &handler );
+            reader.setDevice( dataDev );
+            reader.setSectorSize( DataTrackReader::MODE1 );
+            reader.setSectorRange( 0, s_dataSectors - 1 );
+            reader.writeTo( &sink );
+            return runJob( &reader ) ? quint64( s_dataSectors ) * 2048 : quint64( 0 );
+        } );
+
+        bench.run( QLatin1String( "device/verification" ), Bench::Bytes, [&]() {
+            VerificationJob job( &handler );
+            job.setDevice( dataDev );
+            job.addTrack( 1, dataMd5, Msf( s_dataSectors ) );
+            return runJob( &job ) ? quint64( s_dataSectors ) * 2048 : quint64( 0 );
+        } );
+
+        bench.run( QLatin1String( "device/medium_update" ), Bench::Items, [&]() {
+            for( int i = 0; i < s_mediumUpdates; ++i ) {
+                Medium medium( i % 2 ? audioDev : dataDev );
+                medium.update();
+            }
+            return quint64( s_mediumUpdates );
+        } );
+
+        const Device::Toc audioToc = audioDev->readToc();
+        bench.run( QLatin1String( "device/indexscan" ), Bench::Items, [&]() {
+            Device::Toc toc( audioToc );
+            return audioDev->indexScan( toc ) ? quint64( toc.count() ) : quint64( 0 );
+        } );
+    }
+
+    QFile::remove( dataImage );
+    Q_FOREACH( const QString& image, audioImages )
+        QFile::remove( image );
+}
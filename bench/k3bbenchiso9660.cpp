@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3bcore.h"
+#include "k3bdevicemanager.h"
+#include "k3biso9660.h"
+#include "k3bvirtualdrive.h"
+
+#include <QFileInfo>
+
+
+namespace {
+    quint64 walk( const K3b::Iso9660Directory* dir )
+    {
+        quint64 entries = 0;
+        Q_FOREACH( const QString& name, dir->entries() ) {
+            if( name == QLatin1String( "." ) || name == QLatin1String( ".." ) )
+                continue;
+
+            ++entries;
+            const K3b::Iso9660Entry* entry = dir->entry( name );
+            if( entry && entry->isDirectory() )
+                entries += walk( static_cast<const K3b::Iso9660Directory*>( entry ) );
+        }
+        return entries;
+    }
+
+
+    quint64 parse( K3b::Iso9660& iso )
+    {
+        if( !iso.open() )
+            return 0;
+
+        quint64 entries = 0;
+        if( const K3b::Iso9660Directory* dir = iso.firstRRDirEntry() )
+            entries += walk( dir );
+        if( const K3b::Iso9660Directory* dir = iso.firstJolietDirEntry() )
+            entries += walk( dir );
+        if( const K3b::Iso9660Directory* dir = iso.firstIsoDirEntry() )
+            entries += walk( dir );
+
+        iso.close();
+        return entries;
+    }
+}
+
+
+void K3b::benchIso9660( Bench& bench, const QStringList& images, int latency, int throughput )
+{
+    if( images.isEmpty() ) {
+        bench.skip( QLatin1String( "iso9660" ), QLatin1String( "no images given" ) );
+        return;
+    }
+
+    for( int i = 0; i < images.count(); ++i ) {
+        const QString& image = images[i];
+        const QString name = QFileInfo( image ).fileName();
+
+        // the directories are parsed lazily, so a fresh archive is opened and
+        // walked completely in each run
+        bench.run( QString::fromLatin1( "iso9660/%1" ).arg( name ), Bench::Items, [&]() {
+            Iso9660 iso( image );
+            return parse( iso );
+        } );
+
+        // the same through the device backend on a virtual drive holding
+        // the image, which is how media are parsed
+        const QString deviceBenchName = QString::fromLatin1( "iso9660/device/%1" ).arg( name );
+        if( !bench.wants( deviceBenchName ) )
+            continue;
+
+        Device::VirtualDrive* drive = new Device::VirtualDrive();
+        drive->setProfile( 0x10 ); // DVD-ROM
+        drive->setLatency( latency );
+        drive->setThroughput( throughput );
+        Device::Device* dev = 0;
+        if( drive->addTrack( image, Device::Track::TYPE_DATA ) )
+            dev = k3bcore->deviceManager()->addVirtualDevice( QString::fromLatin1( "virtual:bench-iso%1" ).arg( i ), drive );
+        else
+            delete drive;
+
+        if( !dev ) {
+            bench.skip( deviceBenchName, QLatin1String( "unable to set up the virtual drive" ) );
+            continue;
+        }
+
+        bench.run( deviceBenchName, Bench::Items, [&]() {
+            Iso9660 iso( dev );
+            return parse( iso );
+        } );
+    }
+}
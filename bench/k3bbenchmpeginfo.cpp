@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "mpeginfo/k3bmpeginfo.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+
+void K3b::benchMpegInfo( Bench& bench, const QStringList& mpegFiles )
+{
+    if( mpegFiles.isEmpty() ) {
+        bench.skip( QLatin1String( "mpeginfo" ), QLatin1String( "no MPEG files given" ) );
+        return;
+    }
+
+    Q_FOREACH( const QString& file, mpegFiles ) {
+        const QFileInfo info( file );
+        QString link;
+        int run = 0;
+
+        // MpegInfo caches the results per file name, so each run scans
+        // through a new symlink to measure the actual parsing
+        bench.run( QString::fromLatin1( "mpeginfo/%1" ).arg( info.fileName() ), Bench::Bytes,
+                   [&]() {
+                       if( !link.isEmpty() )
+                           QFile::remove( link );
+                       link = QDir( bench.tempDir() ).filePath( QString::fromLatin1( "k3b-bench-%1.mpg" ).arg( run++ ) );
+                       QFile::link( info.absoluteFilePath(), link );
+                   },
+                   [&]() {
+                       MpegInfo mpegInfo( QFile::encodeName( link ).constData() );
+                       return mpegInfo.version() == MpegInfo::MPEG_VERS_INVALID ? quint64( 0 ) : quint64( info.size() );
+                   } );
+
+        if( !link.isEmpty() )
+            QFile::remove( link );
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3bactivepipe.h"
+#include "k3bchecksumpipe.h"
+
+#include <QIODevice>
+
+#include <string.h>
+
+
+namespace {
+    const qint64 s_pipeVolume = 256*1024*1024;
+
+    /**
+     * Produces a fixed amount of pattern data without touching the disk.
+     */
+    class PatternDevice : public QIODevice
+    {
+    public:
+        explicit PatternDevice( qint64 size )
+            : m_size( size ),
+              m_pos( 0 ) {
+            for( int i = 0; i < int( sizeof( m_pattern ) ); ++i )
+                m_pattern[i] = char( i*7 );
+        }
+
+        bool isSequential() const override { return true; }
+
+        bool open( OpenMode mode ) override {
+            m_pos = 0;
+            return QIODevice::open( mode );
+        }
+
+    protected:
+        qint64 readData( char* data, qint64 max ) override {
+            const qint64 len = qMin( max, m_size - m_pos );
+            for( qint64 done = 0; done < len; ) {
+                const qint64 chunk = qMin( len - done, qint64( sizeof( m_pattern ) ) );
+                ::memcpy( data + done, m_pattern, chunk );
+                done += chunk;
+            }
+            m_pos += len;
+            return len;
+        }
+
+        qint64 writeData( const char*, qint64 ) override {
+            return -1;
+        }
+
+    private:
+        qint64 m_size;
+        qint64 m_pos;
+        char m_pattern[4096];
+    };
+
+
+    class NullDevice : public QIODevice
+    {
+    public:
+        bool isSequential() const override { return true; }
+
+    protected:
+        qint64 readData( char*, qint64 ) override {
+            return -1;
+        }
+
+        qint64 writeData( const char*, qint64 len ) override {
+            return len;
+        }
+    };
+
+
+    quint64 pump( K3b::ActivePipe& pipe, PatternDevice& source, NullDevice& sink )
+    {
+        // the devices stay open so close() only waits for the copy thread
+        pipe.readFrom( &source );
+        pipe.writeTo( &sink );
+        if( !pipe.open() )
+            return 0;
+        pipe.close();
+        return pipe.bytesWritten();
+    }
+}
+
+
+void K3b::benchPipes( Bench& bench )
+{
+    bench.run( QLatin1String( "pipe/active" ), Bench::Bytes, [&]() {
+        PatternDevice source( s_pipeVolume );
+        NullDevice sink;
+        ActivePipe pipe;
+        return pump( pipe, source, sink );
+    } );
+
+    bench.run( QLatin1String( "pipe/checksum-md5" ), Bench::Bytes, [&]() {
+        PatternDevice source( s_pipeVolume );
+        NullDevice sink;
+        ChecksumPipe pipe;
+        const quint64 bytes = pump( pipe, source, sink );
+        return pipe.checksum().isEmpty() ? 0 : bytes;
+    } );
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3blinetokenizer.h"
+#include "k3bprogressmatcher.h"
+
+#include <QByteArray>
+#include <QString>
+
+
+namespace {
+    const int s_progressLines = 200000;
+
+    // K3b::Process reads whatever the pipe delivers, usually up to a page
+    const int s_readChunk = 4096;
+
+    /**
+     * Output of a cdrecord run: a carriage return redraws the progress line.
+     */
+    QByteArray cdrecordOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 72 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            const int made = i * 600 / s_progressLines;
+            out.append( "Track 01: " );
+            out.append( QByteArray::number( made ).rightJustified( 4 ) );
+            out.append( " of  600 MB written (fifo 100%) [buf  99%]  16.1x.\r" );
+            if( i % 1000 == 999 )
+                out.append( "\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Output of a growisofs run which prints one line per progress update.
+     */
+    QByteArray growisofsOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 80 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            const qint64 done = qint64( i ) * 23488102;
+            out.append( "  " );
+            out.append( QByteArray::number( done ) );
+            out.append( "/4697620480 ( 0.0%) @4.0x, remaining 12:34 RBU 100.0% UBU  99.0%\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Output of a cdrskin run. Some versions only report the drive buffer.
+     */
+    QByteArray cdrskinOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 64 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            const int made = i * 600 / s_progressLines;
+            out.append( "Track 01: " );
+            out.append( QByteArray::number( made ).rightJustified( 4 ) );
+            out.append( " of  600 MB written [buf  99%]  16.1x.\r" );
+            if( i % 1000 == 999 )
+                out.append( "\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Output of a cdrdao run, which redraws its progress line like cdrecord.
+     */
+    QByteArray cdrdaoOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 48 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            const int made = i * 600 / s_progressLines;
+            out.append( "Wrote " );
+            out.append( QByteArray::number( made ) );
+            out.append( " of 600 MB (Buffers 100%  99%).\r" );
+            if( i % 1000 == 999 )
+                out.append( "\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Output of a mkisofs run with one line per progress update.
+     */
+    QByteArray mkisofsOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 56 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            out.append( QByteArray::number( 100.0 * i / s_progressLines, 'f', 2 ).rightJustified( 6 ) );
+            out.append( "% done, estimate finish Tue Mar  3 12:00:00 2009\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Output of a transcode >= 1.1 run with one line per encoded frame.
+     */
+    QByteArray transcodeOutput()
+    {
+        QByteArray out;
+        out.reserve( s_progressLines * 144 );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            out.append( "encoding=1 frame=" );
+            out.append( QByteArray::number( i ) );
+            out.append( " first=0 last=-1 fps=14.815 done=-1.000000 timestamp=59.640 timeleft=-1"
+                        " decodebuf=12 filterbuf=5 encodebuf=3\n" );
+        }
+        return out;
+    }
+
+
+    /**
+     * Feed \p output to a tokenizer in pipe sized chunks, convert the lines
+     * like K3b::Process does and run them through \p matcher.
+     */
+    quint64 parse( const QByteArray& output, const K3b::ProgressMatcher& matcher )
+    {
+        K3b::LineTokenizer tokenizer;
+        K3b::ProgressMatcher::Captures cap;
+        quint64 lines = 0;
+        qint64 checksum = 0;
+
+        for( int pos = 0; pos < output.size(); pos += s_readChunk ) {
+            tokenizer.append( output.constData() + pos, qMin( s_readChunk, output.size() - pos ) );
+
+            const char* line = 0;
+            int len = 0;
+            while( tokenizer.nextLine( line, len ) ) {
+                const QString s = QString::fromLocal8Bit( line, len );
+                if( matcher.match( s, cap ) )
+                    checksum += cap.toLongLong( 0 ) + cap.toLongLong( 1 );
+                ++lines;
+            }
+        }
+
+        // keep the compiler from dropping the matching
+        return checksum >= 0 ? lines : 0;
+    }
+}
+
+
+void K3b::benchProcessOutput( Bench& bench )
+{
+    if( bench.wants( QLatin1String( "process/cdrecord" ) ) ) {
+        const QByteArray output = cdrecordOutput();
+        bench.run( QLatin1String( "process/cdrecord" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::CdrecordProgress ) );
+        } );
+    }
+
+    if( bench.wants( QLatin1String( "process/growisofs" ) ) ) {
+        const QByteArray output = growisofsOutput();
+        bench.run( QLatin1String( "process/growisofs" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::GrowisofsProgress ) );
+        } );
+    }
+
+    if( bench.wants( QLatin1String( "process/cdrskin" ) ) ) {
+        const QByteArray output = cdrskinOutput();
+        bench.run( QLatin1String( "process/cdrskin" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::CdrecordProgress ) );
+        } );
+    }
+
+    if( bench.wants( QLatin1String( "process/cdrdao" ) ) ) {
+        const QByteArray output = cdrdaoOutput();
+        bench.run( QLatin1String( "process/cdrdao" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::CdrdaoWrote ) );
+        } );
+    }
+
+    if( bench.wants( QLatin1String( "process/mkisofs" ) ) ) {
+        const QByteArray output = mkisofsOutput();
+        bench.run( QLatin1String( "process/mkisofs" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::MkisofsProgress ) );
+        } );
+    }
+
+    if( bench.wants( QLatin1String( "process/transcode" ) ) ) {
+        const QByteArray output = transcodeOutput();
+        bench.run( QLatin1String( "process/transcode" ), Bench::Items, [&]() {
+            return parse( output, ProgressMatcher::matcher( ProgressMatcher::TranscodeProgress ) );
+        } );
+    }
+}
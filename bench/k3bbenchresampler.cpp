@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bbench.h"
+
+#include "k3baudioresampler.h"
+
+#include <QVector>
+
+#include <math.h>
+
+
+namespace {
+    // ten seconds of stereo audio per run
+    const int s_seconds = 10;
+    const int s_chunkFrames = 4096;
+
+    // 44056 Hz has no small ratio to 44100 Hz and goes to libsamplerate
+    const int s_samplerates[] = { 48000, 96000, 88200, 32000, 44056 };
+
+    struct Tier {
+        K3b::AudioResampler::Quality quality;
+        const char* name;
+    };
+
+    const Tier s_tiers[] = {
+        { K3b::AudioResampler::QualityFast, "fast" },
+        { K3b::AudioResampler::QualityMedium, "medium" },
+        { K3b::AudioResampler::QualityBest, "best" }
+    };
+}
+
+
+void K3b::benchResampler( Bench& bench )
+{
+    //
+    // The work is the amount of 16 bit CD audio produced so the numbers
+    // compare to the audiodecoder benchmarks. The input is fed in chunks
+    // of the size the decoders typically deliver.
+    //
+    for( unsigned int r = 0; r < sizeof(s_samplerates)/sizeof(int); ++r ) {
+        const int samplerate = s_samplerates[r];
+
+        QVector<float> input;
+        QVector<float> output( 2*s_chunkFrames );
+
+        for( unsigned int t = 0; t < sizeof(s_tiers)/sizeof(Tier); ++t ) {
+            const QString name = QString::fromLatin1( "resampler/%1/%2" ).arg( samplerate ).arg( QLatin1String( s_tiers[t].name ) );
+            if( !bench.wants( name ) )
+                continue;
+
+            // a sweep keeps the filter busy across the whole band
+            if( input.isEmpty() ) {
+                const int frames = samplerate*s_seconds;
+                input.resize( 2*frames );
+                for( int i = 0; i < frames; ++i ) {
+                    const double sec = double( i ) / double( samplerate );
+                    const double v = 0.5 * sin( 2.0 * M_PI * ( 20.0 + 1000.0 * sec ) * sec );
+                    input[2*i] = v;
+                    input[2*i+1] = -v;
+                }
+            }
+
+            AudioResampler resampler( samplerate, 2, s_tiers[t].quality );
+            if( !resampler.isValid() ) {
+                bench.skip( name, QLatin1String( "unable to initialize the resampler" ) );
+                continue;
+            }
+
+            bench.run( name, Bench::Bytes,
+                       [&]() {
+                           resampler.reset();
+                       },
+                       [&]() {
+                           const int frames = input.size()/2;
+                           quint64 bytes = 0;
+                           int pos = 0;
+                           forever {
+                               const int chunk = qMin( s_chunkFrames, frames - pos );
+                               int used = 0;
+                               const int produced = resampler.process( input.constData() + 2*pos, chunk,
+                                                                       output.data(), output.size()/2,
+                                                                       used, chunk == 0 );
+                               if( produced < 0 )
+                                   return quint64( 0 );
+                               pos += used;
+                               bytes += 4*produced;
+                               if( chunk == 0 && produced == 0 )
+                                   break;
+                           }
+                           return bytes;
+                       } );
+        }
+    }
+}
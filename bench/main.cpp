@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <config-kylinburner.h>
+
+#include "k3bbench.h"
+
+#include "k3bcore.h"
+#include "k3bpluginmanager.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QThread>
+
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+    QCoreApplication::setApplicationName( QLatin1String( "k3b-bench" ) );
+    QCoreApplication::setApplicationVersion( QLatin1String( K3B_VERSION_STRING ) );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( QLatin1String( "Throughput and latency benchmarks for the K3b libraries." ) );
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption( QCommandLineOption( QLatin1String( "output" ),
+                                          QLatin1String( "Write the JSON results to <file> instead of stdout." ),
+                                          QLatin1String( "file" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "iterations" ),
+                                          QLatin1String( "Timed runs per benchmark (default 5)." ),
+                                          QLatin1String( "n" ), QLatin1String( "5" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "warmup" ),
+                                          QLatin1String( "Untimed runs per benchmark (default 1)." ),
+                                          QLatin1String( "n" ), QLatin1String( "1" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "filter" ),
+                                          QLatin1String( "Only run the benchmarks matching <regexp>." ),
+                                          QLatin1String( "regexp" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "items" ),
+                                          QLatin1String( "Comma separated data project sizes (default 10000,100000)." ),
+                                          QLatin1String( "counts" ), QLatin1String( "10000,100000" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "audio" ),
+                                          QLatin1String( "Audio file to decode with each capable decoder plugin. May be repeated." ),
+                                          QLatin1String( "file" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "iso" ),
+                                          QLatin1String( "ISO9660 image to parse. May be repeated." ),
+                                          QLatin1String( "file" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "drive-latency" ),
+                                          QLatin1String( "Delay of each command of the virtual drives in microseconds (default 0)." ),
+                                          QLatin1String( "usecs" ), QLatin1String( "0" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "drive-throughput" ),
+                                          QLatin1String( "Transfer rate of the virtual drives in KB/s (default 0, unlimited)." ),
+                                          QLatin1String( "kbps" ), QLatin1String( "0" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "mpeg" ),
+                                          QLatin1String( "MPEG file to scan. May be repeated." ),
+                                          QLatin1String( "file" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "tempdir" ),
+                                          QLatin1String( "Directory for temporary files." ),
+                                          QLatin1String( "dir" ), QDir::tempPath() ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "baseline" ),
+                                          QLatin1String( "Compare against the JSON results in <file> and fail on regressions." ),
+                                          QLatin1String( "file" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "max-regression" ),
+                                          QLatin1String( "Allowed slowdown against the baseline in percent (default 10)." ),
+                                          QLatin1String( "percent" ), QLatin1String( "10" ) ) );
+    parser.addOption( QCommandLineOption( QLatin1String( "verbose" ),
+                                          QLatin1String( "Do not suppress the debugging output of the libraries." ) ) );
+    parser.process( app );
+
+    QTextStream err( stderr );
+
+    if( !parser.isSet( QLatin1String( "verbose" ) ) )
+        QLoggingCategory::setFilterRules( QLatin1String( "*.debug=false" ) );
+
+    K3b::Bench bench;
+    bench.setIterations( qMax( 1, parser.value( QLatin1String( "iterations" ) ).toInt() ) );
+    bench.setWarmup( qMax( 0, parser.value( QLatin1String( "warmup" ) ).toInt() ) );
+    bench.setTempDir( parser.value( QLatin1String( "tempdir" ) ) );
+    if( parser.isSet( QLatin1String( "filter" ) ) ) {
+        QRegularExpression rx( parser.value( QLatin1String( "filter" ) ) );
+        if( !rx.isValid() ) {
+            err << "Invalid filter: " << rx.errorString() << endl;
+            return 2;
+        }
+        bench.setFilter( rx );
+    }
+
+    QList<int> itemCounts;
+    Q_FOREACH( const QString& s, parser.value( QLatin1String( "items" ) ).split( QLatin1Char( ',' ), QString::SkipEmptyParts ) ) {
+        bool ok = false;
+        const int count = s.trimmed().toInt( &ok );
+        if( !ok || count <= 0 ) {
+            err << "Invalid item count: " << s << endl;
+            return 2;
+        }
+        itemCounts.append( count );
+    }
+
+    QJsonObject baseline;
+    if( parser.isSet( QLatin1String( "baseline" ) ) ) {
+        QFile f( parser.value( QLatin1String( "baseline" ) ) );
+        QJsonParseError error;
+        if( f.open( QIODevice::ReadOnly ) )
+            baseline = QJsonDocument::fromJson( f.readAll(), &error ).object();
+        if( baseline.isEmpty() ) {
+            err << "Unable to read the baseline " << f.fileName() << endl;
+            return 2;
+        }
+    }
+
+    // only the decoder plugins and the virtual drives are needed, no device
+    // scanning or program search
+    K3b::Core core;
+    const QStringList audioFiles = parser.values( QLatin1String( "audio" ) );
+    if( !audioFiles.isEmpty() )
+        core.pluginManager()->loadAll();
+
+    K3b::benchPipes( bench );
+    K3b::benchAudio( bench, audioFiles );
+    K3b::benchResampler( bench );
+    K3b::benchProcessOutput( bench );
+    K3b::benchDataDoc( bench, itemCounts );
+    const int driveLatency = qMax( 0, parser.value( QLatin1String( "drive-latency" ) ).toInt() );
+    const int driveThroughput = qMax( 0, parser.value( QLatin1String( "drive-throughput" ) ).toInt() );
+
+    K3b::benchDevice( bench, driveLatency, driveThroughput );
+    K3b::benchIso9660( bench, parser.values( QLatin1String( "iso" ) ), driveLatency, driveThroughput );
+    K3b::benchMpegInfo( bench, parser.values( QLatin1String( "mpeg" ) ) );
+
+    QJsonObject result = bench.toJson();
+    result.insert( QLatin1String( "k3b_version" ), QLatin1String( K3B_VERSION_STRING ) );
+    result.insert( QLatin1String( "qt_version" ), QLatin1String( qVersion() ) );
+    result.insert( QLatin1String( "cpus" ), QThread::idealThreadCount() );
+    result.insert( QLatin1String( "timestamp" ), QDateTime::currentDateTimeUtc().toString( Qt::ISODate ) );
+
+    const QByteArray json = QJsonDocument( result ).toJson();
+    if( parser.isSet( QLatin1String( "output" ) ) ) {
+        QFile f( parser.value( QLatin1String( "output" ) ) );
+        if( !f.open( QIODevice::WriteOnly|QIODevice::Truncate ) || f.write( json ) != json.size() ) {
+            err << "Unable to write " << f.fileName() << endl;
+            return 2;
+        }
+    }
+    else {
+        QFile out;
+        out.open( stdout, QIODevice::WriteOnly );
+        out.write( json );
+    }
+
+    if( !baseline.isEmpty() ) {
+        const QStringList regressions = bench.compare( baseline, parser.value( QLatin1String( "max-regression" ) ).toDouble() );
+        Q_FOREACH( const QString& r, regressions )
+            err << "REGRESSION " << r << endl;
+        if( !regressions.isEmpty() )
+            return 1;
+    }
+
+    return 0;
+}
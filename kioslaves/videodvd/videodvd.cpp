@@ -32,6 +32,87 @@
 namespace
 {
     const int CMD_MIMETYPE = 70; // Should be declared in KIOCore/KIO/Global, but it's missing. Why?
+
+    // a file manager sends bursts of requests, only check for a new medium once per burst
+    const qint64 VOLUME_CHECK_INTERVAL = 2000;
+
+    const int MAX_READ_SIZE = 16*1024*1024;
+
+    // close the device after this many seconds without a request, so the tray
+    // is not locked and other programs can open the device exclusively
+    const int DEVICE_IDLE_TIMEOUT = 5;
+
+    /**
+     * Opens the real backend only while data is read. close() releases the
+     * device or the libdvdcss handle while the parsed directory tree of the
+     * Iso9660 using this backend stays valid. The next read opens it again.
+     */
+    class VolumeBackend : public K3b::Iso9660Backend
+    {
+    public:
+        explicit VolumeBackend( K3b::Device::Device* dev )
+            : m_device( dev ),
+              m_backend( 0 ) {
+        }
+
+        ~VolumeBackend() override {
+            close();
+        }
+
+        bool open() override {
+            if( m_backend )
+                return true;
+
+            // the same choice as K3b::Iso9660::open()
+            if( m_device->copyrightProtectionSystemType() == K3b::Device::COPYRIGHT_PROTECTION_CSS ) {
+                m_backend = new K3b::Iso9660LibDvdCssBackend( m_device );
+                if( !m_backend->open() ) {
+                    delete m_backend;
+                    m_backend = new K3b::Iso9660DeviceBackend( m_device );
+                }
+            }
+            else {
+                m_backend = new K3b::Iso9660DeviceBackend( m_device );
+            }
+
+            if( !m_backend->open() ) {
+                delete m_backend;
+                m_backend = 0;
+                return false;
+            }
+            return true;
+        }
+
+        void close() override {
+            delete m_backend;
+            m_backend = 0;
+        }
+
+        bool isOpen() const override {
+            return m_backend != 0;
+        }
+
+        int read( unsigned int sector, char* data, int len ) override {
+            if( !open() )
+                return -1;
+            return m_backend->read( sector, data, len );
+        }
+
+    private:
+        K3b::Device::Device* m_device;
+        K3b::Iso9660Backend* m_backend;
+    };
+
+    KIO::UDSEntry createVideoDvdUDSEntry( const K3b::Iso9660& iso )
+    {
+        KIO::UDSEntry uds;
+        uds.fastInsert( KIO::UDSEntry::UDS_NAME,iso.primaryDescriptor().volumeId );
+        uds.fastInsert( KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR );
+        uds.fastInsert( KIO::UDSEntry::UDS_MIME_TYPE, "inode/directory" );
+        uds.fastInsert( KIO::UDSEntry::UDS_ICON_NAME, "media-optical-video" );
+        uds.fastInsert( KIO::UDSEntry::UDS_SIZE, iso.primaryDescriptor().volumeSetSize );
+        return uds;
+    }
 } // namespace
 
 using namespace KIO;
@@ -75,7 +156,9 @@ K3b::Device::DeviceManager* kio_videodvdProtocol::s_deviceManager = 0;
 int kio_videodvdProtocol::s_instanceCnt = 0;
 
 kio_videodvdProtocol::kio_videodvdProtocol(const QByteArray &pool_socket, const QByteArray &app_socket)
-    : SlaveBase("kio_videodvd", pool_socket, app_socket)
+    : SlaveBase("kio_videodvd", pool_socket, app_socket),
+      m_file( 0 ),
+      m_filePos( 0 )
 {
     qDebug() << "kio_videodvdProtocol::kio_videodvdProtocol()";
     if( !s_deviceManager )
@@ -91,6 +174,10 @@ kio_videodvdProtocol::kio_videodvdProtocol(const QByteArray &pool_socket, const
 kio_videodvdProtocol::~kio_videodvdProtocol()
 {
     qDebug() << "kio_videodvdProtocol::~kio_videodvdProtocol()";
+    m_file = 0;
+    while( !m_volumes.isEmpty() )
+        closeVolume( m_volumes.first()->device );
+
     s_instanceCnt--;
     if( s_instanceCnt == 0 )
     {
@@ -130,8 +217,101 @@ KIO::UDSEntry kio_videodvdProtocol::createUDSEntry( const K3b::Iso9660Entry* e )
 }
 
 
-// FIXME: remember the iso instance for quicker something and search for the videodvd
-//        in the available devices.
+QByteArray kio_videodvdProtocol::readDescriptor( K3b::Device::Device* dev ) const
+{
+    // the primary volume descriptor is never encrypted
+    QByteArray descriptor( 2048, '\0' );
+    if( dev->read10( reinterpret_cast<unsigned char*>( descriptor.data() ), descriptor.size(), 16, 1 ) )
+        return descriptor;
+    else
+        return QByteArray();
+}
+
+
+kio_videodvdProtocol::Volume* kio_videodvdProtocol::cachedVolume( K3b::Device::Device* dev )
+{
+    Q_FOREACH( Volume* volume, m_volumes ) {
+        if( volume->device != dev )
+            continue;
+
+        if( volume->lastCheck.elapsed() < VOLUME_CHECK_INTERVAL ||
+            readDescriptor( dev ) == volume->descriptor ) {
+            volume->lastCheck.restart();
+            return volume;
+        }
+
+        qDebug() << "(kio_videodvdProtocol) medium changed in" << dev->blockDeviceName();
+        closeVolume( dev );
+        break;
+    }
+
+    return 0;
+}
+
+
+kio_videodvdProtocol::Volume* kio_videodvdProtocol::openVolume( K3b::Device::Device* dev )
+{
+    K3b::Device::DiskInfo di = dev->diskInfo();
+
+    // we search for a DVD with a single track.
+    // this time let K3b::Iso9660 decide if we need dvdcss or not
+    // FIXME: check for encryption and libdvdcss and report an error
+    if( !K3b::Device::isDvdMedia( di.mediaType() ) || di.numTracks() != 1 )
+        return 0;
+
+    const QByteArray descriptor = readDescriptor( dev );
+    if( descriptor.isEmpty() )
+        return 0;
+
+    VolumeBackend* backend = new VolumeBackend( dev );
+    K3b::Iso9660* iso = new K3b::Iso9660( backend );
+    iso->setPlainIso9660( true );
+    if( !iso->open() ) {
+        delete iso;
+        return 0;
+    }
+
+    Volume* volume = new Volume;
+    volume->device = dev;
+    volume->iso = iso;
+    volume->backend = backend;
+    volume->descriptor = descriptor;
+    volume->lastCheck.start();
+    m_volumes.append( volume );
+
+    qDebug() << "(kio_videodvdProtocol) opened" << iso->primaryDescriptor().volumeId << "in" << dev->blockDeviceName();
+    return volume;
+}
+
+
+void kio_videodvdProtocol::releaseDevices()
+{
+    Q_FOREACH( Volume* volume, m_volumes )
+        volume->backend->close();
+}
+
+
+void kio_videodvdProtocol::special( const QByteArray& )
+{
+    // only sent by the idle timeout
+    releaseDevices();
+    finished();
+}
+
+
+void kio_videodvdProtocol::closeVolume( K3b::Device::Device* dev )
+{
+    for( int i = 0; i < m_volumes.count(); ++i ) {
+        if( m_volumes[i]->device == dev ) {
+            Volume* volume = m_volumes.takeAt( i );
+            delete volume->iso;
+            delete volume;
+            return;
+        }
+    }
+}
+
+
 K3b::Iso9660* kio_videodvdProtocol::openIso( const QUrl& url, QString& plainIsoPath )
 {
     // get the volume id from the url
@@ -139,28 +319,34 @@ K3b::Iso9660* kio_videodvdProtocol::openIso( const QUrl& url, QString& plainIsoP
 
     qDebug() << "(kio_videodvdProtocol) searching for Video dvd: " << volumeId;
 
-
     // now search the devices for this volume id
-    // FIXME: use the cache created in listVideoDVDs
+    // and fall back to the first Video DVD if there is none
+    Volume* found = 0;
     QList<K3b::Device::Device *> items(s_deviceManager->dvdReader());
     for( QList<K3b::Device::Device *>::const_iterator it = items.constBegin();
          it != items.constEnd(); ++it ) {
         K3b::Device::Device* dev = *it;
-        K3b::Device::DiskInfo di = dev->diskInfo();
-
-        // we search for a DVD with a single track.
-        // this time let K3b::Iso9660 decide if we need dvdcss or not
-        // FIXME: check for encryption and libdvdcss and report an error
-        if( K3b::Device::isDvdMedia( di.mediaType() ) && di.numTracks() == 1 ) {
-            K3b::Iso9660* iso = new K3b::Iso9660( dev );
-            iso->setPlainIso9660( true );
-            if( iso->open() /*&& iso->primaryDescriptor().volumeId == volumeId*/ ) {
-                plainIsoPath = url.path().section( '/', 2, -1 ) + '/';
-                qDebug() << "(kio_videodvdProtocol) using iso path: " << plainIsoPath;
-                return iso;
-            }
-            delete iso;
+        Volume* volume = cachedVolume( dev );
+        if( !volume )
+            volume = openVolume( dev );
+        if( !volume )
+            continue;
+
+        if( volume->iso->primaryDescriptor().volumeId == volumeId ) {
+            found = volume;
+            break;
         }
+        if( !found )
+            found = volume;
+    }
+
+    if( found ) {
+        // keep the devices open for the rest of a burst of requests
+        setTimeoutSpecialCommand( DEVICE_IDLE_TIMEOUT );
+
+        plainIsoPath = url.path().section( '/', 2, -1 ) + '/';
+        qDebug() << "(kio_videodvdProtocol) using iso path: " << plainIsoPath;
+        return found->iso;
     }
 
     error( ERR_SLAVE_DEFINED, i18n("No Video DVD found") );
@@ -168,47 +354,138 @@ K3b::Iso9660* kio_videodvdProtocol::openIso( const QUrl& url, QString& plainIsoP
 }
 
 
+const K3b::Iso9660File* kio_videodvdProtocol::findFile( const QUrl& url )
+{
+    QString isoPath;
+    K3b::Iso9660* iso = openIso( url, isoPath );
+    if( !iso )
+        return 0;
+
+    const K3b::Iso9660Entry* e = iso->firstIsoDirEntry()->entry( isoPath );
+    if( !e )
+        error( ERR_DOES_NOT_EXIST, url.path() );
+    else if( !e->isFile() )
+        error( ERR_IS_DIRECTORY, url.path() );
+    else
+        return static_cast<const K3b::Iso9660File*>( e );
+
+    return 0;
+}
+
+
 void kio_videodvdProtocol::get(const QUrl& url )
 {
     qDebug() << "kio_videodvd::get(const QUrl& url)";
 
-    QString isoPath;
-    if( K3b::Iso9660* iso = openIso( url, isoPath ) )
+    if( const K3b::Iso9660File* file = findFile( url ) )
     {
-        const K3b::Iso9660Entry* e = iso->firstIsoDirEntry()->entry( isoPath );
-        if( e && e->isFile() )
+        totalSize( file->size() );
+
+        KIO::filesize_t totalRead = 0;
+        bool ok = false;
+        const KIO::filesize_t rangeStart = metaData( QStringLiteral("range-start") ).toULongLong( &ok );
+        if( ok && rangeStart > 0 && rangeStart < file->size() ) {
+            canResume();
+            totalRead = rangeStart;
+            processedSize( totalRead );
+        }
+
+        QByteArray buffer( 10*2048, '\n' );
+        int read = 0;
+        int cnt = 0;
+        while( (read = file->read( totalRead, buffer.data(), buffer.size() )) > 0 )
         {
-            const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>( e );
-            totalSize( file->size() );
-            QByteArray buffer( 10*2048, '\n' );
-            int read = 0;
-            int cnt = 0;
-            KIO::filesize_t totalRead = 0;
-            while( (read = file->read( totalRead, buffer.data(), buffer.size() )) > 0 )
+            buffer.resize( read );
+            data(buffer);
+            ++cnt;
+            totalRead += read;
+            if( cnt == 10 )
             {
-                buffer.resize( read );
-                data(buffer);
-                ++cnt;
-                totalRead += read;
-                if( cnt == 10 )
-                {
-                    cnt = 0;
-                    processedSize( totalRead );
-                }
+                cnt = 0;
+                processedSize( totalRead );
             }
+        }
 
-            delete iso;
-
-            data(QByteArray()); // empty array means we're done sending the data
+        data(QByteArray()); // empty array means we're done sending the data
 
-            if( read == 0 )
-                finished();
-            else
-                error( ERR_SLAVE_DEFINED, i18n("Read error.") );
-        }
+        if( read == 0 )
+            finished();
         else
-            error( ERR_DOES_NOT_EXIST, url.path() );
+            error( ERR_SLAVE_DEFINED, i18n("Read error.") );
+    }
+}
+
+
+void kio_videodvdProtocol::open( const QUrl& url, QIODevice::OpenMode mode )
+{
+    qDebug() << "kio_videodvd::open(const QUrl& url)" << url;
+
+    if( mode & QIODevice::WriteOnly ) {
+        error( ERR_CANNOT_OPEN_FOR_WRITING, url.path() );
+        return;
+    }
+
+    m_file = findFile( url );
+    if( !m_file )
+        return;
+
+    // the file is read until close()
+    setTimeoutSpecialCommand( -1 );
+
+    m_filePos = 0;
+    if( m_file->name().endsWith( ".VOB" ) )
+        mimeType( "video/mpeg" );
+    else
+        mimeType( "application/octet-stream" );
+    totalSize( m_file->size() );
+    position( 0 );
+    opened();
+}
+
+
+void kio_videodvdProtocol::read( KIO::filesize_t size )
+{
+    if( !m_file ) {
+        error( ERR_CANNOT_READ, QString() );
+        return;
+    }
+
+    // like a plain file the request may be answered with less data
+    const KIO::filesize_t fileSize = m_file->size();
+    const KIO::filesize_t len = qMin( qMin( size, fileSize - qMin( m_filePos, fileSize ) ),
+                                      KIO::filesize_t( MAX_READ_SIZE ) );
+    QByteArray buffer( int( len ), Qt::Uninitialized );
+    const int read = ( len > 0 ? m_file->read( m_filePos, buffer.data(), buffer.size() ) : 0 );
+    if( read < 0 ) {
+        error( ERR_CANNOT_READ, m_file->name() );
+        m_file = 0;
+        return;
+    }
+
+    buffer.resize( read );
+    m_filePos += read;
+    data( buffer );
+}
+
+
+void kio_videodvdProtocol::seek( KIO::filesize_t offset )
+{
+    if( !m_file || offset > m_file->size() ) {
+        error( ERR_CANNOT_SEEK, m_file ? m_file->name() : QString() );
+        m_file = 0;
+        return;
     }
+
+    m_filePos = offset;
+    position( offset );
+}
+
+
+void kio_videodvdProtocol::close()
+{
+    m_file = 0;
+    setTimeoutSpecialCommand( DEVICE_IDLE_TIMEOUT );
+    finished();
 }
 
 
@@ -245,9 +522,6 @@ void kio_videodvdProtocol::listDir( const QUrl& url )
             else {
                 error( ERR_CANNOT_ENTER_DIRECTORY, url.path() );
             }
-
-            // for testing we always do the whole thing
-            delete iso;
         }
     }
 }
@@ -261,6 +535,14 @@ void kio_videodvdProtocol::listVideoDVDs()
     for( QList<K3b::Device::Device *>::const_iterator it = items.constBegin();
          it != items.constEnd(); ++it ) {
         K3b::Device::Device* dev = *it;
+
+        // an already opened volume needs no further checks
+        if( Volume* volume = cachedVolume( dev ) ) {
+            if( volume->iso->firstIsoDirEntry()->entry( "VIDEO_TS" ) != 0 )
+                udsl.append( createVideoDvdUDSEntry( *volume->iso ) );
+            continue;
+        }
+
         K3b::Device::DiskInfo di = dev->diskInfo();
 
         // we search for a DVD with a single track.
@@ -273,22 +555,13 @@ void kio_videodvdProtocol::listVideoDVDs()
             K3b::Iso9660 iso( new K3b::Iso9660DeviceBackend(dev) );
             iso.setPlainIso9660( true );
             if( iso.open() && iso.firstIsoDirEntry()->entry( "VIDEO_TS" ) != 0 ) {
-                // FIXME: cache the entry for speedup
-
-                UDSEntry uds;
-                uds.fastInsert( KIO::UDSEntry::UDS_NAME,iso.primaryDescriptor().volumeId );
-                uds.fastInsert( KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR );
-                uds.fastInsert( KIO::UDSEntry::UDS_MIME_TYPE, "inode/directory" );
-                uds.fastInsert( KIO::UDSEntry::UDS_ICON_NAME, "media-optical-video" );
-                uds.fastInsert( KIO::UDSEntry::UDS_SIZE, iso.primaryDescriptor().volumeSetSize );
-
-                udsl.append( uds );
-                listEntries( udsl );
+                udsl.append( createVideoDvdUDSEntry( iso ) );
             }
         }
     }
 
     if( !udsl.isEmpty() ) {
+        listEntries( udsl );
         finished();
     }
     else {
@@ -325,8 +598,6 @@ void kio_videodvdProtocol::stat( const QUrl& url )
             }
             else
                 error( ERR_DOES_NOT_EXIST, url.path() );
-
-            delete iso;
         }
     }
 }
@@ -372,6 +643,5 @@ void kio_videodvdProtocol::mimetype( const QUrl& url )
                     error( ERR_SLAVE_DEFINED, i18n("Read error.") );
             }
         }
-        delete iso;
     }
 }
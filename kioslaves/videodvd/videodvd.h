@@ -16,6 +16,8 @@
 #ifndef _videodvd_H_
 #define _videodvd_H_
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QString>
 
 #include "k3biso9660.h"
@@ -42,11 +44,51 @@ public:
     void get(const QUrl& url) override;
     void listDir(const QUrl& url) override;
 
+    void open(const QUrl& url, QIODevice::OpenMode mode) override;
+    void read(KIO::filesize_t size) override;
+    void seek(KIO::filesize_t offset) override;
+    void close() override;
+
+    void special(const QByteArray& data) override;
+
 private:
+    /**
+     * An opened Video DVD. Opening the iso9660 filesystem and parsing its
+     * directories is by far the most expensive part of every request. Thus,
+     * the parsed volumes are kept until the medium is changed. The device
+     * itself is only kept open until the slave has been idle for a while.
+     */
+    struct Volume {
+        K3b::Device::Device* device;
+        K3b::Iso9660* iso;
+
+        // owned by iso, see releaseDevices()
+        K3b::Iso9660Backend* backend;
+
+        // the primary volume descriptor identifies the medium
+        QByteArray descriptor;
+        QElapsedTimer lastCheck;
+    };
+
+    /**
+     * The returned Iso9660 is owned by the volume cache.
+     */
     K3b::Iso9660* openIso( const QUrl&, QString& plainIsoPath );
+    Volume* cachedVolume( K3b::Device::Device* dev );
+    Volume* openVolume( K3b::Device::Device* dev );
+    void closeVolume( K3b::Device::Device* dev );
+    void releaseDevices();
+    QByteArray readDescriptor( K3b::Device::Device* dev ) const;
+    const K3b::Iso9660File* findFile( const QUrl& url );
     KIO::UDSEntry createUDSEntry( const K3b::Iso9660Entry* e ) const;
     void listVideoDVDs();
 
+    QList<Volume*> m_volumes;
+
+    // the file opened via open()
+    const K3b::Iso9660File* m_file;
+    KIO::filesize_t m_filePos;
+
     static K3b::Device::DeviceManager* s_deviceManager;
     static int s_instanceCnt;
 };
@@ -395,8 +395,13 @@ bool K3b::TranscodeProgram::scanFeatures( ExternalBin& bin ) const
     modp.setOutputChannelMode( KProcess::MergedChannels );
     modp << modInfoBin << "-p";
 
+    // the features depend on the installed export modules
+    bin.addProbeDependency( modInfoBin );
+
     if( !modp.execute() ) {
         QString modPath = QString::fromLocal8Bit( modp.readAll() ).simplified();
+        if( !modPath.isEmpty() )
+            bin.addProbeDependency( modPath );
         QDir modDir( modPath );
         if( !modDir.entryList( QStringList() << "*export_xvid*", QDir::Files ).isEmpty() )
             bin.addFeature( "xvid" );
@@ -15,14 +15,20 @@
 
 #include "k3bexternalbinmanager.h"
 #include "k3bglobals.h"
+#include "config-kylinburner.h"
 
 #include <KConfigGroup>
 #include <KProcess>
 
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
 #include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
 #include <QtGlobal>
 #include <QRegExp>
 
@@ -41,6 +47,227 @@ namespace {
     }
 
     const int EXECUTE_TIMEOUT = 5000; // in seconds
+
+
+    /**
+     * Remembers the parsed results of the --version and --help probes so
+     * unchanged binaries do not have to be run again on every startup.
+     * Entries are keyed on the program name and path and are only used
+     * as long as the file identity (inode, size, mtime and ctime) did not
+     * change. ctime is included since chmod (suid bit) only touches that.
+     * The mtimes of the probe dependencies of a binary are part of its
+     * entry as well, so installing or removing plugins is noticed.
+     */
+    class ProbeCache
+    {
+    public:
+        ProbeCache()
+            : m_loaded( false ),
+              m_dirty( false ) {
+        }
+
+        /**
+         * \return true if a cached result was found. In that case \p bin has been
+         *         filled and \p valid tells if the probe succeeded.
+         */
+        bool restore( const QString& programName, K3b::ExternalBin& bin, bool& valid ) {
+            Identity id;
+            if( !identity( bin.path(), id ) )
+                return false;
+
+            const QString key = cacheKey( programName, bin.path() );
+            m_seen.insert( key );
+
+            QHash<QString, Entry>::const_iterator it = m_entries.constFind( key );
+            if( it == m_entries.constEnd() || !( it->id == id ) ||
+                it->dependencies != dependencies( it->dependencies.keys() ) )
+                return false;
+
+            valid = it->valid;
+            if( valid ) {
+                bin.setNeedGroup( "" );
+                bin.setVersion( K3b::Version( it->version ) );
+                bin.setCopyright( it->copyright );
+                Q_FOREACH( const QString& feature, it->features ) {
+                    bin.addFeature( feature );
+                }
+                Q_FOREACH( const QString& path, it->dependencies.keys() ) {
+                    bin.addProbeDependency( path );
+                }
+            }
+            return true;
+        }
+
+        void store( const QString& programName, const K3b::ExternalBin& bin, bool valid ) {
+            Entry entry;
+            if( !identity( bin.path(), entry.id ) )
+                return;
+
+            entry.valid = valid;
+            if( valid ) {
+                entry.version = bin.version().toString();
+                entry.copyright = bin.copyright();
+                entry.features = bin.features();
+                entry.dependencies = dependencies( bin.probeDependencies() );
+            }
+
+            const QString key = cacheKey( programName, bin.path() );
+            m_entries.insert( key, entry );
+            m_seen.insert( key );
+            m_dirty = true;
+        }
+
+        void beginSearch() {
+            if( !m_loaded ) {
+                m_loaded = true;
+                load();
+            }
+            m_seen.clear();
+        }
+
+        void endSearch() {
+            // forget binaries which disappeared
+            for( QHash<QString, Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ) {
+                if( m_seen.contains( it.key() ) ) {
+                    ++it;
+                }
+                else {
+                    it = m_entries.erase( it );
+                    m_dirty = true;
+                }
+            }
+
+            if( m_dirty )
+                save();
+        }
+
+        void clear() {
+            m_entries.clear();
+            m_dirty = true;
+        }
+
+    private:
+        struct Identity {
+            qint64 inode;
+            qint64 size;
+            qint64 mtime;
+            qint64 ctime;
+
+            bool operator==( const Identity& other ) const {
+                return ( inode == other.inode && size == other.size &&
+                         mtime == other.mtime && ctime == other.ctime );
+            }
+        };
+
+        struct Entry {
+            Identity id;
+            bool valid;
+            QString version;
+            QString copyright;
+            QStringList features;
+
+            // path -> mtime, -1 if the path does not exist
+            QHash<QString, qint64> dependencies;
+        };
+
+        static QString cacheKey( const QString& programName, const QString& path ) {
+            return programName + QLatin1Char( '\n' ) + path;
+        }
+
+        static bool identity( const QString& path, Identity& id ) {
+#ifndef Q_OS_WIN32
+            struct stat st;
+            if( ::stat( QFile::encodeName( path ), &st ) )
+                return false;
+            id.inode = st.st_ino;
+            id.size = st.st_size;
+            id.mtime = st.st_mtime;
+            id.ctime = st.st_ctime;
+            return true;
+#else
+            Q_UNUSED( path );
+            Q_UNUSED( id );
+            return false;
+#endif
+        }
+
+        static QHash<QString, qint64> dependencies( const QStringList& paths ) {
+            QHash<QString, qint64> mtimes;
+            Q_FOREACH( const QString& path, paths ) {
+                Identity id;
+                mtimes.insert( path, identity( path, id ) ? id.mtime : -1 );
+            }
+            return mtimes;
+        }
+
+        static QString fileName() {
+            return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/externalbins.cache";
+        }
+
+        // the version of K3b is part of the header since newer versions may
+        // parse the output differently
+        static QString header() {
+            return QString::fromLatin1( "K3b external bin probe cache 2 " K3B_VERSION_STRING );
+        }
+
+        void load() {
+            QFile f( fileName() );
+            if( !f.open( QIODevice::ReadOnly ) )
+                return;
+
+            QDataStream s( &f );
+            s.setVersion( QDataStream::Qt_5_0 );
+
+            QString h;
+            quint32 count = 0;
+            s >> h >> count;
+            if( h != header() )
+                return;
+
+            for( quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i ) {
+                QString key;
+                Entry entry;
+                s >> key >> entry.id.inode >> entry.id.size >> entry.id.mtime >> entry.id.ctime
+                  >> entry.valid >> entry.version >> entry.copyright >> entry.features >> entry.dependencies;
+                if( s.status() == QDataStream::Ok )
+                    m_entries.insert( key, entry );
+            }
+
+            if( s.status() != QDataStream::Ok ) {
+                qDebug() << "Discarding corrupt probe cache" << fileName();
+                m_entries.clear();
+            }
+        }
+
+        void save() {
+            QDir().mkpath( QFileInfo( fileName() ).absolutePath() );
+
+            QSaveFile f( fileName() );
+            if( !f.open( QIODevice::WriteOnly ) ) {
+                qDebug() << "Unable to write probe cache" << fileName();
+                return;
+            }
+
+            QDataStream s( &f );
+            s.setVersion( QDataStream::Qt_5_0 );
+            s << header() << quint32( m_entries.count() );
+            for( QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it ) {
+                const Entry& entry = *it;
+                s << it.key() << entry.id.inode << entry.id.size << entry.id.mtime << entry.id.ctime
+                  << entry.valid << entry.version << entry.copyright << entry.features << entry.dependencies;
+            }
+
+            if( f.commit() )
+                m_dirty = false;
+        }
+
+        QHash<QString, Entry> m_entries;
+        QSet<QString> m_seen;
+        bool m_loaded;
+        bool m_dirty;
+    };
+
+    Q_GLOBAL_STATIC( ProbeCache, s_probeCache )
 }
 
 
@@ -62,6 +289,7 @@ public:
     Version version;
     QString copyright;
     QStringList features;
+    QStringList probeDependencies;
 };
 
 K3b::ExternalBin::ExternalBin( ExternalProgram& program, const QString& path )
@@ -124,6 +352,19 @@ QString K3b::ExternalBin::name() const
 }
 
 
+QStringList K3b::ExternalBin::probeDependencies() const
+{
+    return d->probeDependencies;
+}
+
+
+void K3b::ExternalBin::addProbeDependency( const QString& path )
+{
+    if( !d->probeDependencies.contains( path ) )
+        d->probeDependencies.append( path );
+}
+
+
 bool K3b::ExternalBin::hasFeature( const QString& f ) const
 {
     return d->features.contains( f );
@@ -347,7 +588,26 @@ bool K3b::SimpleExternalProgram::scan( const QString& p )
     if ( QFile::exists( path ) ) {
         K3b::ExternalBin* bin = new ExternalBin( *this, path );
 
-        if ( ( !scanVersion( *bin ) || !scanFeatures( *bin ) ) && bin->needGroup().isEmpty() )  {
+        bool valid = false;
+        if( s_probeCache->restore( name(), *bin, valid ) ) {
+            if( !valid ) {
+                delete bin;
+                return false;
+            }
+            addBin( bin );
+            return true;
+        }
+
+        const bool versionOk = scanVersion( *bin );
+        if( versionOk && scanFeatures( *bin ) ) {
+            s_probeCache->store( name(), *bin, true );
+        }
+        else if( bin->needGroup().isEmpty() ) {
+            // scanVersion sets an empty (but not null) group once the program
+            // actually ran. Only then the output is not usable for good, while
+            // permission problems and timeouts have to be probed again.
+            if( !versionOk && !bin->needGroup().isNull() )
+                s_probeCache->store( name(), *bin, false );
             delete bin;
             return false;
         }
@@ -611,11 +871,15 @@ void K3b::ExternalBinManager::clear()
 }
 
 
-void K3b::ExternalBinManager::search()
+void K3b::ExternalBinManager::search( bool useProbeCache )
 {
     if( d->searchPath.isEmpty() )
         loadDefaultSearchPath();
 
+    s_probeCache->beginSearch();
+    if( !useProbeCache )
+        s_probeCache->clear();
+
     Q_FOREACH( K3b::ExternalProgram* program, d->programs ) {
         program->clear();
     }
@@ -643,6 +907,8 @@ void K3b::ExternalBinManager::search()
             program->scan( path );
         }
     }
+
+    s_probeCache->endSearch();
 }
 
 
@@ -60,6 +60,14 @@ namespace K3b {
         bool hasFeature( const QString& ) const;
         void addFeature( const QString& );
 
+        /**
+         * Files or folders other than the binary itself which the features
+         * have been determined from, like plugin folders. A cached probe
+         * result is only used as long as none of them changed.
+         */
+        QStringList probeDependencies() const;
+        void addProbeDependency( const QString& path );
+
         ExternalProgram& program() const;
 
     private:
@@ -198,7 +206,14 @@ namespace K3b {
         explicit ExternalBinManager( QObject* parent = 0 );
         ~ExternalBinManager() override;
 
-        void search();
+        /**
+         * Search all programs in the search path and the PATH.
+         *
+         * The results of probing the binaries are cached on disk and only
+         * binaries which changed since the last search are run again.
+         * Set \p useProbeCache to false to probe every binary.
+         */
+        void search( bool useProbeCache = true );
 
         /**
          * read config and add changes to current map.
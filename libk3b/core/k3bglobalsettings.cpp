@@ -25,7 +25,9 @@ K3b::GlobalSettings::GlobalSettings()
       m_overburn(false),
       m_useManualBufferSize(false),
       m_bufferSize(4),
-      m_force(false)
+      m_force(false),
+      m_resamplingQuality(K3b::AudioResampler::QualityMedium),
+      m_audioImageCacheSize(2048)
 {
 }
 
@@ -43,6 +45,10 @@ void K3b::GlobalSettings::readSettings( const KConfigGroup& c )
     m_useManualBufferSize = c.readEntry( "Manual buffer size", false );
     m_bufferSize = c.readEntry( "Fifo buffer", 4 );
     m_force = c.readEntry( "Force unsafe operations", false );
+    m_resamplingQuality = static_cast<K3b::AudioResampler::Quality>( qBound( int( K3b::AudioResampler::QualityFast ),
+                                                                             c.readEntry( "Resampling quality", int( K3b::AudioResampler::QualityMedium ) ),
+                                                                             int( K3b::AudioResampler::QualityBest ) ) );
+    m_audioImageCacheSize = qMax( 0, c.readEntry( "Audio image cache size", 2048 ) );
 	m_defaultTempPath = c.readPathEntry("Temp Dir",
             //QStandardPaths::writableLocation(QStandardPaths::MoviesLocation));
             QStandardPaths::writableLocation(QStandardPaths::TempLocation));
@@ -62,5 +68,7 @@ void K3b::GlobalSettings::saveSettings( KConfigGroup c )
     c.writeEntry( "Manual buffer size", m_useManualBufferSize );
     c.writeEntry( "Fifo buffer", m_bufferSize );
     c.writeEntry( "Force unsafe operations", m_force );
+    c.writeEntry( "Resampling quality", int( m_resamplingQuality ) );
+    c.writeEntry( "Audio image cache size", m_audioImageCacheSize );
     c.writeEntry( "Temp Dir", m_defaultTempPath );
 }
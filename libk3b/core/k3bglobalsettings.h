@@ -16,6 +16,7 @@
 #define _K3B_GLOBAL_SETTINGS_H_
 
 #include "k3b_export.h"
+#include "k3baudioresampler.h"
 
 #include <QString>
 
@@ -60,6 +61,17 @@ namespace K3b {
          */
         QString defaultTempPath() const { return m_defaultTempPath; }
 
+        /**
+         * The quality used to convert audio files to 44100 Hz.
+         */
+        AudioResampler::Quality resamplingQuality() const { return m_resamplingQuality; }
+
+        /**
+         * The size of the decoded audio track cache in MB. 0 disables the cache.
+         * \see AudioImageCache
+         */
+        int audioImageCacheSize() const { return m_audioImageCacheSize; }
+
         void setEjectMedia( bool b ) { m_eject = b; }
         void setBurnfree( bool b ) { m_burnfree = b; }
         void setOverburn( bool b ) { m_overburn = b; }
@@ -67,6 +79,8 @@ namespace K3b {
         void setBufferSize( int size ) { m_bufferSize = size; }
         void setForce( bool b ) { m_force = b; }
         void setDefaultTempPath( const QString& s ) { m_defaultTempPath = s; }
+        void setResamplingQuality( AudioResampler::Quality q ) { m_resamplingQuality = q; }
+        void setAudioImageCacheSize( int size ) { m_audioImageCacheSize = size; }
 
     private:
         // FIXME: d-pointer
@@ -77,6 +91,8 @@ namespace K3b {
         int m_bufferSize;
         bool m_force;
         QString m_defaultTempPath;
+        AudioResampler::Quality m_resamplingQuality;
+        int m_audioImageCacheSize;
     };
 }
 
@@ -305,6 +305,13 @@ namespace K3b {
 
         void deviceBuffer( int );
 
+        /**
+         * The rate in KB/s at which the data to be written is produced,
+         * for example by mkisofs reading the source files. Only emitted by
+         * jobs writing on-the-fly from a source that may stall.
+         */
+        void sourceThroughput( int );
+
         /**
          * @param speed current writing speed in Kb
          * @param multiplicator use 150 for CDs and 1380 for DVDs
@@ -320,6 +327,18 @@ namespace K3b {
          */
         void burning(bool);
 
+        /**
+         * Progress of a single device including the verification. Only emitted
+         * by jobs writing to several devices at the same time.
+         */
+        void devicePercent( K3b::Device::Device* dev, int percent );
+
+        /**
+         * Emitted once a device is done writing and verifying when writing
+         * to several devices at the same time.
+         */
+        void deviceFinished( K3b::Device::Device* dev, bool success );
+
     private:
         class Private;
         Private* const d;
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bjobtelemetry.h"
+#include "k3bjob.h"
+
+#include <QAtomicInteger>
+#include <QPointer>
+#include <QTimer>
+
+
+namespace {
+    // must be a power of two
+    const quint32 s_ringSize = 8192;
+    const quint32 s_ringMask = s_ringSize - 1;
+
+    const int s_unset = -1;
+    const quint64 s_unsetPair = Q_UINT64_C( 0xFFFFFFFFFFFFFFFF );
+
+    inline quint64 packPair( int processed, int size )
+    {
+        return ( quint64( quint32( processed ) ) << 32 ) | quint64( quint32( size ) );
+    }
+
+    inline int pairFirst( quint64 v )
+    {
+        return int( quint32( v >> 32 ) );
+    }
+
+    inline int pairSecond( quint64 v )
+    {
+        return int( quint32( v & 0xFFFFFFFF ) );
+    }
+
+
+    /**
+     * Bounded multi-producer single-consumer ring buffer. Each cell carries
+     * a sequence number telling producers and the consumer whose turn it is,
+     * so neither side ever takes a lock.
+     */
+    class DebuggingRing
+    {
+    public:
+        DebuggingRing()
+            : m_cells( new Cell[s_ringSize] ),
+              m_dequeuePos( 0 ) {
+            reset();
+        }
+
+        ~DebuggingRing() {
+            delete [] m_cells;
+        }
+
+        // only safe while no producer is running
+        void reset() {
+            for( quint32 i = 0; i < s_ringSize; ++i ) {
+                m_cells[i].sequence.store( i );
+                m_cells[i].entry = K3b::JobTelemetry::DebuggingLine();
+            }
+            m_enqueuePos.storeRelease( 0 );
+            m_dequeuePos = 0;
+        }
+
+        bool push( const QString& group, const QString& line ) {
+            quint32 pos = m_enqueuePos.load();
+            Cell* cell = 0;
+            for( ;; ) {
+                cell = &m_cells[pos & s_ringMask];
+                const quint32 seq = cell->sequence.loadAcquire();
+                const qint32 diff = qint32( seq - pos );
+                if( diff == 0 ) {
+                    if( m_enqueuePos.testAndSetRelaxed( pos, pos + 1, pos ) )
+                        break;
+                }
+                else if( diff < 0 ) {
+                    // full
+                    return false;
+                }
+                else {
+                    pos = m_enqueuePos.load();
+                }
+            }
+
+            cell->entry.group = group;
+            cell->entry.line = line;
+            cell->sequence.storeRelease( pos + 1 );
+            return true;
+        }
+
+        bool pop( K3b::JobTelemetry::DebuggingLine& entry ) {
+            Cell& cell = m_cells[m_dequeuePos & s_ringMask];
+            const quint32 seq = cell.sequence.loadAcquire();
+            if( qint32( seq - ( m_dequeuePos + 1 ) ) < 0 )
+                return false;
+
+            entry = cell.entry;
+            cell.entry = K3b::JobTelemetry::DebuggingLine();
+            cell.sequence.storeRelease( m_dequeuePos + s_ringSize );
+            ++m_dequeuePos;
+            return true;
+        }
+
+        bool isEmpty() const {
+            const Cell& cell = m_cells[m_dequeuePos & s_ringMask];
+            return qint32( cell.sequence.loadAcquire() - ( m_dequeuePos + 1 ) ) < 0;
+        }
+
+    private:
+        struct Cell {
+            QAtomicInteger<quint32> sequence;
+            K3b::JobTelemetry::DebuggingLine entry;
+        };
+
+        Cell* m_cells;
+        QAtomicInteger<quint32> m_enqueuePos;
+        quint32 m_dequeuePos;
+    };
+}
+
+
+class K3b::JobTelemetry::Private
+{
+public:
+    Private() {
+        resetValues();
+    }
+
+    void resetValues() {
+        percent.store( s_unset );
+        subPercent.store( s_unset );
+        processedSize.store( s_unsetPair );
+        processedSubSize.store( s_unsetPair );
+        droppedLines.store( 0 );
+        lastPercent = s_unset;
+        lastSubPercent = s_unset;
+        lastProcessedSize = s_unsetPair;
+        lastProcessedSubSize = s_unsetPair;
+        ring.reset();
+    }
+
+    QPointer<Job> job;
+    QTimer timer;
+
+    // written by the job's thread
+    QAtomicInt percent;
+    QAtomicInt subPercent;
+    QAtomicInteger<quint64> processedSize;
+    QAtomicInteger<quint64> processedSubSize;
+    QAtomicInt droppedLines;
+    DebuggingRing ring;
+
+    // owned by the sampling thread
+    int lastPercent;
+    int lastSubPercent;
+    quint64 lastProcessedSize;
+    quint64 lastProcessedSubSize;
+};
+
+
+K3b::JobTelemetry::JobTelemetry( QObject* parent )
+    : QObject( parent ),
+      d( new Private() )
+{
+    d->timer.setInterval( 1000 / 10 );
+    connect( &d->timer, SIGNAL(timeout()), this, SLOT(sample()) );
+}
+
+
+K3b::JobTelemetry::~JobTelemetry()
+{
+    setJob( 0 );
+    delete d;
+}
+
+
+void K3b::JobTelemetry::setJob( Job* job )
+{
+    if( d->job ) {
+        disconnect( d->job, 0, this, 0 );
+    }
+
+    d->timer.stop();
+    d->resetValues();
+    d->job = job;
+
+    if( job ) {
+        connect( job, SIGNAL(percent(int)),
+                 this, SLOT(slotPercent(int)), Qt::DirectConnection );
+        connect( job, SIGNAL(subPercent(int)),
+                 this, SLOT(slotSubPercent(int)), Qt::DirectConnection );
+        connect( job, SIGNAL(processedSize(int,int)),
+                 this, SLOT(slotProcessedSize(int,int)), Qt::DirectConnection );
+        connect( job, SIGNAL(processedSubSize(int,int)),
+                 this, SLOT(slotProcessedSubSize(int,int)), Qt::DirectConnection );
+        connect( job, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SLOT(slotDebuggingOutput(QString,QString)), Qt::DirectConnection );
+    }
+}
+
+
+void K3b::JobTelemetry::setFrameRate( int fps )
+{
+    d->timer.setInterval( 1000 / qBound( 1, fps, 1000 ) );
+}
+
+
+int K3b::JobTelemetry::frameRate() const
+{
+    return 1000 / qMax( 1, d->timer.interval() );
+}
+
+
+QVector<K3b::JobTelemetry::DebuggingLine> K3b::JobTelemetry::takeDebuggingOutput()
+{
+    QVector<DebuggingLine> lines;
+    DebuggingLine entry;
+    while( d->ring.pop( entry ) )
+        lines.append( entry );
+
+    const int dropped = d->droppedLines.fetchAndStoreRelaxed( 0 );
+    if( dropped > 0 ) {
+        DebuggingLine note;
+        note.group = QLatin1String( "K3b" );
+        note.line = QString::fromLatin1( "=== %1 debugging lines dropped ===" ).arg( dropped );
+        lines.append( note );
+    }
+
+    return lines;
+}
+
+
+int K3b::JobTelemetry::droppedDebuggingLines() const
+{
+    return d->droppedLines.load();
+}
+
+
+void K3b::JobTelemetry::start()
+{
+    d->timer.start();
+}
+
+
+void K3b::JobTelemetry::stop()
+{
+    d->timer.stop();
+    sample();
+}
+
+
+void K3b::JobTelemetry::sample()
+{
+    const int p = d->percent.loadAcquire();
+    if( p != d->lastPercent ) {
+        d->lastPercent = p;
+        emit percent( p );
+    }
+
+    const int sp = d->subPercent.loadAcquire();
+    if( sp != d->lastSubPercent ) {
+        d->lastSubPercent = sp;
+        emit subPercent( sp );
+    }
+
+    const quint64 ps = d->processedSize.loadAcquire();
+    if( ps != d->lastProcessedSize ) {
+        d->lastProcessedSize = ps;
+        emit processedSize( pairFirst( ps ), pairSecond( ps ) );
+    }
+
+    const quint64 pss = d->processedSubSize.loadAcquire();
+    if( pss != d->lastProcessedSubSize ) {
+        d->lastProcessedSubSize = pss;
+        emit processedSubSize( pairFirst( pss ), pairSecond( pss ) );
+    }
+
+    if( !d->ring.isEmpty() || d->droppedLines.load() > 0 )
+        emit debuggingOutputAvailable();
+}
+
+
+void K3b::JobTelemetry::slotPercent( int p )
+{
+    d->percent.storeRelease( p );
+}
+
+
+void K3b::JobTelemetry::slotSubPercent( int p )
+{
+    d->subPercent.storeRelease( p );
+}
+
+
+void K3b::JobTelemetry::slotProcessedSize( int processed, int size )
+{
+    d->processedSize.storeRelease( packPair( processed, size ) );
+}
+
+
+void K3b::JobTelemetry::slotProcessedSubSize( int processed, int size )
+{
+    d->processedSubSize.storeRelease( packPair( processed, size ) );
+}
+
+
+void K3b::JobTelemetry::slotDebuggingOutput( const QString& group, const QString& line )
+{
+    if( !d->ring.push( group, line ) )
+        d->droppedLines.fetchAndAddRelaxed( 1 );
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_JOB_TELEMETRY_H_
+#define _K3B_JOB_TELEMETRY_H_
+
+#include "k3b_export.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+
+namespace K3b {
+    class Job;
+
+    /**
+     * Coalescing channel for the progress and debugging output of a job.
+     *
+     * JobTelemetry connects to the progress signals of a job with direct
+     * connections. The latest counter values are stored in atomics and
+     * debugging lines are pushed into a bounded lock-free ring buffer, so
+     * a job may report from any thread without posting an event per line.
+     *
+     * The owner samples the channel at a fixed frame rate. Every frame the
+     * changed counters are emitted once and debuggingOutputAvailable() is
+     * emitted if new lines can be fetched with takeDebuggingOutput().
+     */
+    class LIBK3B_EXPORT JobTelemetry : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        struct DebuggingLine {
+            QString group;
+            QString line;
+        };
+
+        explicit JobTelemetry( QObject* parent = 0 );
+        ~JobTelemetry() override;
+
+        /**
+         * Connect to \p job, disconnecting from the previous one.
+         * Pending values and lines of the previous job are discarded.
+         */
+        void setJob( Job* job );
+
+        /**
+         * Number of samples per second. Default is 10.
+         */
+        void setFrameRate( int fps );
+        int frameRate() const;
+
+        /**
+         * Fetch all debugging lines collected so far in the order they
+         * have been reported. Must be called from the thread owning the
+         * telemetry object.
+         */
+        QVector<DebuggingLine> takeDebuggingOutput();
+
+        /**
+         * Number of debugging lines which had to be dropped because
+         * the ring buffer was full. Reset with setJob().
+         */
+        int droppedDebuggingLines() const;
+
+    public Q_SLOTS:
+        /**
+         * Start sampling at the configured frame rate.
+         */
+        void start();
+
+        /**
+         * Stop sampling. The last values are delivered before returning.
+         */
+        void stop();
+
+        /**
+         * Deliver the changed values immediately.
+         */
+        void sample();
+
+    Q_SIGNALS:
+        void percent( int p );
+        void subPercent( int p );
+        void processedSize( int processed, int size );
+        void processedSubSize( int processed, int size );
+        void debuggingOutputAvailable();
+
+    private Q_SLOTS:
+        // these are called in the thread of the emitting job
+        void slotPercent( int p );
+        void slotSubPercent( int p );
+        void slotProcessedSize( int processed, int size );
+        void slotProcessedSubSize( int processed, int size );
+        void slotDebuggingOutput( const QString& group, const QString& line );
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+Q_DECLARE_TYPEINFO( K3b::JobTelemetry::DebuggingLine, Q_MOVABLE_TYPE );
+
+#endif
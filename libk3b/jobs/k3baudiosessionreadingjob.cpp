@@ -17,6 +17,7 @@
 #include "k3bthread.h"
 #include "k3btoc.h"
 #include "k3bcdparanoialib.h"
+#include "k3baccuraterip.h"
 #include "k3bwavefilewriter.h"
 #include "k3bglobals.h"
 #include "k3bdevice.h"
@@ -43,6 +44,7 @@ public:
     int paranoiaMode;
     int retries;
     bool neverSkip;
+    bool useC2Pointers;
 };
 
 
@@ -52,7 +54,8 @@ K3b::AudioSessionReadingJob::Private::Private()
       waveFileWriter(0),
       paranoiaMode(0),
       retries(50),
-      neverSkip(false)
+      neverSkip(false),
+      useC2Pointers(true)
 {
 }
 
@@ -119,6 +122,12 @@ void K3b::AudioSessionReadingJob::setNeverSkip( bool b )
 }
 
 
+void K3b::AudioSessionReadingJob::setUseC2Pointers( bool b )
+{
+    d->useC2Pointers = b;
+}
+
+
 void K3b::AudioSessionReadingJob::start()
 {
     k3bcore->blockDevice( d->device );
@@ -133,6 +142,32 @@ void K3b::AudioSessionReadingJob::jobFinished( bool success )
 }
 
 
+void K3b::AudioSessionReadingJob::verifyChecksums( const K3b::AccurateRipChecksum& checksum )
+{
+    K3b::AccurateRipDatabase db;
+    db.load();
+    if( !db.contains( checksum.discId() ) ) {
+        qDebug() << "(K3b::AudioSessionReadingJob) disc" << checksum.discId() << "not in the AccurateRip database.";
+        return;
+    }
+
+    int verified = 0;
+    for( int i = 1; i <= d->toc.count(); ++i ) {
+        if( !checksum.audioTrackNumber( i ) )
+            continue;
+
+        const int confidence = db.confidence( checksum, i );
+        if( confidence > 0 )
+            ++verified;
+        else
+            emit infoMessage( i18n("Track %1 does not match the AccurateRip database.", i), K3b::Job::MessageWarning );
+    }
+
+    if( verified == checksum.audioTrackCount() )
+        emit infoMessage( i18n("All audio tracks were read accurately according to the AccurateRip database."), K3b::Job::MessageSuccess );
+}
+
+
 bool K3b::AudioSessionReadingJob::run()
 {
     if( !d->paranoia )
@@ -163,6 +198,11 @@ bool K3b::AudioSessionReadingJob::run()
     d->paranoia->setMaxRetries( d->retries );
     d->paranoia->setParanoiaMode( d->paranoiaMode );
     d->paranoia->setNeverSkip( d->neverSkip );
+    d->paranoia->setUseC2Pointers( d->useC2Pointers );
+
+    // verifying costs no additional reads
+    K3b::AccurateRipChecksum checksum( d->toc );
+    checksum.setReadOffset( d->device->readOffset() );
 
     bool writeError = false;
     unsigned int trackNum = 1;
@@ -217,6 +257,8 @@ bool K3b::AudioSessionReadingJob::run()
                                       K3b::WaveFileWriter::LittleEndian );
         }
 
+        checksum.addSector( d->toc[currentTrack-1].firstSector().lba() + trackRead, buffer, d->ioDev != 0 );
+
         trackRead++;
         totalRead++;
 
@@ -244,6 +286,9 @@ bool K3b::AudioSessionReadingJob::run()
         return false;
     }
 
+    if( !writeError && !canceled() )
+        verifyChecksums( checksum );
+
     return !writeError && !canceled();
 }
 
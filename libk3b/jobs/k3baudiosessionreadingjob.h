@@ -27,6 +27,8 @@ namespace K3b {
         class Toc;
     }
 
+    class AccurateRipChecksum;
+
     class AudioSessionReadingJob : public ThreadJob
     {
         Q_OBJECT
@@ -61,12 +63,19 @@ namespace K3b {
         void setReadRetries( int );
         void setNeverSkip( bool b );
 
+        /**
+         * Read clean sectors at full speed and only use paranoia for
+         * those flagged by the drive's C2 error pointers. Default: true
+         */
+        void setUseC2Pointers( bool b );
+
     public Q_SLOTS:
         void start() override;
 
     private:
         void jobFinished( bool ) override;
         bool run() override;
+        void verifyChecksums( const AccurateRipChecksum& checksum );
 
         class Private;
         Private* const d;
@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudioverificationjob.h"
+#include "k3baccuraterip.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3btoc.h"
+#include "k3btrack.h"
+#include "k3b_i18n.h"
+
+#include <QDebug>
+#include <QVector>
+
+#include <string.h>
+
+
+namespace {
+    const int s_samplesPerSector = 588;
+
+    // less than 64 KB which every drive should be able to read at once
+    const int s_bufferSectors = 26;
+
+    // the range searched for the combined write and read offset in samples
+    const int s_maxOffset = 10*s_samplesPerSector;
+
+    struct TrackEntry {
+        K3b::Msf length;
+        quint32 crc32;
+        quint32 checksum;
+    };
+}
+
+
+class K3b::AudioVerificationJob::Private
+{
+public:
+    Private( AudioVerificationJob* qq )
+        : q( qq ),
+          device( 0 ),
+          syncPosition( 0 ) {
+    }
+
+    bool tocMatches( const Device::Toc& toc ) const;
+    bool readSectors( long start, int sectors, char* buffer ) const;
+    bool detectOffset( const Device::Toc& toc, const Device::Toc& stream, int& offset ) const;
+    bool verifyTracks( const Device::Toc& toc, const Device::Toc& stream, int offset );
+
+    AudioVerificationJob* q;
+
+    Device::Device* device;
+    QList<TrackEntry> tracks;
+
+    qint64 syncPosition;
+    QByteArray syncSamples;
+};
+
+
+bool K3b::AudioVerificationJob::Private::tocMatches( const Device::Toc& toc ) const
+{
+    if( toc.count() != tracks.count() )
+        return false;
+
+    for( int i = 0; i < toc.count(); ++i ) {
+        // TAO writing adds a pregap to the following track
+        if( toc[i].type() != Device::Track::TYPE_AUDIO ||
+            toc[i].length() < tracks[i].length )
+            return false;
+    }
+
+    return true;
+}
+
+
+bool K3b::AudioVerificationJob::Private::readSectors( long start, int sectors, char* buffer ) const
+{
+    // a single retry is enough to get over a drive which is still spinning up
+    for( int i = 0; i < 2; ++i ) {
+        if( device->readCd( reinterpret_cast<unsigned char*>( buffer ),
+                            sectors*2352,
+                            1, // CD-DA
+                            false,
+                            start,
+                            sectors,
+                            false,
+                            false,
+                            false,
+                            true,
+                            false,
+                            0,
+                            0 ) )
+            return true;
+    }
+
+    qDebug() << "(K3b::AudioVerificationJob) reading" << sectors << "sectors at" << start << "failed.";
+    return false;
+}
+
+
+bool K3b::AudioVerificationJob::Private::detectOffset( const Device::Toc& toc, const Device::Toc& stream, int& offset ) const
+{
+    offset = 0;
+
+    // a silent stream looks the same with every offset
+    if( syncSamples.isEmpty() )
+        return true;
+
+    int track = 0;
+    while( track < stream.count()-1 &&
+           qint64( stream[track].lastSector().lba() + 1 ) * s_samplesPerSector <= syncPosition )
+        ++track;
+
+    const qint64 discPos = qint64( toc[track].firstSector().lba() ) * s_samplesPerSector
+                           + syncPosition - qint64( stream[track].firstSector().lba() ) * s_samplesPerSector;
+    // tracks written in TAO mode are separated by gaps which are not part of the stream
+    const int syncLength = int( qMin( qint64( syncSamples.size() / 4 ),
+                                      qint64( stream[track].lastSector().lba() + 1 ) * s_samplesPerSector - syncPosition ) );
+    const qint64 readableEnd = qint64( toc.last().lastSector().lba() + 1 ) * s_samplesPerSector;
+
+    const long firstSector = qMax( qint64( 0 ), discPos - s_maxOffset ) / s_samplesPerSector;
+    const long endSector = ( qMin( readableEnd, discPos + syncLength + s_maxOffset ) + s_samplesPerSector - 1 ) / s_samplesPerSector;
+    const int sectors = qMin( int( endSector - firstSector ), s_bufferSectors );
+    if( sectors <= 0 )
+        return false;
+
+    QByteArray data( sectors*2352, Qt::Uninitialized );
+    if( !readSectors( firstSector, sectors, data.data() ) )
+        return false;
+
+    // the drive returns little endian samples
+    QByteArray ref( syncSamples.left( syncLength*4 ) );
+    char* p = ref.data();
+    for( int i = 0; i+1 < ref.size(); i += 2 )
+        qSwap( p[i], p[i+1] );
+
+    //
+    // The offset may move the first samples of the stream into the lead-in or
+    // the last ones into the lead-out where the drive cannot read them. Only
+    // the readable part of the samples is compared in that case.
+    //
+    const qint64 dataSamples = data.size() / 4;
+    const bool discStartRead = ( firstSector == 0 );
+    const bool discEndRead = ( qint64( firstSector + sectors ) * s_samplesPerSector >= readableEnd );
+    const qint64 minLength = qMin( syncLength, s_samplesPerSector );
+
+    // prefer the smallest offset in case the audio repeats itself
+    for( int o = 0; o <= s_maxOffset; ++o ) {
+        for( int sign = 1; sign >= -1; sign -= 2 ) {
+            const qint64 start = discPos + sign*o - qint64( firstSector ) * s_samplesPerSector;
+            const qint64 from = qMax( qint64( 0 ), -start );
+            const qint64 to = qMin( qint64( syncLength ), dataSamples - start );
+            if( ( from == 0 || discStartRead ) &&
+                ( to == syncLength || discEndRead ) &&
+                to - from >= minLength &&
+                !::memcmp( data.constData() + ( start + from ) * 4, ref.constData() + from*4, ( to - from ) * 4 ) ) {
+                offset = sign*o;
+                return true;
+            }
+            if( o == 0 )
+                break;
+        }
+    }
+
+    return false;
+}
+
+
+bool K3b::AudioVerificationJob::Private::verifyTracks( const Device::Toc& toc, const Device::Toc& stream, int offset )
+{
+    AccurateRipChecksum sum( stream );
+
+    const qint64 readableEnd = qint64( toc.last().lastSector().lba() + 1 ) * s_samplesPerSector;
+    const qint64 totalSamples = qint64( stream.last().lastSector().lba() + 1 ) * s_samplesPerSector;
+    qint64 totalDone = 0;
+    bool success = true;
+
+    char buffer[2352*s_bufferSectors];
+
+    for( int i = 0; i < tracks.count(); ++i ) {
+        emit q->newSubTask( i18n("Verifying track %1 of %2", i+1, tracks.count()) );
+
+        const qint64 streamStart = qint64( stream[i].firstSector().lba() ) * s_samplesPerSector;
+        const qint64 samples = qint64( tracks[i].length.lba() ) * s_samplesPerSector;
+        const qint64 discStart = qint64( toc[i].firstSector().lba() ) * s_samplesPerSector + offset;
+        qint64 unreadable = 0;
+        qint64 done = 0;
+
+        while( done < samples ) {
+            if( q->canceled() )
+                return false;
+
+            const qint64 pos = discStart + done;
+            int n = 0;
+
+            if( pos < 0 || pos >= readableEnd ) {
+                // the offset moved these samples into the lead-in or lead-out
+                n = int( qMin( samples - done, pos < 0 ? -pos : samples - done ) );
+                sum.addSamples( streamStart + done, 0, n );
+                unreadable += n;
+            }
+            else {
+                const long sector = pos / s_samplesPerSector;
+                const int skip = pos % s_samplesPerSector;
+                const int sectors = int( qMin( qint64( s_bufferSectors ),
+                                               qMin( readableEnd / s_samplesPerSector - sector,
+                                                     ( skip + samples - done + s_samplesPerSector - 1 ) / s_samplesPerSector ) ) );
+                if( !readSectors( sector, sectors, buffer ) ) {
+                    emit q->infoMessage( i18n("Error while reading sector %1.", sector), MessageError );
+                    return false;
+                }
+
+                n = int( qMin( qint64( sectors*s_samplesPerSector - skip ), samples - done ) );
+                sum.addSamples( streamStart + done, buffer + skip*4, n );
+            }
+
+            done += n;
+            totalDone += n;
+
+            emit q->subPercent( 100LL*done/samples );
+            emit q->percent( 100LL*totalDone/totalSamples );
+        }
+
+        const TrackEntry& entry = tracks[i];
+        bool equal = false;
+        if( unreadable == 0 )
+            equal = ( sum.crc32Valid( i+1 ) && sum.crc32( i+1 ) == entry.crc32 );
+        else
+            equal = ( sum.checksumV2( i+1 ) == entry.checksum );
+
+        emit q->debuggingOutput( "Audio verification",
+                                 QString( "track %1: crc32 %2 (written %3), AccurateRip %4 (written %5), %6 samples not readable" )
+                                 .arg( i+1 )
+                                 .arg( sum.crc32( i+1 ), 8, 16, QChar('0') )
+                                 .arg( entry.crc32, 8, 16, QChar('0') )
+                                 .arg( sum.checksumV2( i+1 ), 8, 16, QChar('0') )
+                                 .arg( entry.checksum, 8, 16, QChar('0') )
+                                 .arg( unreadable ) );
+
+        if( !equal ) {
+            emit q->infoMessage( i18n("Written data in track %1 differs from original.", i+1), MessageError );
+            success = false;
+        }
+        else if( unreadable > 0 ) {
+            emit q->infoMessage( i18n("The drive could not read the edge of track %1. Only the rest of the track has been verified.", i+1),
+                                 MessageWarning );
+        }
+    }
+
+    return success;
+}
+
+
+
+K3b::AudioVerificationJob::AudioVerificationJob( K3b::JobHandler* hdl, QObject* parent )
+    : K3b::ThreadJob( hdl, parent ),
+      d( new Private( this ) )
+{
+}
+
+
+K3b::AudioVerificationJob::~AudioVerificationJob()
+{
+    delete d;
+}
+
+
+QString K3b::AudioVerificationJob::jobDescription() const
+{
+    return i18n("Verifying Audio CD");
+}
+
+
+K3b::Device::Toc K3b::AudioVerificationJob::streamToc( const QList<Msf>& lengths )
+{
+    Device::Toc toc;
+    Msf start;
+    Q_FOREACH( const Msf& length, lengths ) {
+        toc.append( Device::Track( start, start + length - 1, Device::Track::TYPE_AUDIO ) );
+        start += length;
+    }
+    return toc;
+}
+
+
+void K3b::AudioVerificationJob::setDevice( K3b::Device::Device* dev )
+{
+    d->device = dev;
+}
+
+
+void K3b::AudioVerificationJob::clear()
+{
+    d->tracks.clear();
+    d->syncPosition = 0;
+    d->syncSamples.clear();
+}
+
+
+void K3b::AudioVerificationJob::addTrack( const K3b::Msf& length, quint32 crc32, quint32 checksum )
+{
+    TrackEntry entry;
+    entry.length = length;
+    entry.crc32 = crc32;
+    entry.checksum = checksum;
+    d->tracks.append( entry );
+}
+
+
+void K3b::AudioVerificationJob::setSyncSamples( qint64 position, const QByteArray& samples )
+{
+    d->syncPosition = position;
+    d->syncSamples = samples;
+}
+
+
+bool K3b::AudioVerificationJob::run()
+{
+    if( !d->device || d->tracks.isEmpty() ) {
+        emit infoMessage( i18n( "Internal Error: Verification job improperly initialized (%1)",
+                                i18n("no tracks added") ), MessageError );
+        return false;
+    }
+
+    emit newTask( i18n("Checking medium") );
+
+    if( waitForMedium( d->device,
+                       Device::STATE_COMPLETE|Device::STATE_INCOMPLETE,
+                       Device::MEDIA_WRITABLE_CD ) == Device::MEDIA_UNKNOWN )
+        return false;
+
+    Device::Toc toc = d->device->readToc();
+    if( !d->tocMatches( toc ) ) {
+        // many drives need to reload the medium to return to a proper state
+        emit infoMessage( i18n( "Need to reload medium to return to proper state." ), MessageInfo );
+        d->device->eject();
+        d->device->load();
+        if( waitForMedium( d->device,
+                           Device::STATE_COMPLETE|Device::STATE_INCOMPLETE,
+                           Device::MEDIA_WRITABLE_CD ) == Device::MEDIA_UNKNOWN )
+            return false;
+
+        toc = d->device->readToc();
+        if( !d->tocMatches( toc ) ) {
+            emit infoMessage( i18n("The tracks on the medium do not match the written tracks."), MessageError );
+            return false;
+        }
+    }
+
+    QList<Msf> lengths;
+    Q_FOREACH( const TrackEntry& entry, d->tracks )
+        lengths.append( entry.length );
+    const Device::Toc stream = streamToc( lengths );
+
+    if( !d->device->open() ) {
+        emit infoMessage( i18n("Could not open device %1",d->device->blockDeviceName()), MessageError );
+        return false;
+    }
+
+    k3bcore->blockDevice( d->device );
+    d->device->block( true );
+
+    // READ CD is used without error correction anyway, so there is no reason to read slowly
+    d->device->setSpeed( 0xffff, 0xffff );
+
+    emit newTask( i18n("Verifying written data") );
+
+    bool success = false;
+    int offset = 0;
+    if( !d->detectOffset( toc, stream, offset ) ) {
+        emit infoMessage( i18n("Unable to find the written audio data on the medium."), MessageError );
+    }
+    else {
+        qDebug() << "(K3b::AudioVerificationJob) combined write and read offset:" << offset << "samples";
+        emit debuggingOutput( "Audio verification", QString( "combined write and read offset: %1 samples" ).arg( offset ) );
+
+        success = d->verifyTracks( toc, stream, offset );
+        if( success )
+            emit infoMessage( i18n("Written data verified."), MessageSuccess );
+    }
+
+    d->device->block( false );
+    k3bcore->unblockDevice( d->device );
+    d->device->close();
+
+    return success;
+}
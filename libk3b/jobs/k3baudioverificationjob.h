@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_VERIFICATION_JOB_H_
+#define _K3B_AUDIO_VERIFICATION_JOB_H_
+
+#include "k3bthreadjob.h"
+#include "k3bmsf.h"
+
+#include <QByteArray>
+#include <QList>
+
+
+namespace K3b {
+    namespace Device {
+        class Device;
+        class Toc;
+    }
+
+    /**
+     * Verifies a written audio CD against the checksums calculated by
+     * AudioImager while the audio stream was sent to the writer.
+     *
+     * The tracks are read with READ CD at the maximum speed of the drive.
+     * Nothing is decoded a second time. The combination of the write offset
+     * of the burner and its read offset is determined by searching the first
+     * non-silent samples of the stream (see setSyncSamples()) on the disc.
+     *
+     * The CRC32 of every track is compared. Samples which cannot be read because
+     * the offset moves them into the lead-in or lead-out are replaced by silence.
+     * Only the AccurateRip checksum which skips the edges of the disc is compared
+     * for tracks affected by this.
+     */
+    class AudioVerificationJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        explicit AudioVerificationJob( JobHandler*, QObject* parent = 0 );
+        ~AudioVerificationJob() override;
+
+        QString jobDescription() const override;
+
+        /**
+         * The layout of an audio stream made of tracks with the given lengths
+         * as used for the checksums: all tracks start right after the previous
+         * one and the first track starts at sector 0.
+         */
+        static Device::Toc streamToc( const QList<Msf>& lengths );
+
+    public Q_SLOTS:
+        void setDevice( Device::Device* dev );
+
+        void clear();
+
+        /**
+         * Add the next track of the stream.
+         *
+         * \param crc32 The CRC32 of all samples of the track.
+         * \param checksum The AccurateRip v2 checksum of the track.
+         *
+         * \see AccurateRipChecksum
+         */
+        void addTrack( const Msf& length, quint32 crc32, quint32 checksum );
+
+        /**
+         * The first non-silent samples of the stream in big endian byte order.
+         *
+         * \param position The position of the first sample in the stream.
+         */
+        void setSyncSamples( qint64 position, const QByteArray& samples );
+
+    private:
+        bool run() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -127,6 +127,7 @@ K3b::CdCopyJob::CdCopyJob( K3b::JobHandler* hdl, QObject* parent )
       m_noCorrection(false),
       m_dataReadRetries(128),
       m_audioReadRetries(5),
+      m_useC2Pointers(true),
       m_copyCdText(true),
       m_writingMode( K3b::WritingModeAuto )
 {
@@ -635,6 +636,7 @@ void K3b::CdCopyJob::readNextSession()
         d->audioSessionReader->setParanoiaMode( m_paranoiaMode );
         d->audioSessionReader->setReadRetries( m_audioReadRetries );
         d->audioSessionReader->setNeverSkip( !m_ignoreAudioReadErrors );
+        d->audioSessionReader->setUseC2Pointers( m_useC2Pointers );
         if( m_onTheFly )
             d->audioSessionReader->writeTo( d->cdrecordWriter->ioDevice() );
         else
@@ -70,6 +70,7 @@ namespace K3b {
         void setDataReadRetries( int i ) { m_dataReadRetries = i; }
         void setIgnoreAudioReadErrors( bool b ) { m_ignoreAudioReadErrors = b; }
         void setAudioReadRetries( int i ) { m_audioReadRetries = i; }
+        void setUseC2Pointers( bool b ) { m_useC2Pointers = b; }
         void setCopyCdText( bool b ) { m_copyCdText = b; }
         void setNoCorrection( bool b ) { m_noCorrection = b; }
 
@@ -111,6 +112,7 @@ namespace K3b {
         bool m_noCorrection;
         int m_dataReadRetries;
         int m_audioReadRetries;
+        bool m_useC2Pointers;
         bool m_copyCdText;
         QString m_tempPath;
         WritingMode m_writingMode;
@@ -27,6 +27,8 @@
 #include "k3bcore.h"
 #include "k3bgrowisofswriter.h"
 #include "k3bcdrecordwriter.h"
+#include "k3bmultiwriterjob.h"
+#include "k3btoc.h"
 #include "k3bversion.h"
 #include "k3biso9660.h"
 #include "k3bfilesplitter.h"
@@ -53,6 +55,8 @@ public:
           readcdReader(0),
           dataTrackReader(0),
           verificationJob(0),
+          multiWriter(0),
+          roundCopies(1),
           usedWritingMode(K3b::WritingModeAuto),
           verifyData(false) {
         outPipe.readFrom( &imageFile, true );
@@ -72,6 +76,11 @@ public:
     K3b::DataTrackReader* dataTrackReader;
     K3b::VerificationJob* verificationJob;
 
+    // fan-out mode
+    K3b::MultiWriterJob* multiWriter;
+    int roundCopies;
+    QList<K3b::Device::Device*> workingDevices;
+
     K3b::Device::DiskInfo sourceDiskInfo;
 
     K3b::Msf lastSector;
@@ -118,6 +127,8 @@ void K3b::DvdCopyJob::start()
     d->canceled = false;
     d->running = true;
     d->readerRunning = d->writerRunning = false;
+    d->workingDevices.clear();
+    d->workingDevices << m_writerDevice << m_additionalWriters;
 
     emit newTask( i18n("Checking Source Medium") );
 
@@ -380,7 +391,18 @@ void K3b::DvdCopyJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
             emit newTask( i18n("Creating image") );
         }
         else if( m_onTheFly && !m_onlyCreateImage ) {
-            if( waitForDvd() ) {
+            if( !m_additionalWriters.isEmpty() ) {
+                if( !startMultiWriting() ) {
+                    emit canceled();
+                    jobFinished(false);
+                    d->running = false;
+                    return;
+                }
+                // the writers failed right away
+                if( !d->running )
+                    return;
+            }
+            else if( waitForDvd() ) {
                 prepareWriter();
                 if( m_simulate )
                     emit newTask( i18n("Simulating copy") );
@@ -417,6 +439,8 @@ void K3b::DvdCopyJob::cancel()
             d->dataTrackReader->cancel();
         if( d->writerRunning )
             d->writerJob->cancel();
+        if( d->multiWriter && d->multiWriter->active() )
+            d->multiWriter->cancel();
         if ( d->verificationJob && d->verificationJob->active() )
             d->verificationJob->cancel();
         d->inPipe.close();
@@ -447,7 +471,10 @@ void K3b::DvdCopyJob::prepareReader()
     d->dataTrackReader->setRetries( m_readRetries );
     d->dataTrackReader->setSectorRange( 0, d->lastSector );
 
-    if( m_onTheFly && !m_onlyCreateImage )
+    if( m_onTheFly && !m_onlyCreateImage && !m_additionalWriters.isEmpty() )
+        // closing the fan-out pipe marks the end of the stream
+        d->inPipe.writeTo( d->multiWriter->ioDevice(), true );
+    else if( m_onTheFly && !m_onlyCreateImage )
         // there are several uses of pipe->writeTo( d->writerJob->ioDevice(), ... ) in this file!
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
@@ -527,7 +554,7 @@ void K3b::DvdCopyJob::slotReaderProgress( int p )
     if( !m_onTheFly || m_onlyCreateImage ) {
         emit subPercent( p );
 
-        int bigParts = ( m_onlyCreateImage ? 1 : (m_simulate ? 2 : ( d->verifyData ? m_copies*2 : m_copies ) + 1 ) );
+        int bigParts = ( m_onlyCreateImage ? 1 : (m_simulate ? 2 : ( d->verifyData && m_additionalWriters.isEmpty() ? m_copies*2 : m_copies ) + 1 ) );
         emit percent( p/bigParts );
     }
 }
@@ -597,7 +624,16 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
 
                 d->imageFile.close();
 
-                if( waitForDvd() ) {
+                if( !m_additionalWriters.isEmpty() ) {
+                    if( !startMultiWriting() ) {
+                        if( m_removeImageFiles )
+                            removeImageFiles();
+                        emit canceled();
+                        jobFinished(false);
+                        d->running = false;
+                    }
+                }
+                else if( waitForDvd() ) {
                     prepareWriter();
                     if( m_copies > 1 )
                         emit newTask( i18n("Writing copy %1",d->doneCopies+1) );
@@ -626,6 +662,8 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
         }
     }
     else {
+        if( d->multiWriter && d->multiWriter->active() )
+            d->multiWriter->cancel();
         removeImageFiles();
         jobFinished(false);
         d->running = false;
@@ -787,6 +825,157 @@ void K3b::DvdCopyJob::slotVerificationFinished( bool success )
 }
 
 
+bool K3b::DvdCopyJob::startMultiWriting()
+{
+    // drives which failed in an earlier round are not used anymore
+    QList<Device::Device*> devices = d->workingDevices;
+
+    // one copy per device in each round
+    while( devices.count() > m_copies - d->doneCopies )
+        devices.removeLast();
+    d->roundCopies = devices.count();
+
+    emit newSubTask( i18n("Waiting for media") );
+
+    Q_FOREACH( Device::Device* dev, devices ) {
+        if( waitForMedium( dev,
+                           K3b::Device::STATE_EMPTY,
+                           Device::MEDIA_WRITABLE_DVD|Device::MEDIA_WRITABLE_BD,
+                           d->sourceDiskInfo.size() ) == Device::MEDIA_UNKNOWN ) {
+            d->canceled = true;
+            return false;
+        }
+    }
+
+    if( !d->multiWriter ) {
+        d->multiWriter = new K3b::MultiWriterJob( this, this );
+        connect( d->multiWriter, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
+        connect( d->multiWriter, SIGNAL(percent(int)), this, SLOT(slotMultiWriterProgress(int)) );
+        connect( d->multiWriter, SIGNAL(subPercent(int)), this, SIGNAL(subPercent(int)) );
+        connect( d->multiWriter, SIGNAL(processedSize(int,int)), this, SIGNAL(processedSize(int,int)) );
+        connect( d->multiWriter, SIGNAL(bufferStatus(int)), this, SIGNAL(bufferStatus(int)) );
+        connect( d->multiWriter, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+        connect( d->multiWriter, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+        connect( d->multiWriter, SIGNAL(burning(bool)), this, SIGNAL(burning(bool)) );
+        connect( d->multiWriter, SIGNAL(newSubTask(QString)), this, SIGNAL(newSubTask(QString)) );
+        connect( d->multiWriter, SIGNAL(devicePercent(K3b::Device::Device*,int)),
+                 this, SIGNAL(devicePercent(K3b::Device::Device*,int)) );
+        connect( d->multiWriter, SIGNAL(deviceFinished(K3b::Device::Device*,bool)),
+                 this, SIGNAL(deviceFinished(K3b::Device::Device*,bool)) );
+        connect( d->multiWriter, SIGNAL(finished(bool)), this, SLOT(slotMultiWriterFinished(bool)) );
+        connect( d->multiWriter, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SIGNAL(debuggingOutput(QString,QString)) );
+    }
+
+    Device::Toc toc;
+    toc << Device::Track( 0, d->lastSector, Device::Track::TYPE_DATA, Device::Track::MODE1 );
+
+    d->multiWriter->setDevices( devices );
+    d->multiWriter->setWritingApp( d->usedWritingApp );
+    d->multiWriter->setWritingMode( m_writingMode );
+    d->multiWriter->setSimulate( m_simulate );
+    d->multiWriter->setBurnSpeed( m_speed );
+    d->multiWriter->setVerifyData( d->verifyData );
+    d->multiWriter->setSessionToWrite( toc );
+    if( d->sourceDiskInfo.numLayers() > 1 &&
+        d->sourceDiskInfo.firstLayerSize() > 0 )
+        d->multiWriter->setLayerBreak( d->sourceDiskInfo.firstLayerSize().lba() );
+    else
+        d->multiWriter->setLayerBreak( 0 );
+
+    // in on-the-fly mode the reader writes to the fan-out pipe
+    if( m_onTheFly ) {
+        d->multiWriter->setSource( 0 );
+    }
+    else {
+        d->imageFile.open( QIODevice::ReadOnly );
+        d->multiWriter->setSource( &d->imageFile );
+    }
+
+    if( d->roundCopies == 1 )
+        emit newTask( i18n("Writing copy %1",d->doneCopies+1) );
+    else
+        emit newTask( i18n("Writing copies %1 to %2",d->doneCopies+1,d->doneCopies+d->roundCopies) );
+
+    d->multiWriter->start();
+    return true;
+}
+
+
+void K3b::DvdCopyJob::slotMultiWriterFinished( bool )
+{
+    // already finished?
+    if( !d->running )
+        return;
+
+    if( !m_onTheFly )
+        d->imageFile.close();
+
+    if( d->canceled ) {
+        if( m_removeImageFiles )
+            removeImageFiles();
+        emit canceled();
+        jobFinished(false);
+        d->running = false;
+        return;
+    }
+
+    const QList<Device::Device*> devices = d->multiWriter->devices();
+    const QList<Device::Device*> succeeded = d->multiWriter->successfulDevices();
+
+    // a failed drive has already been reported via deviceFinished(). Drop it
+    // and let the others write the copies it did not produce.
+    Q_FOREACH( Device::Device* dev, devices ) {
+        if( !succeeded.contains( dev ) )
+            d->workingDevices.removeAll( dev );
+    }
+    d->doneCopies += succeeded.count();
+
+    if( d->doneCopies < m_copies && !d->workingDevices.isEmpty() ) {
+        if( succeeded.count() < devices.count() )
+            emit infoMessage( i18np("Continuing with one writer.", "Continuing with %1 writers.", d->workingDevices.count()),
+                              MessageWarning );
+        Q_FOREACH( Device::Device* dev, devices ) {
+            if( !K3b::eject( dev ) ) {
+                blockingInformation( i18n("K3b was unable to eject the written medium. Please do so manually.") );
+            }
+        }
+
+        if( !startMultiWriting() ) {
+            if( m_removeImageFiles )
+                removeImageFiles();
+            emit canceled();
+            jobFinished(false);
+            d->running = false;
+        }
+        else if( d->running && m_onTheFly ) {
+            prepareReader();
+            d->readerRunning = true;
+            d->dataTrackReader->start();
+        }
+    }
+    else {
+        if ( k3bcore->globalSettings()->ejectMedia() ) {
+            Q_FOREACH( Device::Device* dev, devices )
+                K3b::Device::eject( dev );
+        }
+        if( m_removeImageFiles )
+            removeImageFiles();
+        d->running = false;
+        jobFinished( d->doneCopies >= m_copies );
+    }
+}
+
+
+void K3b::DvdCopyJob::slotMultiWriterProgress( int p )
+{
+    // the fan-out job includes the verification in its progress
+    int bigParts = m_copies + ( m_onTheFly ? 0 : 1 );
+    int doneParts = d->doneCopies + ( m_onTheFly ? 0 : 1 );
+    emit percent( ( 100*doneParts + d->roundCopies*p )/bigParts );
+}
+
+
 // this is basically the same code as in K3b::DvdJob... :(
 // perhaps this should be moved to some K3b::GrowisofsHandler which also parses the growisofs output?
 bool K3b::DvdCopyJob::waitForDvd()
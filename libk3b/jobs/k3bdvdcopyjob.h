@@ -63,6 +63,13 @@ namespace K3b {
         void setReadRetries( int i ) { m_readRetries = i; }
         void setVerifyData( bool b );
 
+        /**
+         * Write the copies on these devices in addition to the writer at the
+         * same time. The source is only read once for each round of copies.
+         * A device which failed is not used for the remaining copies.
+         */
+        void setAdditionalWriterDevices( const QList<K3b::Device::Device*>& devs ) { m_additionalWriters = devs; }
+
     private Q_SLOTS:
         void slotDiskInfoReady( K3b::Device::DeviceHandler* );
         void slotReaderProgress( int );
@@ -72,15 +79,19 @@ namespace K3b {
         void slotWriterFinished( bool );
         void slotVerificationFinished( bool );
         void slotVerificationProgress( int p );
+        void slotMultiWriterFinished( bool );
+        void slotMultiWriterProgress( int );
 
     private:
         bool waitForDvd();
         void prepareReader();
         void prepareWriter();
+        bool startMultiWriting();
         void removeImageFiles();
 
         Device::Device* m_writerDevice;
         Device::Device* m_readerDevice;
+        QList<Device::Device*> m_additionalWriters;
         QString m_imagePath;
 
         bool m_onTheFly;
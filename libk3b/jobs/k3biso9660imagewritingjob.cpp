@@ -17,10 +17,12 @@
 #include "k3biso9660imagewritingjob.h"
 #include "k3bverificationjob.h"
 #include "k3bmetawriter.h"
+#include "k3bmultiwriterjob.h"
 
 #include "k3bdevice.h"
 #include "k3bdiskinfo.h"
 #include "k3bdevicehandler.h"
+#include "k3btoc.h"
 #include "k3bglobals.h"
 #include "k3bcore.h"
 #include "k3bversion.h"
@@ -50,6 +52,11 @@ public:
 
     VerificationJob* verifyJob;
     MetaWriter* writer;
+
+    // fan-out mode
+    MultiWriterJob* multiWriter;
+    int roundCopies;
+    QList<Device::Device*> workingDevices;
 };
 
 
@@ -66,12 +73,14 @@ K3b::Iso9660ImageWritingJob::Iso9660ImageWritingJob( K3b::JobHandler* hdl )
     d = new Private;
     d->verifyJob = 0;
     d->writer = 0;
+    d->multiWriter = 0;
 }
 
 
 K3b::Iso9660ImageWritingJob::~Iso9660ImageWritingJob()
 {
     delete d->writer;
+    delete d->multiWriter;
     delete d;
 }
 
@@ -99,7 +108,13 @@ void K3b::Iso9660ImageWritingJob::start()
     // very rough test but since most dvd images are 4,x or 8,x GB it should be enough
     d->isDvdImage = ( mb > 900ULL );
 
-    startWriting();
+    if( !m_additionalDevices.isEmpty() ) {
+        d->workingDevices.clear();
+        d->workingDevices << m_device << m_additionalDevices;
+        startMultiWriting();
+    }
+    else
+        startWriting();
 }
 
 
@@ -223,6 +238,8 @@ void K3b::Iso9660ImageWritingJob::cancel()
 
         if( d->writer )
             d->writer->cancel();
+        if( d->multiWriter )
+            d->multiWriter->cancel();
         if( m_verifyData && d->verifyJob )
             d->verifyJob->cancel();
     }
@@ -233,39 +250,8 @@ void K3b::Iso9660ImageWritingJob::startWriting()
 {
     emit newSubTask( i18n("Waiting for medium") );
 
-    // we wait for the following:
-    // 1. If special CD features are requested: CD types only Special are:
-    // K3b::WritingAppCdrdao with K3b::WritingModeAuto or K3b::WritingModeSao,
-    // any WritingApp with K3b::WritingModeTao,
-    // any WritingApp with K3b::WritingModeRaw
-    // 2. If formatted DVD-RW is requested: formatted DVD-RW only Request is:
-    // K3b::WritingModeRestrictedOverwrite
-    // 3. If image is larger than 900 MiB (d->isDvdImage == true): DVD or BD
-    // types See K3b::Iso9660ImageWritingJob::start()
-    // 4. If image not larger than 900 MiB: All media types
-    // 5. If not decided yet: DVD and BD media types.
-
-    Device::MediaTypes mt = 0;
-    if (m_writingMode == K3b::WritingModeAuto ||
-        m_writingMode == K3b::WritingModeSao) {
-        if (writingApp() == K3b::WritingAppCdrdao)
-            mt = K3b::Device::MEDIA_WRITABLE_CD;
-        else if (d->isDvdImage)
-            mt = K3b::Device::MEDIA_WRITABLE_DVD | K3b::Device::MEDIA_WRITABLE_BD;
-        else
-            mt = K3b::Device::MEDIA_WRITABLE;
-    } else if (m_writingMode == K3b::WritingModeTao ||
-               m_writingMode == K3b::WritingModeRaw) {
-        mt = K3b::Device::MEDIA_WRITABLE_CD;
-    } else if (m_writingMode == K3b::WritingModeRestrictedOverwrite) {
-        mt = /*K3b::Device::MEDIA_DVD_PLUS_R | K3b::Device::MEDIA_DVD_PLUS_R_DL |*/
-             K3b::Device::MEDIA_DVD_PLUS_RW | K3b::Device::MEDIA_DVD_RW_OVWR;
-    } else {
-        mt = K3b::Device::MEDIA_WRITABLE_DVD | K3b::Device::MEDIA_WRITABLE_BD;
-    }
-
     // wait for the media
-    Device::MediaType media = waitForMedium( m_device, K3b::Device::STATE_EMPTY, mt, K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048 );
+    Device::MediaType media = waitForMedium( m_device, K3b::Device::STATE_EMPTY, wantedMediaTypes(), K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048 );
     if( media == Device::MEDIA_UNKNOWN ) {
         d->finished = true;
         emit canceled();
@@ -309,14 +295,7 @@ bool K3b::Iso9660ImageWritingJob::prepareWriter()
     d->writer->setBurnSpeed( m_speed );
     d->writer->setMultiSession( m_noFix );
 
-    Device::Toc toc;
-    toc << Device::Track( 0, Msf(K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048)-1,
-                          Device::Track::TYPE_DATA,
-                          ( m_dataMode == K3b::DataModeAuto && m_noFix ) ||
-                          m_dataMode == K3b::DataMode2
-                          ? Device::Track::XA_FORM2
-                          : Device::Track::MODE1 );
-    d->writer->setSessionToWrite( toc );
+    d->writer->setSessionToWrite( sessionToWrite() );
 
     connect( d->writer, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
     connect( d->writer, SIGNAL(nextTrack(int,int)), this, SLOT(slotNextTrack(int,int)) );
@@ -335,6 +314,179 @@ bool K3b::Iso9660ImageWritingJob::prepareWriter()
 }
 
 
+void K3b::Iso9660ImageWritingJob::startMultiWriting()
+{
+    // drives which failed in an earlier round are not used anymore
+    QList<Device::Device*> devices = d->workingDevices;
+
+    // one copy per device in each round
+    const int copiesLeft = m_copies - d->currentCopy + 1;
+    while( devices.count() > copiesLeft )
+        devices.removeLast();
+    d->roundCopies = devices.count();
+
+    emit newSubTask( i18n("Waiting for media") );
+
+    Q_FOREACH( Device::Device* dev, devices ) {
+        Device::MediaType media = waitForMedium( dev, K3b::Device::STATE_EMPTY, wantedMediaTypes(),
+                                                 K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048 );
+        if( media == Device::MEDIA_UNKNOWN ) {
+            d->finished = true;
+            emit canceled();
+            jobFinished(false);
+            return;
+        }
+    }
+
+    d->imageFile.close();
+    d->imageFile.setName( m_imagePath );
+    if( !d->imageFile.open( QIODevice::ReadOnly ) ) {
+        emit infoMessage( i18n("Could not open file %1", m_imagePath), K3b::Job::MessageError );
+        d->finished = true;
+        jobFinished(false);
+        return;
+    }
+
+    if( !d->multiWriter ) {
+        d->multiWriter = new MultiWriterJob( this, this );
+        connect( d->multiWriter, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
+        connect( d->multiWriter, SIGNAL(percent(int)), this, SLOT(slotMultiWriterPercent(int)) );
+        connect( d->multiWriter, SIGNAL(subPercent(int)), this, SIGNAL(subPercent(int)) );
+        connect( d->multiWriter, SIGNAL(processedSize(int,int)), this, SIGNAL(processedSize(int,int)) );
+        connect( d->multiWriter, SIGNAL(bufferStatus(int)), this, SIGNAL(bufferStatus(int)) );
+        connect( d->multiWriter, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+        connect( d->multiWriter, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+        connect( d->multiWriter, SIGNAL(burning(bool)), this, SIGNAL(burning(bool)) );
+        connect( d->multiWriter, SIGNAL(newSubTask(QString)), this, SIGNAL(newSubTask(QString)) );
+        connect( d->multiWriter, SIGNAL(devicePercent(K3b::Device::Device*,int)),
+                 this, SIGNAL(devicePercent(K3b::Device::Device*,int)) );
+        connect( d->multiWriter, SIGNAL(deviceFinished(K3b::Device::Device*,bool)),
+                 this, SIGNAL(deviceFinished(K3b::Device::Device*,bool)) );
+        connect( d->multiWriter, SIGNAL(finished(bool)), this, SLOT(slotMultiWriterFinished(bool)) );
+        connect( d->multiWriter, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SIGNAL(debuggingOutput(QString,QString)) );
+    }
+
+    d->multiWriter->setDevices( devices );
+    d->multiWriter->setSource( &d->imageFile );
+    d->multiWriter->setWritingMode( m_writingMode );
+    d->multiWriter->setWritingApp( writingApp() );
+    d->multiWriter->setSimulate( m_simulate );
+    d->multiWriter->setBurnSpeed( m_speed );
+    d->multiWriter->setMultiSession( m_noFix );
+    d->multiWriter->setVerifyData( m_verifyData );
+    d->multiWriter->setSessionToWrite( sessionToWrite() );
+
+    if( d->roundCopies == 1 )
+        emit newTask( i18n("Writing copy %1 of %2", d->currentCopy, m_copies) );
+    else
+        emit newTask( i18n("Writing copies %1 to %2 of %3", d->currentCopy, d->currentCopy + d->roundCopies - 1, m_copies) );
+
+    d->multiWriter->start();
+}
+
+
+void K3b::Iso9660ImageWritingJob::slotMultiWriterFinished( bool )
+{
+    d->imageFile.close();
+
+    const QList<Device::Device*> devices = d->multiWriter->devices();
+    const QList<Device::Device*> succeeded = d->multiWriter->successfulDevices();
+
+    if( d->canceled ) {
+        d->finished = true;
+        emit canceled();
+        jobFinished(false);
+        return;
+    }
+
+    // a failed drive has already been reported via deviceFinished(). Drop it
+    // and let the others write the copies it did not produce.
+    Q_FOREACH( Device::Device* dev, devices ) {
+        if( !succeeded.contains( dev ) )
+            d->workingDevices.removeAll( dev );
+    }
+    d->currentCopy += succeeded.count();
+
+    if( d->currentCopy <= m_copies && !d->workingDevices.isEmpty() ) {
+        if( succeeded.count() < devices.count() )
+            emit infoMessage( i18np("Continuing with one writer.", "Continuing with %1 writers.", d->workingDevices.count()),
+                              K3b::Job::MessageWarning );
+        Q_FOREACH( Device::Device* dev, devices ) {
+            if( !K3b::eject( dev ) ) {
+                blockingInformation( i18n("K3b was unable to eject the written medium. Please do so manually.") );
+            }
+        }
+        startMultiWriting();
+        return;
+    }
+
+    if( k3bcore->globalSettings()->ejectMedia() ) {
+        Q_FOREACH( Device::Device* dev, devices )
+            K3b::Device::eject( dev );
+    }
+
+    d->finished = true;
+    jobFinished( d->currentCopy > m_copies );
+}
+
+
+void K3b::Iso9660ImageWritingJob::slotMultiWriterPercent( int p )
+{
+    emit percent( (int)(100.0 / (double)m_copies * ( (double)(d->currentCopy-1) + (double)d->roundCopies*(double)p/100.0 )) );
+}
+
+
+K3b::Device::MediaTypes K3b::Iso9660ImageWritingJob::wantedMediaTypes() const
+{
+    // we wait for the following:
+    // 1. If special CD features are requested: CD types only Special are:
+    // K3b::WritingAppCdrdao with K3b::WritingModeAuto or K3b::WritingModeSao,
+    // any WritingApp with K3b::WritingModeTao,
+    // any WritingApp with K3b::WritingModeRaw
+    // 2. If formatted DVD-RW is requested: formatted DVD-RW only Request is:
+    // K3b::WritingModeRestrictedOverwrite
+    // 3. If image is larger than 900 MiB (d->isDvdImage == true): DVD or BD
+    // types See K3b::Iso9660ImageWritingJob::start()
+    // 4. If image not larger than 900 MiB: All media types
+    // 5. If not decided yet: DVD and BD media types.
+
+    Device::MediaTypes mt = 0;
+    if (m_writingMode == K3b::WritingModeAuto ||
+        m_writingMode == K3b::WritingModeSao) {
+        if (writingApp() == K3b::WritingAppCdrdao)
+            mt = K3b::Device::MEDIA_WRITABLE_CD;
+        else if (d->isDvdImage)
+            mt = K3b::Device::MEDIA_WRITABLE_DVD | K3b::Device::MEDIA_WRITABLE_BD;
+        else
+            mt = K3b::Device::MEDIA_WRITABLE;
+    } else if (m_writingMode == K3b::WritingModeTao ||
+               m_writingMode == K3b::WritingModeRaw) {
+        mt = K3b::Device::MEDIA_WRITABLE_CD;
+    } else if (m_writingMode == K3b::WritingModeRestrictedOverwrite) {
+        mt = /*K3b::Device::MEDIA_DVD_PLUS_R | K3b::Device::MEDIA_DVD_PLUS_R_DL |*/
+             K3b::Device::MEDIA_DVD_PLUS_RW | K3b::Device::MEDIA_DVD_RW_OVWR;
+    } else {
+        mt = K3b::Device::MEDIA_WRITABLE_DVD | K3b::Device::MEDIA_WRITABLE_BD;
+    }
+
+    return mt;
+}
+
+
+K3b::Device::Toc K3b::Iso9660ImageWritingJob::sessionToWrite() const
+{
+    Device::Toc toc;
+    toc << Device::Track( 0, Msf(K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048)-1,
+                          Device::Track::TYPE_DATA,
+                          ( m_dataMode == K3b::DataModeAuto && m_noFix ) ||
+                          m_dataMode == K3b::DataMode2
+                          ? Device::Track::XA_FORM2
+                          : Device::Track::MODE1 );
+    return toc;
+}
+
+
 QString K3b::Iso9660ImageWritingJob::jobDescription() const
 {
     if( m_simulate )
@@ -22,6 +22,7 @@
 namespace K3b {
     namespace Device {
         class Device;
+        class Toc;
     }
 
     class LIBK3B_EXPORT Iso9660ImageWritingJob : public BurnJob
@@ -53,6 +54,14 @@ namespace K3b {
         void setVerifyData( bool b ) { m_verifyData = b; }
         void setCopies( int c ) { m_copies = c; }
 
+        /**
+         * Burn on these devices in addition to the burn device at the same
+         * time. The image is only read once and up to one copy per device
+         * is written in each round. A device which failed is not used for
+         * the remaining copies.
+         */
+        void setAdditionalBurnDevices( const QList<K3b::Device::Device*>& devs ) { m_additionalDevices = devs; }
+
     protected Q_SLOTS:
         void slotWriterJobFinished( bool );
         void slotVerificationFinished( bool );
@@ -60,9 +69,14 @@ namespace K3b {
         void slotWriterPercent( int );
         void slotNextTrack( int, int );
         void startWriting();
+        void slotMultiWriterFinished( bool );
+        void slotMultiWriterPercent( int );
 
     private:
         bool prepareWriter();
+        void startMultiWriting();
+        Device::MediaTypes wantedMediaTypes() const;
+        Device::Toc sessionToWrite() const;
 
         WritingMode m_writingMode;
         bool m_simulate;
@@ -73,6 +87,7 @@ namespace K3b {
         bool m_verifyData;
         QString m_imagePath;
         int m_copies;
+        QList<Device::Device*> m_additionalDevices;
 
         class Private;
         Private* d;
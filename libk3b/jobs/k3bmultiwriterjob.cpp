@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bmultiwriterjob.h"
+#include "k3bmetawriter.h"
+#include "k3bverificationjob.h"
+#include "k3bfanoutpipe.h"
+
+#include "k3bdevice.h"
+#include "k3btoc.h"
+#include "k3b_i18n.h"
+
+#include <QDebug>
+#include <QVector>
+
+
+namespace {
+    QString deviceName( K3b::Device::Device* dev )
+    {
+        return dev->vendor() + ' ' + dev->description();
+    }
+}
+
+
+class K3b::MultiWriterJob::Private
+{
+public:
+    struct Drive {
+        Device::Device* device;
+        MetaWriter* writer;
+        VerificationJob* verificationJob;
+        int sink;
+        int writePercent;
+        int verificationPercent;
+        int processed;
+        int size;
+        bool done;
+        bool success;
+    };
+
+    Private()
+        : source( 0 ),
+          writingMode( K3b::WritingModeAuto ),
+          simulate( false ),
+          speed( 0 ),
+          multiSession( false ),
+          layerBreak( 0 ),
+          verifyData( false ),
+          running( false ),
+          canceled( false ) {
+    }
+
+    int slowestDrive() const {
+        int slowest = -1;
+        for( int i = 0; i < drives.count(); ++i ) {
+            if( !drives[i].done && drives[i].writer &&
+                ( slowest < 0 || drives[i].processed < drives[slowest].processed ) )
+                slowest = i;
+        }
+        return slowest;
+    }
+
+    void clearDrives() {
+        // no sink thread may still be writing to a writer we delete
+        pipe.abort();
+        pipe.clearSinks();
+        for( int i = 0; i < drives.count(); ++i ) {
+            delete drives[i].writer;
+            delete drives[i].verificationJob;
+        }
+        drives.clear();
+    }
+
+    QList<Device::Device*> devices;
+    QIODevice* source;
+    Device::Toc toc;
+    WritingMode writingMode;
+    bool simulate;
+    int speed;
+    bool multiSession;
+    qint64 layerBreak;
+    bool verifyData;
+
+    QVector<Drive> drives;
+    FanOutPipe pipe;
+
+    bool running;
+    bool canceled;
+};
+
+
+K3b::MultiWriterJob::MultiWriterJob( JobHandler* hdl, QObject* parent )
+    : BurnJob( hdl, parent ),
+      d( new Private() )
+{
+}
+
+
+K3b::MultiWriterJob::~MultiWriterJob()
+{
+    d->clearDrives();
+    delete d;
+}
+
+
+void K3b::MultiWriterJob::setDevices( const QList<Device::Device*>& devices )
+{
+    d->devices = devices;
+}
+
+
+QList<K3b::Device::Device*> K3b::MultiWriterJob::devices() const
+{
+    return d->devices;
+}
+
+
+void K3b::MultiWriterJob::setSource( QIODevice* source )
+{
+    d->source = source;
+}
+
+
+QIODevice* K3b::MultiWriterJob::ioDevice() const
+{
+    return &d->pipe;
+}
+
+
+void K3b::MultiWriterJob::setSessionToWrite( const Device::Toc& toc )
+{
+    d->toc = toc;
+}
+
+
+void K3b::MultiWriterJob::setWritingMode( WritingMode mode )
+{
+    d->writingMode = mode;
+}
+
+
+void K3b::MultiWriterJob::setSimulate( bool b )
+{
+    d->simulate = b;
+}
+
+
+void K3b::MultiWriterJob::setBurnSpeed( int speed )
+{
+    d->speed = speed;
+}
+
+
+void K3b::MultiWriterJob::setMultiSession( bool b )
+{
+    d->multiSession = b;
+}
+
+
+void K3b::MultiWriterJob::setLayerBreak( qint64 lb )
+{
+    d->layerBreak = lb;
+}
+
+
+void K3b::MultiWriterJob::setVerifyData( bool b )
+{
+    d->verifyData = b;
+}
+
+
+QList<K3b::Device::Device*> K3b::MultiWriterJob::successfulDevices() const
+{
+    QList<Device::Device*> devs;
+    Q_FOREACH( const Private::Drive& drive, d->drives ) {
+        if( drive.done && drive.success )
+            devs.append( drive.device );
+    }
+    return devs;
+}
+
+
+void K3b::MultiWriterJob::start()
+{
+    jobStarted();
+
+    d->canceled = false;
+    d->running = true;
+    d->clearDrives();
+    d->pipe.readFrom( d->source );
+
+    Q_FOREACH( Device::Device* dev, d->devices ) {
+        Private::Drive drive;
+        drive.device = dev;
+        drive.writer = new MetaWriter( dev, this, this );
+        drive.verificationJob = 0;
+        drive.sink = -1;
+        drive.writePercent = drive.verificationPercent = 0;
+        drive.processed = drive.size = 0;
+        drive.done = drive.success = false;
+
+        drive.writer->setWritingMode( d->writingMode );
+        drive.writer->setWritingApp( writingApp() );
+        drive.writer->setSimulate( d->simulate );
+        drive.writer->setBurnSpeed( d->speed );
+        drive.writer->setMultiSession( d->multiSession );
+        if( d->layerBreak > 0 )
+            drive.writer->setLayerBreak( d->layerBreak );
+        drive.writer->setSessionToWrite( d->toc );
+
+        d->drives.append( drive );
+    }
+
+    for( int i = 0; i < d->drives.count(); ++i ) {
+        MetaWriter* writer = d->drives[i].writer;
+        Device::Device* dev = d->drives[i].device;
+
+        connect( writer, &Job::infoMessage, this, [this, dev]( const QString& msg, int type ) {
+            emit infoMessage( i18nc( "@info device name and message", "%1: %2", deviceName( dev ), msg ), type );
+        } );
+        connect( writer, &Job::debuggingOutput, this, [this, dev]( const QString& group, const QString& line ) {
+            emit debuggingOutput( QString::fromLatin1( "%1 (%2)" ).arg( group, dev->blockDeviceName() ), line );
+        } );
+        connect( writer, &Job::percent, this, [this, i]( int p ) {
+            d->drives[i].writePercent = p;
+            updateProgress();
+        } );
+        connect( writer, &Job::processedSize, this, [this, i]( int processed, int size ) {
+            d->drives[i].processed = processed;
+            d->drives[i].size = size;
+            if( d->slowestDrive() == i ) {
+                emit processedSize( processed, size );
+                emit bufferStatus( d->pipe.bufferFill() );
+            }
+        } );
+        connect( writer, &AbstractWriter::deviceBuffer, this, [this, i]( int b ) {
+            if( d->slowestDrive() == i )
+                emit deviceBuffer( b );
+        } );
+        connect( writer, &AbstractWriter::writeSpeed, this, [this, i]( int speed, K3b::Device::SpeedMultiplicator m ) {
+            if( d->slowestDrive() == i )
+                emit writeSpeed( speed, m );
+        } );
+        connect( writer, &Job::finished, this, [this, i]( bool success ) {
+            d->pipe.removeSink( d->drives[i].sink );
+            if( !success )
+                driveFinished( i, false );
+            else if( d->verifyData && !d->simulate && !d->canceled )
+                startVerification( i );
+            else
+                driveFinished( i, true );
+        } );
+
+        writer->start();
+
+        // the writer might have failed right away
+        if( !d->drives[i].done && writer->ioDevice() ) {
+            d->drives[i].sink = d->pipe.addSink( writer->ioDevice(),
+                                                 writer->usedWritingApp() == K3b::WritingAppGrowisofs );
+        }
+    }
+
+    if( d->pipe.sinkCount() == 0 || !d->pipe.open() ) {
+        emit infoMessage( i18n( "None of the burners could be started." ), MessageError );
+        if( !stopDrives() && d->running ) {
+            d->running = false;
+            jobFinished( false );
+        }
+        return;
+    }
+
+    emit burning( true );
+    emit newSubTask( i18np( "Writing to %1 burner", "Writing to %1 burners", d->pipe.sinkCount() ) );
+}
+
+
+void K3b::MultiWriterJob::cancel()
+{
+    if( !d->running )
+        return;
+
+    d->canceled = true;
+
+    // otherwise the last finishing drive finishes the job
+    if( !stopDrives() ) {
+        d->running = false;
+        emit canceled();
+        jobFinished( false );
+    }
+}
+
+
+bool K3b::MultiWriterJob::stopDrives()
+{
+    d->pipe.abort();
+
+    bool waiting = false;
+    for( int i = 0; i < d->drives.count(); ++i ) {
+        Private::Drive& drive = d->drives[i];
+        if( drive.done )
+            continue;
+        if( drive.verificationJob && drive.verificationJob->active() ) {
+            drive.verificationJob->cancel();
+            waiting = true;
+        }
+        else if( drive.writer->active() ) {
+            drive.writer->cancel();
+            waiting = true;
+        }
+        else {
+            drive.done = true;
+        }
+    }
+
+    return waiting;
+}
+
+
+void K3b::MultiWriterJob::startVerification( int i )
+{
+    Private::Drive& drive = d->drives[i];
+
+    drive.verificationJob = new VerificationJob( this, this );
+    drive.verificationJob->setDevice( drive.device );
+    drive.verificationJob->addTrack( 1, d->pipe.checksum(), d->toc.length() );
+
+    connect( drive.verificationJob, &Job::infoMessage, this, [this, i]( const QString& msg, int type ) {
+        emit infoMessage( i18nc( "@info device name and message", "%1: %2", deviceName( d->drives[i].device ), msg ), type );
+    } );
+    connect( drive.verificationJob, &Job::debuggingOutput, this, &Job::debuggingOutput );
+    connect( drive.verificationJob, &Job::percent, this, [this, i]( int p ) {
+        d->drives[i].verificationPercent = p;
+        updateProgress();
+    } );
+    connect( drive.verificationJob, &Job::finished, this, [this, i]( bool success ) {
+        driveFinished( i, success );
+    } );
+
+    drive.verificationJob->start();
+}
+
+
+void K3b::MultiWriterJob::driveFinished( int i, bool success )
+{
+    Private::Drive& drive = d->drives[i];
+    if( drive.done )
+        return;
+
+    drive.done = true;
+    drive.success = success && !d->canceled;
+    drive.writePercent = drive.verificationPercent = 100;
+
+    if( !d->canceled ) {
+        if( drive.success )
+            emit infoMessage( i18n( "Successfully written to %1.", deviceName( drive.device ) ), MessageSuccess );
+        else
+            emit infoMessage( i18n( "Writing to %1 failed.", deviceName( drive.device ) ), MessageError );
+    }
+
+    emit deviceFinished( drive.device, drive.success );
+    updateProgress();
+
+    bool allDone = true;
+    bool allSucceeded = true;
+    Q_FOREACH( const Private::Drive& drive, d->drives ) {
+        allDone = allDone && drive.done;
+        allSucceeded = allSucceeded && drive.success;
+    }
+
+    if( allDone && d->running ) {
+        d->running = false;
+        emit burning( false );
+        if( d->canceled )
+            emit canceled();
+        jobFinished( allSucceeded && !d->canceled );
+    }
+}
+
+
+void K3b::MultiWriterJob::updateProgress()
+{
+    if( d->drives.isEmpty() )
+        return;
+
+    int total = 0;
+    int writing = 100;
+    for( int i = 0; i < d->drives.count(); ++i ) {
+        const Private::Drive& drive = d->drives[i];
+        const int p = ( d->verifyData && !d->simulate )
+                      ? ( drive.writePercent + drive.verificationPercent ) / 2
+                      : drive.writePercent;
+        emit devicePercent( drive.device, p );
+        total += p;
+        if( !drive.done )
+            writing = qMin( writing, drive.writePercent );
+    }
+
+    emit percent( total / d->drives.count() );
+    emit subPercent( writing );
+}
+
+#include "moc_k3bmultiwriterjob.cpp"
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_MULTI_WRITER_JOB_H_
+#define _K3B_MULTI_WRITER_JOB_H_
+
+#include "k3bjob.h"
+#include "k3bglobals.h"
+#include "k3b_export.h"
+
+class QIODevice;
+
+namespace K3b {
+    namespace Device {
+        class Device;
+        class Toc;
+    }
+
+    /**
+     * Writes one data stream to several burners at the same time.
+     *
+     * A MetaWriter is started for each device and all of them are fed
+     * from a single FanOutPipe, so the source is only read once. Each drive
+     * fails independently: a failing writer is dropped from the pipe while
+     * the others continue. With data verification enabled each medium is
+     * verified as soon as its writer is done.
+     *
+     * The job only succeeds if all devices succeeded. Use successfulDevices()
+     * to find out which media are usable after a partial failure.
+     *
+     * The media have to be inserted before the job is started.
+     */
+    class LIBK3B_EXPORT MultiWriterJob : public BurnJob
+    {
+        Q_OBJECT
+
+    public:
+        explicit MultiWriterJob( JobHandler* hdl, QObject* parent = 0 );
+        ~MultiWriterJob() override;
+
+        void setDevices( const QList<Device::Device*>& devices );
+        QList<Device::Device*> devices() const;
+
+        /**
+         * Read the data from \p source. If no source is set the data has to be
+         * written to ioDevice() after the job has been started. Closing the
+         * ioDevice() marks the end of the data in that case.
+         */
+        void setSource( QIODevice* source );
+
+        QIODevice* ioDevice() const;
+
+        /**
+         * The session written to each medium. Used for verification as well.
+         */
+        void setSessionToWrite( const Device::Toc& toc );
+
+        void setWritingMode( WritingMode mode );
+        void setSimulate( bool b );
+        void setBurnSpeed( int speed );
+        void setMultiSession( bool b );
+        void setLayerBreak( qint64 lb );
+        void setVerifyData( bool b );
+
+        /**
+         * The devices which wrote and, if requested, verified their medium
+         * successfully. Valid after the job finished.
+         */
+        QList<Device::Device*> successfulDevices() const;
+
+    public Q_SLOTS:
+        void start() override;
+        void cancel() override;
+
+    private:
+        /**
+         * Cancel all running writers and verifications.
+         * \return true if any of them is still running.
+         */
+        bool stopDrives();
+        void startVerification( int drive );
+        void driveFinished( int drive, bool success );
+        void updateProgress();
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
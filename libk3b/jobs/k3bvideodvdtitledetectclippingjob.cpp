@@ -18,6 +18,7 @@
 #include "k3bprocess.h"
 #include "k3bcore.h"
 #include "k3bglobals.h"
+#include "k3bprogressmatcher.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -149,7 +150,10 @@ void K3b::VideoDVDTitleDetectClippingJob::startTranscode( int chapter )
         *d->process << "--log_no_color";
 
     // the input
-    *d->process << "-i" << m_dvd.device()->blockDeviceName();
+    if( m_inputPath.isEmpty() )
+        *d->process << "-i" << m_dvd.device()->blockDeviceName();
+    else
+        *d->process << "-i" << m_inputPath;
 
     // select the title number and chapter
     *d->process << "-T" << QString("%1,%2").arg(m_titleNumber).arg(chapter);
@@ -200,45 +204,40 @@ void K3b::VideoDVDTitleDetectClippingJob::slotTranscodeStderr( const QString& li
 {
     emit debuggingOutput( "transcode", line );
 
+    K3b::ProgressMatcher::Captures cap;
+
     // parse progress
     // encoding frame [185],  24.02 fps, 93.0%, ETA: 0:00:00, ( 0| 0| 0)
     if( line.startsWith( "encoding frame" ) ) {
-        int pos1 = line.indexOf( '[', 15 );
-        int pos2 = line.indexOf( ']', pos1+1 );
-        if( pos1 > 0 && pos2 > 0 ) {
-            bool ok;
-            int encodedFrames = line.mid( pos1+1, pos2-pos1-1 ).toInt( &ok );
-            if( ok ) {
-                int progress = 100 * encodedFrames / d->currentFrames;
-
-                if( progress > d->lastSubProgress ) {
-                    d->lastSubProgress = progress;
-                    emit subPercent( progress );
-                }
-
-                double part = 100.0 / (double)d->totalChapters;
-
-                progress = (int)( ( (double)(d->currentChapter-1) * part )
-                                  + ( (double)progress / (double)d->totalChapters )
-                                  + 0.5 );
-
-                if( progress > d->lastProgress ) {
-                    d->lastProgress = progress;
-                    emit percent( progress );
-                }
+        if( K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::DetectClippingProgress ).match( line, cap ) ) {
+            int encodedFrames = cap.toInt( 0 );
+            int progress = 100 * encodedFrames / d->currentFrames;
+
+            if( progress > d->lastSubProgress ) {
+                d->lastSubProgress = progress;
+                emit subPercent( progress );
+            }
+
+            double part = 100.0 / (double)d->totalChapters;
+
+            progress = (int)( ( (double)(d->currentChapter-1) * part )
+                              + ( (double)progress / (double)d->totalChapters )
+                              + 0.5 );
+
+            if( progress > d->lastProgress ) {
+                d->lastProgress = progress;
+                emit percent( progress );
             }
         }
     }
 
     // [detectclipping#0] valid area: X: 5..719 Y: 72..507  -> -j 72,6,68,0
     else if( line.startsWith( "[detectclipping" ) ) {
-        int pos = line.indexOf( "-j" );
-        if( pos > 0 ) {
-            QStringList values = line.mid( pos+3 ).split( ',' );
-            m_clippingTop = qMin( m_clippingTop, values[0].toInt() );
-            m_clippingLeft = qMin( m_clippingLeft, values[1].toInt() );
-            m_clippingBottom = qMin( m_clippingBottom, values[2].toInt() );
-            m_clippingRight = qMin( m_clippingRight, values[3].toInt() );
+        if( K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::DetectClippingArea ).match( line, cap ) ) {
+            m_clippingTop = qMin( m_clippingTop, cap.toInt( 0 ) );
+            m_clippingLeft = qMin( m_clippingLeft, cap.toInt( 1 ) );
+            m_clippingBottom = qMin( m_clippingBottom, cap.toInt( 2 ) );
+            m_clippingRight = qMin( m_clippingRight, cap.toInt( 3 ) );
         }
         else
             qDebug() << "(K3b::VideoDVDTitleDetectClippingJob) failed to parse line: " << line;
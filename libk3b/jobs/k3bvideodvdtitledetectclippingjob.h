@@ -34,6 +34,7 @@ namespace K3b {
 
         const VideoDVD::VideoDVD& videoDVD() const { return m_dvd; }
         int title() const { return m_titleNumber; }
+        const QString& inputPath() const { return m_inputPath; }
         bool lowPriority() const { return m_lowPriority; }
 
         /**
@@ -72,6 +73,14 @@ namespace K3b {
          */
         void setTitle( int t ) { m_titleNumber = t; }
 
+        /**
+         * Read the title from a copy of the Video DVD instead of the device,
+         * i.e. a folder containing the VIDEO_TS folder.
+         *
+         * The default is to read from the device.
+         */
+        void setInputPath( const QString& path ) { m_inputPath = path; }
+
         /**
          * If true the transcode processes will be run with a very low scheduling
          * priority.
@@ -96,6 +105,8 @@ namespace K3b {
 
         int m_titleNumber;
 
+        QString m_inputPath;
+
         bool m_lowPriority;
 
         class Private;
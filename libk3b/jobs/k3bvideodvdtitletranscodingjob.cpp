@@ -21,6 +21,7 @@
 #include "k3bglobals.h"
 #include "k3bmediacache.h"
 #include "k3bmedium.h"
+#include "k3bprogressmatcher.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -51,32 +52,21 @@ public:
 
 bool K3b::VideoDVDTitleTranscodingJob::Private::getEncodedFrames( const QString& line, int& encodedFrames ) const
 {
-    int pos1 = 0;
-    int pos2 = 0;
+    K3b::ProgressMatcher::Captures cap;
 
     if ( usedTranscodeBin->version() >= Version( 1, 1, 0 ) ) {
         // encoding=1 frame=1491 first=0 last=-1 fps=14.815 done=-1.000000 timestamp=59.640 timeleft=-1 decodebuf=12 filterbuf=5 encodebuf=3
-        if( line.startsWith( "encoding=" ) ) {
-            pos1 = line.indexOf( '=', 9 );
-            pos2 = line.indexOf( ' ', pos1+1 );
-        }
+        if( !K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::TranscodeProgress ).match( line, cap ) )
+            return false;
     }
     else {
         // encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05, ( 0| 0| 0)
-        if( line.startsWith( "encoding frame" ) ) {
-            pos1 = line.indexOf( '-', 15 );
-            pos2 = line.indexOf( ']', pos1+1 );
-        }
+        if( !K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::TranscodeLegacyProgress ).match( line, cap ) )
+            return false;
     }
 
-    if( pos1 > 0 && pos2 > 0 ) {
-        bool ok;
-        encodedFrames = line.mid( pos1+1, pos2-pos1-1 ).toInt( &ok );
-        return ok;
-    }
-    else {
-        return false;
-    }
+    encodedFrames = cap.toInt( 1 );
+    return true;
 }
 
 
@@ -173,6 +163,11 @@ void K3b::VideoDVDTitleTranscodingJob::start()
     //
     d->twoPassEncodingLogFile = K3b::findTempFile( "log" );
 
+    // reserve the name for other jobs transcoding at the same time
+    QFile logFile( d->twoPassEncodingLogFile );
+    if( logFile.open( QIODevice::WriteOnly ) )
+        logFile.close();
+
     emit newTask( i18n("Transcoding title %1 from Video DVD %2", m_titleNumber, k3bcore->mediaCache()->medium( m_dvd.device() ).beautifiedVolumeId()) );
 
     //
@@ -257,7 +252,10 @@ void K3b::VideoDVDTitleTranscodingJob::startTranscode( int pass )
         *d->process << "--print_status" << QString::number(progressRate);
 
     // the input
-    *d->process << "-i" << m_dvd.device()->blockDeviceName();
+    if( m_inputPath.isEmpty() )
+        *d->process << "-i" << m_dvd.device()->blockDeviceName();
+    else
+        *d->process << "-i" << m_inputPath;
 
     // just to make sure
     *d->process << "-x" << "dvd";
@@ -61,6 +61,7 @@ namespace K3b {
         const VideoDVD::VideoDVD& videoDVD() const { return m_dvd; }
         int title() const { return m_titleNumber; }
         int audioStream() const { return m_audioStreamIndex; }
+        const QString& inputPath() const { return m_inputPath; }
         int clippingTop() const { return m_clippingTop; }
         int clippingLeft() const { return m_clippingLeft; }
         int clippingBottom() const { return m_clippingBottom; }
@@ -109,6 +110,16 @@ namespace K3b {
          */
         void setTitle( int t ) { m_titleNumber = t; }
 
+        /**
+         * Read the title from a copy of the Video DVD instead of the device,
+         * i.e. a folder containing the VIDEO_TS folder. Several jobs can
+         * transcode from the same copy at once without the drive seeking
+         * between them.
+         *
+         * The default is to read from the device.
+         */
+        void setInputPath( const QString& path ) { m_inputPath = path; }
+
         /**
          * Set the audio stream to use.
          *
@@ -256,6 +267,8 @@ namespace K3b {
         int m_titleNumber;
         int m_audioStreamIndex;
 
+        QString m_inputPath;
+
         VideoCodec m_videoCodec;
         AudioCodec m_audioCodec;
 
@@ -17,6 +17,7 @@
 #include "k3bcore.h"
 #include "k3baudiodecoder.h"
 #include "k3bpluginmanager.h"
+#include "k3bglobalsettings.h"
 #include "k3b_i18n.h"
 
 #include <KFileMetaData/ExtractionResult>
@@ -31,8 +32,6 @@
 
 #include <math.h>
 
-#include <samplerate.h>
-
 #if !(HAVE_LRINT && HAVE_LRINTF)
 #define lrint(dbl)              ((int) (dbl+0.5))
 #define lrintf(flt)             ((int) (flt+0.5))
@@ -92,8 +91,8 @@ class K3b::AudioDecoder::Private
 public:
     Private()
         : metaDataCollection(NULL),
-          resampleState(0),
-          resampleData(0),
+          resampler(0),
+          resamplingQuality(k3bcore ? k3bcore->globalSettings()->resamplingQuality() : K3b::AudioResampler::QualityMedium),
           inBuffer(0),
           inBufferPos(0),
           inBufferFill(0),
@@ -127,8 +126,8 @@ public:
     bool decoderFinished;
 
     // resampling
-    SRC_STATE* resampleState;
-    SRC_DATA* resampleData;
+    K3b::AudioResampler* resampler;
+    K3b::AudioResampler::Quality resamplingQuality;
 
     float* inBuffer;
     float* inBufferPos;
@@ -169,11 +168,7 @@ K3b::AudioDecoder::~AudioDecoder()
     if( d->outBuffer ) delete [] d->outBuffer;
     if( d->monoBuffer ) delete [] d->monoBuffer;
 
-    delete d->resampleData;
-    if (d->resampleState) {
-        src_delete(d->resampleState);
-        d->resampleState = NULL;
-    }
+    delete d->resampler;
     delete d;
 }
 
@@ -185,6 +180,18 @@ void K3b::AudioDecoder::setFilename( const QString& filename )
 }
 
 
+void K3b::AudioDecoder::setResamplingQuality( K3b::AudioResampler::Quality quality )
+{
+    d->resamplingQuality = quality;
+}
+
+
+K3b::AudioResampler::Quality K3b::AudioDecoder::resamplingQuality() const
+{
+    return d->resamplingQuality;
+}
+
+
 bool K3b::AudioDecoder::isValid() const
 {
     return d->valid;
@@ -228,8 +235,8 @@ bool K3b::AudioDecoder::initDecoder()
 {
     cleanup();
 
-    if( d->resampleState )
-        src_reset( d->resampleState );
+    if( d->resampler )
+        d->resampler->reset();
 
     d->alreadyDecoded = 0;
     d->currentPos = 0;
@@ -367,46 +374,48 @@ int K3b::AudioDecoder::decode( char* _data, int maxLen )
 //
 int K3b::AudioDecoder::resample( char* data, int maxLen )
 {
-    if( !d->resampleState ) {
-        d->resampleState = src_new( SRC_SINC_MEDIUM_QUALITY, d->channels, 0 );
-        if( !d->resampleState ) {
+    // the file may have been analysed again or the quality changed
+    if( d->resampler &&
+        ( d->resampler->samplerate() != d->samplerate ||
+          d->resampler->channels() != d->channels ||
+          d->resampler->quality() != d->resamplingQuality ) ) {
+        delete d->resampler;
+        d->resampler = 0;
+    }
+
+    if( !d->resampler ) {
+        d->resampler = new K3b::AudioResampler( d->samplerate, d->channels, d->resamplingQuality );
+        if( !d->resampler->isValid() ) {
             qDebug() << "(K3b::AudioDecoder) unable to initialize resampler.";
+            delete d->resampler;
+            d->resampler = 0;
             return -1;
         }
-        d->resampleData = new SRC_DATA;
     }
 
     if( !d->outBuffer ) {
         d->outBuffer = new float[DECODING_BUFFER_SIZE/2];
     }
 
-    d->resampleData->data_in = d->inBufferPos;
-    d->resampleData->data_out = d->outBuffer;
-    d->resampleData->input_frames = d->inBufferFill/d->channels;
-    d->resampleData->output_frames = maxLen/2/2;  // in case of mono files we need the space anyway
-    d->resampleData->src_ratio = 44100.0/(double)d->samplerate;
-    if( d->inBufferFill == 0 )
-        d->resampleData->end_of_input = 1;  // this should force libsamplerate to output the last frames
-    else
-        d->resampleData->end_of_input = 0;
-
-    int len = 0;
-    if( (len = src_process( d->resampleState, d->resampleData ) ) ) {
-        qDebug() << "(K3b::AudioDecoder) error while resampling: " << src_strerror(len);
+    int inputFramesUsed = 0;
+    const int frames = d->resampler->process( d->inBufferPos, d->inBufferFill/d->channels,
+                                              d->outBuffer, maxLen/2/2,  // in case of mono files we need the space anyway
+                                              inputFramesUsed,
+                                              d->inBufferFill == 0 );  // this forces the resampler to output the last frames
+    if( frames < 0 )
         return -1;
-    }
 
     if( d->channels == 2 )
-        fromFloatTo16BitBeSigned( d->outBuffer, data, d->resampleData->output_frames_gen*d->channels );
+        fromFloatTo16BitBeSigned( d->outBuffer, data, frames*d->channels );
     else {
-        for( int i = 0; i < d->resampleData->output_frames_gen; ++i ) {
+        for( int i = 0; i < frames; ++i ) {
             fromFloatTo16BitBeSigned( &d->outBuffer[i], &data[4*i], 1 );
             fromFloatTo16BitBeSigned( &d->outBuffer[i], &data[4*i+2], 1 );
         }
     }
 
-    d->inBufferPos += d->resampleData->input_frames_used*d->channels;
-    d->inBufferFill -= d->resampleData->input_frames_used*d->channels;
+    d->inBufferPos += inputFramesUsed*d->channels;
+    d->inBufferFill -= inputFramesUsed*d->channels;
     if( d->inBufferFill <= 0 ) {
         d->inBufferPos = d->inBuffer;
         d->inBufferFill = 0;
@@ -414,7 +423,7 @@ int K3b::AudioDecoder::resample( char* data, int maxLen )
 
     // 16 bit frames, so we need to multiply by 2
     // and we always have two channels
-    return d->resampleData->output_frames_gen*2*2;
+    return frames*2*2;
 }
 
 
@@ -524,8 +533,8 @@ bool K3b::AudioDecoder::seek( const K3b::Msf& pos )
         //
         // Here we have to reset the resampling stuff since we restart decoding at another position.
         //
-        if( d->resampleState )
-            src_reset( d->resampleState );
+        if( d->resampler )
+            d->resampler->reset();
         d->inBufferFill = 0;
 
         //
@@ -609,23 +618,107 @@ void K3b::AudioDecoder::addTechnicalInfo( const QString& key, const QString& val
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3b::AudioDecoderFactory::sniff( const AudioFileHead& ) const
+{
+    return SNIFF_MAYBE;
+}
+
+
+bool K3b::AudioDecoderFactory::canDecodeHead( const AudioFileHead& head )
+{
+    return canDecode( head.url() );
+}
+
+
+namespace {
+    // single format decoders first, each sorted by their confidence
+    K3b::AudioDecoderFactory* findDecoderFactory( const QList<K3b::Plugin*>& plugins,
+                                                  const K3b::AudioFileHead& head,
+                                                  K3b::AudioDecoderFactory::SniffResult* result )
+    {
+        QList<K3b::AudioDecoderFactory*> candidates[4];
+        Q_FOREACH( K3b::Plugin* plugin, plugins ) {
+            K3b::AudioDecoderFactory* f = dynamic_cast<K3b::AudioDecoderFactory*>( plugin );
+            if( !f )
+                continue;
+
+            const int group = f->multiFormatDecoder() ? 2 : 0;
+            switch( f->sniff( head ) ) {
+            case K3b::AudioDecoderFactory::SNIFF_YES:
+                candidates[group].append( f );
+                break;
+            case K3b::AudioDecoderFactory::SNIFF_MAYBE:
+                candidates[group+1].append( f );
+                break;
+            case K3b::AudioDecoderFactory::SNIFF_NO:
+                break;
+            }
+        }
+
+        for( int i = 0; i < 4; ++i ) {
+            Q_FOREACH( K3b::AudioDecoderFactory* f, candidates[i] ) {
+                if( f->canDecodeHead( head ) ) {
+                    if( result )
+                        *result = ( i % 2 == 0 ? K3b::AudioDecoderFactory::SNIFF_YES : K3b::AudioDecoderFactory::SNIFF_MAYBE );
+                    return f;
+                }
+            }
+        }
+
+        return 0;
+    }
+}
+
+
 K3b::AudioDecoder* K3b::AudioDecoderFactory::createDecoder( const QUrl& url )
 {
     qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " )";
-    QList<K3b::Plugin*> fl = k3bcore->pluginManager()->plugins( "AudioDecoder" );
 
-    // first search for a single format decoder
-    Q_FOREACH( K3b::Plugin* plugin, fl ) {
-        K3b::AudioDecoderFactory* f = dynamic_cast<K3b::AudioDecoderFactory*>( plugin );
-        if( f && !f->multiFormatDecoder() && f->canDecode( url ) ) {
-            qDebug() << "1"; return f->createDecoder();}
+    K3b::AudioFileHead head( url );
+    if( !head.isValid() ) {
+        qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " ) unable to read file";
+        return 0;
+    }
+
+    K3b::PluginManager* pm = k3bcore->pluginManager();
+    const QString format = QString::number( head.format() );
+    K3b::AudioDecoderFactory* factory = 0;
+
+    //
+    // The plugin index remembers which decoders handled a format before. Try those
+    // first so the remaining decoder plugins do not need to be loaded at all.
+    //
+    if( head.format() != K3b::AudioFileHead::FORMAT_UNKNOWN ) {
+        QList<K3b::Plugin*> known;
+        Q_FOREACH( const QString& name, pm->pluginNames( "AudioDecoder" ) ) {
+            if( pm->indexValue( name, "Formats", QStringList() ).toStringList().contains( format ) ) {
+                if( K3b::Plugin* plugin = pm->plugin( name ) )
+                    known.append( plugin );
+            }
+        }
+        factory = findDecoderFactory( known, head, 0 );
+    }
+
+    if( !factory ) {
+        SniffResult result = SNIFF_NO;
+        factory = findDecoderFactory( pm->plugins( "AudioDecoder" ), head, &result );
+
+        // only remember decoders which recognized the format themselves
+        const QString name = factory ? factory->pluginInfo().pluginName() : QString();
+        if( result == SNIFF_YES &&
+            head.format() != K3b::AudioFileHead::FORMAT_UNKNOWN &&
+            !name.isEmpty() ) {
+            QStringList formats = pm->indexValue( name, "Formats", QStringList() ).toStringList();
+            if( !formats.contains( format ) ) {
+                formats.append( format );
+                pm->setIndexValue( name, "Formats", formats );
+            }
+        }
     }
 
-    // no single format decoder. Search for a multi format decoder
-    Q_FOREACH( K3b::Plugin* plugin, fl ) {
-        K3b::AudioDecoderFactory* f = dynamic_cast<K3b::AudioDecoderFactory*>( plugin );
-        if( f && f->multiFormatDecoder() && f->canDecode( url ) ) {
-            qDebug() << "2"; return f->createDecoder();}
+    if( factory ) {
+        qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " ) using" << factory->metaObject()->className();
+        return factory->createDecoder();
     }
 
     qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " ) no success";
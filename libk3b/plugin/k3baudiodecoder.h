@@ -17,6 +17,8 @@
 
 #include "k3bplugin.h"
 #include "k3bmsf.h"
+#include "k3baudiofilehead.h"
+#include "k3baudioresampler.h"
 #include "k3b_export.h"
 #include <QUrl>
 
@@ -58,6 +60,13 @@ namespace K3b {
          */
         bool isValid() const;
 
+        /**
+         * The quality used to convert files which are not sampled at 44100 Hz.
+         * Defaults to the quality from the global settings.
+         */
+        void setResamplingQuality( AudioResampler::Quality quality );
+        AudioResampler::Quality resamplingQuality() const;
+
         /**
          * Initialize the decoding.
          * Normally there is no need to call this as analyseFile already does so.
@@ -239,12 +248,38 @@ namespace K3b {
          */
         virtual bool canDecode( const QUrl& filename ) = 0;
 
+        enum SniffResult {
+            SNIFF_NO,    /**< The file cannot be decoded. */
+            SNIFF_MAYBE, /**< canDecodeHead() has to decide. */
+            SNIFF_YES    /**< The file is in the format of the decoder. canDecodeHead() has to confirm. */
+        };
+
+        /**
+         * Quick check based on the start and end of the file as read by createDecoder().
+         * It must not open the file. Decoders returning SNIFF_NO are not asked
+         * any further which saves every decoder from opening every file.
+         *
+         * The default implementation returns SNIFF_MAYBE.
+         */
+        virtual SniffResult sniff( const AudioFileHead& head ) const;
+
+        /**
+         * Same as canDecode() but with the start and end of the file already read.
+         * Decoders which can check the format from that data should reimplement it
+         * to avoid opening the file again.
+         *
+         * The default implementation calls canDecode( head.url() ).
+         */
+        virtual bool canDecodeHead( const AudioFileHead& head );
+
         virtual AudioDecoder* createDecoder( QObject* parent = 0 ) const = 0;
 
         /**
          * Searching for an audiodecoder for @p filename.
          *
-         * It first searches the single format decoder and the multiformat decoder.
+         * The file is read only once to ask all decoders to sniff() it. Then
+         * the decoders which recognized the format are asked before those which
+         * were unsure, single format decoders before multiformat decoders.
          *
          * @returns a newly created decoder on success and 0 when no decoder could be found.
          */
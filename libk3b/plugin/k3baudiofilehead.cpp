@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudiofilehead.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+#include <string.h>
+
+
+namespace {
+    const int s_headSize = 16*1024;
+
+    // enough for an APE tag footer in front of an ID3v1 tag
+    const int s_tailSize = 160;
+
+    // MPEG audio frames may be preceded by padding after an ID3v2 tag
+    const int s_maxMpegSyncSearch = 4096;
+
+    // the number of consecutive frame headers required, the same as
+    // the mp3 decoder plugin uses
+    const int s_mpegFrameChain = 5;
+
+    struct Signature {
+        K3b::AudioFileHead::Format format;
+        int offset;
+        const char* magic;
+        int offset2;
+        const char* magic2;
+    };
+
+    // formats sharing a container come with the more specific signature first
+    const Signature s_signatures[] = {
+        { K3b::AudioFileHead::FORMAT_WAVE, 0, "RIFF", 8, "WAVE" },
+        { K3b::AudioFileHead::FORMAT_WAVE, 0, "RF64", 8, "WAVE" },
+        { K3b::AudioFileHead::FORMAT_AIFF, 0, "FORM", 8, "AIFF" },
+        { K3b::AudioFileHead::FORMAT_AIFF, 0, "FORM", 8, "AIFC" },
+        { K3b::AudioFileHead::FORMAT_AU, 0, ".snd", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_FLAC, 0, "fLaC", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_OGG_VORBIS, 0, "OggS", 28, "\x01vorbis" },
+        { K3b::AudioFileHead::FORMAT_OGG_FLAC, 0, "OggS", 28, "\x7f" "FLAC" },
+        { K3b::AudioFileHead::FORMAT_OGG_OPUS, 0, "OggS", 28, "OpusHead" },
+        { K3b::AudioFileHead::FORMAT_OGG, 0, "OggS", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_MUSEPACK, 0, "MPCK", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_MUSEPACK, 0, "MP+", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_MP4, 4, "ftyp", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_ASF, 0, "\x30\x26\xb2\x75\x8e\x66\xcf\x11", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_APE, 0, "MAC ", 0, 0 },
+        { K3b::AudioFileHead::FORMAT_WAVPACK, 0, "wvpk", 0, 0 }
+    };
+
+    struct MpegHeader {
+        int version; // 3: MPEG 1, 2: MPEG 2, 0: MPEG 2.5
+        int layer;   // 1-3
+        int sampleRate;
+        int frameLength;
+    };
+
+    bool parseMpegHeader( const unsigned char* h, MpegHeader& header )
+    {
+        static const int s_bitrates[2][3][15] = {
+            // MPEG 1
+            { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+              { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+              { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+            // MPEG 2 and 2.5
+            { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+              { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+              { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } }
+        };
+        static const int s_sampleRates[3] = { 44100, 48000, 32000 };
+
+        if( h[0] != 0xff || ( h[1] & 0xe0 ) != 0xe0 )
+            return false;
+
+        const int version = ( h[1] >> 3 ) & 0x3;
+        const int layerBits = ( h[1] >> 1 ) & 0x3;
+        const int bitrateIndex = h[2] >> 4;
+        const int sampleRateIndex = ( h[2] >> 2 ) & 0x3;
+        const int padding = ( h[2] >> 1 ) & 0x1;
+
+        // reserved values and free format which has no frame length in the header
+        if( version == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3 )
+            return false;
+
+        header.version = version;
+        header.layer = 4 - layerBits;
+        header.sampleRate = s_sampleRates[sampleRateIndex];
+        if( version == 2 )
+            header.sampleRate /= 2;
+        else if( version == 0 )
+            header.sampleRate /= 4;
+
+        const int bitrate = 1000 * s_bitrates[version == 3 ? 0 : 1][header.layer-1][bitrateIndex];
+        if( header.layer == 1 )
+            header.frameLength = ( 12 * bitrate / header.sampleRate + padding ) * 4;
+        else if( header.layer == 3 && version != 3 )
+            header.frameLength = 72 * bitrate / header.sampleRate + padding;
+        else
+            header.frameLength = 144 * bitrate / header.sampleRate + padding;
+
+        return header.frameLength > 4;
+    }
+
+    // returns the layer of the first frame of a chain of consistent frames or 0
+    int findMpegFrames( const QByteArray& data, bool wholeFile )
+    {
+        const unsigned char* buf = reinterpret_cast<const unsigned char*>( data.constData() );
+        const int size = data.size();
+
+        for( int start = 0; start < qMin( size - 4, s_maxMpegSyncSearch ); ++start ) {
+            MpegHeader first;
+            if( !parseMpegHeader( buf + start, first ) )
+                continue;
+
+            int frames = 1;
+            int pos = start + first.frameLength;
+            while( frames < s_mpegFrameChain && pos + 4 <= size ) {
+                MpegHeader next;
+                if( !parseMpegHeader( buf + pos, next ) ||
+                    next.version != first.version ||
+                    next.layer != first.layer ||
+                    next.sampleRate != first.sampleRate )
+                    break;
+                ++frames;
+                pos += next.frameLength;
+            }
+
+            // very short files may not have enough frames
+            if( frames >= s_mpegFrameChain || ( wholeFile && frames > 1 && pos >= size ) )
+                return first.layer;
+        }
+
+        return 0;
+    }
+}
+
+
+class K3b::AudioFileHead::Private
+{
+public:
+    Private()
+        : size( 0 ),
+          headOffset( 0 ),
+          format( FORMAT_UNKNOWN ),
+          mpegAudioLayer( 0 ),
+          valid( false ) {
+    }
+
+    void detectFormat( const AudioFileHead* h ) {
+        for( unsigned int i = 0; i < sizeof(s_signatures)/sizeof(Signature); ++i ) {
+            const Signature& sig = s_signatures[i];
+            if( h->matches( sig.magic, sig.offset ) &&
+                ( !sig.magic2 || h->matches( sig.magic2, sig.offset2 ) ) ) {
+                format = sig.format;
+                return;
+            }
+        }
+
+        mpegAudioLayer = findMpegFrames( head, headOffset + head.size() >= size );
+        if( mpegAudioLayer > 0 )
+            format = FORMAT_MPEG_AUDIO;
+    }
+
+    QUrl url;
+    qint64 size;
+    qint64 headOffset;
+    QByteArray head;
+    QByteArray tail;
+    Format format;
+    int mpegAudioLayer;
+    bool valid;
+};
+
+
+K3b::AudioFileHead::AudioFileHead( const QUrl& url )
+    : d( new Private() )
+{
+    d->url = url;
+
+    QFile f( url.toLocalFile() );
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        qDebug() << "(K3b::AudioFileHead) could not open" << url.toLocalFile();
+        return;
+    }
+
+    d->size = f.size();
+    d->head = f.read( s_headSize );
+    if( d->head.isEmpty() )
+        return;
+
+    //
+    // Skip an ID3v2 tag. See www.id3.org for details of the header: the size
+    // is stored in 7 bit bytes and does not include the header and footer.
+    //
+    if( d->head.size() >= 10 && d->head.startsWith( "ID3" ) ) {
+        const unsigned char* h = reinterpret_cast<const unsigned char*>( d->head.constData() );
+        d->headOffset = ( ( h[6] & 0x7f ) << 21 | ( h[7] & 0x7f ) << 14 | ( h[8] & 0x7f ) << 7 | ( h[9] & 0x7f ) ) + 10;
+        if( h[5] & 0x10 )
+            d->headOffset += 10;
+
+        if( d->headOffset < d->head.size() ) {
+            // read the rest without reading the start again
+            QByteArray rest = d->head.mid( d->headOffset );
+            d->head = rest + f.read( s_headSize - rest.size() );
+        }
+        else if( f.seek( d->headOffset ) ) {
+            d->head = f.read( s_headSize );
+        }
+        else {
+            d->head.clear();
+        }
+    }
+
+    if( d->size > d->headOffset + d->head.size() ) {
+        const qint64 tailStart = qMax( d->headOffset + d->head.size(), d->size - s_tailSize );
+        if( f.seek( tailStart ) )
+            d->tail = f.read( s_tailSize );
+    }
+    else {
+        d->tail = d->head.right( s_tailSize );
+    }
+
+    d->valid = true;
+    d->detectFormat( this );
+}
+
+
+K3b::AudioFileHead::~AudioFileHead()
+{
+    delete d;
+}
+
+
+bool K3b::AudioFileHead::isValid() const
+{
+    return d->valid;
+}
+
+
+QUrl K3b::AudioFileHead::url() const
+{
+    return d->url;
+}
+
+
+QString K3b::AudioFileHead::extension() const
+{
+    return QFileInfo( d->url.toLocalFile() ).suffix().toLower();
+}
+
+
+qint64 K3b::AudioFileHead::size() const
+{
+    return d->size;
+}
+
+
+qint64 K3b::AudioFileHead::headOffset() const
+{
+    return d->headOffset;
+}
+
+
+QByteArray K3b::AudioFileHead::head() const
+{
+    return d->head;
+}
+
+
+QByteArray K3b::AudioFileHead::tail() const
+{
+    return d->tail;
+}
+
+
+bool K3b::AudioFileHead::matches( const char* magic, int offset ) const
+{
+    const int len = qstrlen( magic );
+    return( offset + len <= d->head.size() &&
+            !memcmp( d->head.constData() + offset, magic, len ) );
+}
+
+
+bool K3b::AudioFileHead::hasId3v2Tag() const
+{
+    return d->headOffset > 0;
+}
+
+
+bool K3b::AudioFileHead::hasId3v1Tag() const
+{
+    return( d->tail.size() >= 128 && !memcmp( d->tail.constData() + d->tail.size() - 128, "TAG", 3 ) );
+}
+
+
+bool K3b::AudioFileHead::hasApeTag() const
+{
+    // the APE tag footer is either the last thing in the file or followed by an ID3v1 tag
+    const int footer = d->tail.size() - ( hasId3v1Tag() ? 128 : 0 ) - 32;
+    return( footer >= 0 && !memcmp( d->tail.constData() + footer, "APETAGEX", 8 ) );
+}
+
+
+K3b::AudioFileHead::Format K3b::AudioFileHead::format() const
+{
+    return d->format;
+}
+
+
+int K3b::AudioFileHead::mpegAudioLayer() const
+{
+    return d->mpegAudioLayer;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_FILE_HEAD_H_
+#define _K3B_AUDIO_FILE_HEAD_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QUrl>
+
+
+namespace K3b {
+    /**
+     * The start and the end of an audio file, read once when searching
+     * a decoder for it.
+     *
+     * A leading ID3v2 tag is skipped: head() starts with the first byte
+     * after the tag. tail() holds the last bytes of the file which contain
+     * an ID3v1 tag or an APE tag footer if there is one.
+     *
+     * The format is determined from the magic numbers at the start of head().
+     * MPEG audio has no magic number. It is only reported if a chain of
+     * consistent frame headers is found.
+     *
+     * \see AudioDecoderFactory::sniff()
+     */
+    class LIBK3B_EXPORT AudioFileHead
+    {
+    public:
+        /**
+         * Reads the head and tail of the local file \p url.
+         */
+        explicit AudioFileHead( const QUrl& url );
+        ~AudioFileHead();
+
+        enum Format {
+            FORMAT_UNKNOWN,
+            FORMAT_WAVE,
+            FORMAT_AIFF,
+            FORMAT_AU,
+            FORMAT_FLAC,
+            FORMAT_OGG_VORBIS,
+            FORMAT_OGG_FLAC,
+            FORMAT_OGG_OPUS,
+            FORMAT_OGG,          /**< Any other Ogg stream */
+            FORMAT_MUSEPACK,
+            FORMAT_MPEG_AUDIO,
+            FORMAT_MP4,
+            FORMAT_ASF,
+            FORMAT_APE,
+            FORMAT_WAVPACK
+        };
+
+        /**
+         * \return false if the file could not be read or is empty.
+         */
+        bool isValid() const;
+
+        QUrl url() const;
+
+        /**
+         * The suffix of the file name in lower case.
+         */
+        QString extension() const;
+
+        qint64 size() const;
+
+        /**
+         * The size of the leading ID3v2 tag, i.e. the file offset of head().
+         */
+        qint64 headOffset() const;
+
+        /**
+         * Up to the first 16 KB after a leading ID3v2 tag.
+         */
+        QByteArray head() const;
+
+        /**
+         * Up to the last 160 bytes of the file.
+         */
+        QByteArray tail() const;
+
+        /**
+         * \return true if \p magic is found at \p offset in head().
+         */
+        bool matches( const char* magic, int offset = 0 ) const;
+
+        bool hasId3v2Tag() const;
+        bool hasId3v1Tag() const;
+        bool hasApeTag() const;
+
+        Format format() const;
+
+        /**
+         * The MPEG audio layer (1-3) of the first frame header if
+         * format() is FORMAT_MPEG_AUDIO, 0 otherwise.
+         */
+        int mpegAudioLayer() const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AudioFileHead )
+    };
+}
+
+#endif
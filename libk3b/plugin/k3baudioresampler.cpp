@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudioresampler.h"
+
+#include <QDebug>
+#include <QVector>
+
+#include <math.h>
+#include <string.h>
+
+#include <samplerate.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+    const int s_cdSamplerate = 44100;
+
+    // the largest interpolation factor we build a filter bank for. 441 covers
+    // all multiples of 100 Hz and 11025 Hz (e.g. 32000 Hz is 441/320).
+    const int s_maxUp = 441;
+    const int s_maxSamplerate = 384000;
+
+    struct FilterDesign {
+        double attenuation;   // stop band attenuation in dB
+        double passband;      // fraction of the output bandwidth kept untouched
+    };
+
+    // indexed by AudioResampler::Quality
+    const FilterDesign s_designs[] = {
+        { 60.0, 0.80 },
+        { 90.0, 0.88 },
+        { 120.0, 0.92 }
+    };
+
+    int greatestCommonDivisor( int a, int b )
+    {
+        while( b ) {
+            const int t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    // the zeroth order modified Bessel function of the first kind, needed for the Kaiser window
+    double besselI0( double x )
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for( int k = 1; k < 100; ++k ) {
+            const double f = x / ( 2.0 * k );
+            term *= f * f;
+            sum += term;
+            if( term < sum * 1e-12 )
+                break;
+        }
+        return sum;
+    }
+
+    // n is a multiple of 8
+    inline float dotProduct( const float* a, const float* b, int n )
+    {
+#if defined(__SSE__)
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for( int i = 0; i < n; i += 8 ) {
+            sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+            sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ), _mm_loadu_ps( b + i + 4 ) ) );
+        }
+        float s[4];
+        _mm_storeu_ps( s, _mm_add_ps( sum0, sum1 ) );
+        return s[0] + s[1] + s[2] + s[3];
+#elif defined(__ARM_NEON)
+        float32x4_t sum0 = vdupq_n_f32( 0.0f );
+        float32x4_t sum1 = vdupq_n_f32( 0.0f );
+        for( int i = 0; i < n; i += 8 ) {
+            sum0 = vmlaq_f32( sum0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+            sum1 = vmlaq_f32( sum1, vld1q_f32( a + i + 4 ), vld1q_f32( b + i + 4 ) );
+        }
+        const float32x4_t sum = vaddq_f32( sum0, sum1 );
+        return vgetq_lane_f32( sum, 0 ) + vgetq_lane_f32( sum, 1 ) + vgetq_lane_f32( sum, 2 ) + vgetq_lane_f32( sum, 3 );
+#else
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        for( int i = 0; i < n; i += 4 ) {
+            s0 += a[i] * b[i];
+            s1 += a[i+1] * b[i+1];
+            s2 += a[i+2] * b[i+2];
+            s3 += a[i+3] * b[i+3];
+        }
+        return ( s0 + s1 ) + ( s2 + s3 );
+#endif
+    }
+}
+
+
+class K3b::AudioResampler::Private
+{
+public:
+    Private()
+        : up( 0 ),
+          down( 0 ),
+          taps( 0 ),
+          bufferFill( 0 ),
+          bufferPos( 0 ),
+          phase( 0 ),
+          inputFrames( 0 ),
+          outputFrames( 0 ),
+          flushed( false ),
+          srcState( 0 ),
+          valid( false ) {
+    }
+
+    void initPolyphase();
+    void resetPolyphase();
+    void append( const float* in, int frames );
+    int processPolyphase( const float* in, int inFrames, float* out, int maxOutFrames, int& inFramesUsed, bool endOfInput );
+    int processSrc( const float* in, int inFrames, float* out, int maxOutFrames, int& inFramesUsed, bool endOfInput );
+
+    int samplerate;
+    int channels;
+    Quality quality;
+
+    //
+    // The polyphase filter interpolates by up and decimates by down. Output
+    // frame n is taken from the virtual upsampled signal at n*down. The
+    // coefficients of each of the up phases are stored in reverse order so
+    // the filter is a plain dot product with the buffered input.
+    //
+    int up;
+    int down;
+    int taps;
+    QVector<float> coefficients;
+
+    // the input of each channel, starting with taps-1 frames of history
+    QVector<float> buffer[2];
+    int bufferFill;
+    int bufferPos;  // first buffer frame of the filter window for the next output frame
+    int phase;
+
+    quint64 inputFrames;
+    quint64 outputFrames;
+    bool flushed;
+
+    SRC_STATE* srcState;
+
+    bool valid;
+};
+
+
+void K3b::AudioResampler::Private::initPolyphase()
+{
+    const int g = greatestCommonDivisor( samplerate, s_cdSamplerate );
+    up = s_cdSamplerate / g;
+    down = samplerate / g;
+
+    //
+    // Kaiser windowed sinc designed at the upsampled rate. When decimating
+    // the stop band starts at the output Nyquist frequency, otherwise at the
+    // input Nyquist frequency. Frequencies are in cycles per input frame.
+    //
+    const FilterDesign& design = s_designs[quality];
+    const double stop = 0.5 * qMin( 1.0, double( up ) / double( down ) );
+    const double pass = stop * design.passband;
+    const double cutoff = 0.5 * ( pass + stop );
+    const int minTaps = int( ceil( ( design.attenuation - 8.0 ) / ( 2.285 * 2.0 * M_PI * ( stop - pass ) ) ) );
+    taps = ( minTaps + 7 ) & ~7;
+
+    const int length = up * taps;
+    const double beta = 0.1102 * ( design.attenuation - 8.7 );
+    // an integer center so the delay can be compensated exactly. With an
+    // even length the last coefficient stays zero.
+    const int center = ( length - 1 ) / 2;
+    const double i0Beta = besselI0( beta );
+
+    QVector<double> h( length );
+    double sum = 0.0;
+    for( int j = 0; j < length; ++j ) {
+        if( j > 2*center ) {
+            h[j] = 0.0;
+            continue;
+        }
+        const double x = double( j - center ) / double( up );
+        const double sinc = ( j == center ? 2.0 * cutoff : sin( 2.0 * M_PI * cutoff * x ) / ( M_PI * x ) );
+        const double r = double( j - center ) / double( center );
+        const double window = besselI0( beta * sqrt( 1.0 - r * r ) ) / i0Beta;
+        h[j] = sinc * window;
+        sum += h[j];
+    }
+
+    // unity gain for each phase on average
+    coefficients.resize( length );
+    for( int p = 0; p < up; ++p )
+        for( int k = 0; k < taps; ++k )
+            coefficients[p*taps + taps-1-k] = float( h[p + k*up] * double( up ) / sum );
+
+    qDebug() << "(K3b::AudioResampler)" << samplerate << "Hz:" << up << "/" << down
+             << "with" << taps << "taps per phase";
+}
+
+
+void K3b::AudioResampler::Private::resetPolyphase()
+{
+    for( int c = 0; c < channels; ++c ) {
+        if( buffer[c].size() < taps )
+            buffer[c].resize( taps );
+        ::memset( buffer[c].data(), 0, ( taps - 1 ) * sizeof( float ) );
+    }
+    bufferFill = taps - 1;
+
+    // compensate the delay of the linear phase filter
+    const int delay = ( up * taps - 1 ) / 2;
+    bufferPos = delay / up;
+    phase = delay % up;
+
+    inputFrames = outputFrames = 0;
+    flushed = false;
+}
+
+
+void K3b::AudioResampler::Private::append( const float* in, int frames )
+{
+    for( int c = 0; c < channels; ++c ) {
+        if( buffer[c].size() < bufferFill + frames )
+            buffer[c].resize( qMax( bufferFill + frames, 2*buffer[c].size() ) );
+
+        float* dest = buffer[c].data() + bufferFill;
+        if( in ) {
+            for( int i = 0; i < frames; ++i )
+                dest[i] = in[i*channels + c];
+        }
+        else {
+            ::memset( dest, 0, frames * sizeof( float ) );
+        }
+    }
+    bufferFill += frames;
+}
+
+
+int K3b::AudioResampler::Private::processPolyphase( const float* in, int inFrames,
+                                                    float* out, int maxOutFrames,
+                                                    int& inFramesUsed, bool endOfInput )
+{
+    inFramesUsed = 0;
+    int produced = 0;
+
+    while( produced < maxOutFrames ) {
+        if( bufferPos + taps > bufferFill ) {
+            const int available = inFrames - inFramesUsed;
+            if( available > 0 ) {
+                // take what is needed for the free output space, not everything
+                const int wanted = int( qint64( maxOutFrames - produced ) * down / up ) + taps;
+                const int frames = qMin( available, qMax( wanted, bufferPos + taps - bufferFill ) );
+                append( in + inFramesUsed*channels, frames );
+                inFramesUsed += frames;
+                inputFrames += frames;
+                continue;
+            }
+            else if( endOfInput && !flushed ) {
+                append( 0, taps );
+                flushed = true;
+                continue;
+            }
+            else {
+                break;
+            }
+        }
+
+        // after the flush stop at the length the input corresponds to
+        if( flushed && outputFrames >= ( inputFrames * up + down - 1 ) / down )
+            break;
+
+        const float* coef = coefficients.constData() + phase*taps;
+        for( int c = 0; c < channels; ++c )
+            out[produced*channels + c] = dotProduct( coef, buffer[c].constData() + bufferPos, taps );
+
+        ++produced;
+        ++outputFrames;
+        phase += down;
+        bufferPos += phase / up;
+        phase %= up;
+    }
+
+    // drop the frames which are not needed anymore. When decimating the
+    // window may already start behind the buffered frames.
+    const int drop = qMin( bufferPos, bufferFill );
+    if( drop > 0 ) {
+        for( int c = 0; c < channels; ++c )
+            ::memmove( buffer[c].data(), buffer[c].constData() + drop, ( bufferFill - drop ) * sizeof( float ) );
+        bufferFill -= drop;
+        bufferPos -= drop;
+    }
+
+    return produced;
+}
+
+
+int K3b::AudioResampler::Private::processSrc( const float* in, int inFrames,
+                                              float* out, int maxOutFrames,
+                                              int& inFramesUsed, bool endOfInput )
+{
+    SRC_DATA data;
+    data.data_in = const_cast<float*>( in );
+    data.data_out = out;
+    data.input_frames = inFrames;
+    data.output_frames = maxOutFrames;
+    data.src_ratio = double( s_cdSamplerate ) / double( samplerate );
+    data.end_of_input = endOfInput ? 1 : 0;  // this forces libsamplerate to output the last frames
+
+    const int error = src_process( srcState, &data );
+    if( error ) {
+        qDebug() << "(K3b::AudioResampler) error while resampling: " << src_strerror( error );
+        inFramesUsed = 0;
+        return -1;
+    }
+
+    inFramesUsed = data.input_frames_used;
+    return data.output_frames_gen;
+}
+
+
+K3b::AudioResampler::AudioResampler( int samplerate, int channels, Quality quality )
+    : d( new Private() )
+{
+    d->samplerate = samplerate;
+    d->channels = channels;
+    d->quality = quality;
+
+    if( channels < 1 || channels > 2 || samplerate <= 0 ) {
+        qDebug() << "(K3b::AudioResampler) unsupported format:" << samplerate << "Hz," << channels << "channels";
+        return;
+    }
+
+    if( hasPolyphaseFilter( samplerate ) ) {
+        d->initPolyphase();
+        d->resetPolyphase();
+        d->valid = true;
+    }
+    else {
+        static const int s_srcConverters[] = {
+            SRC_SINC_FASTEST,
+            SRC_SINC_MEDIUM_QUALITY,
+            SRC_SINC_BEST_QUALITY
+        };
+        int error = 0;
+        d->srcState = src_new( s_srcConverters[quality], channels, &error );
+        if( !d->srcState )
+            qDebug() << "(K3b::AudioResampler) unable to initialize libsamplerate:" << src_strerror( error );
+        d->valid = ( d->srcState != 0 );
+    }
+}
+
+
+K3b::AudioResampler::~AudioResampler()
+{
+    if( d->srcState )
+        src_delete( d->srcState );
+    delete d;
+}
+
+
+bool K3b::AudioResampler::hasPolyphaseFilter( int samplerate )
+{
+    if( samplerate <= 0 || samplerate > s_maxSamplerate )
+        return false;
+    return s_cdSamplerate / greatestCommonDivisor( samplerate, s_cdSamplerate ) <= s_maxUp;
+}
+
+
+bool K3b::AudioResampler::isValid() const
+{
+    return d->valid;
+}
+
+
+bool K3b::AudioResampler::usesPolyphaseFilter() const
+{
+    return d->up > 0;
+}
+
+
+int K3b::AudioResampler::samplerate() const
+{
+    return d->samplerate;
+}
+
+
+int K3b::AudioResampler::channels() const
+{
+    return d->channels;
+}
+
+
+K3b::AudioResampler::Quality K3b::AudioResampler::quality() const
+{
+    return d->quality;
+}
+
+
+void K3b::AudioResampler::reset()
+{
+    if( d->srcState )
+        src_reset( d->srcState );
+    else if( d->valid )
+        d->resetPolyphase();
+}
+
+
+int K3b::AudioResampler::process( const float* in, int inFrames,
+                                  float* out, int maxOutFrames,
+                                  int& inFramesUsed, bool endOfInput )
+{
+    if( !d->valid ) {
+        inFramesUsed = 0;
+        return -1;
+    }
+
+    if( d->srcState )
+        return d->processSrc( in, inFrames, out, maxOutFrames, inFramesUsed, endOfInput );
+    else
+        return d->processPolyphase( in, inFrames, out, maxOutFrames, inFramesUsed, endOfInput );
+}
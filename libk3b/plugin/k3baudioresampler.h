@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_RESAMPLER_H_
+#define _K3B_AUDIO_RESAMPLER_H_
+
+#include "k3b_export.h"
+
+#include <QtGlobal>
+
+
+namespace K3b {
+    /**
+     * Converts interleaved float samples of one or two channels to 44100 Hz.
+     *
+     * Rates with a small integer ratio to 44100 Hz (48000 Hz: 147/160,
+     * 96000 Hz: 147/320, 88200 Hz: 1/2, 32000 Hz: 441/320, ...) are
+     * converted with a polyphase FIR filter. All other rates are handed
+     * to libsamplerate.
+     *
+     * The quality selects the filter length and stop band attenuation of
+     * the polyphase filter or the libsamplerate converter respectively.
+     */
+    class LIBK3B_EXPORT AudioResampler
+    {
+    public:
+        enum Quality {
+            QualityFast,    /**< about 60 dB, for previews and on-the-fly writing on slow systems */
+            QualityMedium,  /**< about 90 dB, the default */
+            QualityBest     /**< about 120 dB */
+        };
+
+        AudioResampler( int samplerate, int channels, Quality quality = QualityMedium );
+        ~AudioResampler();
+
+        /**
+         * \return true if \p samplerate is converted with the polyphase
+         * filter and not with libsamplerate.
+         */
+        static bool hasPolyphaseFilter( int samplerate );
+
+        /**
+         * \return false if the converter could not be initialized.
+         */
+        bool isValid() const;
+
+        bool usesPolyphaseFilter() const;
+
+        int samplerate() const;
+        int channels() const;
+        Quality quality() const;
+
+        /**
+         * Forget all buffered samples, for example after seeking.
+         */
+        void reset();
+
+        /**
+         * Converts up to \p inFrames frames from \p in into at most \p maxOutFrames
+         * frames in \p out.
+         *
+         * Not all input may be consumed if the output is full. Set \p endOfInput
+         * once all input has been passed to flush the filter.
+         *
+         * \param inFramesUsed is set to the number of frames taken from \p in.
+         *
+         * \return The number of frames written to \p out or -1 on error.
+         */
+        int process( const float* in, int inFrames,
+                     float* out, int maxOutFrames,
+                     int& inFramesUsed, bool endOfInput );
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AudioResampler )
+    };
+}
+
+#endif
@@ -21,7 +21,7 @@
 #include <KPluginInfo>
 #include <QObject>
 
-#define K3B_PLUGIN_SYSTEM_VERSION 5
+#define K3B_PLUGIN_SYSTEM_VERSION 6
 
 
 
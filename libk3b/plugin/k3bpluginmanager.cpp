@@ -21,16 +21,22 @@
 
 #include <KCModuleInfo>
 #include <KCModuleProxy>
+#include <KConfig>
+#include <KConfigGroup>
 #include <KPluginInfo>
+#include <KPluginLoader>
 #include <KService>
 #include <KServiceTypeTrader>
 #include <KMessageBox>
 
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QList>
 #include <QMap>
 #include <QSharedPointer>
+#include <QStandardPaths>
 #include <QAbstractButton>
 #include <QDialog>
 #include <QDialogButtonBox>
@@ -42,12 +48,27 @@ class K3b::PluginManager::Private
 {
 public:
     Private( K3b::PluginManager* parent )
-        : m_parent( parent ) {
+        : index( 0 ),
+          m_parent( parent ) {
     }
 
-    QList<K3b::Plugin*> plugins;
+    ~Private() {
+        delete index;
+    }
+
+    struct Entry {
+        KService::Ptr service;
+        QString name;
+        QString category;
+        K3b::Plugin* plugin;
+        bool loaded;
+    };
+
+    QList<Entry> entries;
+    KConfig* index;
 
-    void loadPlugin( const KService::Ptr &service );
+    K3b::Plugin* loadPlugin( Entry& entry );
+    KConfig* indexConfig();
     KCModuleProxy* getModuleProxy( Plugin* plugin ) const;
 
 private:
@@ -74,11 +95,9 @@ K3b::PluginManager::~PluginManager()
 QStringList K3b::PluginManager::categories() const
 {
     QStringList grps;
-
-    QList<K3b::Plugin*> fl;
-    Q_FOREACH( K3b::Plugin* plugin, d->plugins ) {
-        if( !grps.contains( plugin->category() ) )
-            grps.append( plugin->category() );
+    Q_FOREACH( const Private::Entry& entry, d->entries ) {
+        if( !grps.contains( entry.category ) )
+            grps.append( entry.category );
     }
 
     return grps;
@@ -88,16 +107,70 @@ QStringList K3b::PluginManager::categories() const
 QList<K3b::Plugin*> K3b::PluginManager::plugins( const QString& group ) const
 {
     QList<K3b::Plugin*> fl;
-    Q_FOREACH( K3b::Plugin* plugin, d->plugins ) {
-        if( plugin->category() == group || group.isEmpty() )
-            fl.append( plugin );
+    for( int i = 0; i < d->entries.count(); ++i ) {
+        if( d->entries[i].category == group || group.isEmpty() ) {
+            K3b::Plugin* plugin = d->loadPlugin( d->entries[i] );
+            if( plugin && ( plugin->category() == group || group.isEmpty() ) )
+                fl.append( plugin );
+        }
     }
     return fl;
 }
 
 
-void K3b::PluginManager::Private::loadPlugin( const KService::Ptr &service )
+QStringList K3b::PluginManager::pluginNames( const QString& group ) const
+{
+    QStringList names;
+    Q_FOREACH( const Private::Entry& entry, d->entries ) {
+        if( entry.category == group || group.isEmpty() )
+            names.append( entry.name );
+    }
+    return names;
+}
+
+
+K3b::Plugin* K3b::PluginManager::plugin( const QString& name ) const
+{
+    for( int i = 0; i < d->entries.count(); ++i ) {
+        if( d->entries[i].name == name )
+            return d->loadPlugin( d->entries[i] );
+    }
+    return 0;
+}
+
+
+QVariant K3b::PluginManager::indexValue( const QString& name, const QString& key, const QVariant& defaultValue ) const
 {
+    return KConfigGroup( d->indexConfig(), name ).readEntry( key, defaultValue );
+}
+
+
+void K3b::PluginManager::setIndexValue( const QString& name, const QString& key, const QVariant& value )
+{
+    KConfigGroup grp( d->indexConfig(), name );
+    grp.writeEntry( key, value );
+    grp.sync();
+}
+
+
+KConfig* K3b::PluginManager::Private::indexConfig()
+{
+    if( !index ) {
+        const QString dir = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation ) + "/k3b";
+        QDir().mkpath( dir );
+        index = new KConfig( dir + "/pluginindex", KConfig::SimpleConfig );
+    }
+    return index;
+}
+
+
+K3b::Plugin* K3b::PluginManager::Private::loadPlugin( Entry& entry )
+{
+    if( entry.loaded )
+        return entry.plugin;
+    entry.loaded = true;
+
+    const KService::Ptr& service = entry.service;
     qDebug() << service->name() << service->library();
     QString err;
     K3b::Plugin* plugin = service->createInstance<K3b::Plugin>( 0, m_parent, QVariantList(), &err );
@@ -106,17 +179,20 @@ void K3b::PluginManager::Private::loadPlugin( const KService::Ptr &service )
         // FIXME: improve this versioning stuff
         if( plugin->pluginSystemVersion() != K3B_PLUGIN_SYSTEM_VERSION ) {
             delete plugin;
+            plugin = 0;
             qDebug() << "plugin system does not fit";
         }
         else {
             plugin->m_pluginInfo = KPluginInfo( service );
-            plugins.append( plugin );
+            entry.plugin = plugin;
         }
     }
     else {
         qDebug() << "Loading plugin" << service->name() << "failed. Error:" << err;
     }
 
+    return plugin;
+
 
 // 	// make sure to only use the latest version of one plugin
 // 	bool addPlugin = true;
@@ -156,9 +232,45 @@ KCModuleProxy* K3b::PluginManager::Private::getModuleProxy( Plugin* plugin ) con
 void K3b::PluginManager::loadAll()
 {
     qDebug();
+    if( !d->entries.isEmpty() )
+        return;
+
+    KConfig* index = d->indexConfig();
+
     KService::List services = KServiceTypeTrader::self()->query( "K3b/Plugin" );
     Q_FOREACH( const KService::Ptr &service, services ) {
-        d->loadPlugin( service );
+        KPluginInfo info( service );
+
+        Private::Entry entry;
+        entry.service = service;
+        entry.name = info.pluginName().isEmpty() ? service->library() : info.pluginName();
+        entry.category = info.category();
+        entry.plugin = 0;
+        entry.loaded = false;
+
+        // forget what we know about plugins which have been replaced
+        const QString library = KPluginLoader::findPlugin( service->library() );
+        // KConfig drops the milliseconds of a QDateTime, so store plain seconds
+        const qint64 modified = QFileInfo( library ).lastModified().toSecsSinceEpoch();
+        KConfigGroup grp( index, entry.name );
+        if( grp.readEntry( "Library", QString() ) != library ||
+            grp.readEntry( "Modified", qint64( -1 ) ) != modified ||
+            grp.readEntry( "Plugin System Version", 0 ) != K3B_PLUGIN_SYSTEM_VERSION ) {
+            grp.deleteGroup();
+            grp.writeEntry( "Library", library );
+            grp.writeEntry( "Modified", modified );
+            grp.writeEntry( "Plugin System Version", K3B_PLUGIN_SYSTEM_VERSION );
+            grp.writeEntry( "Category", entry.category );
+        }
+
+        d->entries.append( entry );
+    }
+
+    index->sync();
+
+    for( int i = 0; i < d->entries.count(); ++i ) {
+        if( d->entries[i].service->property( "X-K3b-LoadOnStartup", QVariant::Bool ).toBool() )
+            d->loadPlugin( d->entries[i] );
     }
 }
 
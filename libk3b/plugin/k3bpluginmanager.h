@@ -20,6 +20,7 @@
 #include <QList>
 #include <QObject>
 #include <QStringList>
+#include <QVariant>
 
 class QWidget;
 
@@ -33,6 +34,15 @@ namespace K3b {
      * KParts Plugins!).
      * Like the Core the single instance (which has to be created manually)
      * can be obtained with the k3bpluginmanager macro.
+     *
+     * Plugins are loaded lazily: loadAll() only builds an index of the
+     * installed plugins from their desktop files. The library of a plugin is
+     * loaded the first time the plugin or its category is requested. Plugins
+     * which have to be loaded at startup set X-K3b-LoadOnStartup in their
+     * desktop file.
+     *
+     * The index is persisted together with metadata which is only known once
+     * a plugin has been loaded, see indexValue().
      */
     class LIBK3B_EXPORT PluginManager : public QObject
     {
@@ -44,6 +54,8 @@ namespace K3b {
 
         /**
          * if group is empty all plugins are returned
+         *
+         * All plugins of the category are loaded.
          */
         QList<Plugin*> plugins( const QString& category = QString() ) const;
 
@@ -52,11 +64,35 @@ namespace K3b {
          */
         QStringList categories() const;
 
+        /**
+         * The names of the plugins in \p category without loading them.
+         * If category is empty the names of all plugins are returned.
+         */
+        QStringList pluginNames( const QString& category = QString() ) const;
+
+        /**
+         * The plugin called \p name. It is loaded if that did not happen yet.
+         *
+         * \return 0 if there is no such plugin or it could not be loaded.
+         */
+        Plugin* plugin( const QString& name ) const;
+
+        /**
+         * Metadata saved for the plugin \p name in the persistent index,
+         * for example the formats an audio decoder handled before. The values
+         * are dropped when the plugin library changes.
+         */
+        QVariant indexValue( const QString& name, const QString& key, const QVariant& defaultValue = QVariant() ) const;
+        void setIndexValue( const QString& name, const QString& key, const QVariant& value );
+
         int pluginSystemVersion() const;
         
         bool hasPluginDialog( Plugin* plugin ) const;
 
     public Q_SLOTS:
+        /**
+         * Builds the plugin index. Only plugins with X-K3b-LoadOnStartup are loaded.
+         */
         void loadAll();
 
         int execPluginDialog( Plugin* plugin, QWidget* parent = 0 );
@@ -61,6 +61,7 @@ public:
 
     bool hideFirstTrack;
     bool normalize;
+    bool verifyData;
 
     // CD-Text
     // --------------------------------------------------
@@ -110,6 +111,7 @@ bool K3b::AudioDoc::newDocument()
 {
     clear();
     d->normalize = false;
+    d->verifyData = false;
     d->hideFirstTrack = false;
     d->cdText = false;
     d->cdTextData.clear();
@@ -564,6 +566,12 @@ void K3b::AudioDoc::setNormalize( bool b )
 }
 
 
+void K3b::AudioDoc::setVerifyData( bool b )
+{
+    d->verifyData = b;
+}
+
+
 void K3b::AudioDoc::writeCdText( bool b )
 {
     d->cdText = b;
@@ -594,6 +602,9 @@ bool K3b::AudioDoc::loadDocumentData( QDomElement* root )
         else if( e.nodeName() == "normalize" )
             setNormalize( e.text() == "yes" );
 
+        else if( e.nodeName() == "verify_data" )
+            setVerifyData( e.text() == "yes" );
+
         else if( e.nodeName() == "hide_first_track" )
             setHideFirstTrack( e.text() == "yes" );
 
@@ -799,6 +810,11 @@ bool K3b::AudioDoc::saveDocumentData( QDomElement* docElem )
     normalizeElem.appendChild( doc.createTextNode( normalize() ? "yes" : "no" ) );
     docElem->appendChild( normalizeElem );
 
+    // add verify
+    QDomElement verifyElem = doc.createElement( "verify_data" );
+    verifyElem.appendChild( doc.createTextNode( verifyData() ? "yes" : "no" ) );
+    docElem->appendChild( verifyElem );
+
     // add hide track
     QDomElement hideFirstTrackElem = doc.createElement( "hide_first_track" );
     hideFirstTrackElem.appendChild( doc.createTextNode( hideFirstTrack() ? "yes" : "no" ) );
@@ -1004,6 +1020,12 @@ bool K3b::AudioDoc::normalize() const
 }
 
 
+bool K3b::AudioDoc::verifyData() const
+{
+    return d->verifyData;
+}
+
+
 K3b::BurnJob* K3b::AudioDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
     return new K3b::AudioJob( this, hdl, parent );
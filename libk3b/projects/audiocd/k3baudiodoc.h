@@ -64,6 +64,12 @@ namespace K3b {
 
         bool normalize() const;
 
+        /**
+         * Read the written disc back and compare it with the checksums
+         * calculated while writing.
+         */
+        bool verifyData() const;
+
         AudioTrack* firstTrack() const;
         AudioTrack* lastTrack() const;
 
@@ -163,6 +169,7 @@ namespace K3b {
 
         void setHideFirstTrack( bool b );
         void setNormalize( bool b );
+        void setVerifyData( bool b );
 
         // CD-Text
         void writeCdText( bool b );
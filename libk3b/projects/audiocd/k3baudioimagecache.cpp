@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudioimagecache.h"
+#include "k3baudiotrack.h"
+#include "k3baudiodatasource.h"
+#include "k3baudiofile.h"
+#include "k3baudiocdtracksource.h"
+#include "k3brawaudiodatasource.h"
+#include "k3baudiozerodata.h"
+#include "k3bcore.h"
+#include "k3bglobalsettings.h"
+#include "k3btoc.h"
+
+#include <KDiskFreeSpaceInfo>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+
+namespace {
+    // bump when the stored data or the key changes
+    const int s_cacheVersion = 2;
+
+    const char s_dataSuffix[] = ".pcm";
+    const char s_partSuffix[] = ".part";
+
+    // unfinished files of crashed or parallel runs
+    const qint64 s_stalePartSeconds = 24*60*60;
+
+    QString fileIdentity( const QString& path )
+    {
+        const QFileInfo fi( path );
+        return QString( "%1:%2:%3" )
+            .arg( fi.absoluteFilePath() )
+            .arg( fi.size() )
+            .arg( fi.lastModified().toMSecsSinceEpoch() );
+    }
+
+    // the CDDB disc id is a weak hash of the track offsets and different
+    // discs share it, so the offsets themselves identify the disc
+    QString tocIdentity( const K3b::Device::Toc& toc )
+    {
+        QStringList starts;
+        Q_FOREACH( const K3b::Device::Track& track, toc )
+            starts << QString::number( track.firstSector().lba() );
+        starts << QString::number( toc.last().lastSector().lba() + 1 );
+        return starts.join( QChar(',') );
+    }
+}
+
+
+class K3b::AudioImageCache::Private
+{
+public:
+    QString path( const QString& key, const char* suffix ) const {
+        return folder + '/' + key + QLatin1String( suffix );
+    }
+
+    void evict( qint64 limit );
+
+    QString folder;
+    qint64 maxSize;
+};
+
+
+void K3b::AudioImageCache::Private::evict( qint64 limit )
+{
+    QDir dir( folder );
+
+    const QDateTime now = QDateTime::currentDateTime();
+    Q_FOREACH( const QFileInfo& fi, dir.entryInfoList( QStringList() << QString( "*%1" ).arg( s_partSuffix ), QDir::Files ) ) {
+        if( fi.lastModified().secsTo( now ) > s_stalePartSeconds )
+            QFile::remove( fi.absoluteFilePath() );
+    }
+
+    // oldest first
+    QFileInfoList entries = dir.entryInfoList( QStringList() << QString( "*%1" ).arg( s_dataSuffix ),
+                                               QDir::Files, QDir::Time|QDir::Reversed );
+    qint64 total = 0;
+    Q_FOREACH( const QFileInfo& fi, entries )
+        total += fi.size();
+
+    for( int i = 0; i < entries.count() && total > limit; ++i ) {
+        qDebug() << "(K3b::AudioImageCache) removing" << entries[i].fileName() << "last used" << entries[i].lastModified();
+        if( QFile::remove( entries[i].absoluteFilePath() ) )
+            total -= entries[i].size();
+    }
+}
+
+
+K3b::AudioImageCache::AudioImageCache()
+    : d( new Private() )
+{
+    d->folder = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation ) + "/k3b/audioimages";
+    d->maxSize = k3bcore ? qint64( k3bcore->globalSettings()->audioImageCacheSize() ) * 1024LL * 1024LL : 0;
+}
+
+
+K3b::AudioImageCache::~AudioImageCache()
+{
+    delete d;
+}
+
+
+void K3b::AudioImageCache::setMaxSize( qint64 bytes )
+{
+    d->maxSize = qMax( 0LL, bytes );
+}
+
+
+qint64 K3b::AudioImageCache::maxSize() const
+{
+    return d->maxSize;
+}
+
+
+bool K3b::AudioImageCache::isEnabled() const
+{
+    return d->maxSize > 0;
+}
+
+
+QString K3b::AudioImageCache::cacheFolder() const
+{
+    return d->folder;
+}
+
+
+QString K3b::AudioImageCache::key( const AudioTrack& track )
+{
+    QStringList parts;
+    parts << QString( "v%1" ).arg( s_cacheVersion )
+          << QString( "length:%1" ).arg( track.length().lba() );
+
+    // the decoded data of resampled files depends on the quality
+    if( k3bcore )
+        parts << QString( "resampling:%1" ).arg( int( k3bcore->globalSettings()->resamplingQuality() ) );
+
+    for( AudioDataSource* source = track.firstSource(); source; source = source->next() ) {
+        QString identity;
+        if( AudioFile* file = dynamic_cast<AudioFile*>( source ) )
+            identity = "file:" + fileIdentity( file->filename() );
+        else if( RawAudioDataSource* raw = dynamic_cast<RawAudioDataSource*>( source ) )
+            identity = "raw:" + fileIdentity( raw->path() );
+        else if( AudioCdTrackSource* cdTrack = dynamic_cast<AudioCdTrackSource*>( source ) ) {
+            // sources loaded from a project only know the disc id
+            if( cdTrack->toc().isEmpty() )
+                return QString();
+            identity = QString( "cd:%1:%2" ).arg( tocIdentity( cdTrack->toc() ) ).arg( cdTrack->cdTrackNumber() );
+        }
+        else if( dynamic_cast<AudioZeroData*>( source ) )
+            identity = "zero";
+        else
+            return QString();
+
+        parts << QString( "%1:%2:%3" ).arg( identity ).arg( source->startOffset().lba() ).arg( source->length().lba() );
+    }
+
+    return QString::fromLatin1( QCryptographicHash::hash( parts.join( QChar('\n') ).toUtf8(), QCryptographicHash::Md5 ).toHex() );
+}
+
+
+QString K3b::AudioImageCache::lookup( const QString& key, qint64 size )
+{
+    if( !isEnabled() || key.isEmpty() )
+        return QString();
+
+    QFile f( d->path( key, s_dataSuffix ) );
+    if( f.size() != size || !f.open( QIODevice::ReadOnly ) )
+        return QString();
+
+    // the modification time is the last use
+    f.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+    return f.fileName();
+}
+
+
+QString K3b::AudioImageCache::reserve( const QString& key, qint64 size )
+{
+    if( !isEnabled() || key.isEmpty() || size > d->maxSize )
+        return QString();
+
+    if( !QDir().mkpath( d->folder ) ) {
+        qDebug() << "(K3b::AudioImageCache) unable to create" << d->folder;
+        return QString();
+    }
+
+    d->evict( d->maxSize - size );
+
+    KDiskFreeSpaceInfo free = KDiskFreeSpaceInfo::freeSpaceInfo( d->folder );
+    if( free.isValid() && free.available() < KIO::filesize_t( size ) ) {
+        qDebug() << "(K3b::AudioImageCache) not enough space for" << size << "bytes in" << d->folder;
+        return QString();
+    }
+
+    const QString part = d->path( key, s_partSuffix );
+    QFile::remove( part );
+    return part;
+}
+
+
+bool K3b::AudioImageCache::commit( const QString& key )
+{
+    const QString data = d->path( key, s_dataSuffix );
+    QFile::remove( data );
+    if( !QFile::rename( d->path( key, s_partSuffix ), data ) ) {
+        abort( key );
+        return false;
+    }
+    return true;
+}
+
+
+void K3b::AudioImageCache::abort( const QString& key )
+{
+    QFile::remove( d->path( key, s_partSuffix ) );
+}
+
+
+void K3b::AudioImageCache::clear()
+{
+    QDir dir( d->folder );
+    Q_FOREACH( const QString& name, dir.entryList( QStringList() << QString( "*%1" ).arg( s_dataSuffix ) << QString( "*%1" ).arg( s_partSuffix ), QDir::Files ) )
+        dir.remove( name );
+}
+
+
+qint64 K3b::AudioImageCache::size() const
+{
+    qint64 total = 0;
+    Q_FOREACH( const QFileInfo& fi, QDir( d->folder ).entryInfoList( QStringList() << QString( "*%1" ).arg( s_dataSuffix ), QDir::Files ) )
+        total += fi.size();
+    return total;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_IMAGE_CACHE_H_
+#define _K3B_AUDIO_IMAGE_CACHE_H_
+
+#include "k3b_export.h"
+
+#include <QString>
+
+
+namespace K3b {
+    class AudioTrack;
+
+    /**
+     * Decoded audio tracks kept on disk so burning several copies or
+     * burning a project again does not decode all the sources again.
+     *
+     * Each track is stored as the raw big endian CD audio AudioTrackReader
+     * delivers. The key describes the sources of the track: the files with
+     * their size and modification time, the TOC of source CDs, the offsets
+     * and the resampling quality. Changing any of them results in a new key.
+     *
+     * The cache is limited to the size set in the global settings. The
+     * least recently used tracks are removed to make room for new ones.
+     *
+     * \code
+     * AudioImageCache cache;
+     * const QString key = AudioImageCache::key( track );
+     * QString file = cache.lookup( key, size );
+     * if( file.isEmpty() && !( file = cache.reserve( key, size ) ).isEmpty() ) {
+     *     // write the track to file
+     *     cache.commit( key );
+     * }
+     * \endcode
+     */
+    class LIBK3B_EXPORT AudioImageCache
+    {
+    public:
+        /**
+         * Uses the size from the global settings.
+         */
+        AudioImageCache();
+        ~AudioImageCache();
+
+        /**
+         * The maximum size of the cache in bytes. 0 disables the cache.
+         */
+        void setMaxSize( qint64 bytes );
+        qint64 maxSize() const;
+
+        bool isEnabled() const;
+
+        QString cacheFolder() const;
+
+        /**
+         * \return The key for the decoded data of \p track or an empty string
+         * if the track contains sources which cannot be cached.
+         */
+        static QString key( const AudioTrack& track );
+
+        /**
+         * \return The file containing \p size bytes of decoded data for
+         * \p key or an empty string if there is none.
+         */
+        QString lookup( const QString& key, qint64 size );
+
+        /**
+         * Makes room for \p size bytes by removing the least recently used
+         * entries.
+         *
+         * \return The file to write the decoded data to or an empty string
+         * if the data does not fit into the cache.
+         */
+        QString reserve( const QString& key, qint64 size );
+
+        /**
+         * Makes the data written to the file from reserve() available.
+         */
+        bool commit( const QString& key );
+
+        /**
+         * Removes the data written to the file from reserve().
+         */
+        void abort( const QString& key );
+
+        /**
+         * Removes all cached tracks.
+         */
+        void clear();
+
+        /**
+         * The size of all cached tracks in bytes.
+         */
+        qint64 size() const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AudioImageCache )
+    };
+}
+
+#endif
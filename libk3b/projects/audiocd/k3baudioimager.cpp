@@ -16,6 +16,9 @@
 #include "k3baudioimager.h"
 #include "k3baudiodoc.h"
 #include "k3baudiojobtempdata.h"
+#include "k3baudioverificationjob.h"
+#include "k3baccuraterip.h"
+#include "k3baudioimagecache.h"
 #include "k3baudiotrack.h"
 #include "k3baudiotrackreader.h"
 #include "k3baudiodatasource.h"
@@ -28,22 +31,95 @@
 #include <QFile>
 
 #include <unistd.h>
+#include <string.h>
+
+
+namespace {
+    // two sectors are enough to find the stream on the disc again
+    const int s_syncSize = 2*2352;
+}
 
 
 class K3b::AudioImager::Private
 {
 public:
     Private()
-        : ioDev(0) {
+        : ioDev(0),
+          calculateChecksums(false),
+          checksum(0),
+          position(0),
+          carryLength(0),
+          syncPosition(0) {
+    }
+
+    ~Private() {
+        delete checksum;
     }
 
+    void addToChecksum( const char* data, int len );
+    void addSamples( const char* data, int samples );
+
     QIODevice* ioDev;
     AudioImager::ErrorType lastError;
     AudioDoc* doc;
     AudioJobTempData* tempData;
+
+    bool calculateChecksums;
+    AccurateRipChecksum* checksum;
+
+    // the position in the stream in samples
+    qint64 position;
+
+    // the bytes of an incomplete sample at the end of the last read
+    char carry[4];
+    int carryLength;
+
+    qint64 syncPosition;
+    QByteArray syncSamples;
 };
 
 
+void K3b::AudioImager::Private::addToChecksum( const char* data, int len )
+{
+    if( carryLength > 0 ) {
+        while( carryLength < 4 && len > 0 ) {
+            carry[carryLength++] = *data++;
+            --len;
+        }
+        if( carryLength < 4 )
+            return;
+        addSamples( carry, 1 );
+        carryLength = 0;
+    }
+
+    const int samples = len / 4;
+    if( samples > 0 )
+        addSamples( data, samples );
+
+    carryLength = len % 4;
+    ::memcpy( carry, data + samples*4, carryLength );
+}
+
+
+void K3b::AudioImager::Private::addSamples( const char* data, int samples )
+{
+    checksum->addSamples( position, data, samples, true );
+
+    if( syncSamples.size() < s_syncSize ) {
+        int start = 0;
+        if( syncSamples.isEmpty() ) {
+            static const char s_silence[4] = { 0, 0, 0, 0 };
+            while( start < samples && !::memcmp( data + start*4, s_silence, 4 ) )
+                ++start;
+            syncPosition = position + start;
+        }
+        syncSamples.append( data + start*4, qMin( ( samples - start ) * 4, s_syncSize - syncSamples.size() ) );
+    }
+
+    position += samples;
+}
+
+
 
 K3b::AudioImager::AudioImager( AudioDoc* doc, AudioJobTempData* tempData, JobHandler* jh, QObject* parent )
     : K3b::ThreadJob( jh, parent ),
@@ -72,27 +148,95 @@ K3b::AudioImager::ErrorType K3b::AudioImager::lastErrorType() const
 }
 
 
+void K3b::AudioImager::setCalculateChecksums( bool b )
+{
+    d->calculateChecksums = b;
+}
+
+
+quint32 K3b::AudioImager::trackCrc32( int track ) const
+{
+    return d->checksum ? d->checksum->crc32( track ) : 0;
+}
+
+
+quint32 K3b::AudioImager::trackChecksum( int track ) const
+{
+    return d->checksum ? d->checksum->checksumV2( track ) : 0;
+}
+
+
+QByteArray K3b::AudioImager::syncSamples() const
+{
+    return d->syncSamples;
+}
+
+
+qint64 K3b::AudioImager::syncPosition() const
+{
+    return d->syncPosition;
+}
+
+
 bool K3b::AudioImager::run()
 {
     d->lastError = K3b::AudioImager::ERROR_UNKNOWN;
 
     K3b::WaveFileWriter waveFileWriter;
+    K3b::AudioImageCache cache;
 
     qint64 totalSize = d->doc->length().audioBytes();
     qint64 totalRead = 0;
     char buffer[2352 * 10];
 
+    delete d->checksum;
+    d->checksum = 0;
+    d->position = 0;
+    d->carryLength = 0;
+    d->syncPosition = 0;
+    d->syncSamples.clear();
+    if( d->calculateChecksums ) {
+        QList<Msf> lengths;
+        for( AudioTrack* track = d->doc->firstTrack(); track != 0; track = track->next() )
+            lengths.append( track->length() );
+        d->checksum = new AccurateRipChecksum( AudioVerificationJob::streamToc( lengths ) );
+    }
+
     for( AudioTrack* track = d->doc->firstTrack(); track != 0; track = track->next() ) {
 
         emit nextTrack( track->trackNumber(), d->doc->numOfTracks() );
 
         //
-        // Create track reader
+        // Read the track from the cache if it has been decoded before.
+        // Otherwise decode it and store the result in the cache on the way.
         //
         AudioTrackReader trackReader( *track );
-        if( !trackReader.open() ) {
-            emit infoMessage( i18n("Unable to read track %1.", track->trackNumber()), K3b::Job::MessageError );
-            return false;
+        QFile cacheFile;
+        QIODevice* reader = &trackReader;
+        const QString cacheKey = cache.isEnabled() ? AudioImageCache::key( *track ) : QString();
+        const qint64 trackSize = track->length().audioBytes();
+        bool fillCache = false;
+
+        const QString cachedImage = cache.lookup( cacheKey, trackSize );
+        if( !cachedImage.isEmpty() ) {
+            cacheFile.setFileName( cachedImage );
+            if( cacheFile.open( QIODevice::ReadOnly ) ) {
+                qDebug() << "(K3b::AudioImager) reading track" << track->trackNumber() << "from" << cachedImage;
+                reader = &cacheFile;
+            }
+        }
+
+        if( reader == &trackReader ) {
+            if( !trackReader.open() ) {
+                emit infoMessage( i18n("Unable to read track %1.", track->trackNumber()), K3b::Job::MessageError );
+                return false;
+            }
+
+            const QString cacheImage = cache.reserve( cacheKey, trackSize );
+            if( !cacheImage.isEmpty() ) {
+                cacheFile.setFileName( cacheImage );
+                fillCache = cacheFile.open( QIODevice::WriteOnly );
+            }
         }
 
         //
@@ -108,6 +252,8 @@ bool K3b::AudioImager::run()
             QString imageFile = d->tempData->bufferFileName( track );
             if( !waveFileWriter.open( imageFile ) ) {
                 emit infoMessage( i18n("Could not open %1 for writing", imageFile), K3b::Job::MessageError );
+                if( fillCache )
+                    cache.abort( cacheKey );
                 return false;
             }
         }
@@ -115,7 +261,12 @@ bool K3b::AudioImager::run()
         //
         // Read data from the track
         //
-        while( !trackReader.atEnd() && (read = trackReader.read( buffer, sizeof(buffer) )) > 0 ) {
+        while( !reader->atEnd() && (read = reader->read( buffer, sizeof(buffer) )) > 0 ) {
+            // the checksums of exactly the data the writer gets, complete
+            // before the writer has received the last byte
+            if( d->checksum )
+                d->addToChecksum( buffer, read );
+
             if( !d->ioDev ) {
                 waveFileWriter.write( buffer, read, K3b::WaveFileWriter::BigEndian );
             }
@@ -124,11 +275,23 @@ bool K3b::AudioImager::run()
                 if ( w != read ) {
                     qDebug() << "(K3b::AudioImager::WorkThread) writing to device" << d->ioDev << "failed:" << read << w;
                     d->lastError = K3b::AudioImager::ERROR_FD_WRITE;
+                    if( fillCache )
+                        cache.abort( cacheKey );
                     return false;
                 }
             }
 
+            // a full disk only costs us the cache entry, not the burn
+            if( fillCache && cacheFile.write( buffer, read ) != read ) {
+                qDebug() << "(K3b::AudioImager::WorkThread) writing to cache file" << cacheFile.fileName() << "failed.";
+                cacheFile.close();
+                cache.abort( cacheKey );
+                fillCache = false;
+            }
+
             if( canceled() ) {
+                if( fillCache )
+                    cache.abort( cacheKey );
                 return false;
             }
 
@@ -138,9 +301,9 @@ bool K3b::AudioImager::run()
             totalRead += read;
             trackRead += read;
 
-            emit subPercent( 100LL*trackRead/trackReader.size() );
+            emit subPercent( 100LL*trackRead/reader->size() );
             emit percent( 100LL*totalRead/totalSize );
-            emit processedSubSize( trackRead/1024LL/1024LL, trackReader.size()/1024LL/1024LL );
+            emit processedSubSize( trackRead/1024LL/1024LL, reader->size()/1024LL/1024LL );
             emit processedSize( totalRead/1024LL/1024LL, totalSize/1024LL/1024LL );
         }
 
@@ -149,11 +312,19 @@ bool K3b::AudioImager::run()
             qDebug() << "(K3b::AudioImager::WorkThread) read error on track " << track->trackNumber()
                      << " at pos " << K3b::Msf(trackRead/2352) << endl;
             d->lastError = K3b::AudioImager::ERROR_DECODING_TRACK;
+            if( fillCache )
+                cache.abort( cacheKey );
             return false;
         }
+
+        if( fillCache ) {
+            cacheFile.close();
+            if( trackRead == trackSize && cacheFile.error() == QFile::NoError )
+                cache.commit( cacheKey );
+            else
+                cache.abort( cacheKey );
+        }
     }
 
     return true;
 }
-
-
@@ -17,6 +17,8 @@
 
 #include "k3bthreadjob.h"
 
+#include <QByteArray>
+
 class QIODevice;
 
 namespace K3b {
@@ -38,6 +40,31 @@ namespace K3b {
          */
         void writeTo( QIODevice* dev );
 
+        /**
+         * Calculate the CRC32 and the AccurateRip checksum of every track
+         * of the stream while writing it. Used to verify the written disc
+         * with AudioVerificationJob.
+         */
+        void setCalculateChecksums( bool b );
+
+        /**
+         * The checksums of \p track (starting at 1) as calculated
+         * in the last successful run.
+         */
+        quint32 trackCrc32( int track ) const;
+        quint32 trackChecksum( int track ) const;
+
+        /**
+         * The first non-silent samples of the stream in big endian byte
+         * order. Empty if the stream only contains silence.
+         */
+        QByteArray syncSamples() const;
+
+        /**
+         * The position of the first of syncSamples() in the stream.
+         */
+        qint64 syncPosition() const;
+
         enum ErrorType {
             ERROR_FD_WRITE,
             ERROR_DECODING_TRACK,
@@ -22,6 +22,7 @@
 #include "k3baudionormalizejob.h"
 #include "k3baudiojobtempdata.h"
 #include "k3baudiomaxspeedjob.h"
+#include "k3baudioverificationjob.h"
 #include "k3baudiocdtracksource.h"
 #include "k3baudiofile.h"
 #include "k3bdevicemanager.h"
@@ -75,7 +76,8 @@ class K3b::AudioJob::Private
 public:
     Private()
         : copies(1),
-          copiesDone(0) {
+          copiesDone(0),
+          verificationJob(0) {
     }
 
     int copies;
@@ -85,6 +87,10 @@ public:
     bool useCdText;
     bool maxSpeed;
 
+    bool verify;
+    bool verificationFailed;
+    AudioVerificationJob* verificationJob;
+
     bool zeroPregap;
     bool less4Sec;
 };
@@ -152,6 +158,22 @@ void K3b::AudioJob::start()
     if( m_doc->dummy() )
         d->copies = 1;
 
+    //
+    // The written disc is compared with checksums of the stream the imager
+    // produces. Normalizing changes the image files after that.
+    //
+    d->verify = m_doc->verifyData() && !m_doc->onlyCreateImages() && !m_doc->dummy();
+    d->verificationFailed = false;
+    if( d->verify && m_doc->normalize() ) {
+        emit infoMessage( i18n("Normalized audio tracks cannot be verified."), MessageWarning );
+        d->verify = false;
+    }
+    else if( d->verify && m_doc->hideFirstTrack() ) {
+        emit infoMessage( i18n("Audio CDs with a hidden first track cannot be verified."), MessageWarning );
+        d->verify = false;
+    }
+    m_audioImager->setCalculateChecksums( d->verify );
+
     emit newTask( i18n("Preparing data") );
 
     //
@@ -384,6 +406,9 @@ void K3b::AudioJob::cancel()
     if( m_writer )
         m_writer->cancel();
 
+    if( d->verificationJob && d->verificationJob->active() )
+        d->verificationJob->cancel();
+
     m_audioImager->cancel();
     emit infoMessage( i18n("Writing canceled."), K3b::Job::MessageError );
     removeBufferFiles();
@@ -402,34 +427,110 @@ void K3b::AudioJob::slotWriterFinished( bool success )
         jobFinished(false);
         return;
     }
+    else if( d->verify ) {
+        verifyCopy();
+    }
     else {
         d->copiesDone++;
+        finishCopy();
+    }
+}
 
-        if( d->copiesDone == d->copies ) {
-            if( m_doc->onTheFly() || m_doc->removeImages() )
-                removeBufferFiles();
 
-            if ( k3bcore->globalSettings()->ejectMedia() ) {
-                K3b::Device::eject( m_doc->burner() );
-            }
+void K3b::AudioJob::verifyCopy()
+{
+    if( !d->verificationJob ) {
+        d->verificationJob = new K3b::AudioVerificationJob( this, this );
+        connect( d->verificationJob, SIGNAL(infoMessage(QString,int)),
+                 this, SIGNAL(infoMessage(QString,int)) );
+        connect( d->verificationJob, SIGNAL(newTask(QString)),
+                 this, SIGNAL(newSubTask(QString)) );
+        connect( d->verificationJob, SIGNAL(newSubTask(QString)),
+                 this, SIGNAL(newSubTask(QString)) );
+        connect( d->verificationJob, SIGNAL(percent(int)),
+                 this, SLOT(slotVerificationProgress(int)) );
+        connect( d->verificationJob, SIGNAL(subPercent(int)),
+                 this, SIGNAL(subPercent(int)) );
+        connect( d->verificationJob, SIGNAL(finished(bool)),
+                 this, SLOT(slotVerificationFinished(bool)) );
+        connect( d->verificationJob, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SIGNAL(debuggingOutput(QString,QString)) );
+    }
 
-            jobFinished(true);
+    // the checksums of the stream which has just been written
+    d->verificationJob->clear();
+    d->verificationJob->setDevice( m_doc->burner() );
+    int trackNumber = 1;
+    for( K3b::AudioTrack* track = m_doc->firstTrack(); track != 0; track = track->next() ) {
+        d->verificationJob->addTrack( track->length(),
+                                      m_audioImager->trackCrc32( trackNumber ),
+                                      m_audioImager->trackChecksum( trackNumber ) );
+        ++trackNumber;
+    }
+    d->verificationJob->setSyncSamples( m_audioImager->syncPosition(), m_audioImager->syncSamples() );
+
+    emit burning(false);
+
+    emit newTask( i18n("Verifying written data") );
+
+    d->verificationJob->start();
+}
+
+
+void K3b::AudioJob::slotVerificationProgress( int p )
+{
+    double totalTasks = d->copies*2;
+    double tasksDone = d->copiesDone*2 + 1; // the writing of the current copy has already been finished
+
+    if( !m_doc->onTheFly() ) {
+        totalTasks+=1.0;
+        tasksDone+=1.0;
+    }
+
+    emit percent( (int)((100.0*tasksDone + (double)p) / totalTasks) );
+}
+
+
+void K3b::AudioJob::slotVerificationFinished( bool success )
+{
+    if( m_canceled || m_errorOccuredAndAlreadyReported )
+        return;
+
+    // like with data projects a failed verification does not stop the other copies
+    if( !success )
+        d->verificationFailed = true;
+
+    d->copiesDone++;
+    finishCopy();
+}
+
+
+void K3b::AudioJob::finishCopy()
+{
+    if( d->copiesDone == d->copies ) {
+        if( m_doc->onTheFly() || m_doc->removeImages() )
+            removeBufferFiles();
+
+        if ( k3bcore->globalSettings()->ejectMedia() ) {
+            K3b::Device::eject( m_doc->burner() );
         }
-        else {
-            if( !K3b::eject( m_doc->burner() ) ) {
-                blockingInformation( i18n("K3b was unable to eject the written disk. Please do so manually.") );
-            }
 
-            if( startWriting() ) {
-                if( m_doc->onTheFly() ) {
-                    // now the writer is running and we can get it's stdin
-                    // we only use this method when writing on-the-fly since
-                    // we cannot easily change the audioDecode fd while it's working
-                    // which we would need to do since we write into several
-                    // image files.
-                    m_audioImager->writeTo( m_writer->ioDevice() );
-                    m_audioImager->start();
-                }
+        jobFinished( !d->verificationFailed );
+    }
+    else {
+        if( !K3b::eject( m_doc->burner() ) ) {
+            blockingInformation( i18n("K3b was unable to eject the written disk. Please do so manually.") );
+        }
+
+        if( startWriting() ) {
+            if( m_doc->onTheFly() ) {
+                // now the writer is running and we can get it's stdin
+                // we only use this method when writing on-the-fly since
+                // we cannot easily change the audioDecode fd while it's working
+                // which we would need to do since we write into several
+                // image files.
+                m_audioImager->writeTo( m_writer->ioDevice() );
+                m_audioImager->start();
             }
         }
     }
@@ -600,6 +701,10 @@ void K3b::AudioJob::slotWriterJobPercent( int p )
 {
     double totalTasks = d->copies;
     double tasksDone = d->copiesDone;
+    if( d->verify ) {
+        totalTasks*=2.0;
+        tasksDone*=2.0;
+    }
     if( m_doc->normalize() ) {
         totalTasks+=1.0;
         tasksDone+=1.0;
@@ -624,6 +729,9 @@ void K3b::AudioJob::slotAudioDecoderPercent( int p )
     else if( !m_doc->onTheFly() ) {
         double totalTasks = d->copies;
         double tasksDone = d->copiesDone; // =0 when creating an image
+        if( d->verify ) {
+            totalTasks*=2.0;
+        }
         if( m_doc->normalize() ) {
             totalTasks+=1.0;
         }
@@ -70,9 +70,15 @@ namespace K3b {
         // max speed
         void slotMaxSpeedJobFinished( bool );
 
+        // verification slots
+        void slotVerificationProgress( int );
+        void slotVerificationFinished( bool );
+
     private:
         bool prepareWriter();
         bool startWriting();
+        void verifyCopy();
+        void finishCopy();
         void cleanupAfterError();
         void removeBufferFiles();
         void normalizeFiles();
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudiopeaks.h"
+
+#include <QDataStream>
+
+
+namespace {
+    // one day of audio, anything longer comes from a broken cache file
+    const qint32 s_maxFrames = 75*60*60*24;
+
+    K3b::AudioPeaks::Peak merge( const K3b::AudioPeaks::Peak& a, const K3b::AudioPeaks::Peak& b )
+    {
+        K3b::AudioPeaks::Peak p;
+        p.min = qMin( a.min, b.min );
+        p.max = qMax( a.max, b.max );
+        return p;
+    }
+}
+
+
+K3b::AudioPeaks::AudioPeaks()
+{
+}
+
+
+K3b::AudioPeaks::AudioPeaks( const QVector<Peak>& framePeaks )
+{
+    m_levels.append( framePeaks );
+    buildLevels();
+}
+
+
+void K3b::AudioPeaks::buildLevels()
+{
+    m_levels.resize( 1 );
+    while( m_levels.last().count() > 1 ) {
+        const QVector<Peak>& below = m_levels.last();
+        QVector<Peak> level( ( below.count() + 1 ) / 2 );
+        for( int i = 0; i < level.count(); ++i ) {
+            if( 2*i + 1 < below.count() )
+                level[i] = merge( below[2*i], below[2*i+1] );
+            else
+                level[i] = below[2*i];
+        }
+        m_levels.append( level );
+    }
+}
+
+
+bool K3b::AudioPeaks::isEmpty() const
+{
+    return m_levels.isEmpty() || m_levels.first().isEmpty();
+}
+
+
+K3b::Msf K3b::AudioPeaks::length() const
+{
+    return m_levels.isEmpty() ? 0 : m_levels.first().count();
+}
+
+
+K3b::AudioPeaks::Peak K3b::AudioPeaks::peak( const K3b::Msf& start, const K3b::Msf& end ) const
+{
+    const int first = qMax( 0, start.lba() );
+    const int last = qMin( length().lba(), end.lba() );
+    if( first >= last )
+        return Peak();
+
+    // climb the pyramid, taking the peaks at the ends of the range which
+    // do not pair up into a peak of the next level
+    Peak p = m_levels[0][first];
+    int lo = first;
+    int hi = last;
+    for( int level = 0; lo < hi; ++level ) {
+        const QVector<Peak>& peaks = m_levels[level];
+        if( lo & 1 )
+            p = merge( p, peaks[lo++] );
+        if( hi & 1 )
+            p = merge( p, peaks[--hi] );
+        lo >>= 1;
+        hi >>= 1;
+    }
+    return p;
+}
+
+
+K3b::AudioPeaks::Peak K3b::AudioPeaks::framePeak( const char* data, int len )
+{
+    Peak p;
+    const unsigned char* u = reinterpret_cast<const unsigned char*>( data );
+    for( int i = 0; i + 1 < len; i += 2 ) {
+        const qint16 sample = (qint16)( u[i] << 8 | u[i+1] );
+        if( sample < p.min )
+            p.min = sample;
+        if( sample > p.max )
+            p.max = sample;
+    }
+    return p;
+}
+
+
+QDataStream& K3b::operator<<( QDataStream& s, const K3b::AudioPeaks& peaks )
+{
+    const QVector<K3b::AudioPeaks::Peak> frames = peaks.m_levels.isEmpty() ? QVector<K3b::AudioPeaks::Peak>() : peaks.m_levels.first();
+    s << (qint32)frames.count();
+    for( int i = 0; i < frames.count(); ++i )
+        s << frames[i].min << frames[i].max;
+    return s;
+}
+
+
+QDataStream& K3b::operator>>( QDataStream& s, K3b::AudioPeaks& peaks )
+{
+    qint32 count = 0;
+    s >> count;
+
+    QVector<K3b::AudioPeaks::Peak> frames;
+    if( count > 0 && count <= s_maxFrames && s.status() == QDataStream::Ok ) {
+        frames.resize( count );
+        for( int i = 0; i < count && s.status() == QDataStream::Ok; ++i )
+            s >> frames[i].min >> frames[i].max;
+    }
+
+    peaks.m_levels.clear();
+    if( s.status() == QDataStream::Ok ) {
+        peaks.m_levels.append( frames );
+        peaks.buildLevels();
+    }
+    return s;
+}
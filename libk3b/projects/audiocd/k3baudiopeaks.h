@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_PEAKS_H_
+#define _K3B_AUDIO_PEAKS_H_
+
+#include "k3bmsf.h"
+#include "k3b_export.h"
+
+#include <QVector>
+
+class QDataStream;
+
+
+namespace K3b {
+    /**
+     * The minimum and maximum sample values of an audio source, used to
+     * draw its waveform.
+     *
+     * There is one peak per audio frame (1/75 second) which is the finest
+     * position the editors can handle. On top of that the peaks are kept
+     * in a pyramid where each level merges two peaks of the level below,
+     * about twice the frame peaks in total. The peak of a range of n frames
+     * is merged from at most two peaks per level up to log2(n), so drawing
+     * a waveform takes time proportional to the number of pixels, independent
+     * of the length of the source.
+     *
+     * The peaks are implicitly shared and cheap to copy.
+     *
+     * \see AudioPeaksLoader
+     */
+    class LIBK3B_EXPORT AudioPeaks
+    {
+    public:
+        struct Peak {
+            Peak() : min( 0 ), max( 0 ) {}
+            qint16 min;
+            qint16 max;
+        };
+
+        AudioPeaks();
+
+        /**
+         * \param framePeaks the peaks of each frame.
+         */
+        explicit AudioPeaks( const QVector<Peak>& framePeaks );
+
+        bool isEmpty() const;
+
+        /**
+         * The number of frames.
+         */
+        Msf length() const;
+
+        /**
+         * The peak of the frames from \p start up to but excluding \p end.
+         */
+        Peak peak( const Msf& start, const Msf& end ) const;
+
+        /**
+         * Determines the peak of one frame of 16 bit big endian
+         * samples as delivered by AudioDecoder.
+         */
+        static Peak framePeak( const char* data, int len );
+
+    private:
+        void buildLevels();
+
+        // levels[n][i] holds the peak of the frames i*2^n to (i+1)*2^n-1
+        QVector<QVector<Peak> > m_levels;
+
+        friend LIBK3B_EXPORT QDataStream& operator<<( QDataStream&, const AudioPeaks& );
+        friend LIBK3B_EXPORT QDataStream& operator>>( QDataStream&, AudioPeaks& );
+    };
+
+    LIBK3B_EXPORT QDataStream& operator<<( QDataStream& s, const AudioPeaks& peaks );
+    LIBK3B_EXPORT QDataStream& operator>>( QDataStream& s, AudioPeaks& peaks );
+}
+
+#endif
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baudiopeaksloader.h"
+#include "k3baudiodecoder.h"
+#include "k3b_i18n.h"
+
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QUrl>
+
+
+namespace {
+    const qint32 s_cacheVersion = 1;
+
+    // one frame of 16 bit stereo samples as delivered by the decoders
+    const int s_frameSize = 2352;
+
+    struct Work {
+        Work()
+            : size( 0 ),
+              modified( 0 ),
+              decoder( 0 ),
+              canceled( false ) {
+        }
+
+        QString filename;
+        qint64 size;
+        qint64 modified;
+        K3b::AudioDecoder* decoder;
+        volatile bool canceled;
+        QAtomicInt done;
+        K3b::AudioPeaks peaks;
+        QString error;
+    };
+
+    QString cacheFile( const QString& filename )
+    {
+        return QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+            + "/k3b/peaks/"
+            + QString::fromLatin1( QCryptographicHash::hash( filename.toUtf8(), QCryptographicHash::Md5 ).toHex() );
+    }
+
+    bool readCache( Work& work )
+    {
+        QFile f( cacheFile( work.filename ) );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return false;
+
+        QDataStream s( &f );
+        qint32 version = 0;
+        QString filename;
+        qint64 size = 0;
+        qint64 modified = 0;
+        s >> version;
+        if( version != s_cacheVersion )
+            return false;
+
+        // the file name guards against hash collisions
+        s >> filename >> size >> modified;
+        if( filename != work.filename || size != work.size || modified != work.modified )
+            return false;
+
+        s >> work.peaks;
+        return( s.status() == QDataStream::Ok && !work.peaks.isEmpty() );
+    }
+
+    void writeCache( const Work& work )
+    {
+        const QString path = cacheFile( work.filename );
+        QDir().mkpath( QFileInfo( path ).path() );
+        QSaveFile f( path );
+        if( f.open( QIODevice::WriteOnly ) ) {
+            QDataStream s( &f );
+            s << s_cacheVersion << work.filename << work.size << work.modified << work.peaks;
+            f.commit();
+        }
+    }
+}
+
+
+class K3b::AudioPeaksLoader::Private
+{
+public:
+    class DecodeJob : public QRunnable
+    {
+    public:
+        DecodeJob( AudioPeaksLoader* loader, const QSharedPointer<Work>& work )
+            : m_loader( loader ),
+              m_work( work ) {
+        }
+
+        void run() override {
+            decode();
+
+            // the decoder belongs to the GUI thread
+            m_work->decoder->cleanup();
+            m_work->decoder->deleteLater();
+            m_work->decoder = 0;
+
+            m_work->done = 1;
+            QMetaObject::invokeMethod( m_loader, "slotDecoded", Qt::QueuedConnection );
+        }
+
+    private:
+        void decode() {
+            if( m_work->canceled )
+                return;
+
+            if( !m_work->decoder->analyseFile() ) {
+                qDebug() << "(K3b::AudioPeaksLoader) failed to analyse" << m_work->filename;
+                m_work->error = i18n("Unable to analyse '%1'.", m_work->filename );
+                return;
+            }
+
+            QVector<AudioPeaks::Peak> frames;
+            frames.reserve( m_work->decoder->length().lba() );
+
+            // one second at a time
+            QByteArray buffer( 75*s_frameSize, Qt::Uninitialized );
+            AudioPeaks::Peak current;
+            int currentBytes = 0;
+            int read = 0;
+            while( !m_work->canceled &&
+                   ( read = m_work->decoder->decode( buffer.data(), buffer.size() ) ) > 0 ) {
+                int pos = 0;
+                while( pos < read ) {
+                    const int len = qMin( s_frameSize - currentBytes, read - pos );
+                    const AudioPeaks::Peak p = AudioPeaks::framePeak( buffer.constData() + pos, len );
+                    current.min = qMin( current.min, p.min );
+                    current.max = qMax( current.max, p.max );
+                    currentBytes += len;
+                    pos += len;
+
+                    if( currentBytes == s_frameSize ) {
+                        frames.append( current );
+                        current = AudioPeaks::Peak();
+                        currentBytes = 0;
+                    }
+                }
+            }
+
+            if( m_work->canceled )
+                return;
+
+            if( read < 0 ) {
+                qDebug() << "(K3b::AudioPeaksLoader) failed to decode" << m_work->filename;
+                m_work->error = i18n("Unable to decode '%1'.", m_work->filename );
+                return;
+            }
+
+            if( currentBytes > 0 )
+                frames.append( current );
+
+            m_work->peaks = AudioPeaks( frames );
+            writeCache( *m_work );
+        }
+
+        AudioPeaksLoader* m_loader;
+        QSharedPointer<Work> m_work;
+    };
+
+    QSharedPointer<Work> work;
+    AudioPeaks peaks;
+    QString error;
+
+    QThreadPool pool;
+};
+
+
+K3b::AudioPeaksLoader::AudioPeaksLoader( QObject* parent )
+    : QObject( parent ),
+      d( new Private() )
+{
+    // canceled jobs finish right away, there is no point in decoding files in parallel
+    d->pool.setMaxThreadCount( 1 );
+}
+
+
+K3b::AudioPeaksLoader::~AudioPeaksLoader()
+{
+    cancel();
+    d->pool.waitForDone();
+    delete d;
+}
+
+
+void K3b::AudioPeaksLoader::load( const QString& filename )
+{
+    cancel();
+    d->peaks = AudioPeaks();
+    d->error.clear();
+
+    QFileInfo info( filename );
+    QSharedPointer<Work> work( new Work() );
+    work->filename = info.absoluteFilePath();
+    work->size = info.size();
+    work->modified = info.lastModified().toMSecsSinceEpoch();
+
+    if( readCache( *work ) ) {
+        d->peaks = work->peaks;
+        emit loaded();
+        return;
+    }
+
+    work->decoder = K3b::AudioDecoderFactory::createDecoder( QUrl::fromLocalFile( work->filename ) );
+    if( !work->decoder ) {
+        d->error = i18n("No decoder plugin found for '%1'.", work->filename );
+        emit loaded();
+        return;
+    }
+    work->decoder->setFilename( work->filename );
+
+    d->work = work;
+    d->pool.start( new Private::DecodeJob( this, work ) );
+}
+
+
+void K3b::AudioPeaksLoader::cancel()
+{
+    if( d->work ) {
+        d->work->canceled = true;
+        d->work.clear();
+    }
+}
+
+
+K3b::AudioPeaks K3b::AudioPeaksLoader::peaks() const
+{
+    return d->peaks;
+}
+
+
+QString K3b::AudioPeaksLoader::errorString() const
+{
+    return d->error;
+}
+
+
+void K3b::AudioPeaksLoader::slotDecoded()
+{
+    // canceled jobs also end up here
+    if( d->work && d->work->done ) {
+        d->peaks = d->work->peaks;
+        d->error = d->work->error;
+        d->work.clear();
+        emit loaded();
+    }
+}
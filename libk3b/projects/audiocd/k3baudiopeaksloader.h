@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_AUDIO_PEAKS_LOADER_H_
+#define _K3B_AUDIO_PEAKS_LOADER_H_
+
+#include "k3baudiopeaks.h"
+#include "k3b_export.h"
+
+#include <QObject>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * Provides the AudioPeaks of audio files.
+     *
+     * The peaks are read from a cache on disk. Files which are not in the
+     * cache yet or changed since are decoded in a background thread and the
+     * result is written to the cache, so a file is decoded only once no
+     * matter how often its waveform is shown.
+     */
+    class LIBK3B_EXPORT AudioPeaksLoader : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit AudioPeaksLoader( QObject* parent = 0 );
+        ~AudioPeaksLoader() override;
+
+        /**
+         * Starts loading the peaks of \p filename and cancels loading any
+         * other file. loaded() is emitted once the peaks are available, right
+         * away if they are found in the cache.
+         */
+        void load( const QString& filename );
+
+        /**
+         * Stops decoding the current file.
+         */
+        void cancel();
+
+        /**
+         * The peaks of the last loaded file. Empty if they are not known yet
+         * or the file could not be decoded.
+         */
+        AudioPeaks peaks() const;
+
+        /**
+         * Why the peaks of the last loaded file are empty. Empty if loading
+         * succeeded or is still in progress.
+         */
+        QString errorString() const;
+
+    Q_SIGNALS:
+        void loaded();
+
+    private Q_SLOTS:
+        void slotDecoded();
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
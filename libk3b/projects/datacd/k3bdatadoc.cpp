@@ -20,10 +20,12 @@
 #include "k3bdataitem.h"
 #include "k3bdiritem.h"
 #include "k3bsessionimportitem.h"
+#include "k3bimportedsession.h"
 #include "k3bdatajob.h"
 #include "k3bbootitem.h"
 #include "k3bspecialdataitem.h"
 #include "k3bfilecompilationsizehandler.h"
+#include "k3bzisofssizeestimator.h"
 #include "k3bmkisofshandler.h"
 #include "k3bcore.h"
 #include "k3bglobals.h"
@@ -48,11 +50,16 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
 #include <QStringList>
 #include <QTimer>
 #include <QApplication>
 #include <QDomElement>
 #include <QTextCodec>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include <string.h>
 #include <stdlib.h>
@@ -69,6 +76,7 @@ public:
         dataMode( 0 ),
         verifyData( false ),
         importedSession( -1 ),
+        sessionImport( 0 ),
         bootCataloge( 0 ),
         bExistingItemsReplaceAll( false ),
         bExistingItemsIgnoreAll( false ),
@@ -80,12 +88,16 @@ public:
     ~Private()
     {
         delete root;
+        delete sessionImport;
         delete sizeHandler;
         //  delete oldSessionSizeHandler;
     }
 
     FileCompilationSizeHandler* sizeHandler;
 
+    // only fed while zisofs compression is used
+    ZisofsSizeEstimator* zisofsEstimator;
+
     //  FileCompilationSizeHandler* oldSessionSizeHandler;
     KIO::filesize_t oldSessionSize;
 
@@ -103,6 +115,8 @@ public:
     MultiSessionMode multisessionMode;
     QList<DataItem*> oldSession;
     int importedSession;
+    ImportedSession* sessionImport;
+    QStringList hiddenOldSessionPaths;
 
     // boot cd stuff
     DataItem* bootCataloge;
@@ -113,6 +127,14 @@ public:
 
     bool needToCutFilenames;
     QList<DataItem*> needToCutFilenameItems;
+
+    // items may be created from the url adding thread
+    QMutex localDirsMutex;
+    QSet<QString> localDirs;
+
+    bool zisofsCompression() const {
+        return isoOptions.zisofsCompression() && isoOptions.createRockRidge();
+    }
 };
 
 
@@ -126,6 +148,9 @@ K3b::DataDoc::DataDoc( QObject* parent )
     : K3b::Doc( parent ),
       d( new Private )
 {
+    d->zisofsEstimator = new K3b::ZisofsSizeEstimator( this );
+    connect( d->zisofsEstimator, SIGNAL(savedBytesChanged()),
+             this, SIGNAL(changed()) );
 }
 
 
@@ -163,9 +188,24 @@ void K3b::DataDoc::clear()
             removeItem( d->root->children().first() );
     }
     d->sizeHandler->clear();
+    d->zisofsEstimator->clear();
+    {
+        QMutexLocker locker( &d->localDirsMutex );
+        d->localDirs.clear();
+    }
     emit importedSessionChanged( importedSession() );
 }
 
+
+QString K3b::DataDoc::internLocalDir( const QString& dir )
+{
+    QMutexLocker locker( &d->localDirsMutex );
+    QSet<QString>::const_iterator it = d->localDirs.constFind( dir );
+    if( it == d->localDirs.constEnd() )
+        it = d->localDirs.insert( dir );
+    return *it;
+}
+
 bool K3b::DataDoc::removeDiskItem( K3b::DataItem* item )
 {
     if (NULL == item) return false;
@@ -192,6 +232,7 @@ void K3b::DataDoc::clearDisk()
         }
     }
     d->sizeHandler->clear();
+    d->zisofsEstimator->clear();
     emit importedSessionChanged( importedSession() );
 }
 
@@ -224,7 +265,13 @@ const K3b::IsoOptions& K3b::DataDoc::isoOptions() const
 
 void K3b::DataDoc::setIsoOptions( const K3b::IsoOptions& isoOptions )
 {
+    const bool zisofsCompression = d->zisofsCompression();
     d->isoOptions = isoOptions;
+    if( d->zisofsCompression() != zisofsCompression ) {
+        d->zisofsEstimator->clear();
+        if( d->zisofsCompression() && d->root )
+            d->zisofsEstimator->addItem( d->root );
+    }
     emit changed();
 }
 
@@ -453,11 +500,18 @@ K3b::DirItem* K3b::DataDoc::addEmptyDir( const QString& name, K3b::DirItem* pare
 
 KIO::filesize_t K3b::DataDoc::size() const
 {
+    KIO::filesize_t size = 0;
     if( d->isoOptions.doNotCacheInodes() )
-        return root()->blocks().mode1Bytes() + d->oldSessionSize;
+        size = root()->blocks().mode1Bytes();
     else
-        return d->sizeHandler->blocks( d->isoOptions.followSymbolicLinks() ||
+        size = d->sizeHandler->blocks( d->isoOptions.followSymbolicLinks() ||
                                       !d->isoOptions.createRockRidge() ).mode1Bytes();
+
+    // the estimate does not know about hard links, so do not go below zero
+    if( d->zisofsCompression() )
+        size -= qMin( size, d->zisofsEstimator->savedBytes() );
+
+    return size + d->oldSessionSize;
 }
 
 
@@ -557,6 +611,66 @@ bool K3b::DataDoc::loadDocumentData( QDomElement* rootElem )
 }
 
 
+bool K3b::DataDoc::loadDocumentStream( QXmlStreamReader& xml )
+{
+    if( !root() )
+        newDocument();
+
+    // the small sections are parsed as DOM, only the files are streamed
+    QDomDocument doc;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "general" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'general' section.";
+        return false;
+    }
+    if( !readGeneralDocumentData( readDomElement( xml, doc ) ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "options" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'options' section.";
+        return false;
+    }
+    if( !loadDocumentDataOptions( readDomElement( xml, doc ) ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "header" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'header' section.";
+        return false;
+    }
+    if( !loadDocumentDataHeader( readDomElement( xml, doc ) ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "files" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'files' section.";
+        return false;
+    }
+
+    if( d->root == 0 )
+        d->root = new K3b::RootItem( *this );
+
+    while( xml.readNextStartElement() ) {
+        if( !loadDataItem( xml, root() ) )
+            return false;
+    }
+
+    // ignore anything following the files just like loadDocumentData does
+    xml.skipCurrentElement();
+
+    if( xml.hasError() ) {
+        qDebug() << "(K3b::DataDoc) parse error in line" << xml.lineNumber() << ":" << xml.errorString();
+        return false;
+    }
+
+    // see loadDocumentData()
+    if( !d->bootImages.isEmpty() && !d->bootCataloge )
+        createBootCatalogeItem( d->bootImages.first()->parent() );
+
+    informAboutNotFoundFiles();
+
+    return true;
+}
+
+
 bool K3b::DataDoc::loadDocumentDataOptions( QDomElement elem )
 {
     QDomNodeList headerList = elem.childNodes();
@@ -632,6 +746,9 @@ bool K3b::DataDoc::loadDocumentDataOptions( QDomElement elem )
         else if( e.nodeName() == "do_not_cache_inodes" )
             d->isoOptions.setDoNotCacheInodes( e.attributeNode( "activated" ).value() == "yes" );
 
+        else if( e.nodeName() == "zisofs_compression" )
+            d->isoOptions.setZisofsCompression( e.attributeNode( "activated" ).value() == "yes" );
+
         else if( e.nodeName() == "whitespace_treatment" ) {
             if( e.text() == "strip" )
                 d->isoOptions.setWhiteSpaceTreatment( K3b::IsoOptions::strip );
@@ -815,6 +932,110 @@ bool K3b::DataDoc::loadDataItem( QDomElement& elem, K3b::DirItem* parent )
 }
 
 
+bool K3b::DataDoc::loadDataItem( QXmlStreamReader& xml, K3b::DirItem* parent )
+{
+    if( !parent )
+        return false;
+
+    // the attributes are invalidated by reading on
+    const QXmlStreamAttributes attributes = xml.attributes();
+    const QString name = attributes.value( "name" ).toString();
+    K3b::DataItem* newItem = 0;
+
+    if( xml.name() == QLatin1String( "file" ) ) {
+        // the url is the first child element
+        QString url;
+        bool haveUrl = false;
+        while( xml.readNextStartElement() ) {
+            if( !haveUrl ) {
+                url = xml.readElementText();
+                haveUrl = true;
+            }
+            else {
+                xml.skipCurrentElement();
+            }
+        }
+        if( !haveUrl ) {
+            qDebug() << "(K3b::DataDoc) file-element without url!";
+            return false;
+        }
+
+        QFileInfo f( url );
+
+        // We canot use exists() here since this always disqualifies broken symlinks
+        if( !f.isFile() && !f.isSymLink() )
+            d->notFoundFiles.append( url );
+
+        // broken symlinks are not readable according to QFileInfo which is wrong in our case
+        else if( f.isFile() && !f.isReadable() )
+            d->noPermissionFiles.append( url );
+
+        else if( !attributes.value( "bootimage" ).isEmpty() ) {
+            K3b::BootItem* bootItem = new K3b::BootItem( url, *this, name );
+            parent->addDataItem( bootItem );
+            const QStringRef bootImage = attributes.value( "bootimage" );
+            if( bootImage == QLatin1String( "floppy" ) )
+                bootItem->setImageType( K3b::BootItem::FLOPPY );
+            else if( bootImage == QLatin1String( "harddisk" ) )
+                bootItem->setImageType( K3b::BootItem::HARDDISK );
+            else
+                bootItem->setImageType( K3b::BootItem::NONE );
+            bootItem->setNoBoot( attributes.value( "no_boot" ) == QLatin1String( "yes" ) );
+            bootItem->setBootInfoTable( attributes.value( "boot_info_table" ) == QLatin1String( "yes" ) );
+            bootItem->setLoadSegment( attributes.value( "load_segment" ).toString().toInt() );
+            bootItem->setLoadSize( attributes.value( "load_size" ).toString().toInt() );
+
+            newItem = bootItem;
+        }
+
+        else {
+            newItem = new K3b::FileItem( url, *this, name );
+            parent->addDataItem( newItem );
+        }
+    }
+    else if( xml.name() == QLatin1String( "special" ) ) {
+        if( attributes.value( "type" ) == QLatin1String( "boot cataloge" ) )
+            createBootCatalogeItem( parent )->setK3bName( name );
+        xml.skipCurrentElement();
+    }
+    else if( xml.name() == QLatin1String( "directory" ) ) {
+        // This is for the VideoDVD project which already contains the *_TS folders
+        K3b::DirItem* newDirItem = 0;
+        if( K3b::DataItem* item = parent->find( name ) ) {
+            if( item->isDir() ) {
+                newDirItem = static_cast<K3b::DirItem*>(item);
+            }
+            else {
+                qCritical() << "(K3b::DataDoc) INVALID DOCUMENT: item " << item->k3bPath() << " saved twice" << endl;
+                return false;
+            }
+        }
+
+        if( !newDirItem ) {
+            newDirItem = new K3b::DirItem( name );
+            parent->addDataItem( newDirItem );
+        }
+
+        while( xml.readNextStartElement() ) {
+            if( !loadDataItem( xml, newDirItem ) )
+                return false;
+        }
+
+        newItem = newDirItem;
+    }
+    else {
+        qDebug() << "(K3b::DataDoc) wrong tag in files-section: " << xml.name();
+        return false;
+    }
+
+    // load the sort weight
+    if( newItem )
+        newItem->setSortWeight( attributes.value( "sort_weight" ).toString().toInt() );
+
+    return !xml.hasError();
+}
+
+
 bool K3b::DataDoc::saveDocumentData( QDomElement* docElem )
 {
     QDomDocument doc = docElem->ownerDocument();
@@ -850,6 +1071,35 @@ bool K3b::DataDoc::saveDocumentData( QDomElement* docElem )
 }
 
 
+bool K3b::DataDoc::saveDocumentStream( QXmlStreamWriter& xml )
+{
+    QDomDocument doc;
+    QDomElement sectionsElem = doc.createElement( "sections" );
+
+    saveGeneralDocumentData( &sectionsElem );
+
+    QDomElement optionsElem = doc.createElement( "options" );
+    saveDocumentDataOptions( optionsElem );
+    sectionsElem.appendChild( optionsElem );
+
+    QDomElement headerElem = doc.createElement( "header" );
+    saveDocumentDataHeader( headerElem );
+    sectionsElem.appendChild( headerElem );
+
+    for( QDomElement e = sectionsElem.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+        writeDomElement( xml, e );
+
+    // the entries are written directly without building a DOM tree
+    xml.writeStartElement( "files" );
+    Q_FOREACH( K3b::DataItem* item, root()->children() ) {
+        saveDataItem( item, xml );
+    }
+    xml.writeEndElement();
+
+    return !xml.hasError();
+}
+
+
 void K3b::DataDoc::saveDocumentDataOptions( QDomElement& optionsElem )
 {
     QDomDocument doc = optionsElem.ownerDocument();
@@ -942,6 +1192,10 @@ void K3b::DataDoc::saveDocumentDataOptions( QDomElement& optionsElem )
     topElem.setAttribute( "activated", isoOptions().doNotCacheInodes() ? "yes" : "no" );
     optionsElem.appendChild( topElem );
 
+    topElem = doc.createElement( "zisofs_compression" );
+    topElem.setAttribute( "activated", isoOptions().zisofsCompression() ? "yes" : "no" );
+    optionsElem.appendChild( topElem );
+
 
     topElem = doc.createElement( "whitespace_treatment" );
     switch( isoOptions().whiteSpaceTreatment() ) {
@@ -1098,6 +1352,60 @@ void K3b::DataDoc::saveDataItem( K3b::DataItem* item, QDomDocument* doc, QDomEle
 }
 
 
+void K3b::DataDoc::saveDataItem( K3b::DataItem* item, QXmlStreamWriter& xml )
+{
+    if( K3b::FileItem* fileItem = dynamic_cast<K3b::FileItem*>( item ) ) {
+        if( d->oldSession.contains( fileItem ) ) {
+            qDebug() << "(K3b::DataDoc) ignoring fileitem " << fileItem->k3bName() << " from old session while saving...";
+        }
+        else {
+            xml.writeStartElement( "file" );
+            xml.writeAttribute( "name", fileItem->k3bName() );
+
+            if( item->sortWeight() != 0 )
+                xml.writeAttribute( "sort_weight", QString::number(item->sortWeight()) );
+
+            // add boot options as attributes to preserve compatibility to older K3b versions
+            if( K3b::BootItem* bootItem = dynamic_cast<K3b::BootItem*>( fileItem ) ) {
+                if( bootItem->imageType() == K3b::BootItem::FLOPPY )
+                    xml.writeAttribute( "bootimage", "floppy" );
+                else if( bootItem->imageType() == K3b::BootItem::HARDDISK )
+                    xml.writeAttribute( "bootimage", "harddisk" );
+                else
+                    xml.writeAttribute( "bootimage", "none" );
+
+                xml.writeAttribute( "no_boot", bootItem->noBoot() ? "yes" : "no" );
+                xml.writeAttribute( "boot_info_table", bootItem->bootInfoTable() ? "yes" : "no" );
+                xml.writeAttribute( "load_segment", QString::number( bootItem->loadSegment() ) );
+                xml.writeAttribute( "load_size", QString::number( bootItem->loadSize() ) );
+            }
+
+            xml.writeTextElement( "url", fileItem->localPath() );
+            xml.writeEndElement();
+        }
+    }
+    else if( item == d->bootCataloge ) {
+        xml.writeStartElement( "special" );
+        xml.writeAttribute( "name", d->bootCataloge->k3bName() );
+        xml.writeAttribute( "type", "boot cataloge" );
+        xml.writeEndElement();
+    }
+    else if( K3b::DirItem* dirItem = dynamic_cast<K3b::DirItem*>( item ) ) {
+        xml.writeStartElement( "directory" );
+        xml.writeAttribute( "name", dirItem->k3bName() );
+
+        if( item->sortWeight() != 0 )
+            xml.writeAttribute( "sort_weight", QString::number(item->sortWeight()) );
+
+        Q_FOREACH( K3b::DataItem* item, dirItem->children() ) {
+            saveDataItem( item, xml );
+        }
+
+        xml.writeEndElement();
+    }
+}
+
+
 void K3b::DataDoc::removeItem( K3b::DataItem* item )
 {
     if( !item )
@@ -1130,8 +1438,11 @@ void K3b::DataDoc::endInsertItems( DirItem* parent, int start, int end )
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
         // update the project size
-        if( !item->isFromOldSession() )
+        if( !item->isFromOldSession() ) {
             d->sizeHandler->addFile( item );
+            if( d->zisofsCompression() )
+                d->zisofsEstimator->addItem( item );
+        }
 
         // update the boot item list
         if( item->isBootItem() )
@@ -1150,8 +1461,11 @@ void K3b::DataDoc::beginRemoveItems( DirItem* parent, int start, int end )
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
         // update the project size
-        if( !item->isFromOldSession() )
+        if( !item->isFromOldSession() ) {
             d->sizeHandler->removeFile( item );
+            if( d->zisofsCompression() )
+                d->zisofsEstimator->removeItem( item );
+        }
 
         // update the boot item list
         if( item->isBootItem() ) {
@@ -1433,9 +1747,9 @@ bool K3b::DataDoc::importSession( K3b::Device::Device* device, int session )
             }
         }
     }
-    K3b::Iso9660 iso( device, startSec );
+    K3b::ImportedSession* import = new K3b::ImportedSession( device, startSec );
 
-    if( iso.open() ) {
+    if( import->open() ) {
         // remove previously imported sessions
         clearImportedSession();
 
@@ -1447,11 +1761,14 @@ bool K3b::DataDoc::importSession( K3b::Device::Device* device, int session )
         // simply summing the file sizes could result in wrong values
         // that's why we use the size from the toc. This is more accurate
         // anyway since there might be files overwritten or removed
+        // The folders are imported lazily so summing would not even be possible.
         d->oldSessionSize = toc.last().lastSector().mode1Bytes();
         d->importedSession = session;
 
         qDebug() << "(K3b::DataDoc) imported session size: " << KIO::convertSize(d->oldSessionSize);
 
+        const K3b::Iso9660& iso = import->iso();
+
         // the track size for DVD+RW media and DVD-RW Overwrite media has nothing to do with the filesystem
         // size. in that case we need to use the filesystem's size (which is ok since it's one track anyway,
         // no real multisession)
@@ -1466,31 +1783,100 @@ bool K3b::DataDoc::importSession( K3b::Device::Device* device, int session )
         d->isoOptions.setVolumeID( iso.primaryDescriptor().volumeId );
         // TODO: also import some other pd fields
 
-        const K3b::Iso9660Directory* rootDir = iso.firstRRDirEntry();
-        // J�rg Schilling says that it is impossible to import the joliet tree for multisession
-//     if( !rootDir )
-//       rootDir = iso.firstJolietDirEntry();
-        if( !rootDir )
-            rootDir = iso.firstIsoDirEntry();
-
-        if( rootDir ) {
-            createSessionImportItems( rootDir, root() );
+        if( import->rootDir() ) {
+            // only the top level is read now, the folders are filled on demand
+            d->sessionImport = import;
+            createSessionImportItems( import->rootDir(), root() );
+            import->startPrefetching();
             emit changed();
             emit importedSessionChanged( importedSession() );
             return true;
         }
         else {
             qDebug() << "(K3b::DataDoc::importSession) Could not find primary volume desc.";
+            delete import;
             return false;
         }
     }
     else {
         qDebug() << "(K3b::DataDoc) unable to read toc.";
+        delete import;
         return false;
     }
 }
 
 
+void K3b::DataDoc::expandImportedDir( K3b::DirItem* dir )
+{
+    if( d->sessionImport && d->sessionImport->isPending( dir ) ) {
+        // wait for the prefetching thread in case it is reading right now
+        QMutexLocker locker( d->sessionImport->mutex() );
+
+        // folders which have not been read yet would be read from whatever
+        // medium is in the drive now
+        if( !d->sessionImport->isComplete() && !d->sessionImport->checkMedium() ) {
+            qDebug() << "(K3b::DataDoc) medium changed. Dropping the unread folders of the imported session.";
+            d->sessionImport->clearPendingDirs();
+        }
+        else {
+            createSessionImportItems( d->sessionImport->takePendingDir( dir ), dir );
+        }
+
+        d->sessionImport->releaseDevice();
+    }
+}
+
+
+bool K3b::DataDoc::isImportedDirPending( const K3b::DirItem* dir ) const
+{
+    return( d->sessionImport && d->sessionImport->isPending( dir ) );
+}
+
+
+void K3b::DataDoc::stopImportedSessionPrefetching()
+{
+    if( d->sessionImport )
+        d->sessionImport->stopPrefetching();
+}
+
+
+K3b::ImportedSession* K3b::DataDoc::sessionImport() const
+{
+    return d->sessionImport;
+}
+
+
+void K3b::DataDoc::hideOldSessionItem( K3b::DataItem* item )
+{
+    if( !item || !item->parent() )
+        return;
+
+    d->hiddenOldSessionPaths.append( item->k3bPath() );
+
+    // the items below a dir are deleted with it
+    QList<K3b::DataItem*> items;
+    items.append( item );
+    while( !items.isEmpty() ) {
+        K3b::DataItem* i = items.takeFirst();
+        d->oldSession.removeOne( i );
+        if( i->isDir() ) {
+            if( d->sessionImport )
+                d->sessionImport->takePendingDir( static_cast<K3b::DirItem*>( i ) );
+            items += static_cast<K3b::DirItem*>( i )->children();
+        }
+    }
+
+    delete item;
+    setModified( true );
+}
+
+
+QStringList K3b::DataDoc::hiddenOldSessionPaths() const
+{
+    return d->hiddenOldSessionPaths;
+}
+
+
 void K3b::DataDoc::createSessionImportItems( const K3b::Iso9660Directory* importDir, K3b::DirItem* parent )
 {
     if( !parent )
@@ -1525,7 +1911,8 @@ void K3b::DataDoc::createSessionImportItems( const K3b::Iso9660Directory* import
                 dir->setExtraInfo( i18n("From previous session") );
                 d->oldSession.append( dir );
 
-                createSessionImportItems( static_cast<const K3b::Iso9660Directory*>(entry), dir );
+                // the contents are created once the dir is accessed
+                d->sessionImport->addPendingDir( dir, static_cast<const K3b::Iso9660Directory*>(entry) );
             }
             else {
                 const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>(entry);
@@ -1549,6 +1936,11 @@ void K3b::DataDoc::clearImportedSession()
     //  d->oldSessionSizeHandler->clear();
     d->importedSession = -1;
     d->oldSessionSize = 0;
+    d->hiddenOldSessionPaths.clear();
+
+    // the folders which have not been expanded yet are simply deleted below
+    delete d->sessionImport;
+    d->sessionImport = 0;
 
     while( !d->oldSession.isEmpty() ) {
         K3b::DataItem* item = d->oldSession.takeFirst();
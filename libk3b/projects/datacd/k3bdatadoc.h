@@ -34,6 +34,7 @@ namespace K3b {
     class DirItem;
     class Job;
     class BootItem;
+    class ImportedSession;
     class Iso9660Directory;
     class IsoOptions;
 
@@ -115,6 +116,15 @@ namespace K3b {
 
         QString treatWhitespace( const QString& );
 
+        /**
+         * \return A shared copy of the local directory path \p dir.
+         *
+         * FileItems store their local path as the interned directory plus
+         * the file name so the directory is only kept once in memory.
+         * This is thread-safe.
+         */
+        QString internLocalDir( const QString& dir );
+
         BurnJob* newBurnJob( JobHandler* hdl, QObject* parent = 0 ) override;
 
         MultiSessionMode multiSessionMode() const;
@@ -186,6 +196,10 @@ namespace K3b {
          * and properly set the imported session size.
          * Some settings will be adjusted to the imported session (joliet, rr).
          *
+         * Only the top level of the session is imported right away. The
+         * folders are filled once they are accessed, see expandImportedDir(),
+         * while the rest of the tree is read in the background.
+         *
          * Be aware that this method is blocking.
          *
          * \return true if the old session was successfully imported, false if no
@@ -202,6 +216,47 @@ namespace K3b {
          */
         int importedSession() const;
 
+        /**
+         * Creates the items of a folder from the imported session if that
+         * did not happen yet. DirItem calls this before its children are
+         * searched or new items are added.
+         */
+        void expandImportedDir( DirItem* dir );
+
+        /**
+         * \return true if \p dir is a folder from the imported session
+         *         which has not been expanded yet.
+         */
+        bool isImportedDirPending( const DirItem* dir ) const;
+
+        /**
+         * Stops reading the imported session in the background. Folders
+         * which have not been expanded yet are still read on demand.
+         * Used before burning to keep the drive free.
+         */
+        void stopImportedSessionPrefetching();
+
+        /**
+         * The file system of the imported session or 0 if no session
+         * was imported.
+         */
+        ImportedSession* sessionImport() const;
+
+        /**
+         * Removes an item of the imported session from the project. Since
+         * the data cannot be removed from the medium the item is hidden
+         * in the new session instead.
+         *
+         * \see hiddenOldSessionPaths()
+         */
+        void hideOldSessionItem( DataItem* item );
+
+        /**
+         * The paths of the items removed via hideOldSessionItem(). Directories
+         * end with a slash like DataItem::k3bPath().
+         */
+        QStringList hiddenOldSessionPaths() const;
+
         /**
          * Searches for an item by it's local path.
          *
@@ -236,6 +291,11 @@ namespace K3b {
         void itemsAboutToBeRemoved( K3b::DirItem* parent, int start, int end );
         void itemsInserted( K3b::DirItem* parent, int start, int end );
         void itemsRemoved( K3b::DirItem* parent, int start, int end );
+
+        /**
+         * Emitted when the name of \p item in the project changed.
+         */
+        void itemRenamed( K3b::DataItem* item );
         void volumeIdChanged();
         void importedSessionChanged( int importedSession );
 
@@ -244,6 +304,10 @@ namespace K3b {
         bool loadDocumentData( QDomElement* root ) override;
         /** reimplemented from Doc */
         bool saveDocumentData( QDomElement* ) override;
+        /** reimplemented from Doc */
+        bool loadDocumentStream( QXmlStreamReader& xml ) override;
+        /** reimplemented from Doc */
+        bool saveDocumentStream( QXmlStreamWriter& xml ) override;
 
         void saveDocumentDataOptions( QDomElement& optionsElem );
         void saveDocumentDataHeader( QDomElement& headerElem );
@@ -266,10 +330,12 @@ namespace K3b {
          * load recursively
          */
         bool loadDataItem( QDomElement& e, DirItem* parent );
+        bool loadDataItem( QXmlStreamReader& xml, DirItem* parent );
         /**
          * save recursively
          */
         void saveDataItem( DataItem* item, QDomDocument* doc, QDomElement* parent );
+        void saveDataItem( DataItem* item, QXmlStreamWriter& xml );
 
         void informAboutNotFoundFiles();
 
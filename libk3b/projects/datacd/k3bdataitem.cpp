@@ -20,20 +20,36 @@
 #include "k3bisooptions.h"
 #include <QDebug>
 
+#include <QAtomicInteger>
+
 #include <math.h>
-#include <QTime>
+
+
+namespace {
+    // items are created from the dir scanning thread as well
+    QAtomicInteger<quint64> s_inTimeCounter;
+
+    quint64 nextInTime()
+    {
+        return s_inTimeCounter.fetchAndAddRelaxed( 1 );
+    }
+}
 
 
 class K3b::DataItem::Private
 {
 public:
-    K3b::DataItem::ItemFlags flags;
+    QString writtenName;
+    QString rawIsoName;
+    QString extraInfo;
 };
 
 
 K3b::DataItem::DataItem( const ItemFlags& flags )
-    : m_parentDir(0),
+    : d(0),
+      m_parentDir(0),
       m_sortWeight(0),
+      m_flags(flags),
       m_bHideOnRockRidge(false),
       m_bHideOnJoliet(false),
       m_bRemoveable(true),
@@ -43,27 +59,28 @@ K3b::DataItem::DataItem( const ItemFlags& flags )
       m_bHideable(true),
       m_bWriteToCd(true)
 {
-    d = new Private;
-    d->flags = flags;
-    m_inTime = QTime::currentTime().toString("hhmmss");
+    m_inTime = nextInTime();
 }
 
 
 K3b::DataItem::DataItem( const K3b::DataItem& item )
     : m_k3bName( item.m_k3bName ),
-      m_extraInfo( item.m_extraInfo ),
+      d( 0 ),
       m_parentDir( 0 ),
       m_sortWeight( item.m_sortWeight ),
+      m_flags( item.m_flags ),
       m_bHideOnRockRidge( item.m_bHideOnRockRidge ),
       m_bHideOnJoliet( item.m_bHideOnJoliet ),
       m_bRemoveable( item.m_bRemoveable ),
+      m_bDeleteable( item.m_bDeleteable ),
       m_bRenameable( item.m_bRenameable ),
       m_bMovable( item.m_bMovable ),
       m_bHideable( item.m_bHideable ),
       m_bWriteToCd( item.m_bWriteToCd )
 {
-    d = new Private;
-    d->flags = item.d->flags;
+    if( !item.extraInfo().isEmpty() )
+        setExtraInfo( item.extraInfo() );
+    m_inTime = nextInTime();
 }
 
 
@@ -73,51 +90,45 @@ K3b::DataItem::~DataItem()
 }
 
 
-const K3b::DataItem::ItemFlags& K3b::DataItem::flags() const
-{
-   return d->flags;
-}
-
-
 void K3b::DataItem::setFlags( const ItemFlags& flags )
 {
-    d->flags = flags;
+    m_flags = flags;
 }
 
 
 bool K3b::DataItem::isDir() const
 {
-   return d->flags & DIR;
+   return m_flags & DIR;
 }
 
 
 bool K3b::DataItem::isFile() const
 {
-   return d->flags & FILE;
+   return m_flags & FILE;
 }
 
 
 bool K3b::DataItem::isSpecialFile() const
 {
-   return d->flags & SPECIALFILE;
+   return m_flags & SPECIALFILE;
 }
 
 
 bool K3b::DataItem::isSymLink() const
 {
-   return d->flags & SYMLINK;
+   return m_flags & SYMLINK;
 }
 
 
 bool K3b::DataItem::isFromOldSession() const
 {
-   return d->flags & OLD_SESSION;
+   return m_flags & OLD_SESSION;
 }
 
 
 bool K3b::DataItem::isBootItem() const
 {
-   return d->flags & BOOT_IMAGE;
+   return m_flags & BOOT_IMAGE;
 }
 
 
@@ -169,6 +180,7 @@ void K3b::DataItem::setK3bName( const QString& name ) {
 
         if( DataDoc* doc = getDoc() ) {
             doc->setModified();
+            emit doc->itemRenamed( this );
         }
     }
 }
@@ -195,6 +207,61 @@ K3b::DataItem* K3b::DataItem::take()
 }
 
 
+QString K3b::DataItem::writtenName() const
+{
+    // a null written name means it equals the k3b name
+    if( d && !d->writtenName.isNull() )
+        return d->writtenName;
+    else
+        return m_k3bName;
+}
+
+
+QString K3b::DataItem::iso9660Name() const
+{
+    return d ? d->rawIsoName : QString();
+}
+
+
+void K3b::DataItem::setWrittenName( const QString& s )
+{
+    if( s == m_k3bName ) {
+        if( d )
+            d->writtenName = QString();
+        return;
+    }
+    if( !d )
+        d = new Private;
+    d->writtenName = s;
+}
+
+
+void K3b::DataItem::setIso9660Name( const QString& s )
+{
+    if( !d && s.isEmpty() )
+        return;
+    if( !d )
+        d = new Private;
+    d->rawIsoName = s;
+}
+
+
+QString K3b::DataItem::extraInfo() const
+{
+    return d ? d->extraInfo : QString();
+}
+
+
+void K3b::DataItem::setExtraInfo( const QString& i )
+{
+    if( !d && i.isEmpty() )
+        return;
+    if( !d )
+        d = new Private;
+    d->extraInfo = i;
+}
+
+
 QString K3b::DataItem::k3bPath() const
 {
     if( !parent() )
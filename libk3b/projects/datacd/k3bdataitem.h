@@ -87,16 +87,17 @@ namespace K3b {
         /**
          * Returns the name of the item as used on the CD or DVD image.
          *
-         * This is only valid after a call to @p DataDoc::prepareFilenames()
+         * This is only valid after a call to @p DataDoc::prepareFilenames().
+         * Before that it equals k3bName().
          */
-        QString writtenName() const { return m_writtenName; }
+        QString writtenName() const;
 
         /**
          * \return the pure name used in the Iso9660 tree.
          *
          * This is only valid after a call to @p DataDoc::prepareFilenames()
          */
-        QString iso9660Name() const { return m_rawIsoName; }
+        QString iso9660Name() const;
 
         /**
          * Returns the path of the item as written to the CD or DVD image.
@@ -112,12 +113,12 @@ namespace K3b {
         /**
          * Used to set the written name by @p DataDoc::prepareFilenames()
          */
-        void setWrittenName( const QString& s ) { m_writtenName = s; }
+        void setWrittenName( const QString& s );
 
         /**
          * Used to set the pure Iso9660 name by @p DataDoc::prepareFilenames()
          */
-        void setIso9660Name( const QString& s ) { m_rawIsoName = s; }
+        void setIso9660Name( const QString& s );
 
         virtual DataItem* nextSibling() const;
 
@@ -142,7 +143,7 @@ namespace K3b {
 
         virtual void reparent( DirItem* );
 
-        const ItemFlags& flags() const;
+        const ItemFlags& flags() const { return m_flags; }
         bool isDir() const;
         bool isFile() const;
         bool isSpecialFile() const;
@@ -171,8 +172,12 @@ namespace K3b {
         virtual bool isRenameable() const { return m_bRenameable; }
         virtual bool isHideable() const { return m_bHideable; }
         virtual bool writeToCd() const { return m_bWriteToCd; }
-        virtual QString extraInfo() const { return m_extraInfo; }
-        virtual QString inTime() const { return m_inTime; }
+        virtual QString extraInfo() const;
+
+        /**
+         * A sequence number which orders the items by the time they were added.
+         */
+        quint64 inTime() const { return m_inTime; }
 
         /**
          * Default implementation returns the default mimetype.
@@ -185,7 +190,7 @@ namespace K3b {
         void setDeleteable( bool b ) { m_bDeleteable = b; }
         void setHideable( bool b ) { m_bHideable = b; }
         void setWriteToCd( bool b ) { m_bWriteToCd = b; }
-        void setExtraInfo( const QString& i ) { m_extraInfo = i; }
+        void setExtraInfo( const QString& i );
 
     protected:
         virtual KIO::filesize_t itemSize( bool followSymlinks ) const = 0;
@@ -205,26 +210,27 @@ namespace K3b {
         void setParentDir( DirItem* parentDir ) { m_parentDir = parentDir; }
 
     private:
+        // The names are only set while preparing the image and the extra
+        // info only for special items, so they live in a lazily created
+        // Private to keep the items of large projects small.
         class Private;
         Private* d;
 
-        QString m_writtenName;
-        QString m_rawIsoName;
-        QString m_extraInfo;
-        QString m_inTime;
-
         DirItem* m_parentDir;
         long m_sortWeight;
+        quint64 m_inTime;
+
+        ItemFlags m_flags;
+        bool m_bHideOnRockRidge : 1;
+        bool m_bHideOnJoliet : 1;
+        bool m_bRemoveable : 1;
+        bool m_bDeleteable : 1;
+        bool m_bRenameable : 1;
+        bool m_bMovable : 1;
+        bool m_bHideable : 1;
+        bool m_bWriteToCd : 1;
+
 
-        bool m_bHideOnRockRidge;
-        bool m_bHideOnJoliet;
-        bool m_bRemoveable;
-        bool m_bDeleteable;
-        bool m_bRenameable;
-        bool m_bMovable;
-        bool m_bHideable;
-        bool m_bWriteToCd;
-        
         friend class DirItem;
     };
 }
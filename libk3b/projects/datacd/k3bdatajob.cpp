@@ -44,10 +44,12 @@
 #include <QDataStream>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryFile>
+#include <QTimer>
 
 
 
@@ -83,6 +85,11 @@ public:
     K3b::DataMultiSessionParameterJob* multiSessionParameterJob;
 
     QByteArray checksumCache;
+
+    // source throughput and prefetching while the image is created
+    QTimer sourceTimer;
+    QElapsedTimer sourceClock;
+    quint64 sourceBytes;
 };
 
 
@@ -100,6 +107,9 @@ K3b::DataJob::DataJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent
     m_writerJob = 0;
     d->tocFile = 0;
     m_isoImager = 0;
+
+    d->sourceTimer.setInterval( 500 );
+    connect( &d->sourceTimer, SIGNAL(timeout()), this, SLOT(slotUpdateSourceStatus()) );
 }
 
 
@@ -137,6 +147,9 @@ void K3b::DataJob::start()
     d->copies = d->doc->copies();
     d->copiesDone = 0;
 
+    // the old session is merged by mkisofs, we do not need to read it anymore
+    d->doc->stopImportedSessionPrefetching();
+
     prepareImager();
 
     if( d->doc->dummy() ) {
@@ -255,6 +268,27 @@ void K3b::DataJob::startPipe()
         d->pipe->readFrom( m_isoImager->ioDevice(), true );
 
     d->pipe->open( true );
+
+    if( d->imageFinished ) {
+        d->sourceTimer.stop();
+    }
+    else {
+        d->sourceBytes = 0;
+        d->sourceClock.start();
+        d->sourceTimer.start();
+    }
+}
+
+
+void K3b::DataJob::slotUpdateSourceStatus()
+{
+    const quint64 bytes = d->pipe->bytesRead();
+    m_isoImager->setImagePosition( bytes );
+
+    const qint64 elapsed = d->sourceClock.restart();
+    if( elapsed > 0 )
+        emit sourceThroughput( int( ( bytes - d->sourceBytes ) * 1000ULL / 1024ULL / quint64( elapsed ) ) );
+    d->sourceBytes = bytes;
 }
 
 
@@ -372,6 +406,8 @@ void K3b::DataJob::slotIsoImagerFinished( bool success )
         }
     }
     else {
+        d->sourceTimer.stop();
+
         // cache the calculated checksum since the ChecksumPipe may be deleted below
         if ( ChecksumPipe* cp = qobject_cast<ChecksumPipe*>( d->pipe ) )
             d->checksumCache = cp->checksum();
@@ -1023,6 +1059,8 @@ K3b::DataDoc::MultiSessionMode K3b::DataJob::usedMultiSessionMode() const
 void K3b::DataJob::cleanup()
 {
     qDebug();
+    d->sourceTimer.stop();
+
     if( !d->doc->onTheFly() && ( d->doc->removeImages() || d->canceled ) ) {
         if( QFile::exists( d->doc->tempDir() ) ) {
             d->imageFile.remove();
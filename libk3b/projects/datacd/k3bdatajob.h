@@ -79,6 +79,7 @@ namespace K3b {
 
     private Q_SLOTS:
         void slotMultiSessionParamterSetupDone( bool );
+        void slotUpdateSourceStatus();
 
     protected:
         virtual bool prepareWriterJob();
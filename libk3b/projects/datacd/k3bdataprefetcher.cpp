@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bdataprefetcher.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bbootitem.h"
+#include "k3bisooptions.h"
+#include "k3bglobals.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <algorithm>
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace {
+    const quint64 s_defaultBudget = 64ULL*1024ULL*1024ULL;
+
+    // large files are read ahead in pieces so they do not exceed the budget
+    const quint64 s_chunkSize = 4ULL*1024ULL*1024ULL;
+
+    struct Entry {
+        QString path;
+        long weight;
+        quint64 size;
+        quint64 offset;
+    };
+
+    bool nameLessThan( K3b::DataItem* a, K3b::DataItem* b )
+    {
+        return a->writtenName() < b->writtenName();
+    }
+
+    bool weightGreaterThan( const Entry& a, const Entry& b )
+    {
+        return a.weight > b.weight;
+    }
+
+    void collectFiles( K3b::DirItem* dir, bool followLinks, QVector<Entry>& entries )
+    {
+        K3b::DirItem::Children items = dir->children();
+        std::sort( items.begin(), items.end(), nameLessThan );
+
+        QList<K3b::DirItem*> dirs;
+        Q_FOREACH( K3b::DataItem* item, items ) {
+            if( !item->writeToCd() || item->isFromOldSession() )
+                continue;
+
+            if( item->isDir() ) {
+                dirs.append( static_cast<K3b::DirItem*>( item ) );
+                continue;
+            }
+
+            QString path;
+            if( item->isBootItem() )
+                path = static_cast<K3b::BootItem*>( item )->tempPath();
+            else if( item->isSymLink() ) {
+                // links are written as links unless they are followed
+                if( followLinks )
+                    path = K3b::resolveLink( item->localPath() );
+            }
+            else if( item->isFile() )
+                path = item->localPath();
+
+            if( path.isEmpty() )
+                continue;
+
+            Entry entry;
+            entry.path = path;
+            entry.weight = item->sortWeight();
+            entry.size = item->itemSize( followLinks );
+            entry.offset = 0;
+            entries.append( entry );
+        }
+
+        // mkisofs places the files of a directory before those of its subdirectories
+        Q_FOREACH( K3b::DirItem* subDir, dirs )
+            collectFiles( subDir, followLinks, entries );
+    }
+}
+
+
+class K3b::DataPrefetcher::Private
+{
+public:
+    class PrefetchThread : public QThread
+    {
+    public:
+        explicit PrefetchThread( Private* d )
+            : m_d( d ) {
+        }
+
+        void run() override {
+            m_d->prefetch();
+        }
+
+    private:
+        Private* m_d;
+    };
+
+    Private( DataDoc* d )
+        : doc( d ),
+          budget( s_defaultBudget ),
+          position( 0 ),
+          prefetched( 0 ),
+          stopped( false ),
+          thread( this ) {
+    }
+
+    // wait until the range starting at offset is within the budget
+    bool waitForWindow( quint64 offset ) {
+        QMutexLocker locker( &mutex );
+        while( !stopped && offset > position + budget )
+            positionChanged.wait( &mutex );
+        return !stopped;
+    }
+
+    void prefetch() {
+#ifndef POSIX_FADV_WILLNEED
+        QByteArray buffer( int( s_chunkSize ), Qt::Uninitialized );
+#endif
+        for( int i = 0; i < entries.count(); ++i ) {
+            const Entry& entry = entries[i];
+            int fd = -1;
+            quint64 done = 0;
+            while( done < entry.size ) {
+                if( !waitForWindow( entry.offset + done ) ) {
+                    if( fd >= 0 )
+                        ::close( fd );
+                    return;
+                }
+
+                if( fd < 0 ) {
+                    fd = ::open( QFile::encodeName( entry.path ).constData(), O_RDONLY );
+                    if( fd < 0 ) {
+                        // mkisofs reports unreadable files
+                        break;
+                    }
+                }
+
+                const quint64 len = qMin( s_chunkSize, entry.size - done );
+#ifdef POSIX_FADV_WILLNEED
+                // starts the read ahead without waiting for it
+                ::posix_fadvise( fd, off_t( done ), off_t( len ), POSIX_FADV_WILLNEED );
+#else
+                if( ::read( fd, buffer.data(), len ) <= 0 )
+                    break;
+#endif
+                done += len;
+
+                QMutexLocker locker( &mutex );
+                prefetched += len;
+            }
+
+            if( fd >= 0 )
+                ::close( fd );
+        }
+    }
+
+    DataDoc* doc;
+    QVector<Entry> entries;
+
+    // protected by the mutex
+    quint64 budget;
+    quint64 position;
+    quint64 prefetched;
+    bool stopped;
+
+    mutable QMutex mutex;
+    QWaitCondition positionChanged;
+
+    PrefetchThread thread;
+};
+
+
+K3b::DataPrefetcher::DataPrefetcher( DataDoc* doc )
+    : d( new Private( doc ) )
+{
+}
+
+
+K3b::DataPrefetcher::~DataPrefetcher()
+{
+    stop();
+    delete d;
+}
+
+
+void K3b::DataPrefetcher::setBudget( quint64 bytes )
+{
+    QMutexLocker locker( &d->mutex );
+    d->budget = bytes;
+    d->positionChanged.wakeAll();
+}
+
+
+void K3b::DataPrefetcher::start()
+{
+    stop();
+
+    d->entries.clear();
+    collectFiles( d->doc->root(), d->doc->isoOptions().followSymbolicLinks(), d->entries );
+
+    // mkisofs -sort moves the files with higher weights to the front
+    std::stable_sort( d->entries.begin(), d->entries.end(), weightGreaterThan );
+
+    // hard links and files added more than once are only written once
+    QSet<QString> seen;
+    quint64 offset = 0;
+    QVector<Entry>::iterator it = d->entries.begin();
+    while( it != d->entries.end() ) {
+        if( seen.contains( it->path ) ) {
+            it = d->entries.erase( it );
+        }
+        else {
+            seen.insert( it->path );
+            it->offset = offset;
+            offset += ( it->size + 2047ULL ) / 2048ULL * 2048ULL;
+            ++it;
+        }
+    }
+
+    qDebug() << "(K3b::DataPrefetcher) prefetching" << d->entries.count() << "files with" << offset << "bytes.";
+
+    d->position = 0;
+    d->prefetched = 0;
+    d->stopped = false;
+    d->thread.start( QThread::LowPriority );
+}
+
+
+void K3b::DataPrefetcher::stop()
+{
+    {
+        QMutexLocker locker( &d->mutex );
+        d->stopped = true;
+        d->positionChanged.wakeAll();
+    }
+    d->thread.wait();
+}
+
+
+void K3b::DataPrefetcher::setPosition( quint64 bytes )
+{
+    QMutexLocker locker( &d->mutex );
+    d->position = bytes;
+    d->positionChanged.wakeAll();
+}
+
+
+quint64 K3b::DataPrefetcher::prefetchedBytes() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->prefetched;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_DATA_PREFETCHER_H_
+#define _K3B_DATA_PREFETCHER_H_
+
+#include <QtGlobal>
+
+
+namespace K3b {
+    class DataDoc;
+
+    /**
+     * Reads the source files of a data project into the page cache
+     * shortly before mkisofs needs them.
+     *
+     * The files are visited in the order mkisofs writes them to the image:
+     * the directory tree depth-first with the files of a directory before
+     * its subdirectories, each sorted by name, and all of it stably sorted
+     * by descending sort weight. A background thread asks the kernel to read
+     * ahead the files which lie within the budget ahead of the current image
+     * position. This smooths out the seeks of many small files on rotating
+     * disks or network file systems which otherwise starve the writer.
+     *
+     * The image position has to be fed via setPosition(). It does not have
+     * to be exact, the metadata at the start of the image only makes the
+     * prefetcher run slightly further ahead.
+     */
+    class DataPrefetcher
+    {
+    public:
+        explicit DataPrefetcher( DataDoc* doc );
+        ~DataPrefetcher();
+
+        /**
+         * How far the prefetcher may run ahead of the image position.
+         * Default is 64 MB.
+         */
+        void setBudget( quint64 bytes );
+
+        /**
+         * Determines the file order and starts prefetching.
+         * Call after the file names of the project have been prepared.
+         */
+        void start();
+
+        /**
+         * Stops prefetching and waits for the thread to finish.
+         */
+        void stop();
+
+        /**
+         * The number of image bytes consumed so far. Thread-safe.
+         */
+        void setPosition( quint64 bytes );
+
+        /**
+         * The number of file bytes the prefetcher asked the kernel for.
+         */
+        quint64 prefetchedBytes() const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( DataPrefetcher )
+    };
+}
+
+#endif
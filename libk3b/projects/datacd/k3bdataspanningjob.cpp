@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bdataspanningjob.h"
+#include "k3bdataspanningplanner.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bfilesplitter.h"
+#include "k3bglobals.h"
+#include "k3bisooptions.h"
+#include "k3bthreadjob.h"
+#include "k3b_i18n.h"
+
+#include <KDiskFreeSpaceInfo>
+#include <KIO/Global>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+
+namespace {
+    const int s_bufferSize = 1024*1024;
+
+    /**
+     * Splits the files which are larger than a disc into the pieces
+     * the discs are built from.
+     */
+    class FileSplitJob : public K3b::ThreadJob
+    {
+    public:
+        struct File {
+            QString source;
+            QString target;
+            KIO::filesize_t size;
+            KIO::filesize_t pieceSize;
+        };
+
+        FileSplitJob( K3b::JobHandler* hdl, QObject* parent )
+            : K3b::ThreadJob( hdl, parent ) {
+        }
+
+        QString jobDescription() const override { return i18n("Splitting Large Files"); }
+
+        QList<File> files;
+
+    private:
+        bool run() override;
+    };
+
+
+    bool FileSplitJob::run()
+    {
+        emit newTask( i18n("Splitting large files") );
+
+        KIO::filesize_t total = 0;
+        Q_FOREACH( const File& file, files )
+            total += file.size;
+
+        QByteArray buffer( s_bufferSize, Qt::Uninitialized );
+        KIO::filesize_t done = 0;
+        Q_FOREACH( const File& file, files ) {
+            emit newSubTask( i18n("Splitting %1", QFileInfo( file.source ).fileName()) );
+
+            QFile in( file.source );
+            if( !in.open( QIODevice::ReadOnly ) ) {
+                emit infoMessage( i18n("Could not open file %1", file.source), MessageError );
+                return false;
+            }
+
+            K3b::FileSplitter out( file.target );
+            out.setMaxFileSize( file.pieceSize );
+            if( !out.open( QIODevice::WriteOnly ) ) {
+                emit infoMessage( i18n("Unable to open '%1' for writing.", file.target), MessageError );
+                return false;
+            }
+
+            qint64 read = 0;
+            while( ( read = in.read( buffer.data(), buffer.size() ) ) > 0 ) {
+                if( canceled() ) {
+                    out.remove();
+                    return false;
+                }
+
+                if( out.write( buffer.constData(), read ) != read ) {
+                    emit infoMessage( i18n("Error while writing to '%1'.", file.target), MessageError );
+                    out.remove();
+                    return false;
+                }
+
+                done += read;
+                emit percent( total > 0 ? 100ULL*done/total : 100 );
+                emit processedSize( done/1024ULL/1024ULL, total/1024ULL/1024ULL );
+            }
+
+            out.close();
+
+            if( read < 0 ) {
+                emit infoMessage( i18n("Error while reading file %1", file.source), MessageError );
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+
+class K3b::DataSpanningJob::Private
+{
+public:
+    Private()
+        : capacity( MediaSizeBluRay25Gb ),
+          currentDisc( 0 ),
+          splitJob( 0 ),
+          discDoc( 0 ),
+          burnJob( 0 ),
+          canceled( false ) {
+    }
+
+    DataDoc* doc;
+    DataSpanningPlanner* planner;
+    Msf capacity;
+
+    QList<DataSpanningPlanner::Disc> discs;
+    int currentDisc;
+
+    QString tempFolder;
+    QString catalogPath;
+
+    // the name of the first piece of each split file, see FileSplitter
+    QHash<const DataItem*, QString> pieceFiles;
+
+    FileSplitJob* splitJob;
+    DataDoc* discDoc;
+    BurnJob* burnJob;
+    bool canceled;
+};
+
+
+K3b::DataSpanningJob::DataSpanningJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent )
+    : K3b::BurnJob( hdl, parent ),
+      d( new Private() )
+{
+    d->doc = doc;
+    d->planner = new DataSpanningPlanner( doc, this );
+}
+
+
+K3b::DataSpanningJob::~DataSpanningJob()
+{
+    cleanup();
+    delete d;
+}
+
+
+QString K3b::DataSpanningJob::jobDescription() const
+{
+    return i18n("Writing Data Project to Several Discs");
+}
+
+
+QString K3b::DataSpanningJob::jobDetails() const
+{
+    if( d->discs.isEmpty() )
+        return QString();
+    else
+        return i18np("%2 on 1 disc", "%2 on %1 discs", d->discs.count(), KIO::convertSize( d->doc->size() ));
+}
+
+
+K3b::Device::Device* K3b::DataSpanningJob::writer() const
+{
+    return d->doc->burner();
+}
+
+
+void K3b::DataSpanningJob::setCapacity( const K3b::Msf& blocks )
+{
+    d->capacity = blocks;
+}
+
+
+void K3b::DataSpanningJob::start()
+{
+    jobStarted();
+
+    d->canceled = false;
+    d->currentDisc = 0;
+    d->pieceFiles.clear();
+
+    emit newTask( i18n("Distributing the files over the discs") );
+
+    d->planner->setCapacity( d->capacity );
+    d->discs = d->planner->plan();
+    if( d->discs.isEmpty() ) {
+        emit infoMessage( i18n("The project cannot be split into discs of %1.",
+                               KIO::convertSize( d->capacity.mode1Bytes() )), MessageError );
+        jobFinished( false );
+        return;
+    }
+
+    emit infoMessage( i18np("The project is written to 1 disc.",
+                            "The project is written to %1 discs.", d->discs.count()), MessageInfo );
+
+    if( !prepareTempFolder() ) {
+        cleanup();
+        jobFinished( false );
+        return;
+    }
+
+    if( !d->splitJob ) {
+        startNextDisc();
+    }
+    else {
+        connectSubJob( d->splitJob, SLOT(slotSplitFinished(bool)) );
+        d->splitJob->start();
+    }
+}
+
+
+void K3b::DataSpanningJob::cancel()
+{
+    d->canceled = true;
+
+    if( d->splitJob && d->splitJob->active() )
+        d->splitJob->cancel();
+    else if( d->burnJob && d->burnJob->active() )
+        d->burnJob->cancel();
+}
+
+
+bool K3b::DataSpanningJob::prepareTempFolder()
+{
+    d->tempFolder = K3b::findTempFile();
+    if( !QDir().mkpath( d->tempFolder ) ) {
+        emit infoMessage( i18n("Unable to create folder '%1'", d->tempFolder), MessageError );
+        d->tempFolder.clear();
+        return false;
+    }
+
+    d->catalogPath = d->tempFolder + '/' + d->planner->catalogName();
+    QFile catalog( d->catalogPath );
+    const QByteArray data = d->planner->catalog( d->discs );
+    if( !catalog.open( QIODevice::WriteOnly ) || catalog.write( data ) != data.size() ) {
+        emit infoMessage( i18n("Unable to open '%1' for writing.", d->catalogPath), MessageError );
+        return false;
+    }
+    catalog.close();
+
+    //
+    // Each split file gets its own folder to keep the piece names of files
+    // with the same name in different folders apart.
+    //
+    QList<FileSplitJob::File> files;
+    KIO::filesize_t totalSize = 0;
+    Q_FOREACH( const DataSpanningPlanner::Disc& disc, d->discs ) {
+        Q_FOREACH( const DataSpanningPlanner::Unit& unit, disc.units ) {
+            if( unit.piece < 0 || d->pieceFiles.contains( unit.item ) )
+                continue;
+
+            const QString folder = d->tempFolder + '/' + QString::number( files.count() );
+            if( !QDir().mkpath( folder ) ) {
+                emit infoMessage( i18n("Unable to create folder '%1'", folder), MessageError );
+                return false;
+            }
+
+            FileSplitJob::File file;
+            file.source = unit.item->localPath();
+            file.target = folder + '/' + unit.item->k3bName();
+            file.size = unit.item->size();
+            file.pieceSize = d->planner->pieceSize( unit.item );
+            files.append( file );
+            totalSize += file.size;
+
+            d->pieceFiles.insert( unit.item, file.target );
+        }
+    }
+
+    if( !files.isEmpty() ) {
+        KDiskFreeSpaceInfo free = KDiskFreeSpaceInfo::freeSpaceInfo( d->tempFolder );
+        if( free.isValid() && free.available() < totalSize ) {
+            emit infoMessage( i18n("Not enough space in %1 to split the large files (%2 needed).",
+                                   d->tempFolder, KIO::convertSize( totalSize ) ), MessageError );
+            return false;
+        }
+
+        d->splitJob = new FileSplitJob( this, this );
+        d->splitJob->files = files;
+    }
+
+    return true;
+}
+
+
+void K3b::DataSpanningJob::slotSplitFinished( bool success )
+{
+    d->splitJob->deleteLater();
+    d->splitJob = 0;
+
+    if( d->canceled ) {
+        emit canceled();
+        cleanup();
+        jobFinished( false );
+    }
+    else if( !success ) {
+        cleanup();
+        jobFinished( false );
+    }
+    else {
+        startNextDisc();
+    }
+}
+
+
+void K3b::DataSpanningJob::startNextDisc()
+{
+    if( d->currentDisc >= d->discs.count() ) {
+        cleanup();
+        jobFinished( true );
+        return;
+    }
+
+    emit newTask( i18n("Writing disc %1 of %2", d->currentDisc+1, d->discs.count()) );
+
+    d->discDoc = createDiscDoc( d->currentDisc );
+    d->burnJob = d->discDoc->newBurnJob( this, this );
+    connectSubJob( d->burnJob,
+                   SLOT(slotBurnJobFinished(bool)),
+                   DEFAULT_SIGNAL_CONNECTION,
+                   DEFAULT_SIGNAL_CONNECTION,
+                   SLOT(slotBurnPercent(int)) );
+    connect( d->burnJob, SIGNAL(bufferStatus(int)), this, SIGNAL(bufferStatus(int)) );
+    connect( d->burnJob, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+    connect( d->burnJob, SIGNAL(sourceThroughput(int)), this, SIGNAL(sourceThroughput(int)) );
+    connect( d->burnJob, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+    connect( d->burnJob, SIGNAL(burning(bool)), this, SIGNAL(burning(bool)) );
+
+    d->burnJob->start();
+}
+
+
+void K3b::DataSpanningJob::slotBurnPercent( int p )
+{
+    emit subPercent( p );
+    emit percent( ( 100*d->currentDisc + p ) / d->discs.count() );
+}
+
+
+void K3b::DataSpanningJob::slotBurnJobFinished( bool success )
+{
+    d->burnJob->deleteLater();
+    d->burnJob = 0;
+    d->discDoc->deleteLater();
+    d->discDoc = 0;
+
+    if( d->canceled ) {
+        emit canceled();
+        cleanup();
+        jobFinished( false );
+    }
+    else if( !success ) {
+        emit infoMessage( i18n("Writing disc %1 of %2 failed.", d->currentDisc+1, d->discs.count()), MessageError );
+        cleanup();
+        jobFinished( false );
+    }
+    else {
+        emit infoMessage( i18n("Disc %1 of %2 successfully written.", d->currentDisc+1, d->discs.count()), MessageSuccess );
+        ++d->currentDisc;
+        startNextDisc();
+    }
+}
+
+
+K3b::DataDoc* K3b::DataSpanningJob::createDiscDoc( int disc )
+{
+    DataDoc* doc = new DataDoc( this );
+    doc->newDocument();
+
+    const int count = d->discs.count();
+
+    // the volume ID is limited to 32 characters
+    IsoOptions options = d->doc->isoOptions();
+    const QString suffix = QString( "_%1" ).arg( disc+1 );
+    options.setVolumeID( options.volumeID().left( 32 - suffix.length() ) + suffix );
+    options.setVolumeSetSize( count );
+    options.setVolumeSetNumber( disc+1 );
+    doc->setIsoOptions( options );
+
+    doc->setBurner( d->doc->burner() );
+    doc->setSpeed( d->doc->speed() );
+    doc->setWritingMode( d->doc->writingMode() );
+    doc->setWritingApp( d->doc->writingApp() );
+    doc->setDummy( d->doc->dummy() );
+    doc->setOnTheFly( d->doc->onTheFly() );
+    doc->setRemoveImages( d->doc->removeImages() );
+    doc->setOnlyCreateImages( d->doc->onlyCreateImages() );
+    doc->setCopies( d->doc->copies() );
+    doc->setDataMode( d->doc->dataMode() );
+    doc->setVerifyData( d->doc->verifyData() );
+    doc->setMultiSessionMode( DataDoc::NONE );
+
+    // each disc needs its own image file
+    if( !d->doc->tempDir().isEmpty() ) {
+        const QFileInfo image( d->doc->tempDir() );
+        QString name = image.path() + '/' + image.completeBaseName() + suffix;
+        if( !image.suffix().isEmpty() )
+            name += '.' + image.suffix();
+        doc->setTempDir( name );
+    }
+
+    Q_FOREACH( const DataSpanningPlanner::Unit& unit, d->discs[disc].units ) {
+        DirItem* parent = doc->root();
+        const QString parentPath = unit.item->parent()->k3bPath();
+        if( !parentPath.isEmpty() ) {
+            const QString path = parentPath.left( parentPath.length()-1 );
+            doc->root()->mkdir( path );
+            DataItem* item = doc->root()->findByPath( path );
+            parent = ( item && item->isDir() ? static_cast<DirItem*>( item ) : 0 );
+        }
+
+        if( !parent ) {
+            qDebug() << "(K3b::DataSpanningJob) could not create" << parentPath;
+            continue;
+        }
+
+        if( unit.piece < 0 ) {
+            parent->addDataItem( unit.item->copy() );
+        }
+        else {
+            const QString pieceFile = DataSpanningPlanner::pieceName( d->pieceFiles[unit.item], unit.piece );
+            parent->addDataItem( new FileItem( pieceFile, *doc,
+                                               DataSpanningPlanner::pieceName( unit.item->k3bName(), unit.piece ) ) );
+        }
+    }
+
+    doc->root()->addDataItem( new FileItem( d->catalogPath, *doc, d->planner->catalogName() ) );
+
+    return doc;
+}
+
+
+void K3b::DataSpanningJob::cleanup()
+{
+    if( !d->tempFolder.isEmpty() ) {
+        QDir( d->tempFolder ).removeRecursively();
+        d->tempFolder.clear();
+    }
+    d->pieceFiles.clear();
+}
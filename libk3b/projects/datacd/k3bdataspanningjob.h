@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_DATA_SPANNING_JOB_H_
+#define _K3B_DATA_SPANNING_JOB_H_
+
+#include "k3bjob.h"
+#include "k3bmsf.h"
+#include "k3b_export.h"
+
+
+namespace K3b {
+    class DataDoc;
+
+    /**
+     * Writes a data project which is too big for one medium to several
+     * discs, one after the other.
+     *
+     * The project is distributed with DataSpanningPlanner. Files larger than
+     * a disc are split into the temporary folder with FileSplitter first.
+     * Each disc is burned from its own DataDoc with the settings of the
+     * project. The volume ID gets the disc number appended and the volume set
+     * fields are filled. All discs contain the catalog of the whole set.
+     *
+     * The project must not be changed while the job is running.
+     */
+    class LIBK3B_EXPORT DataSpanningJob : public BurnJob
+    {
+        Q_OBJECT
+
+    public:
+        DataSpanningJob( DataDoc* doc, JobHandler* hdl, QObject* parent = 0 );
+        ~DataSpanningJob() override;
+
+        QString jobDescription() const override;
+        QString jobDetails() const override;
+
+        Device::Device* writer() const override;
+
+        /**
+         * The usable size of one disc.
+         */
+        void setCapacity( const Msf& blocks );
+
+    public Q_SLOTS:
+        void start() override;
+        void cancel() override;
+
+    private Q_SLOTS:
+        void slotSplitFinished( bool success );
+        void slotBurnJobFinished( bool success );
+        void slotBurnPercent( int p );
+
+    private:
+        bool prepareTempFolder();
+        void startNextDisc();
+        DataDoc* createDiscDoc( int disc );
+        void cleanup();
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -0,0 +1,946 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bdataspanningplanner.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bglobals.h"
+#include "k3bisooptions.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+#include <map>
+
+
+namespace {
+    const int s_sectorSize = 2048;
+
+    // a directory record never crosses a sector boundary, so up to a record
+    // minus one byte is wasted per sector
+    const int s_maxRecordLength = 255;
+
+    // system area, primary and Joliet volume descriptors, terminator, and
+    // the 150 sectors mkisofs pads the image with by default
+    const int s_fixedSectors = 16 + 3 + 150;
+
+    // anchors, volume descriptor sequences, integrity sequence and file set
+    // descriptor of the UDF bridge
+    const int s_udfFixedSectors = 280;
+
+    // the rounding of the four path tables and the continuation area
+    const int s_roundingSectors = 5;
+
+    // PX (RRIP 1.12), TF with three time stamps, and the NM header mkisofs
+    // adds to every directory record
+    const int s_rrRecordLength = 44 + 26 + 5;
+    const int s_rrDotRecordLength = 44 + 26;
+
+    // SP and the continuation entry holding the ER entry of the root folder
+    const int s_rrRootLength = 7 + 28;
+    const int s_rrRootContinuationLength = 237;
+
+    // CE entry pointing to the rest of a record longer than 255 bytes
+    const int s_rrContinuationLength = 28;
+
+    // the link target is not known without reading the link, this is
+    // enough for a SL entry with a typical path
+    const int s_rrSymlinkLength = 64;
+
+    // ISO9660 limits the size of a single extent, larger files get a
+    // record for each extent
+    const KIO::filesize_t s_maxExtentSize = 0xFFFFF800ULL;
+
+    // disc number, tab and newline of a catalog line, enough for 99999 discs
+    const int s_catalogLineLength = 7;
+
+    const int s_jolietNameLength = 64;
+    const int s_jolietLongNameLength = 103;
+
+    int padEven( int n )
+    {
+        return n + ( n & 1 );
+    }
+
+    qint64 blocksForBytes( qint64 bytes )
+    {
+        return ( bytes + s_sectorSize - 1 ) / s_sectorSize;
+    }
+
+    int extentsForBytes( KIO::filesize_t bytes )
+    {
+        return qMax( KIO::filesize_t( 1 ), ( bytes + s_maxExtentSize - 1 ) / s_maxExtentSize );
+    }
+
+    // the space taken by records in folders which are only partly on a disc
+    // with the worst case sector alignment
+    qint64 alignedRecordBytes( qint64 bytes )
+    {
+        return ( bytes * s_sectorSize + s_sectorSize - s_maxRecordLength - 1 ) / ( s_sectorSize - s_maxRecordLength );
+    }
+
+    /**
+     * Fills directory records into sectors like mkisofs does: a record
+     * which does not fit into the current sector starts a new one.
+     */
+    class ExtentPacker
+    {
+    public:
+        ExtentPacker()
+            : m_sectors( 1 ),
+              m_used( 0 ) {
+        }
+
+        void add( int length, int count = 1 ) {
+            for( int i = 0; i < count; ++i ) {
+                if( m_used + length > s_sectorSize ) {
+                    ++m_sectors;
+                    m_used = 0;
+                }
+                m_used += length;
+            }
+        }
+
+        qint64 sectors() const { return m_sectors; }
+
+    private:
+        qint64 m_sectors;
+        int m_used;
+    };
+
+    /**
+     * The records of one item in the folder of its parent.
+     */
+    struct Record {
+        int iso;
+        int joliet;
+        int udf;
+        int extents;
+        int continuation;
+        int nameBytes;
+
+        int bytes() const { return extents * ( iso + joliet ) + udf + continuation; }
+    };
+
+    struct DirStats {
+        // the contents of the files
+        qint64 dataBlocks;
+        // the extents of this folder and all subfolders and the UDF file
+        // entries of all items
+        qint64 dirBlocks;
+        // these are shared by all folders on a disc
+        qint64 continuationBytes;
+        qint64 isoPathTableBytes;
+        qint64 jolietPathTableBytes;
+        qint64 files;
+        // the length of the paths of all files relative to this folder
+        qint64 catalogBytes;
+    };
+
+    // the extents of a folder which is on a disc because of some of its children
+    struct PartialDir {
+        ExtentPacker iso;
+        ExtentPacker joliet;
+        qint64 udfBytes;
+    };
+
+    struct PlannedUnit {
+        K3b::DataSpanningPlanner::Unit unit;
+        const K3b::DirItem* parent;
+        Record record;
+        qint64 blocks;
+        // blocks plus the records with the worst case alignment, in bytes
+        qint64 cost;
+    };
+
+    struct Bin {
+        QVector<int> units;
+        QSet<const K3b::DirItem*> dirs;
+        qint64 used;
+        qint64 blocks;
+    };
+
+    class CostGreaterThan
+    {
+    public:
+        explicit CostGreaterThan( const QVector<PlannedUnit>& units ) : m_units( units ) {}
+        bool operator()( int a, int b ) const { return m_units[a].cost > m_units[b].cost; }
+
+    private:
+        const QVector<PlannedUnit>& m_units;
+    };
+}
+
+
+class K3b::DataSpanningPlanner::Private
+{
+public:
+    Private()
+        : capacity( MediaSizeBluRay25Gb ),
+          isoNameLength( 0 ),
+          isoVersion( false ),
+          jolietNameLength( 0 ),
+          joliet( false ),
+          rockRidge( false ),
+          udf( false ),
+          followSymlinks( false ),
+          binBytes( 0 ),
+          fixedBlocks( 0 ),
+          catalogBlocks( 0 ),
+          pieceCatalogBytes( 0 ),
+          failed( false ) {
+    }
+
+    DataDoc* doc;
+    Msf capacity;
+
+    // the options the cached numbers are based on
+    int isoNameLength;
+    bool isoVersion;
+    int jolietNameLength;
+    bool joliet;
+    bool rockRidge;
+    bool udf;
+    bool followSymlinks;
+
+    QHash<const DirItem*, DirStats> stats;
+    QHash<const DataItem*, KIO::filesize_t> pieceSizes;
+
+    // only used during plan()
+    QVector<PlannedUnit> units;
+    QHash<const DirItem*, qint64> ancestorCosts;
+    QString catalogName;
+    Record catalogRecord;
+    qint64 binBytes;
+    qint64 fixedBlocks;
+    qint64 catalogBlocks;
+    qint64 pieceCatalogBytes;
+    bool failed;
+
+    void updateOptions();
+    void invalidate( const DirItem* dir );
+    void purge( const DataItem* item );
+
+    bool isIncluded( const DataItem* item ) const;
+    Record record( const QString& name, bool dir, KIO::filesize_t size, bool symlink ) const;
+    Record record( const DataItem* item ) const;
+    void addDotRecords( const DirItem* dir, PartialDir& partial ) const;
+    int pathTableEntryIso( const DirItem* dir ) const;
+    int pathTableEntryJoliet( const DirItem* dir ) const;
+    DirStats dirStats( const DirItem* dir );
+
+    qint64 ancestorCost( const DirItem* dir ) const;
+    void collectUnits( DirItem* dir, qint64 chainCost );
+    void collectFileUnits( DataItem* file, const DirItem* parent, const Record& r, qint64 chainCost );
+    void addUnit( DataItem* item, const DirItem* parent, int piece, KIO::filesize_t offset, KIO::filesize_t length,
+                  const Record& r, qint64 blocks, qint64 extraBytes );
+
+    qint64 missingAncestorCost( const Bin& bin, const DirItem* dir ) const;
+    void pack( const QVector<int>& order, QList<Bin>& bins, int firstBin );
+    void addPartialRecord( QHash<const DirItem*, PartialDir>& partials, const DirItem* parent, const Record& r,
+                           qint64& continuationBytes, qint64& isoPathTableBytes, qint64& jolietPathTableBytes );
+    qint64 discBlocks( const QVector<int>& discUnits );
+
+    void appendCatalog( QByteArray& catalog, const QByteArray& number, const QByteArray& prefix, const DirItem* dir ) const;
+};
+
+
+void K3b::DataSpanningPlanner::Private::updateOptions()
+{
+    const IsoOptions& o = doc->isoOptions();
+
+    int isoLength = 12;
+    if( o.ISOmaxFilenameLength() )
+        isoLength = 37;
+    else if( o.ISOallow31charFilenames() || o.ISOLevel() > 1 )
+        isoLength = 31;
+
+    const int jolietLength = o.jolietLong() ? s_jolietLongNameLength : s_jolietNameLength;
+    const bool follow = o.followSymbolicLinks() || !o.createRockRidge();
+
+    if( isoLength != isoNameLength ||
+        o.ISOomitVersionNumbers() == isoVersion ||
+        jolietLength != jolietNameLength ||
+        o.createJoliet() != joliet ||
+        o.createRockRidge() != rockRidge ||
+        o.createUdf() != udf ||
+        follow != followSymlinks ) {
+        isoNameLength = isoLength;
+        isoVersion = !o.ISOomitVersionNumbers();
+        jolietNameLength = jolietLength;
+        joliet = o.createJoliet();
+        rockRidge = o.createRockRidge();
+        udf = o.createUdf();
+        followSymlinks = follow;
+        stats.clear();
+    }
+}
+
+
+void K3b::DataSpanningPlanner::Private::invalidate( const DirItem* dir )
+{
+    for( ; dir; dir = dir->parent() )
+        stats.remove( dir );
+}
+
+
+void K3b::DataSpanningPlanner::Private::purge( const DataItem* item )
+{
+    if( item->isDir() ) {
+        const DirItem* dir = static_cast<const DirItem*>( item );
+        stats.remove( dir );
+        Q_FOREACH( DataItem* child, dir->children() )
+            purge( child );
+    }
+}
+
+
+bool K3b::DataSpanningPlanner::Private::isIncluded( const DataItem* item ) const
+{
+    if( item->isDir() )
+        return true;
+    else
+        return( !item->isFromOldSession() &&
+                !item->isBootItem() &&
+                item != doc->bootCataloge() );
+}
+
+
+Record K3b::DataSpanningPlanner::Private::record( const QString& name, bool dir, KIO::filesize_t size, bool symlink ) const
+{
+    Record r;
+    const int nameLength = name.length();
+    r.nameBytes = name.toUtf8().length();
+    r.extents = dir ? 1 : extentsForBytes( size );
+    r.continuation = 0;
+
+    r.iso = padEven( 33 + qMin( nameLength, isoNameLength ) + ( !dir && isoVersion ? 2 : 0 ) );
+    if( rockRidge ) {
+        int rr = s_rrRecordLength + r.nameBytes;
+        if( symlink && !followSymlinks )
+            rr += s_rrSymlinkLength;
+        if( r.iso + rr > s_maxRecordLength ) {
+            r.iso += s_rrContinuationLength;
+            r.continuation = rr;
+        }
+        else {
+            r.iso = padEven( r.iso + rr );
+        }
+    }
+
+    // the file names get a version number in the Joliet tree, too
+    r.joliet = 0;
+    if( joliet )
+        r.joliet = padEven( 33 + 2*( qMin( nameLength, jolietNameLength ) + ( dir ? 0 : 2 ) ) );
+
+    // file identifier descriptor with 16 bit characters padded to 4 bytes
+    r.udf = 0;
+    if( udf )
+        r.udf = ( 38 + 1 + 2*nameLength + 3 ) & ~3;
+
+    return r;
+}
+
+
+Record K3b::DataSpanningPlanner::Private::record( const DataItem* item ) const
+{
+    return record( item->k3bName(), item->isDir(), item->isDir() ? 0 : item->size(), item->isSymLink() );
+}
+
+
+void K3b::DataSpanningPlanner::Private::addDotRecords( const DirItem* dir, PartialDir& partial ) const
+{
+    int rr = 0;
+    int rrRoot = 0;
+    if( rockRidge ) {
+        rr = s_rrDotRecordLength;
+        if( !dir->parent() )
+            rrRoot = s_rrRootLength;
+    }
+    partial.iso.add( padEven( 34 + rr + rrRoot ) );
+    partial.iso.add( 34 + rr );
+    if( joliet )
+        partial.joliet.add( 34, 2 );
+    partial.udfBytes = 40;
+}
+
+
+int K3b::DataSpanningPlanner::Private::pathTableEntryIso( const DirItem* dir ) const
+{
+    if( !dir->parent() )
+        return 10;
+    else
+        return 8 + padEven( qMin( dir->k3bName().length(), isoNameLength ) );
+}
+
+
+int K3b::DataSpanningPlanner::Private::pathTableEntryJoliet( const DirItem* dir ) const
+{
+    if( !joliet )
+        return 0;
+    else if( !dir->parent() )
+        return 10;
+    else
+        return 8 + 2*qMin( dir->k3bName().length(), jolietNameLength );
+}
+
+
+DirStats K3b::DataSpanningPlanner::Private::dirStats( const DirItem* dir )
+{
+    QHash<const DirItem*, DirStats>::const_iterator it = stats.constFind( dir );
+    if( it != stats.constEnd() )
+        return *it;
+
+    DirStats s;
+    s.dataBlocks = 0;
+    s.dirBlocks = 0;
+    s.continuationBytes = ( rockRidge && !dir->parent() ? s_rrRootContinuationLength : 0 );
+    s.isoPathTableBytes = pathTableEntryIso( dir );
+    s.jolietPathTableBytes = pathTableEntryJoliet( dir );
+    s.files = 0;
+    s.catalogBytes = 0;
+
+    PartialDir extents;
+    addDotRecords( dir, extents );
+
+    Q_FOREACH( DataItem* child, dir->children() ) {
+        if( !isIncluded( child ) )
+            continue;
+
+        const Record r = record( child );
+        extents.iso.add( r.iso, r.extents );
+        if( joliet )
+            extents.joliet.add( r.joliet, r.extents );
+        extents.udfBytes += r.udf;
+        s.continuationBytes += r.continuation;
+
+        if( child->isDir() ) {
+            const DirStats cs = dirStats( static_cast<DirItem*>( child ) );
+            s.dataBlocks += cs.dataBlocks;
+            s.dirBlocks += cs.dirBlocks;
+            s.continuationBytes += cs.continuationBytes;
+            s.isoPathTableBytes += cs.isoPathTableBytes;
+            s.jolietPathTableBytes += cs.jolietPathTableBytes;
+            s.files += cs.files;
+            s.catalogBytes += cs.catalogBytes + cs.files*( r.nameBytes + 1 );
+        }
+        else {
+            s.dataBlocks += child->blocks().lba();
+            ++s.files;
+            s.catalogBytes += r.nameBytes;
+            if( udf )
+                ++s.dirBlocks; // file entry
+        }
+    }
+
+    s.dirBlocks += extents.iso.sectors();
+    if( joliet )
+        s.dirBlocks += extents.joliet.sectors();
+    if( udf )
+        s.dirBlocks += 1 + blocksForBytes( extents.udfBytes );
+
+    stats.insert( dir, s );
+    return s;
+}
+
+
+qint64 K3b::DataSpanningPlanner::Private::ancestorCost( const DirItem* dir ) const
+{
+    // a folder only on the disc because of some of its children takes at
+    // least one sector in each tree plus its own records
+    qint64 blocks = 1;
+    if( joliet )
+        ++blocks;
+    if( udf )
+        blocks += 2;
+
+    qint64 bytes = 2*( pathTableEntryIso( dir ) + pathTableEntryJoliet( dir ) );
+    bytes += 2*34 + ( rockRidge ? 2*s_rrDotRecordLength : 0 );
+    if( joliet )
+        bytes += 2*34;
+    if( udf )
+        bytes += 40;
+
+    if( dir->parent() )
+        bytes += record( dir ).bytes();
+    else if( rockRidge )
+        bytes += s_rrRootLength + s_rrRootContinuationLength;
+
+    return blocks*s_sectorSize + alignedRecordBytes( bytes );
+}
+
+
+void K3b::DataSpanningPlanner::Private::collectUnits( DirItem* dir, qint64 chainCost )
+{
+    Q_FOREACH( DataItem* child, dir->children() ) {
+        if( failed )
+            return;
+        if( !isIncluded( child ) )
+            continue;
+
+        const Record r = record( child );
+        if( child->isDir() ) {
+            DirItem* childDir = static_cast<DirItem*>( child );
+            const DirStats s = dirStats( childDir );
+            const qint64 extraBytes = s.continuationBytes + 2*( s.isoPathTableBytes + s.jolietPathTableBytes );
+            const qint64 blocks = s.dataBlocks + s.dirBlocks;
+            if( blocks*s_sectorSize + alignedRecordBytes( r.bytes() + extraBytes ) + chainCost <= binBytes ) {
+                addUnit( child, dir, -1, 0, child->size(), r, blocks, extraBytes );
+            }
+            else {
+                // too big for one disc, the folder is created on each disc its children end up on
+                const qint64 cost = ancestorCost( childDir );
+                ancestorCosts.insert( childDir, cost );
+                collectUnits( childDir, chainCost + cost );
+            }
+        }
+        else {
+            collectFileUnits( child, dir, r, chainCost );
+        }
+    }
+}
+
+
+void K3b::DataSpanningPlanner::Private::collectFileUnits( DataItem* file, const DirItem* parent, const Record& r, qint64 chainCost )
+{
+    const qint64 entryBlocks = ( udf ? 1 : 0 );
+    const qint64 blocks = file->blocks().lba() + entryBlocks;
+    if( blocks*s_sectorSize + alignedRecordBytes( r.bytes() ) + chainCost <= binBytes ) {
+        addUnit( file, parent, -1, 0, file->size(), r, blocks, 0 );
+        return;
+    }
+
+    //
+    // Cut the file into pieces as big as a disc allows. The longest piece
+    // name and the number of extents of a full disc are used for the records
+    // so all pieces have the same size as FileSplitter requires.
+    //
+    const QString name = file->k3bName();
+    const KIO::filesize_t size = file->size();
+    Record maxRecord = record( pieceName( name, 999 ), false, 0, false );
+    maxRecord.extents = extentsForBytes( binBytes );
+    const qint64 available = binBytes - chainCost - entryBlocks*s_sectorSize - alignedRecordBytes( maxRecord.bytes() );
+    const KIO::filesize_t size2048 = ( available > 0 ? available / s_sectorSize * s_sectorSize : 0 );
+    if( size2048 == 0 ) {
+        qDebug() << "(K3b::DataSpanningPlanner) no space left for" << file->k3bPath();
+        failed = true;
+        return;
+    }
+
+    pieceSizes.insert( file, size2048 );
+
+    const int pathBytes = file->k3bPath().toUtf8().length();
+    int piece = 0;
+    for( KIO::filesize_t offset = 0; offset < size; offset += size2048, ++piece ) {
+        const KIO::filesize_t length = qMin( size2048, size - offset );
+        const QString partName = pieceName( name, piece );
+        const Record pr = record( partName, false, length, false );
+        addUnit( file, parent, piece, offset, length, pr, blocksForBytes( length ) + entryBlocks, 0 );
+
+        // the first piece replaces the file in the catalog
+        if( piece > 0 )
+            pieceCatalogBytes += s_catalogLineLength + pathBytes + pr.nameBytes - r.nameBytes;
+    }
+}
+
+
+void K3b::DataSpanningPlanner::Private::addUnit( DataItem* item, const DirItem* parent, int piece,
+                                                  KIO::filesize_t offset, KIO::filesize_t length,
+                                                  const Record& r, qint64 blocks, qint64 extraBytes )
+{
+    PlannedUnit u;
+    u.unit.item = item;
+    u.unit.piece = piece;
+    u.unit.offset = offset;
+    u.unit.length = length;
+    u.parent = parent;
+    u.record = r;
+    u.blocks = blocks;
+    u.cost = blocks*s_sectorSize + alignedRecordBytes( r.bytes() + extraBytes );
+    units.append( u );
+}
+
+
+qint64 K3b::DataSpanningPlanner::Private::missingAncestorCost( const Bin& bin, const DirItem* dir ) const
+{
+    qint64 cost = 0;
+    for( ; dir && !bin.dirs.contains( dir ); dir = dir->parent() )
+        cost += ancestorCosts.value( dir );
+    return cost;
+}
+
+
+void K3b::DataSpanningPlanner::Private::pack( const QVector<int>& order, QList<Bin>& bins, int firstBin )
+{
+    // best fit: the fullest disc with enough space left
+    std::multimap<qint64, int> freeBins;
+    for( int i = firstBin; i < bins.count(); ++i )
+        freeBins.insert( std::make_pair( binBytes - bins[i].used, i ) );
+
+    Q_FOREACH( int index, order ) {
+        const PlannedUnit& u = units[index];
+
+        qint64 extra = 0;
+        std::multimap<qint64, int>::iterator it = freeBins.lower_bound( u.cost );
+        for( ; it != freeBins.end(); ++it ) {
+            extra = missingAncestorCost( bins[it->second], u.parent );
+            if( it->first >= u.cost + extra )
+                break;
+        }
+
+        int binIndex = 0;
+        if( it == freeBins.end() ) {
+            Bin bin;
+            bin.used = 0;
+            bin.blocks = 0;
+            bins.append( bin );
+            binIndex = bins.count() - 1;
+            extra = missingAncestorCost( bins[binIndex], u.parent );
+        }
+        else {
+            binIndex = it->second;
+            freeBins.erase( it );
+        }
+
+        Bin& bin = bins[binIndex];
+        bin.used += u.cost + extra;
+        bin.units.append( index );
+        for( const DirItem* dir = u.parent; dir && !bin.dirs.contains( dir ); dir = dir->parent() )
+            bin.dirs.insert( dir );
+
+        freeBins.insert( std::make_pair( binBytes - bin.used, binIndex ) );
+    }
+}
+
+
+void K3b::DataSpanningPlanner::Private::addPartialRecord( QHash<const DirItem*, PartialDir>& partials,
+                                                           const DirItem* parent, const Record& r,
+                                                           qint64& continuationBytes,
+                                                           qint64& isoPathTableBytes,
+                                                           qint64& jolietPathTableBytes )
+{
+    QHash<const DirItem*, PartialDir>::iterator it = partials.find( parent );
+    if( it == partials.end() ) {
+        PartialDir partial;
+        addDotRecords( parent, partial );
+        isoPathTableBytes += pathTableEntryIso( parent );
+        jolietPathTableBytes += pathTableEntryJoliet( parent );
+        if( parent->parent() )
+            addPartialRecord( partials, parent->parent(), record( parent ),
+                              continuationBytes, isoPathTableBytes, jolietPathTableBytes );
+        else if( rockRidge )
+            continuationBytes += s_rrRootContinuationLength;
+        it = partials.insert( parent, partial );
+    }
+
+    it->iso.add( r.iso, r.extents );
+    if( joliet )
+        it->joliet.add( r.joliet, r.extents );
+    it->udfBytes += r.udf;
+    continuationBytes += r.continuation;
+}
+
+
+qint64 K3b::DataSpanningPlanner::Private::discBlocks( const QVector<int>& discUnits )
+{
+    qint64 blocks = fixedBlocks + catalogBlocks + ( udf ? 1 : 0 );
+    qint64 continuationBytes = 0;
+    qint64 isoPathTableBytes = 0;
+    qint64 jolietPathTableBytes = 0;
+    QHash<const DirItem*, PartialDir> partials;
+
+    addPartialRecord( partials, doc->root(), catalogRecord,
+                      continuationBytes, isoPathTableBytes, jolietPathTableBytes );
+
+    Q_FOREACH( int index, discUnits ) {
+        const PlannedUnit& u = units[index];
+        blocks += u.blocks;
+        if( u.unit.item->isDir() ) {
+            const DirStats s = dirStats( static_cast<const DirItem*>( u.unit.item ) );
+            continuationBytes += s.continuationBytes;
+            isoPathTableBytes += s.isoPathTableBytes;
+            jolietPathTableBytes += s.jolietPathTableBytes;
+        }
+        addPartialRecord( partials, u.parent, u.record,
+                          continuationBytes, isoPathTableBytes, jolietPathTableBytes );
+    }
+
+    for( QHash<const DirItem*, PartialDir>::const_iterator it = partials.constBegin();
+         it != partials.constEnd(); ++it ) {
+        blocks += it->iso.sectors();
+        if( joliet )
+            blocks += it->joliet.sectors();
+        if( udf )
+            blocks += 1 + blocksForBytes( it->udfBytes );
+    }
+
+    // both tables are written in little and big endian
+    blocks += 2*blocksForBytes( isoPathTableBytes ) + 2*blocksForBytes( jolietPathTableBytes );
+    blocks += blocksForBytes( continuationBytes );
+
+    return blocks;
+}
+
+
+void K3b::DataSpanningPlanner::Private::appendCatalog( QByteArray& catalog, const QByteArray& number,
+                                                        const QByteArray& prefix, const DirItem* dir ) const
+{
+    Q_FOREACH( DataItem* child, dir->children() ) {
+        if( !isIncluded( child ) )
+            continue;
+
+        const QByteArray path = prefix + child->k3bName().toUtf8();
+        if( child->isDir() ) {
+            appendCatalog( catalog, number, path + '/', static_cast<DirItem*>( child ) );
+        }
+        else {
+            catalog += number;
+            catalog += path;
+            catalog += '\n';
+        }
+    }
+}
+
+
+K3b::DataSpanningPlanner::DataSpanningPlanner( K3b::DataDoc* doc, QObject* parent )
+    : QObject( parent ),
+      d( new Private() )
+{
+    d->doc = doc;
+
+    connect( doc, SIGNAL(itemsInserted(K3b::DirItem*,int,int)),
+             this, SLOT(slotItemsInserted(K3b::DirItem*,int,int)) );
+    connect( doc, SIGNAL(itemsAboutToBeRemoved(K3b::DirItem*,int,int)),
+             this, SLOT(slotItemsAboutToBeRemoved(K3b::DirItem*,int,int)) );
+    connect( doc, SIGNAL(itemRenamed(K3b::DataItem*)),
+             this, SLOT(slotItemRenamed(K3b::DataItem*)) );
+}
+
+
+K3b::DataSpanningPlanner::~DataSpanningPlanner()
+{
+    delete d;
+}
+
+
+void K3b::DataSpanningPlanner::setCapacity( const K3b::Msf& blocks )
+{
+    d->capacity = blocks;
+}
+
+
+K3b::Msf K3b::DataSpanningPlanner::capacity() const
+{
+    return d->capacity;
+}
+
+
+QList<K3b::DataSpanningPlanner::Disc> K3b::DataSpanningPlanner::plan()
+{
+    QList<Disc> discs;
+
+    d->updateOptions();
+    d->pieceSizes.clear();
+
+    DirItem* root = d->doc->root();
+    const DirStats rootStats = d->dirStats( root );
+    if( root->children().isEmpty() )
+        return discs;
+
+    // do not clash with an item of the project, case does not matter on joliet
+    QSet<QString> rootNames;
+    Q_FOREACH( const DataItem* item, root->children() )
+        rootNames.insert( item->k3bName().toLower() );
+    d->catalogName = QLatin1String( "catalog.txt" );
+    for( int i = 1; rootNames.contains( d->catalogName ); ++i )
+        d->catalogName = QString( "catalog_%1.txt" ).arg( i );
+
+    d->fixedBlocks = s_fixedSectors + ( d->udf ? s_udfFixedSectors : 0 );
+    d->catalogRecord = d->record( d->catalogName, false, 0, false );
+    const qint64 catalogBytes = rootStats.catalogBytes + rootStats.files*s_catalogLineLength;
+
+    //
+    // The pieces of split files add lines to the catalog which in turn
+    // leaves less space for the pieces. A few rounds are enough to settle.
+    //
+    d->pieceCatalogBytes = 0;
+    do {
+        d->catalogBlocks = blocksForBytes( catalogBytes + d->pieceCatalogBytes );
+        d->binBytes = ( d->capacity.lba() - d->fixedBlocks - s_roundingSectors - d->catalogBlocks - ( d->udf ? 1 : 0 ) ) * s_sectorSize
+                      - alignedRecordBytes( d->catalogRecord.bytes() );
+
+        d->units.clear();
+        d->ancestorCosts.clear();
+        d->pieceSizes.clear();
+        d->pieceCatalogBytes = 0;
+        d->failed = false;
+
+        const qint64 rootCost = d->ancestorCost( root );
+        d->ancestorCosts.insert( root, rootCost );
+        if( rootCost >= d->binBytes )
+            d->failed = true;
+        else
+            d->collectUnits( root, rootCost );
+    } while( !d->failed && blocksForBytes( catalogBytes + d->pieceCatalogBytes ) > d->catalogBlocks );
+
+    if( d->failed ) {
+        qDebug() << "(K3b::DataSpanningPlanner) capacity of" << d->capacity.lba() << "blocks is too small.";
+        d->units.clear();
+        d->ancestorCosts.clear();
+        d->pieceSizes.clear();
+        return discs;
+    }
+
+    QVector<int> order( d->units.count() );
+    for( int i = 0; i < order.count(); ++i )
+        order[i] = i;
+    std::stable_sort( order.begin(), order.end(), CostGreaterThan( d->units ) );
+
+    QList<Bin> bins;
+    d->pack( order, bins, 0 );
+
+    //
+    // Check each disc with the folders it actually contains. Units which
+    // do not fit are moved to additional discs, starting with the smallest
+    // ones since they waste the least space elsewhere.
+    //
+    int firstUnchecked = 0;
+    while( firstUnchecked < bins.count() ) {
+        QVector<int> leftOver;
+        const int count = bins.count();
+        for( int i = firstUnchecked; i < count; ++i ) {
+            Bin& bin = bins[i];
+            qint64 blocks = d->discBlocks( bin.units );
+            while( blocks > d->capacity.lba() && bin.units.count() > 1 ) {
+                std::sort( bin.units.begin(), bin.units.end(), CostGreaterThan( d->units ) );
+                qint64 freed = 0;
+                while( bin.units.count() > 1 && freed < ( blocks - d->capacity.lba() )*s_sectorSize ) {
+                    freed += d->units[bin.units.last()].cost;
+                    leftOver.append( bin.units.takeLast() );
+                }
+                blocks = d->discBlocks( bin.units );
+            }
+
+            if( blocks > d->capacity.lba() ) {
+                qDebug() << "(K3b::DataSpanningPlanner)" << d->units[bin.units.first()].unit.item->k3bPath()
+                         << "does not fit on a disc.";
+                d->units.clear();
+                d->ancestorCosts.clear();
+                return discs;
+            }
+
+            bin.blocks = blocks;
+        }
+
+        firstUnchecked = count;
+        if( !leftOver.isEmpty() ) {
+            qDebug() << "(K3b::DataSpanningPlanner) moving" << leftOver.count() << "units to additional discs.";
+            std::stable_sort( leftOver.begin(), leftOver.end(), CostGreaterThan( d->units ) );
+            d->pack( leftOver, bins, count );
+        }
+    }
+
+    for( int i = 0; i < bins.count(); ++i ) {
+        // list the units in project order
+        QVector<int> unitIndexes = bins[i].units;
+        std::sort( unitIndexes.begin(), unitIndexes.end() );
+
+        Disc disc;
+        disc.blocks = bins[i].blocks;
+        Q_FOREACH( int index, unitIndexes )
+            disc.units.append( d->units[index].unit );
+        discs.append( disc );
+    }
+
+    qDebug() << "(K3b::DataSpanningPlanner)" << d->units.count() << "units on" << discs.count() << "discs.";
+
+    d->units.clear();
+    d->ancestorCosts.clear();
+
+    return discs;
+}
+
+
+KIO::filesize_t K3b::DataSpanningPlanner::pieceSize( const K3b::DataItem* item ) const
+{
+    return d->pieceSizes.value( item );
+}
+
+
+QByteArray K3b::DataSpanningPlanner::catalog( const QList<Disc>& discs ) const
+{
+    QByteArray catalog;
+    for( int i = 0; i < discs.count(); ++i ) {
+        const QByteArray number = QByteArray::number( i+1 ) + '\t';
+        Q_FOREACH( const Unit& unit, discs[i].units ) {
+            if( unit.item->isDir() ) {
+                d->appendCatalog( catalog, number, unit.item->k3bPath().toUtf8(), static_cast<DirItem*>( unit.item ) );
+            }
+            else {
+                catalog += number;
+                catalog += ( unit.piece < 0 ? unit.item->k3bPath() : pieceName( unit.item->k3bPath(), unit.piece ) ).toUtf8();
+                catalog += '\n';
+            }
+        }
+    }
+    return catalog;
+}
+
+
+QString K3b::DataSpanningPlanner::catalogName() const
+{
+    return d->catalogName;
+}
+
+
+QString K3b::DataSpanningPlanner::pieceName( const QString& name, int piece )
+{
+    // the same as FileSplitter
+    if( piece > 0 )
+        return name + '.' + QString::number( piece ).rightJustified( 3, '0' );
+    else
+        return name;
+}
+
+
+void K3b::DataSpanningPlanner::slotItemsInserted( K3b::DirItem* parent, int, int )
+{
+    d->invalidate( parent );
+}
+
+
+void K3b::DataSpanningPlanner::slotItemsAboutToBeRemoved( K3b::DirItem* parent, int start, int end )
+{
+    // the items are deleted afterwards, their addresses may be reused
+    for( int i = start; i <= end; ++i )
+        d->purge( parent->children().at( i ) );
+    d->invalidate( parent );
+}
+
+
+void K3b::DataSpanningPlanner::slotItemRenamed( K3b::DataItem* item )
+{
+    // a folder's own name is part of its path table entry
+    if( item->isDir() )
+        d->invalidate( static_cast<DirItem*>( item ) );
+    else
+        d->invalidate( item->parent() );
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_DATA_SPANNING_PLANNER_H_
+#define _K3B_DATA_SPANNING_PLANNER_H_
+
+#include "k3bmsf.h"
+#include "k3b_export.h"
+
+#include <KIO/Global>
+
+#include <QList>
+#include <QObject>
+
+
+namespace K3b {
+    class DataDoc;
+    class DataItem;
+    class DirItem;
+
+    /**
+     * Splits a data project which does not fit on one medium into
+     * several discs.
+     *
+     * The project tree is cut into units: a folder becomes a unit if its
+     * whole subtree fits on one disc, otherwise its children are
+     * considered one by one. Files larger than a disc are cut into pieces
+     * named like FileSplitter names its parts: the first piece keeps the
+     * name of the file, the others get the suffixes .001, .002, etc. The
+     * units are distributed with a best-fit-decreasing bin packing. Each disc
+     * gets the parent folders of its units so paths stay the same on all
+     * discs.
+     *
+     * The size of a disc includes an estimate of the file system created
+     * by mkisofs: the ISO9660, Joliet and UDF directory records with their
+     * sector alignment, the Rock Ridge extensions, the path tables, and the
+     * volume descriptors. Afterwards each disc is checked with the sizes of
+     * the folders it really contains and units are moved to other discs if
+     * the estimate was too low.
+     *
+     * Every disc also gets a catalog listing the disc number of each file,
+     * see catalog(). Its space is reserved before packing.
+     *
+     * The per folder numbers are cached and only the folders on the path of a
+     * change are recalculated, so planning a large project again after adding
+     * or removing some items is fast.
+     *
+     * Items of an imported session and boot images are not part of the plan.
+     */
+    class LIBK3B_EXPORT DataSpanningPlanner : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit DataSpanningPlanner( DataDoc* doc, QObject* parent = 0 );
+        ~DataSpanningPlanner() override;
+
+        /**
+         * A part of the project stored on a single disc.
+         */
+        struct Unit {
+            /**
+             * The file or folder including all its children.
+             */
+            DataItem* item;
+
+            /**
+             * The number of the piece for files which are split, -1 if the
+             * whole item is stored.
+             */
+            int piece;
+
+            /**
+             * Position and size of the piece in the file.
+             */
+            KIO::filesize_t offset;
+            KIO::filesize_t length;
+        };
+
+        struct Disc {
+            QList<Unit> units;
+
+            /**
+             * The estimated size of the image including the file system
+             * and the catalog.
+             */
+            Msf blocks;
+        };
+
+        /**
+         * The usable size of one disc. Defaults to a single layer BD.
+         */
+        void setCapacity( const Msf& blocks );
+        Msf capacity() const;
+
+        /**
+         * Distributes the project over the discs. The returned units point
+         * to the items of the project and are only valid as long as the
+         * project is not changed.
+         *
+         * \return an empty list if the project is empty or the capacity is
+         *         too small to hold the file system of a single folder.
+         */
+        QList<Disc> plan();
+
+        /**
+         * The size of the pieces \p item is cut into. Only valid for files
+         * split by the last plan(). All pieces except the last have this size.
+         */
+        KIO::filesize_t pieceSize( const DataItem* item ) const;
+
+        /**
+         * The catalog stored on every disc. One line per file with the disc
+         * number (starting at 1), a tab and the path of the file in the project.
+         * Pieces of split files are listed with their names.
+         */
+        QByteArray catalog( const QList<Disc>& discs ) const;
+
+        /**
+         * The name of the catalog in the root folder of every disc. This is
+         * catalog.txt unless the root folder of the project already contains
+         * an item of that name. Only valid after plan().
+         */
+        QString catalogName() const;
+
+        /**
+         * The name of piece \p piece of \p name, following the naming used by FileSplitter.
+         */
+        static QString pieceName( const QString& name, int piece );
+
+    private Q_SLOTS:
+        void slotItemsInserted( K3b::DirItem* parent, int start, int end );
+        void slotItemsAboutToBeRemoved( K3b::DirItem* parent, int start, int end );
+        void slotItemRenamed( K3b::DataItem* item );
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -0,0 +1,581 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bdatasyncjob.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bimportedsession.h"
+#include "k3bisooptions.h"
+#include "k3biso9660.h"
+#include "k3b_i18n.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QUrl>
+
+#include <limits.h>
+#include <unistd.h>
+
+
+namespace {
+    // bump when changing the format of the hash cache
+    const qint32 s_hashCacheVersion = 2;
+
+    enum ChangeType {
+        CHANGE_NEW,
+        CHANGE_MODIFIED,
+        CHANGE_REMOVED
+    };
+
+    struct Change {
+        ChangeType type;
+        QString localPath;
+        // the folder new and modified files are added to or the path of a removed item
+        QString projectPath;
+    };
+
+    // an entry of the old session, copied while holding the session lock
+    struct OldEntry {
+        const K3b::Iso9660Entry* entry;
+        bool isDir;
+        QString symlink;
+        KIO::filesize_t size;
+        qint64 date;
+    };
+
+    // a file which only differs in its modification time
+    struct Candidate {
+        QString localPath;
+        QString localKey;
+        const K3b::Iso9660File* oldFile;
+        QString oldKey;
+        QString projectPath;
+    };
+
+    QString readLink( const QString& path )
+    {
+        char buf[PATH_MAX];
+        const ssize_t len = ::readlink( QFile::encodeName( path ).constData(), buf, sizeof(buf) );
+        if( len > 0 )
+            return QFile::decodeName( QByteArray( buf, len ) );
+        else
+            return QString();
+    }
+
+    QString hashCacheFile()
+    {
+        return QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation ) + "/k3b/synchashes";
+    }
+}
+
+
+class K3b::DataSyncJob::Private
+{
+public:
+    class HashTask : public QRunnable
+    {
+    public:
+        HashTask( Private* d, const QString& path, const QString& key )
+            : m_d( d ),
+              m_path( path ),
+              m_key( key ) {
+        }
+
+        void run() override {
+            QFile f( m_path );
+            QCryptographicHash md5( QCryptographicHash::Md5 );
+            if( f.open( QIODevice::ReadOnly ) && md5.addData( &f ) )
+                m_d->cacheHash( m_key, md5.result().toHex() );
+        }
+
+    private:
+        Private* m_d;
+        QString m_path;
+        QString m_key;
+    };
+
+    Private( DataSyncJob* job, DataDoc* d )
+        : q( job ),
+          doc( d ),
+          compareContents( false ),
+          followLinks( false ),
+          addHiddenFiles( true ),
+          session( 0 ),
+          newFiles( 0 ),
+          modifiedFiles( 0 ),
+          removedFiles( 0 ),
+          unchangedFiles( 0 ) {
+    }
+
+    void addChange( ChangeType type, const QString& localPath, const QString& projectPath ) {
+        Change change;
+        change.type = type;
+        change.localPath = localPath;
+        change.projectPath = projectPath;
+        changes.append( change );
+
+        if( type == CHANGE_NEW )
+            ++newFiles;
+        else if( type == CHANGE_MODIFIED )
+            ++modifiedFiles;
+        else
+            ++removedFiles;
+    }
+
+    QByteArray cachedHash( const QString& key ) {
+        QMutexLocker locker( &hashMutex );
+        QHash<QString, QByteArray>::const_iterator it = hashes.constFind( key );
+        if( it != hashes.constEnd() )
+            return it.value();
+
+        // only the sums used in this run are saved again
+        const QByteArray hash = cache.take( key );
+        if( !hash.isEmpty() )
+            hashes.insert( key, hash );
+        return hash;
+    }
+
+    void cacheHash( const QString& key, const QByteArray& hash ) {
+        QMutexLocker locker( &hashMutex );
+        hashes.insert( key, hash );
+    }
+
+    void loadHashes() {
+        QFile f( hashCacheFile() );
+        if( f.open( QIODevice::ReadOnly ) ) {
+            QDataStream s( &f );
+            qint32 version = 0;
+            s >> version;
+            if( version == s_hashCacheVersion )
+                s >> cache;
+        }
+    }
+
+    void saveHashes() {
+        QDir().mkpath( QFileInfo( hashCacheFile() ).path() );
+        QFile f( hashCacheFile() );
+        if( f.open( QIODevice::WriteOnly ) ) {
+            // without a session id the hashes of the old files are only valid for this run
+            QHash<QString, QByteArray> saved = hashes;
+            if( sessionId.isEmpty() ) {
+                for( QHash<QString, QByteArray>::iterator it = saved.begin(); it != saved.end(); ) {
+                    if( it.key().startsWith( "iso:" ) )
+                        it = saved.erase( it );
+                    else
+                        ++it;
+                }
+            }
+
+            QDataStream s( &f );
+            s << s_hashCacheVersion << saved;
+        }
+    }
+
+    QString localKey( const QFileInfo& info ) const {
+        return QString( "file:%1:%2:%3" )
+            .arg( info.absoluteFilePath() )
+            .arg( info.size() )
+            .arg( info.lastModified().toMSecsSinceEpoch() );
+    }
+
+    QString oldKey( const Iso9660File* file ) const {
+        // the position of a file in a session does not change
+        return QString( "iso:%1:%2:%3" )
+            .arg( sessionId )
+            .arg( file->startSector() )
+            .arg( file->size() );
+    }
+
+    bool compareFolder( const QString& localPath, const Iso9660Directory* oldDir, const QString& projectPath );
+    bool resolveCandidates();
+
+    DataSyncJob* q;
+    DataDoc* doc;
+
+    QString localFolder;
+    QString projectFolder;
+    bool compareContents;
+    bool followLinks;
+    bool addHiddenFiles;
+
+    ImportedSession* session;
+
+    // identifies the old session on rewritten media which keep the volume id
+    QString sessionId;
+
+    QList<Change> changes;
+    QList<Candidate> candidates;
+    int newFiles;
+    int modifiedFiles;
+    int removedFiles;
+    int unchangedFiles;
+
+    QMutex hashMutex;
+    QHash<QString, QByteArray> cache;
+    QHash<QString, QByteArray> hashes;
+};
+
+
+bool K3b::DataSyncJob::Private::compareFolder( const QString& localPath, const Iso9660Directory* oldDir, const QString& projectPath )
+{
+    QHash<QString, OldEntry> oldEntries;
+    if( oldDir ) {
+        // reading the folder may need the drive, the lock is not held while comparing
+        QMutexLocker locker( session->mutex() );
+        Q_FOREACH( const QString& name, oldDir->entries() ) {
+            if( name == "." || name == ".." )
+                continue;
+            if( const Iso9660Entry* entry = oldDir->entry( name ) ) {
+                OldEntry old;
+                old.entry = entry;
+                old.isDir = entry->isDirectory();
+                old.symlink = entry->symlink();
+                old.size = entry->isFile() ? static_cast<const Iso9660File*>( entry )->dataSize() : 0;
+                old.date = entry->date();
+                oldEntries.insert( name, old );
+            }
+        }
+    }
+
+    QDir::Filters filters = QDir::AllEntries|QDir::System|QDir::NoDotAndDotDot;
+    if( addHiddenFiles )
+        filters |= QDir::Hidden;
+
+    Q_FOREACH( const QFileInfo& info, QDir( localPath ).entryInfoList( filters, QDir::Name ) ) {
+        if( q->canceled() )
+            return false;
+
+        const QString name = info.fileName();
+        QHash<QString, OldEntry>::iterator it = oldEntries.find( name );
+        if( it == oldEntries.end() ) {
+            addChange( CHANGE_NEW, info.filePath(), projectPath );
+            continue;
+        }
+
+        const OldEntry old = it.value();
+        oldEntries.erase( it );
+
+        const bool isDir = info.isDir() && !info.isSymLink();
+        if( isDir && old.isDir ) {
+            if( !compareFolder( info.filePath(), static_cast<const Iso9660Directory*>( old.entry ), projectPath + name + '/' ) )
+                return false;
+        }
+        else if( isDir || old.isDir ) {
+            // a folder replaced a file or the other way round
+            addChange( CHANGE_REMOVED, QString(), projectPath + name + ( old.isDir ? "/" : "" ) );
+            addChange( CHANGE_NEW, info.filePath(), projectPath );
+        }
+        else if( info.isSymLink() && !followLinks ) {
+            if( old.symlink.isEmpty() || old.symlink != readLink( info.filePath() ) )
+                addChange( CHANGE_MODIFIED, info.filePath(), projectPath );
+            else
+                ++unchangedFiles;
+        }
+        else if( KIO::filesize_t( info.size() ) == old.size &&
+                 info.lastModified().toMSecsSinceEpoch()/1000 == old.date ) {
+            ++unchangedFiles;
+        }
+        else if( compareContents && KIO::filesize_t( info.size() ) == old.size && old.symlink.isEmpty() ) {
+            Candidate c;
+            c.localPath = info.filePath();
+            c.localKey = localKey( info );
+            c.oldFile = static_cast<const Iso9660File*>( old.entry );
+            c.oldKey = oldKey( c.oldFile );
+            c.projectPath = projectPath;
+            candidates.append( c );
+        }
+        else {
+            addChange( CHANGE_MODIFIED, info.filePath(), projectPath );
+        }
+    }
+
+    // whatever is left has been removed locally
+    for( QHash<QString, OldEntry>::const_iterator it = oldEntries.constBegin(); it != oldEntries.constEnd(); ++it )
+        addChange( CHANGE_REMOVED, QString(), projectPath + it.key() + ( it.value().isDir ? "/" : "" ) );
+
+    return true;
+}
+
+
+bool K3b::DataSyncJob::Private::resolveCandidates()
+{
+    if( candidates.isEmpty() )
+        return true;
+
+    emit q->newSubTask( i18n("Comparing file contents") );
+
+    // the local files are hashed in parallel while the drive reads one file at a time
+    QThreadPool pool;
+    Q_FOREACH( const Candidate& c, candidates ) {
+        if( cachedHash( c.localKey ).isEmpty() )
+            pool.start( new HashTask( this, c.localPath, c.localKey ) );
+    }
+
+    QByteArray buffer( K3b::Iso9660File::ReadBufferSize, Qt::Uninitialized );
+    for( int i = 0; i < candidates.count(); ++i ) {
+        const Candidate& c = candidates[i];
+        if( cachedHash( c.oldKey ).isEmpty() ) {
+            QCryptographicHash md5( QCryptographicHash::Md5 );
+            unsigned int pos = 0;
+            while( pos < c.oldFile->dataSize() ) {
+                if( q->canceled() ) {
+                    pool.clear();
+                    pool.waitForDone();
+                    return false;
+                }
+
+                int read = 0;
+                {
+                    QMutexLocker locker( session->mutex() );
+                    read = c.oldFile->read( pos, buffer.data(), buffer.size() );
+                }
+                if( read <= 0 )
+                    break;
+
+                md5.addData( buffer.constData(), read );
+                pos += read;
+            }
+
+            // a file which cannot be read is written again
+            if( pos >= c.oldFile->dataSize() )
+                cacheHash( c.oldKey, md5.result().toHex() );
+        }
+
+        emit q->subPercent( 100*(i+1)/candidates.count() );
+    }
+
+    pool.waitForDone();
+
+    Q_FOREACH( const Candidate& c, candidates ) {
+        const QByteArray localHash = cachedHash( c.localKey );
+        if( localHash.isEmpty() || localHash != cachedHash( c.oldKey ) )
+            addChange( CHANGE_MODIFIED, c.localPath, c.projectPath );
+        else
+            ++unchangedFiles;
+    }
+
+    return true;
+}
+
+
+K3b::DataSyncJob::DataSyncJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent )
+    : K3b::ThreadJob( hdl, parent ),
+      d( new Private( this, doc ) )
+{
+    // connected first so the project is up to date when others are informed
+    connect( this, SIGNAL(finished(bool)), this, SLOT(slotFinished(bool)) );
+}
+
+
+K3b::DataSyncJob::~DataSyncJob()
+{
+    delete d;
+}
+
+
+QString K3b::DataSyncJob::jobDescription() const
+{
+    return i18n("Synchronizing Folder");
+}
+
+
+QString K3b::DataSyncJob::jobDetails() const
+{
+    return d->localFolder;
+}
+
+
+int K3b::DataSyncJob::newFiles() const
+{
+    return d->newFiles;
+}
+
+
+int K3b::DataSyncJob::modifiedFiles() const
+{
+    return d->modifiedFiles;
+}
+
+
+int K3b::DataSyncJob::removedFiles() const
+{
+    return d->removedFiles;
+}
+
+
+void K3b::DataSyncJob::setLocalFolder( const QString& path )
+{
+    d->localFolder = path;
+}
+
+
+void K3b::DataSyncJob::setProjectFolder( const QString& path )
+{
+    // relative to the root without a leading but with a trailing slash like DataItem::k3bPath()
+    d->projectFolder = path;
+    while( d->projectFolder.startsWith( '/' ) )
+        d->projectFolder.remove( 0, 1 );
+    if( !d->projectFolder.isEmpty() && !d->projectFolder.endsWith( '/' ) )
+        d->projectFolder += '/';
+}
+
+
+void K3b::DataSyncJob::setCompareContents( bool b )
+{
+    d->compareContents = b;
+}
+
+
+void K3b::DataSyncJob::start()
+{
+    d->session = d->doc->sessionImport();
+    d->followLinks = d->doc->isoOptions().followSymbolicLinks();
+
+    // the same files as when adding the folder to the project
+    KConfigGroup grp( KSharedConfig::openConfig(), "default data settings" );
+    d->addHiddenFiles = !grp.readEntry( "discard hidden file", false );
+
+    d->changes.clear();
+    d->candidates.clear();
+    d->newFiles = d->modifiedFiles = d->removedFiles = d->unchangedFiles = 0;
+
+    K3b::ThreadJob::start();
+}
+
+
+bool K3b::DataSyncJob::run()
+{
+    emit newTask( i18n("Comparing %1 with the imported session", d->localFolder) );
+
+    if( !d->session ) {
+        emit infoMessage( i18n("No session has been imported."), MessageError );
+        return false;
+    }
+
+    if( !QFileInfo( d->localFolder ).isDir() ) {
+        emit infoMessage( i18n("Could not find folder %1.", d->localFolder), MessageError );
+        return false;
+    }
+
+    //
+    // Find the folder in the old session. If it does not exist everything is new.
+    //
+    const K3b::Iso9660Directory* oldDir = d->session->rootDir();
+    {
+        QMutexLocker locker( d->session->mutex() );
+
+        // unread folders and the file contents come from the medium
+        if( ( d->compareContents || !d->session->isComplete() ) &&
+            !d->session->checkMedium() ) {
+            emit infoMessage( i18n("The medium the session was imported from is no longer in the drive."), MessageError );
+            return false;
+        }
+
+        const K3b::Iso9660SimplePrimaryDescriptor& desc = d->session->iso().primaryDescriptor();
+        if( desc.creationDate.count( '0' ) < desc.creationDate.length() )
+            d->sessionId = QString( "%1/%2/%3" )
+                           .arg( desc.volumeId )
+                           .arg( desc.creationDate )
+                           .arg( d->session->startSector() );
+        Q_FOREACH( const QString& name, d->projectFolder.split( '/', QString::SkipEmptyParts ) ) {
+            const K3b::Iso9660Entry* entry = oldDir->entry( name );
+            if( !entry || !entry->isDirectory() ) {
+                oldDir = 0;
+                break;
+            }
+            oldDir = static_cast<const K3b::Iso9660Directory*>( entry );
+        }
+    }
+
+    if( d->compareContents )
+        d->loadHashes();
+
+    const bool success = ( d->compareFolder( d->localFolder, oldDir, d->projectFolder ) &&
+                           d->resolveCandidates() );
+    d->session->releaseDevice();
+    if( !success )
+        return false;
+
+    if( d->compareContents )
+        d->saveHashes();
+
+    qDebug() << "(K3b::DataSyncJob)" << d->newFiles << "new," << d->modifiedFiles << "modified,"
+             << d->removedFiles << "removed," << d->unchangedFiles << "unchanged.";
+
+    emit infoMessage( i18n("Found %1 new, %2 modified and %3 removed files. %4 files are unchanged.",
+                           d->newFiles, d->modifiedFiles, d->removedFiles, d->unchangedFiles ), MessageInfo );
+    if( d->newFiles == 0 && d->modifiedFiles == 0 && d->removedFiles > 0 )
+        emit infoMessage( i18n("Only removed files were found. The new session will contain no files "
+                               "and just hide them on the medium."), MessageInfo );
+
+    return true;
+}
+
+
+void K3b::DataSyncJob::slotFinished( bool success )
+{
+    if( !success )
+        return;
+
+    K3b::DirItem* root = d->doc->root();
+
+    // remove first so the new items do not get renamed
+    Q_FOREACH( const Change& change, d->changes ) {
+        if( change.type == CHANGE_REMOVED ) {
+            // only hide items which are not part of the new session anyway
+            K3b::DataItem* item = root->findByPath( change.projectPath );
+            if( item && !item->writeToCd() )
+                d->doc->hideOldSessionItem( item );
+        }
+    }
+
+    QMap<QString, QList<QUrl> > urls;
+    Q_FOREACH( const Change& change, d->changes ) {
+        if( change.type != CHANGE_REMOVED )
+            urls[change.projectPath].append( QUrl::fromLocalFile( change.localPath ) );
+    }
+
+    for( QMap<QString, QList<QUrl> >::const_iterator it = urls.constBegin(); it != urls.constEnd(); ++it ) {
+        K3b::DirItem* dir = root;
+        if( !it.key().isEmpty() ) {
+            const QString path = it.key().left( it.key().length()-1 );
+            root->mkdir( path );
+            K3b::DataItem* item = root->findByPath( path );
+            dir = ( item && item->isDir() ? static_cast<K3b::DirItem*>( item ) : 0 );
+        }
+
+        if( dir )
+            d->doc->addUrlsToDir( it.value(), dir );
+        else
+            qDebug() << "(K3b::DataSyncJob) could not create folder" << it.key();
+    }
+}
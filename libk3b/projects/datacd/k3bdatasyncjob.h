@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_DATA_SYNC_JOB_H_
+#define _K3B_DATA_SYNC_JOB_H_
+
+#include "k3bthreadjob.h"
+#include "k3b_export.h"
+
+
+namespace K3b {
+    class DataDoc;
+
+    /**
+     * Brings the session imported into a data project up to date with
+     * a local folder so the new session only contains the changes.
+     *
+     * The local folder is compared to a folder of the imported session by
+     * size and modification time. Optionally files which only differ in
+     * their modification time are compared by their MD5 sums. Local files
+     * are hashed in parallel while the old files are read from the medium
+     * and all sums are cached between runs.
+     *
+     * Once the job finished successfully new and modified files have been
+     * added to the project. Unchanged files stay referenced from the old
+     * session and files which no longer exist locally are hidden, see
+     * DataDoc::hideOldSessionItem().
+     *
+     * A session has to be imported before starting the job.
+     */
+    class LIBK3B_EXPORT DataSyncJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        DataSyncJob( DataDoc* doc, JobHandler* hdl, QObject* parent = 0 );
+        ~DataSyncJob() override;
+
+        QString jobDescription() const override;
+        QString jobDetails() const override;
+
+        int newFiles() const;
+        int modifiedFiles() const;
+        int removedFiles() const;
+
+    public Q_SLOTS:
+        void start() override;
+
+        /**
+         * The local folder to synchronize.
+         */
+        void setLocalFolder( const QString& path );
+
+        /**
+         * The folder in the project, i.e. in the old session, which corresponds
+         * to the local folder. Defaults to the root folder.
+         */
+        void setProjectFolder( const QString& path );
+
+        /**
+         * Compare files with the same size but a different modification time
+         * by their contents. Defaults to false.
+         */
+        void setCompareContents( bool b );
+
+    private Q_SLOTS:
+        void slotFinished( bool success );
+
+    private:
+        bool run() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
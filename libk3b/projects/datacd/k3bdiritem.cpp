@@ -88,6 +88,8 @@ K3b::DirItem* K3b::DirItem::getDirItem() const
 
 K3b::DirItem* K3b::DirItem::addDataItem( K3b::DataItem* item )
 {
+    expandImportedSession();
+
     if( canAddDataItem( item ) ) {
 
         // Detach item from its parent in case it's moved from elsewhere.
@@ -114,6 +116,8 @@ K3b::DirItem* K3b::DirItem::addDataItem( K3b::DataItem* item )
 
 void K3b::DirItem::addDataItems( const Children& items )
 {
+    expandImportedSession();
+
     Children newItems;
     newItems.reserve( items.size() );
     Q_FOREACH( DataItem* item, items ) {
@@ -251,6 +255,9 @@ bool K3b::DirItem::alreadyInDirectory( const QString& filename ) const
 
 K3b::DataItem* K3b::DirItem::find( const QString& filename ) const
 {
+    // name collisions with items from an old session have to be detected
+    expandImportedSession();
+
     if (m_children.isEmpty()) return 0;
     Q_FOREACH( K3b::DataItem* item, m_children ) {
         if( item->k3bName() == filename )
@@ -409,6 +416,13 @@ void K3b::DirItem::updateFiles( long files, long dirs )
 }
 
 
+void K3b::DirItem::expandImportedSession() const
+{
+    if( DataDoc* doc = getDoc() )
+        doc->expandImportedDir( const_cast<K3b::DirItem*>( this ) );
+}
+
+
 void K3b::DirItem::updateOldSessionFlag()
 {
     if( flags().testFlag( OLD_SESSION ) ) {
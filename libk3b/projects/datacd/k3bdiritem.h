@@ -124,6 +124,12 @@ namespace K3b {
          */
         void updateOldSessionFlag();
 
+        /**
+         * Reads the contents of this dir if it was imported from an old session
+         * and has not been expanded yet.
+         */
+        void expandImportedSession() const;
+
         bool canAddDataItem( DataItem* item ) const;
         void addDataItemImpl( DataItem* item );
 
@@ -18,12 +18,12 @@
 #include "k3bdiritem.h"
 #include "k3bglobals.h"
 #include "k3bisooptions.h"
+#include "k3bmimetyperesolver.h"
 #include <config-kylinburner.h>
 
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
-#include <QMimeDatabase>
 #include <QRegExp>
 #include <QString>
 #include <QStringList>
@@ -58,7 +58,7 @@ bool K3b::operator>( const K3b::FileItem::Id& id1, const K3b::FileItem::Id& id2
 K3b::FileItem::FileItem( const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
       m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_linkTarget(0)
 {
     k3b_struct_stat statBuf;
     k3b_struct_stat followedStatBuf;
@@ -89,7 +89,7 @@ K3b::FileItem::FileItem( const QString& filePath, K3b::DataDoc& doc, const QStri
 K3b::FileItem::FileItem( const QString& filePath, K3b::DataDoc& doc, bool removable, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
       m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_linkTarget(0)
 {
     setDeleteable(removable);
     k3b_struct_stat statBuf;
@@ -123,7 +123,7 @@ K3b::FileItem::FileItem( const k3b_struct_stat* stat,
                           const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
       m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_linkTarget(0)
 {
     init( filePath, k3bName, doc, stat, followedStat );
 }
@@ -133,10 +133,10 @@ K3b::FileItem::FileItem( const K3b::FileItem& item )
     : K3b::DataItem( item ),
       m_replacedItemFromOldSession(0),
       m_size( item.m_size ),
-      m_sizeFollowed( item.m_sizeFollowed ),
       m_id( item.m_id ),
-      m_idFollowed( item.m_idFollowed ),
-      m_localPath( item.m_localPath ),
+      m_linkTarget( item.m_linkTarget ? new LinkTarget( *item.m_linkTarget ) : 0 ),
+      m_localDir( item.m_localDir ),
+      m_localName( item.m_localName ),
       m_mimeType( item.m_mimeType )
 {
 }
@@ -146,6 +146,7 @@ K3b::FileItem::~FileItem()
 {
     // remove this from parentdir
     take();
+    delete m_linkTarget;
 }
 
 
@@ -157,14 +158,27 @@ K3b::DataItem* K3b::FileItem::copy() const
 
 QMimeType K3b::FileItem::mimeType() const
 {
-    return m_mimeType;
+    if( m_mimeType.isValid() )
+        return m_mimeType;
+
+    K3b::MimeTypeResolver* resolver = K3b::MimeTypeResolver::instance();
+    const QMimeType type = resolver->typeForContent( localPath() );
+    return type.isValid() ? type : resolver->defaultType();
+}
+
+
+bool K3b::FileItem::updateMimeType()
+{
+    if( !m_mimeType.isValid() )
+        m_mimeType = K3b::MimeTypeResolver::instance()->typeForContent( localPath() );
+    return m_mimeType.isValid();
 }
 
 
 KIO::filesize_t K3b::FileItem::itemSize( bool followSymlinks ) const
 {
-    if( followSymlinks )
-        return m_sizeFollowed;
+    if( followSymlinks && m_linkTarget )
+        return m_linkTarget->size;
     else
         return m_size;
 }
@@ -181,8 +195,8 @@ K3b::FileItem::Id K3b::FileItem::localId() const
 
 K3b::FileItem::Id K3b::FileItem::localId( bool followSymlinks ) const
 {
-    if( followSymlinks )
-        return m_idFollowed;
+    if( followSymlinks && m_linkTarget )
+        return m_linkTarget->id;
     else
         return m_id;
 }
@@ -202,7 +216,7 @@ QString K3b::FileItem::absIsoPath()
 
 QString K3b::FileItem::localPath() const
 {
-    return m_localPath;
+    return m_localDir + m_localName;
 }
 
 
@@ -285,8 +299,12 @@ void K3b::FileItem::init( const QString& filePath,
                           const k3b_struct_stat* stat,
                           const k3b_struct_stat* followedStat )
 {
+    const int slash = filePath.lastIndexOf( '/' );
+    m_localDir = doc.internLocalDir( filePath.left( slash + 1 ) );
+    m_localName = filePath.mid( slash + 1 );
+
     if( k3bName.isEmpty() )
-        m_k3bName = filePath.section( '/', -1 );
+        m_k3bName = m_localName;
     else
         m_k3bName = k3bName;
 
@@ -314,27 +332,27 @@ void K3b::FileItem::init( const QString& filePath,
     }
 
     if( isSymLink() ) {
+        m_linkTarget = new LinkTarget;
+        m_linkTarget->id.inode = 0;
+        m_linkTarget->id.device = 0;
         if( QFile::exists( K3b::resolveLink( filePath ) ) && followedStat != 0 ) {
-            m_sizeFollowed = (KIO::filesize_t)followedStat->st_size;
-            m_idFollowed.inode = followedStat->st_ino;
-            m_idFollowed.device = followedStat->st_dev;
+            m_linkTarget->size = (KIO::filesize_t)followedStat->st_size;
+            m_linkTarget->id.inode = followedStat->st_ino;
+            m_linkTarget->id.device = followedStat->st_dev;
         }
         else if( followedStat == 0 ) {
-            m_sizeFollowed = m_size;
-            m_idFollowed.inode = 0;
-            m_idFollowed.device = 0;
+            m_linkTarget->size = m_size;
         }
         else {
             // This means the link is broken, so size of target equals 0
-            m_sizeFollowed = 0;
+            m_linkTarget->size = 0;
         }
     }
-    else {
-        m_sizeFollowed = m_size;
-        m_idFollowed = m_id;
-    }
 
-    m_mimeType = QMimeDatabase().mimeTypeForFile( filePath );
+    // links are resolved by looking at their target. Sniffing is left to
+    // mimeType() since most items are never shown.
+    if( !isSymLink() )
+        m_mimeType = K3b::MimeTypeResolver::instance()->typeForFileName( m_localName );
 
     // add automagically like a qlistviewitem
     if( parent() )
@@ -88,8 +88,27 @@ namespace K3b {
 
         QString linkDest() const;
 
+        /**
+         * The mime type is determined from the file name when the item is
+         * created. If the name is not conclusive the file is sniffed in the
+         * background on first use and the default type is returned meanwhile.
+         *
+         * \sa MimeTypeResolver
+         */
         QMimeType mimeType() const override;
 
+        /**
+         * \return false if mimeType() is still waiting for the background sniff.
+         */
+        bool isMimeTypeResolved() const { return m_mimeType.isValid(); }
+
+        /**
+         * Store the type once the background sniff finished.
+         *
+         * \return true if the type is known now.
+         */
+        bool updateMimeType();
+
         /** returns true if the item is not a link or
          *  if the link's destination is part of the compilation */
         bool isValid() const override;
@@ -113,12 +132,20 @@ namespace K3b {
         DataItem* m_replacedItemFromOldSession;
 
         KIO::filesize_t m_size;
-        KIO::filesize_t m_sizeFollowed;
         Id m_id;
-        Id m_idFollowed;
 
-        QString m_localPath;
+        // only symlinks differ from their target
+        struct LinkTarget {
+            KIO::filesize_t size;
+            Id id;
+        };
+        LinkTarget* m_linkTarget;
+
+        // the directory is shared between all items of the same local dir
+        QString m_localDir;
+        QString m_localName;
 
+        // invalid until the contents have been sniffed if the name is not conclusive
         QMimeType m_mimeType;
     };
 
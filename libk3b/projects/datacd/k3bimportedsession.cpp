@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bimportedsession.h"
+#include "k3biso9660.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+
+
+class K3b::ImportedSession::Private
+{
+public:
+    class PrefetchThread : public QThread
+    {
+    public:
+        explicit PrefetchThread( Private* d )
+            : m_d( d ) {
+        }
+
+        void run() override {
+            m_d->prefetch();
+
+            QMutexLocker locker( &m_d->mutex );
+            m_d->iso.releaseBackend();
+        }
+
+    private:
+        Private* m_d;
+    };
+
+    Private( Device::Device* dev, unsigned int startSector )
+        : iso( dev, startSector ),
+          startSector( startSector ),
+          rootDir( 0 ),
+          mutex( QMutex::Recursive ),
+          stopped( false ),
+          complete( false ),
+          thread( this ) {
+    }
+
+    // expands the tree breadth first so the top level folders which are
+    // most likely to be opened become available first
+    void prefetch() {
+        QQueue<const Iso9660Directory*> dirs;
+        dirs.enqueue( rootDir );
+        int count = 0;
+
+        while( !dirs.isEmpty() ) {
+            QMutexLocker locker( &mutex );
+            if( stopped )
+                return;
+
+            // never read the folders of another medium
+            if( !checkMedium() ) {
+                qDebug() << "(K3b::ImportedSession) medium changed after reading" << count << "folders.";
+                return;
+            }
+
+            const Iso9660Directory* dir = dirs.dequeue();
+            Q_FOREACH( const QString& name, dir->entries() ) {
+                if( name == "." || name == ".." )
+                    continue;
+                const Iso9660Entry* entry = dir->entry( name );
+                if( entry && entry->isDirectory() )
+                    dirs.enqueue( static_cast<const Iso9660Directory*>( entry ) );
+            }
+            ++count;
+        }
+
+        QMutexLocker locker( &mutex );
+        complete = true;
+        qDebug() << "(K3b::ImportedSession) read" << count << "folders.";
+    }
+
+    bool checkMedium() const {
+        QByteArray data( 2048, Qt::Uninitialized );
+        return( !volumeDescriptor.isEmpty() &&
+                iso.read( startSector+16, data.data(), 1 ) == 1 &&
+                data == volumeDescriptor );
+    }
+
+    mutable Iso9660 iso;
+    unsigned int startSector;
+    const Iso9660Directory* rootDir;
+
+    // the first volume descriptor of the session as read on import
+    QByteArray volumeDescriptor;
+
+    // only used from the thread the session was imported in
+    QHash<const DirItem*, const Iso9660Directory*> pendingDirs;
+
+    // protects iso, stopped and complete, recursive since creating the items of
+    // one folder may cause a view to expand another one
+    mutable QMutex mutex;
+    bool stopped;
+    bool complete;
+
+    PrefetchThread thread;
+};
+
+
+K3b::ImportedSession::ImportedSession( K3b::Device::Device* dev, unsigned int startSector )
+    : d( new Private( dev, startSector ) )
+{
+}
+
+
+K3b::ImportedSession::~ImportedSession()
+{
+    stopPrefetching();
+    delete d;
+}
+
+
+bool K3b::ImportedSession::open()
+{
+    if( !d->iso.open() )
+        return false;
+
+    d->volumeDescriptor.resize( 2048 );
+    if( d->iso.read( d->startSector+16, d->volumeDescriptor.data(), 1 ) != 1 )
+        d->volumeDescriptor.clear();
+
+    // the joliet tree cannot be imported for multisession
+    d->rootDir = d->iso.firstRRDirEntry();
+    if( !d->rootDir )
+        d->rootDir = d->iso.firstIsoDirEntry();
+
+    return true;
+}
+
+
+unsigned int K3b::ImportedSession::startSector() const
+{
+    return d->startSector;
+}
+
+
+K3b::Iso9660& K3b::ImportedSession::iso() const
+{
+    return d->iso;
+}
+
+
+const K3b::Iso9660Directory* K3b::ImportedSession::rootDir() const
+{
+    return d->rootDir;
+}
+
+
+QMutex* K3b::ImportedSession::mutex() const
+{
+    return &d->mutex;
+}
+
+
+void K3b::ImportedSession::addPendingDir( DirItem* item, const Iso9660Directory* dir )
+{
+    d->pendingDirs.insert( item, dir );
+}
+
+
+bool K3b::ImportedSession::isPending( const DirItem* item ) const
+{
+    return d->pendingDirs.contains( item );
+}
+
+
+const K3b::Iso9660Directory* K3b::ImportedSession::takePendingDir( DirItem* item )
+{
+    return d->pendingDirs.take( item );
+}
+
+
+void K3b::ImportedSession::clearPendingDirs()
+{
+    d->pendingDirs.clear();
+}
+
+
+bool K3b::ImportedSession::isComplete() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->complete;
+}
+
+
+bool K3b::ImportedSession::checkMedium() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->checkMedium();
+}
+
+
+void K3b::ImportedSession::releaseDevice()
+{
+    QMutexLocker locker( &d->mutex );
+    if( !d->thread.isRunning() )
+        d->iso.releaseBackend();
+}
+
+
+void K3b::ImportedSession::startPrefetching()
+{
+    if( d->rootDir && !d->thread.isRunning() ) {
+        d->stopped = false;
+        d->thread.start( QThread::LowPriority );
+    }
+}
+
+
+void K3b::ImportedSession::stopPrefetching()
+{
+    {
+        QMutexLocker locker( &d->mutex );
+        d->stopped = true;
+    }
+    d->thread.wait();
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_IMPORTED_SESSION_H_
+#define _K3B_IMPORTED_SESSION_H_
+
+#include <QtGlobal>
+
+class QMutex;
+
+namespace K3b {
+    namespace Device {
+        class Device;
+    }
+    class DirItem;
+    class Iso9660;
+    class Iso9660Directory;
+
+    /**
+     * The file system of a session imported into a data project.
+     *
+     * The folders of the session are imported lazily: a DirItem is created
+     * as a placeholder for each folder and only filled once it is accessed,
+     * see DataDoc::expandImportedDir(). Meanwhile a background thread reads
+     * the directory records of the whole tree so that the placeholders can
+     * be expanded without waiting for the drive.
+     *
+     * The Iso9660 object is shared with that thread. Once prefetching has
+     * been started it may only be used while holding mutex().
+     *
+     * The device is closed once the whole tree has been read. Since the
+     * medium might have been changed in the meantime checkMedium() needs
+     * to be called before reading anything else from it.
+     */
+    class ImportedSession
+    {
+    public:
+        ImportedSession( Device::Device* dev, unsigned int startSector );
+        ~ImportedSession();
+
+        bool open();
+
+        /**
+         * The first sector of the imported session.
+         */
+        unsigned int startSector() const;
+
+        Iso9660& iso() const;
+
+        /**
+         * The RockRidge tree or the plain iso9660 tree if there is none.
+         */
+        const Iso9660Directory* rootDir() const;
+
+        QMutex* mutex() const;
+
+        void addPendingDir( DirItem* item, const Iso9660Directory* dir );
+        bool isPending( const DirItem* item ) const;
+
+        /**
+         * \return The iso9660 folder of the placeholder \p item or 0 if it
+         *         was expanded already.
+         */
+        const Iso9660Directory* takePendingDir( DirItem* item );
+
+        /**
+         * Drops all placeholders, for example since they can no longer be
+         * read from the medium. The DirItems simply stay empty.
+         */
+        void clearPendingDirs();
+
+        /**
+         * \return true once all folders have been read so expanding the
+         *         placeholders does not access the medium anymore.
+         */
+        bool isComplete() const;
+
+        /**
+         * Compares the volume descriptor on the medium in the drive with the
+         * one of the imported session.
+         *
+         * \return false if the medium has been changed or removed.
+         */
+        bool checkMedium() const;
+
+        /**
+         * Closes the device unless the prefetching still uses it. It is
+         * reopened by the next read.
+         */
+        void releaseDevice();
+
+        void startPrefetching();
+
+        /**
+         * Stops the prefetching and waits for the thread to finish.
+         */
+        void stopPrefetching();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( ImportedSession )
+    };
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "k3bbootitem.h"
 #include "k3bdatadoc.h"
 #include "k3bdatapreparationjob.h"
+#include "k3bdataprefetcher.h"
 #include "k3bexternalbinmanager.h"
 #include "k3bdevice.h"
 #include "k3bprocess.h"
@@ -27,6 +28,7 @@
 #include "k3bversion.h"
 #include "k3bfilesplitter.h"
 #include "k3bisooptions.h"
+#include "k3bzisofscompressionjob.h"
 #include "k3b_i18n.h"
 
 #include <KIO/CopyJob>
@@ -68,6 +70,11 @@ public:
     bool knownError;
 
     K3b::DataPreparationJob* dataPreparationJob;
+    K3b::DataPrefetcher* prefetcher;
+
+    // compressed copies of the files stored in zisofs format
+    K3b::ZisofsCompressionJob* compressionJob;
+    QHash<K3b::FileItem*, QString> compressedFiles;
 };
 
 
@@ -85,10 +92,15 @@ K3b::IsoImager::IsoImager( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* par
       m_mkisofsPrintSizeResult( 0 )
 {
     d = new Private();
+    d->prefetcher = new K3b::DataPrefetcher( doc );
     d->dataPreparationJob = new K3b::DataPreparationJob( doc, this, this );
     connectSubJob( d->dataPreparationJob,
                    SLOT(slotDataPreparationDone(bool)),
                    DEFAULT_SIGNAL_CONNECTION );
+    d->compressionJob = new K3b::ZisofsCompressionJob( doc, this, this );
+    connectSubJob( d->compressionJob,
+                   SLOT(slotCompressionDone(bool)),
+                   DEFAULT_SIGNAL_CONNECTION );
 }
 
 
@@ -96,6 +108,7 @@ K3b::IsoImager::~IsoImager()
 {
     qDebug();
     cleanup();
+    delete d->prefetcher;
     delete d;
 }
 
@@ -189,6 +202,8 @@ void K3b::IsoImager::cleanup()
 {
     qDebug();
 
+    d->prefetcher->stop();
+
     // remove all temp files
     delete m_pathSpecFile;
     delete m_rrHideFile;
@@ -221,10 +236,26 @@ void K3b::IsoImager::slotDataPreparationDone( bool success )
 {
     if( success ) {
         //
-        // We always calculate the image size. It does not take long and at least the mixed job needs it
-        // anyway
+        // The files are compressed before the size calculation since mkisofs
+        // needs the compressed files to determine the size of the image.
+        // zisofs files can only be marked as such with RockRidge.
         //
-        startSizeCalculation();
+        d->compressedFiles.clear();
+        if( m_doc->isoOptions().zisofsCompression() && m_doc->isoOptions().createRockRidge() ) {
+            // the compressed files go next to the image
+            if( !m_doc->tempDir().isEmpty() ) {
+                const QFileInfo temp( m_doc->tempDir() );
+                d->compressionJob->setTempPath( temp.isDir() ? temp.absoluteFilePath() : temp.absolutePath() );
+            }
+            d->compressionJob->start();
+        }
+        else {
+            //
+            // We always calculate the image size. It does not take long and at least the mixed job needs it
+            // anyway
+            //
+            startSizeCalculation();
+        }
     }
     else {
         if( d->dataPreparationJob->hasBeenCanceled() ) {
@@ -236,6 +267,22 @@ void K3b::IsoImager::slotDataPreparationDone( bool success )
 }
 
 
+void K3b::IsoImager::slotCompressionDone( bool success )
+{
+    if( success ) {
+        d->compressedFiles = d->compressionJob->compressedFiles();
+        startSizeCalculation();
+    }
+    else {
+        if( d->compressionJob->hasBeenCanceled() ) {
+            m_canceled = true;
+            emit canceled();
+        }
+        jobFinished( false );
+    }
+}
+
+
 void K3b::IsoImager::calculateSize()
 {
     jobStarted();
@@ -457,6 +504,10 @@ void K3b::IsoImager::start()
         jobFinished( false );
         cleanup();
     }
+    else {
+        // the boot image backups have been created by now
+        d->prefetcher->start();
+    }
 }
 
 
@@ -469,6 +520,9 @@ void K3b::IsoImager::cancel()
         qDebug() << "terminating process";
         m_process->terminate();
     }
+    else if( d->compressionJob->active() ) {
+        d->compressionJob->cancel();
+    }
     else if( active() ) {
         emit canceled();
         jobFinished(false);
@@ -476,6 +530,12 @@ void K3b::IsoImager::cancel()
 }
 
 
+void K3b::IsoImager::setImagePosition( quint64 bytes )
+{
+    d->prefetcher->setPosition( bytes );
+}
+
+
 void K3b::IsoImager::setMultiSessionInfo( const QString& info, K3b::Device::Device* dev )
 {
     m_multiSessionInfo = info;
@@ -589,6 +649,8 @@ bool K3b::IsoImager::addMkisofsParameters( bool printSize )
             *m_process << "-rational-rock";
         if( m_rrHideFile )
             *m_process << "-hide-list" << m_rrHideFile->fileName();
+        if( !d->compressedFiles.isEmpty() )
+            *m_process << "-z";
     }
 
     if( m_doc->isoOptions().createJoliet() ) {
@@ -743,7 +805,15 @@ int K3b::IsoImager::writePathSpec()
         QTextStream s( m_pathSpecFile );
 
         // recursive path spec writing
-        return writePathSpecForDir( m_doc->root(), s );
+        int num = writePathSpecForDir( m_doc->root(), s );
+
+        // a session which only hides files of the imported one still needs a graft point
+        if( num == 0 && !m_doc->hiddenOldSessionPaths().isEmpty() ) {
+            s << "/=" << escapeGraftPoint( dummyDir( m_doc->root() ) ) << "\n";
+            num = 1;
+        }
+
+        return num;
     }
     else {
         return -1;
@@ -761,6 +831,8 @@ int K3b::IsoImager::writePathSpecForDir( K3b::DirItem* dirItem, QTextStream& str
     // now create the graft points
     int num = 0;
     Q_FOREACH( K3b::DataItem* item, dirItem->children() ) {
+        // folders of an imported session which were never expanded do not
+        // contain new items, so there is no need to read them here
         bool writeItem = item->writeToCd();
 
         if( item->isSymLink() ) {
@@ -854,6 +926,8 @@ void K3b::IsoImager::writePathSpecForFile( K3b::FileItem* item, QTextStream& str
         m_tempFiles.append(tempPath);
         stream << escapeGraftPoint( tempPath ) << "\n";
     }
+    else if( d->compressedFiles.contains( item ) )
+        stream << escapeGraftPoint( d->compressedFiles[item] ) << "\n";
     else if( item->isSymLink() && d->usedLinkHandling == Private::FOLLOW )
         stream << escapeGraftPoint( K3b::resolveLink( item->localPath() ) ) << "\n";
     else
@@ -878,6 +952,8 @@ bool K3b::IsoImager::writeRRHideFile()
         item = item->nextSibling();
     }
 
+    writeOldSessionHidePaths( s );
+
     return true;
 }
 
@@ -899,10 +975,24 @@ bool K3b::IsoImager::writeJolietHideFile()
         item = item->nextSibling();
     }
 
+    writeOldSessionHidePaths( s );
+
     return true;
 }
 
 
+void K3b::IsoImager::writeOldSessionHidePaths( QTextStream& s )
+{
+    // items removed from the imported session have no local path, they are
+    // hidden by their path in the merged tree
+    Q_FOREACH( QString path, m_doc->hiddenOldSessionPaths() ) {
+        if( path.endsWith( '/' ) )
+            path.truncate( path.length()-1 );
+        s << escapeGraftPoint( '/' + path ) << endl;
+    }
+}
+
+
 bool K3b::IsoImager::writeSortWeightFile()
 {
     delete m_sortWeightFile;
@@ -45,6 +45,13 @@ namespace K3b {
 
         QIODevice* ioDevice() const;
 
+        /**
+         * The number of image bytes read from ioDevice() so far. The source
+         * files are prefetched ahead of this position while the image is
+         * created.
+         */
+        void setImagePosition( quint64 bytes );
+
     public Q_SLOTS:
         /**
          * Starts the actual image creation. Always run init()
@@ -112,6 +119,7 @@ namespace K3b {
         virtual int writePathSpec();
         bool writeRRHideFile();
         bool writeJolietHideFile();
+        void writeOldSessionHidePaths( QTextStream& s );
         bool writeSortWeightFile();
 
         // used by writePathSpec
@@ -137,6 +145,7 @@ namespace K3b {
         void slotCollectMkisofsPrintSizeStdout( const QString& );
         void slotMkisofsPrintSizeFinished();
         void slotDataPreparationDone( bool success );
+        void slotCompressionDone( bool success );
 
     private:
         void startSizeCalculation();
@@ -50,6 +50,7 @@ K3b::IsoOptions::IsoOptions()
 
     m_doNotCacheInodes = true;
     m_doNotImportSession = false;
+    m_zisofsCompression = false;
 
     m_isoLevel = 3;
 
@@ -122,6 +123,7 @@ void K3b::IsoOptions::save( KConfigGroup c, bool saveVolumeDesc )
 
     c.writeEntry( "do not cache inodes", m_doNotCacheInodes );
     c.writeEntry( "do not import last session", m_doNotImportSession );
+    c.writeEntry( "zisofs compression", m_zisofsCompression );
 
     // save whitespace-treatment
     switch( m_whiteSpaceTreatment ) {
@@ -197,6 +199,7 @@ K3b::IsoOptions K3b::IsoOptions::load( const KConfigGroup& c, bool loadVolumeDes
 
     options.setDoNotCacheInodes( c.readEntry( "do not cache inodes", options.doNotCacheInodes() ) );
     options.setDoNotImportSession( c.readEntry( "no not import last session", options.doNotImportSession() ) );
+    options.setZisofsCompression( c.readEntry( "zisofs compression", options.zisofsCompression() ) );
 
     QString w = c.readEntry( "white_space_treatment", "noChange" );
     if( w == "replace" )
@@ -119,6 +119,13 @@ namespace K3b {
         bool doNotImportSession() const { return m_doNotImportSession; }
         void setDoNotImportSession( bool b ) { m_doNotImportSession = b; }
 
+        /**
+         * Store files which compress well in zisofs format. Needs RockRidge
+         * extensions to be readable.
+         */
+        bool zisofsCompression() const { return m_zisofsCompression; }
+        void setZisofsCompression( bool b ) { m_zisofsCompression = b; }
+
         void save( KConfigGroup c, bool saveVolumeDesc = true );
 
         static IsoOptions load( const KConfigGroup& c, bool loadVolumeDesc = true );
@@ -168,6 +175,7 @@ namespace K3b {
 
         bool m_doNotCacheInodes;
         bool m_doNotImportSession;
+        bool m_zisofsCompression;          // -z
 
         int m_isoLevel;
 
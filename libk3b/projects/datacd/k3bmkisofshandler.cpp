@@ -17,6 +17,7 @@
 #include "k3bexternalbinmanager.h"
 #include "k3bcore.h"
 #include "k3bjob.h"
+#include "k3bprogressmatcher.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -137,26 +138,13 @@ int K3b::MkisofsHandler::parseMkisofsProgress(const QString& line)
     // This is not very dramatic but kind or ugly.
     // We just save the first emitted progress value and to some math ;)
 
-    QString perStr = line;
-    perStr.truncate(perStr.indexOf('%'));
-    // FIXME: how to support Inuit or Samaritan Aramaic format or cover all
-    // formats? right now it only support, for example: 0.52 and 0,52
-    QRegExp rx("(\\d+.|,+\\d)");
-    QStringList list;
-    int pos = 0;
-    bool ok;
-    while ((pos = rx.indexIn(perStr, pos)) != -1) {
-        list << rx.cap(1);
-        pos += rx.matchedLength();
-    }
-    if (list.size() < 2)
-        return -1;
-    // FIXME: the same story
-    double p = (list[0].replace(',', '.') + list[1]).toDouble(&ok);
-    if (!ok) {
-        qDebug() << "(K3b::MkisofsHandler) Parsing did not work for " << perStr;
+    K3b::ProgressMatcher::Captures cap;
+    if( !K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::MkisofsProgress ).match( line, cap ) ) {
+        qDebug() << "(K3b::MkisofsHandler) Parsing did not work for " << line;
         return -1;
     } else {
+        // both 0.52 and 0,52 are accepted as decimal separator
+        double p = cap.toDouble(0);
         if (d->firstProgressValue < 0)
             d->firstProgressValue = p;
 
@@ -41,6 +41,13 @@ namespace K3b {
         bool isHideable() const override { return false; }
         bool writeToCd() const override { return false; }
 
+    protected:
+        /**
+         * The data is already on the medium and accounted for by
+         * the size of the imported session.
+         */
+        Msf itemBlocks( bool ) const override { return 0; }
+
     private:
         FileItem* m_replaceItem;
     };
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bzisofscompressionjob.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bglobals.h"
+#include "k3bzisofs.h"
+#include "k3b_i18n.h"
+
+#include <KDiskFreeSpaceInfo>
+#include <KIO/Global>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+
+
+namespace {
+    void collectFiles( K3b::DirItem* dir, QList<K3b::FileItem*>& files )
+    {
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            if( !item->writeToCd() || item->isFromOldSession() )
+                continue;
+
+            if( item->isDir() )
+                collectFiles( static_cast<K3b::DirItem*>( item ), files );
+
+            // boot images are copied by the imager and links are written as links
+            else if( item->isFile() && !item->isSymLink() && !item->isBootItem() &&
+                     K3b::Zisofs::isCandidate( item->localPath(), item->itemSize( false ) ) )
+                files.append( static_cast<K3b::FileItem*>( item ) );
+        }
+    }
+
+
+    /**
+     * Identifies the files to compress, their state on disk and the folder
+     * to compress them to. The access time is left out since compressing
+     * a file updates it.
+     */
+    QByteArray fingerprint( const QList<K3b::FileItem*>& files, const QString& tempPath )
+    {
+        QCryptographicHash hash( QCryptographicHash::Md5 );
+        hash.addData( tempPath.toUtf8() + '\n' );
+        Q_FOREACH( K3b::FileItem* item, files ) {
+            const QFileInfo fi( item->localPath() );
+            hash.addData( QString( "%1:%2:%3:%4:%5\n" )
+                          .arg( quintptr( item ) )
+                          .arg( fi.absoluteFilePath() )
+                          .arg( fi.size() )
+                          .arg( fi.lastModified().toMSecsSinceEpoch() )
+                          .arg( int( fi.permissions() ) ).toUtf8() );
+        }
+        return hash.result();
+    }
+}
+
+
+class K3b::ZisofsCompressionJob::Private
+{
+public:
+    class CompressTask : public QRunnable
+    {
+    public:
+        CompressTask( Private* d, int index )
+            : m_d( d ),
+              m_index( index ) {
+        }
+
+        void run() override {
+            const Task& task = m_d->tasks[m_index];
+            m_d->results[m_index] = K3b::Zisofs::compressFile( task.source, task.target, &m_d->cancel );
+
+            QMutexLocker locker( &m_d->mutex );
+            m_d->doneSize += task.size;
+        }
+
+    private:
+        Private* m_d;
+        int m_index;
+    };
+
+    struct Task {
+        FileItem* item;
+        QString source;
+        QString target;
+        KIO::filesize_t size;
+    };
+
+    Private()
+        : cancel( false ),
+          doneSize( 0 ) {
+    }
+
+    DataDoc* doc;
+    QString tempPath;
+    QString folder;
+    QHash<FileItem*, QString> files;
+
+    // the files compressed in folder
+    QByteArray fingerprint;
+
+    // each compress task only touches its own entries
+    QVector<Task> tasks;
+    QVector<Zisofs::Result> results;
+
+    volatile bool cancel;
+
+    QMutex mutex;
+    KIO::filesize_t doneSize;
+};
+
+
+K3b::ZisofsCompressionJob::ZisofsCompressionJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent )
+    : K3b::ThreadJob( hdl, parent ),
+      d( new Private() )
+{
+    d->doc = doc;
+}
+
+
+K3b::ZisofsCompressionJob::~ZisofsCompressionJob()
+{
+    removeCompressedFiles();
+    delete d;
+}
+
+
+QString K3b::ZisofsCompressionJob::jobDescription() const
+{
+    return i18n("Compressing Files");
+}
+
+
+QHash<K3b::FileItem*, QString> K3b::ZisofsCompressionJob::compressedFiles() const
+{
+    return d->files;
+}
+
+
+void K3b::ZisofsCompressionJob::removeCompressedFiles()
+{
+    if( !d->folder.isEmpty() ) {
+        QDir( d->folder ).removeRecursively();
+        d->folder.clear();
+    }
+    d->files.clear();
+    d->fingerprint.clear();
+}
+
+
+void K3b::ZisofsCompressionJob::setTempPath( const QString& path )
+{
+    d->tempPath = path;
+}
+
+
+bool K3b::ZisofsCompressionJob::run()
+{
+    QList<K3b::FileItem*> files;
+    collectFiles( d->doc->root(), files );
+
+    //
+    // The imager is initialized again for each copy. As long as the project
+    // and its files did not change the files compressed last time are used.
+    //
+    const QByteArray print = fingerprint( files, d->tempPath );
+    if( !d->folder.isEmpty() && print == d->fingerprint && QFileInfo( d->folder ).isDir() ) {
+        qDebug() << "(K3b::ZisofsCompressionJob) reusing" << d->files.count() << "compressed files in" << d->folder;
+        for( QHash<FileItem*, QString>::const_iterator it = d->files.constBegin(); it != d->files.constEnd(); ++it )
+            K3b::Zisofs::copyFileAttributes( it.key()->localPath(), it.value() );
+        return true;
+    }
+
+    removeCompressedFiles();
+
+    emit newTask( i18n("Compressing files") );
+
+    if( files.isEmpty() )
+        return true;
+
+    d->folder = K3b::findTempFile( QString(), d->tempPath );
+    if( !QDir().mkpath( d->folder ) ) {
+        emit infoMessage( i18n("Unable to create folder '%1'", d->folder), MessageError );
+        d->folder.clear();
+        return false;
+    }
+
+    d->tasks.resize( files.count() );
+    d->results.fill( K3b::Zisofs::Error, files.count() );
+    KIO::filesize_t totalSize = 0;
+    for( int i = 0; i < files.count(); ++i ) {
+        Private::Task& task = d->tasks[i];
+        task.item = files[i];
+        task.source = files[i]->localPath();
+        task.target = QString( "%1/%2" ).arg( d->folder ).arg( i );
+        task.size = files[i]->itemSize( false );
+        totalSize += task.size;
+    }
+
+    // worst case every file is copied in full before we know if it compresses
+    KDiskFreeSpaceInfo free = KDiskFreeSpaceInfo::freeSpaceInfo( d->folder );
+    if( free.isValid() && free.available() < totalSize ) {
+        emit infoMessage( i18n("Not enough space in %1 to compress the files (%2 needed).",
+                               d->tempPath, KIO::convertSize( totalSize ) ), MessageError );
+        removeCompressedFiles();
+        return false;
+    }
+
+    qDebug() << "(K3b::ZisofsCompressionJob) compressing" << files.count() << "files with" << totalSize << "bytes in" << d->folder;
+
+    d->cancel = false;
+    d->doneSize = 0;
+
+    // the biggest files first so the pool does not end up waiting for a single one
+    QVector<int> order( files.count() );
+    for( int i = 0; i < order.count(); ++i )
+        order[i] = i;
+    std::sort( order.begin(), order.end(), [this]( int a, int b ) { return d->tasks[a].size > d->tasks[b].size; } );
+
+    QThreadPool pool;
+    Q_FOREACH( int i, order )
+        pool.start( new Private::CompressTask( d, i ) );
+
+    while( !pool.waitForDone( 100 ) ) {
+        if( canceled() && !d->cancel ) {
+            d->cancel = true;
+            pool.clear();
+        }
+
+        QMutexLocker locker( &d->mutex );
+        emit percent( totalSize > 0 ? 100ULL*d->doneSize/totalSize : 100 );
+    }
+
+    if( canceled() ) {
+        removeCompressedFiles();
+        return false;
+    }
+
+    int errors = 0;
+    KIO::filesize_t saved = 0;
+    for( int i = 0; i < d->tasks.count(); ++i ) {
+        const Private::Task& task = d->tasks[i];
+        if( d->results[i] == K3b::Zisofs::Compressed ) {
+            d->files.insert( task.item, task.target );
+            saved += task.size - QFileInfo( task.target ).size();
+        }
+        else if( d->results[i] == K3b::Zisofs::Error ) {
+            ++errors;
+        }
+    }
+
+    d->tasks.clear();
+    d->results.clear();
+    d->fingerprint = print;
+
+    if( errors > 0 )
+        emit infoMessage( i18np("Failed to compress %1 file. It will be written uncompressed.",
+                                "Failed to compress %1 files. They will be written uncompressed.", errors ),
+                          MessageWarning );
+
+    emit infoMessage( i18np("Compressed %1 file saving %2.", "Compressed %1 files saving %2.",
+                            d->files.count(), KIO::convertSize( saved ) ),
+                      MessageInfo );
+
+    return true;
+}
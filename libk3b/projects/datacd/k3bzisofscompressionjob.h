@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_ZISOFS_COMPRESSION_JOB_H_
+#define _K3B_ZISOFS_COMPRESSION_JOB_H_
+
+#include "k3bthreadjob.h"
+
+#include <QHash>
+
+
+namespace K3b {
+    class DataDoc;
+    class FileItem;
+
+    /**
+     * Compresses the files of a data project which compress well into
+     * zisofs format so mkisofs can store them with -z.
+     *
+     * The files are compressed in parallel on a thread pool. Files which
+     * would not get smaller by at least one sector are left alone.
+     *
+     * \see Zisofs
+     */
+    class ZisofsCompressionJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        ZisofsCompressionJob( DataDoc* doc, JobHandler* hdl, QObject* parent = 0 );
+        ~ZisofsCompressionJob() override;
+
+        QString jobDescription() const override;
+
+        /**
+         * The compressed copies of the project's files. The copies stay
+         * around until removeCompressedFiles() is called or the job
+         * is deleted.
+         */
+        QHash<FileItem*, QString> compressedFiles() const;
+
+        void removeCompressedFiles();
+
+    public Q_SLOTS:
+        /**
+         * The folder in which the compressed files are stored.
+         * Defaults to the K3b temporary folder.
+         */
+        void setTempPath( const QString& path );
+
+    private:
+        bool run() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bzisofssizeestimator.h"
+#include "k3bdiritem.h"
+#include "k3bzisofs.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QMultiHash>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+
+namespace {
+    KIO::filesize_t savedBytes( KIO::filesize_t size, qint64 compressedSize )
+    {
+        if( compressedSize < 0 )
+            return 0;
+
+        const KIO::filesize_t sectors = ( size + 2047 ) / 2048;
+        const KIO::filesize_t compressedSectors = ( compressedSize + 2047 ) / 2048;
+        return compressedSectors < sectors ? ( sectors - compressedSectors ) * 2048 : 0;
+    }
+}
+
+
+class K3b::ZisofsSizeEstimator::Private
+{
+public:
+    class EstimateJob : public QRunnable
+    {
+    public:
+        EstimateJob( ZisofsSizeEstimator* e, const QString& p )
+            : estimator( e ),
+              path( p ) {
+        }
+
+        void run() override {
+            emit estimator->estimated( path, Zisofs::estimateCompressedSize( path ) );
+        }
+
+    private:
+        ZisofsSizeEstimator* estimator;
+        QString path;
+    };
+
+    Private()
+        : total( 0 ) {
+    }
+
+    // everything but the pool is only used from the GUI thread
+    QHash<QString, qint64> estimates;
+    QSet<QString> pending;
+    QMultiHash<QString, DataItem*> waiting;
+    QHash<DataItem*, KIO::filesize_t> saved;
+    KIO::filesize_t total;
+
+    QThreadPool pool;
+};
+
+
+K3b::ZisofsSizeEstimator::ZisofsSizeEstimator( QObject* parent )
+    : QObject( parent ),
+      d( new Private() )
+{
+    // estimating is bound by the disk rather than the CPU
+    d->pool.setMaxThreadCount( 2 );
+
+    connect( this, SIGNAL(estimated(QString,qint64)),
+             this, SLOT(slotEstimated(QString,qint64)),
+             Qt::QueuedConnection );
+}
+
+
+K3b::ZisofsSizeEstimator::~ZisofsSizeEstimator()
+{
+    d->pool.clear();
+    d->pool.waitForDone();
+    delete d;
+}
+
+
+void K3b::ZisofsSizeEstimator::addItem( K3b::DataItem* item )
+{
+    if( item->isDir() ) {
+        Q_FOREACH( K3b::DataItem* child, static_cast<K3b::DirItem*>( item )->children() )
+            addItem( child );
+        return;
+    }
+
+    if( !item->isFile() || item->isSymLink() || item->isBootItem() || item->isFromOldSession() )
+        return;
+
+    const QString path = item->localPath();
+    const KIO::filesize_t size = item->itemSize( false );
+    if( !K3b::Zisofs::isCandidate( path, size ) )
+        return;
+
+    QHash<QString, qint64>::const_iterator it = d->estimates.constFind( path );
+    if( it != d->estimates.constEnd() ) {
+        const KIO::filesize_t saved = ::savedBytes( size, it.value() );
+        d->saved.insert( item, saved );
+        d->total += saved;
+    }
+    else {
+        d->waiting.insert( path, item );
+        if( !d->pending.contains( path ) ) {
+            d->pending.insert( path );
+            d->pool.start( new Private::EstimateJob( this, path ) );
+        }
+    }
+}
+
+
+void K3b::ZisofsSizeEstimator::removeItem( K3b::DataItem* item )
+{
+    if( item->isDir() ) {
+        Q_FOREACH( K3b::DataItem* child, static_cast<K3b::DirItem*>( item )->children() )
+            removeItem( child );
+        return;
+    }
+
+    QHash<K3b::DataItem*, KIO::filesize_t>::iterator it = d->saved.find( item );
+    if( it != d->saved.end() ) {
+        d->total -= it.value();
+        d->saved.erase( it );
+    }
+    else if( item->isFile() ) {
+        d->waiting.remove( item->localPath(), item );
+    }
+}
+
+
+void K3b::ZisofsSizeEstimator::clear()
+{
+    // estimates which are running already still end up in the cache
+    d->pool.clear();
+    d->pending.clear();
+    d->waiting.clear();
+    d->saved.clear();
+    d->total = 0;
+}
+
+
+KIO::filesize_t K3b::ZisofsSizeEstimator::savedBytes() const
+{
+    return d->total;
+}
+
+
+void K3b::ZisofsSizeEstimator::slotEstimated( const QString& path, qint64 compressedSize )
+{
+    d->pending.remove( path );
+    d->estimates.insert( path, compressedSize );
+
+    bool changed = false;
+    Q_FOREACH( K3b::DataItem* item, d->waiting.values( path ) ) {
+        const KIO::filesize_t saved = ::savedBytes( item->itemSize( false ), compressedSize );
+        d->saved.insert( item, saved );
+        d->total += saved;
+        changed = changed || saved > 0;
+    }
+    d->waiting.remove( path );
+
+    if( changed )
+        emit savedBytesChanged();
+}
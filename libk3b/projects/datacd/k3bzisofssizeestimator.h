@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_ZISOFS_SIZE_ESTIMATOR_H_
+#define _K3B_ZISOFS_SIZE_ESTIMATOR_H_
+
+#include <KIO/Global>
+
+#include <QObject>
+
+
+namespace K3b {
+    class DataItem;
+
+    /**
+     * Estimates how much space zisofs compression saves for the files
+     * of a data project.
+     *
+     * The estimate for a file is based on compressing a few blocks of it,
+     * which happens in a background thread. savedBytesChanged() is emitted
+     * once estimates come in.
+     *
+     * \see Zisofs::estimateCompressedSize()
+     */
+    class ZisofsSizeEstimator : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ZisofsSizeEstimator( QObject* parent = 0 );
+        ~ZisofsSizeEstimator() override;
+
+        /**
+         * Adds \p item and, for a folder, all items below it.
+         */
+        void addItem( DataItem* item );
+
+        /**
+         * Removes \p item and, for a folder, all items below it.
+         */
+        void removeItem( DataItem* item );
+
+        void clear();
+
+        /**
+         * The estimated number of bytes saved by compressing the added items,
+         * always a multiple of the sector size.
+         */
+        KIO::filesize_t savedBytes() const;
+
+    Q_SIGNALS:
+        void savedBytesChanged();
+
+        /**
+         * Emitted from the estimating thread.
+         */
+        void estimated( const QString& path, qint64 compressedSize );
+
+    private Q_SLOTS:
+        void slotEstimated( const QString& path, qint64 compressedSize );
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include "k3bthroughputestimator.h"
 #include "k3bglobals.h"
 #include "k3bglobalsettings.h"
+#include "k3bprogressmatcher.h"
 #include "k3b_i18n.h"
 
 #include <KIO/CopyJob>
@@ -34,7 +35,6 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QRegExp>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryFile>
@@ -785,10 +785,10 @@ void K3b::CdrdaoWriter::unknownCdrdaoLine( const QString& line )
     if( line.contains( "at speed" ) )
     {
         // parse the speed and inform the user if cdrdao switched it down
-        int pos = line.indexOf( "at speed" );
-        int po2 = line.indexOf( QRegExp("\\D"), pos + 9 );
-        int speed = line.mid( pos+9, po2-pos-9 ).toInt();
-        if( speed < d->usedSpeed )
+        K3b::ProgressMatcher::Captures cap;
+        bool ok = K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::CdrdaoSpeed ).match( line, cap );
+        int speed = cap.toInt( 0 );
+        if( ok && speed < d->usedSpeed )
         {
             // xgettext: no-c-format
             emit infoMessage( i18n("Medium or burner does not support writing at %1x speed",d->usedSpeed), K3b::Job::MessageWarning );
@@ -901,14 +901,12 @@ void K3b::CdrdaoWriter::parseCdrdaoError( const QString& line )
 
 void K3b::CdrdaoWriter::parseCdrdaoWrote( const QString& line )
 {
-    int pos, po2;
-    pos = line.indexOf( "Wrote" );
-    po2 = line.indexOf( " ", pos + 6 );
-    int processed = line.mid( pos+6, po2-pos-6 ).toInt();
-
-    pos = line.indexOf( "of" );
-    po2 = line.indexOf( " ", pos + 3 );
-    m_size = line.mid( pos+3, po2-pos-3 ).toInt();
+    K3b::ProgressMatcher::Captures cap;
+    if( !K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::CdrdaoWrote ).match( line, cap ) )
+        return;
+
+    int processed = cap.toInt( 0 );
+    m_size = cap.toInt( 1 );
 
     d->speedEst->dataWritten( processed*1024 );
 
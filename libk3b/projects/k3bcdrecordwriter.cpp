@@ -26,6 +26,7 @@
 #include "k3bglobals.h"
 #include "k3bthroughputestimator.h"
 #include "k3bglobalsettings.h"
+#include "k3bprogressmatcher.h"
 
 #include <QDebug>
 #include <QString>
@@ -480,12 +481,13 @@ void K3b::CdrecordWriter::slotStdLine( const QString& line )
     static QRegExp s_burnfreeCounterRx( "^BURN\\-Free\\swas\\s(\\d+)\\stimes\\sused" );
     static QRegExp s_burnfreeCounterRxPredict( "^Total\\sof\\s(\\d+)\\s\\spossible\\sbuffer\\sunderruns\\spredicted" );
 
-    // tracknumber: cap(1)
-    // done: cap(2)
-    // complete: cap(3)
-    // fifo: cap(4)  (it seems as if some patched cdrecord versions do not emit the fifo info but only the buf... :(
-    // buffer: cap(5)
-    static QRegExp s_progressRx( "Track\\s(\\d\\d)\\:\\s*(\\d*)\\sof\\s*(\\d*)\\sMB\\swritten\\s(?:\\(fifo\\s*(\\d*)\\%\\)\\s*)?(?:\\[buf\\s*(\\d*)\\%\\])?.*" );
+    // tracknumber: cap(0)
+    // done: cap(1)
+    // complete: cap(2)
+    // fifo: cap(3)  (it seems as if some patched cdrecord versions do not emit the fifo info but only the buf... :(
+    // buffer: cap(4)
+    const K3b::ProgressMatcher& progressMatcher = K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::CdrecordProgress );
+    K3b::ProgressMatcher::Captures cap;
 
     emit debuggingOutput( d->cdrecordBinObject->name(), line );
 
@@ -523,17 +525,17 @@ void K3b::CdrecordWriter::slotStdLine( const QString& line )
                          << line.mid( 6, 2 );
         }
 
-        else if( s_progressRx.exactMatch( line ) ) {
-            //      int num = s_progressRx.cap(1).toInt();
-            int made = s_progressRx.cap(2).toInt();
-            int size = s_progressRx.cap(3).toInt();
-            int fifo = s_progressRx.cap(4).toInt();
+        else if( progressMatcher.match( line, cap ) ) {
+            //      int num = cap.toInt(0);
+            int made = cap.toInt(1);
+            int size = cap.toInt(2);
+            int fifo = cap.toInt(3);
 
             emit buffer( fifo );
             d->lastFifoValue = fifo;
 
-            if( s_progressRx.captureCount() > 4 )
-                emit deviceBuffer( s_progressRx.cap(5).toInt() );
+            if( cap.isValid(4) )
+                emit deviceBuffer( cap.toInt(4) );
 
             //
             // cdrecord's output sucks a bit.
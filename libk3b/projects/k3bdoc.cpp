@@ -24,6 +24,8 @@
 #include <QString>
 #include <QDomElement>
 #include <QWidget>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 
 K3b::Doc::Doc( QObject* parent )
@@ -161,6 +163,78 @@ bool K3b::Doc::saveGeneralDocumentData( QDomElement* part )
 }
 
 
+bool K3b::Doc::loadDocumentStream( QXmlStreamReader& xml )
+{
+    QDomDocument doc;
+    QDomElement root = readDomElement( xml, doc );
+    if( xml.hasError() )
+        return false;
+
+    return loadDocumentData( &root );
+}
+
+
+bool K3b::Doc::saveDocumentStream( QXmlStreamWriter& xml )
+{
+    QDomDocument doc;
+    QDomElement root = doc.createElement( "project" );
+    doc.appendChild( root );
+
+    if( !saveDocumentData( &root ) )
+        return false;
+
+    for( QDomElement e = root.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+        writeDomElement( xml, e );
+
+    return !xml.hasError();
+}
+
+
+// static
+QDomElement K3b::Doc::readDomElement( QXmlStreamReader& xml, QDomDocument& doc )
+{
+    QDomElement elem = doc.createElement( xml.name().toString() );
+    Q_FOREACH( const QXmlStreamAttribute& attr, xml.attributes() ) {
+        elem.setAttribute( attr.name().toString(), attr.value().toString() );
+    }
+
+    while( !xml.atEnd() ) {
+        xml.readNext();
+        if( xml.isStartElement() )
+            elem.appendChild( readDomElement( xml, doc ) );
+        // QDomDocument::setContent drops whitespace-only text as well
+        else if( xml.isCharacters() && !xml.isWhitespace() )
+            elem.appendChild( doc.createTextNode( xml.text().toString() ) );
+        else if( xml.isEndElement() )
+            break;
+    }
+
+    return elem;
+}
+
+
+// static
+void K3b::Doc::writeDomElement( QXmlStreamWriter& xml, const QDomElement& elem )
+{
+    xml.writeStartElement( elem.tagName() );
+
+    QDomNamedNodeMap attributes = elem.attributes();
+    for( int i = 0; i < attributes.count(); ++i ) {
+        QDomAttr attr = attributes.item( i ).toAttr();
+        xml.writeAttribute( attr.name(), attr.value() );
+    }
+
+    for( QDomNode n = elem.firstChild(); !n.isNull(); n = n.nextSibling() ) {
+        if( n.isElement() )
+            writeDomElement( xml, n.toElement() );
+        else if( n.isText() )
+            xml.writeCharacters( n.toText().data() );
+    }
+
+    xml.writeEndElement();
+}
+
+
 bool K3b::Doc::readGeneralDocumentData( const QDomElement& elem )
 {
     if( elem.nodeName() != "general" )
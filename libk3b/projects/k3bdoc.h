@@ -26,7 +26,10 @@
 #include <QString>
 #include <QUrl>
 
+class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 namespace K3b {
     class BurnJob;
     class JobHandler;
@@ -125,6 +128,24 @@ namespace K3b {
          */
         virtual bool saveDocumentData( QDomElement* docElem ) = 0;
 
+        /**
+         * Load a project while parsing it. \p xml is positioned on the start
+         * element of the project and has to be read up to its end element.
+         *
+         * The default implementation reads the element into a QDomElement and
+         * calls loadDocumentData(). Projects which may contain a lot of items
+         * should reimplement this to avoid building the whole DOM tree.
+         */
+        virtual bool loadDocumentStream( QXmlStreamReader& xml );
+
+        /**
+         * Write the contents of the project element.
+         *
+         * The default implementation writes the elements created by
+         * saveDocumentData().
+         */
+        virtual bool saveDocumentStream( QXmlStreamWriter& xml );
+
         /** returns the QUrl of the document */
         const QUrl& URL() const;
         /** sets the URL of the document */
@@ -200,6 +221,18 @@ namespace K3b {
 
         bool readGeneralDocumentData( const QDomElement& );
 
+        /**
+         * Reads the element \p xml is positioned on, including all children,
+         * into a QDomElement owned by \p doc. Used to parse the small sections
+         * of a project while streaming it.
+         */
+        static QDomElement readDomElement( QXmlStreamReader& xml, QDomDocument& doc );
+
+        /**
+         * Writes \p elem including all children to \p xml.
+         */
+        static void writeDomElement( QXmlStreamWriter& xml, const QDomElement& elem );
+
     private Q_SLOTS:
         void slotChanged();
 
@@ -17,6 +17,7 @@
 #include "k3bcore.h"
 #include "k3bglobalsettings.h"
 #include "k3bdevicehandler.h"
+#include "k3bprogressmatcher.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -176,39 +177,28 @@ void K3b::GrowisofsHandler::handleLine( const QString& line )
         } else
             qDebug() << "(K3b::GrowisofsHandler) parsing error: '" << line.mid( pos, endPos-pos ) << "'";
     }
-    else if( (pos = line.indexOf( "RBU" )) > 0 ) {
-
-        // FIXME: use QRegExp
+    else if( line.indexOf( "RBU" ) > 0 ) {
 
         // parse ring buffer fill for growisofs >= 6.0
-        pos += 4;
-        int endPos = line.indexOf( '%', pos+1 );
-        bool ok = true;
-        double val = line.mid( pos, endPos-pos ).toDouble( &ok );
-        if( ok ) {
-            int newBuffer = (int)(val+0.5);
+        K3b::ProgressMatcher::Captures cap;
+        if( K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::GrowisofsRingBuffer ).match( line, cap ) ) {
+            int newBuffer = (int)(cap.toDouble(0)+0.5);
             if( newBuffer != d->lastBuffer ) {
                 d->lastBuffer = newBuffer;
                 emit buffer( newBuffer );
             }
 
             // device buffer for growisofs >= 7.0
-            pos = line.indexOf( "UBU", pos );
-            endPos = line.indexOf( '%', pos+5 );
-            if( pos > 0 ) {
-                pos += 4;
-                val = line.mid( pos, endPos-pos ).toDouble( &ok );
-                if( ok ) {
-                    int newBuffer = (int)(val+0.5);
-                    if( newBuffer != d->lastDeviceBuffer ) {
-                        d->lastDeviceBuffer = newBuffer;
-                        emit deviceBuffer( newBuffer );
-                    }
+            if( cap.isValid(1) ) {
+                int newBuffer = (int)(cap.toDouble(1)+0.5);
+                if( newBuffer != d->lastDeviceBuffer ) {
+                    d->lastDeviceBuffer = newBuffer;
+                    emit deviceBuffer( newBuffer );
                 }
             }
         }
         else
-            qDebug() << "(K3b::GrowisofsHandler) failed to parse ring buffer fill from '" << line.mid( pos, endPos-pos ) << "'";
+            qDebug() << "(K3b::GrowisofsHandler) failed to parse ring buffer fill from '" << line << "'";
     }
 
     else {
@@ -25,6 +25,7 @@
 #include "k3bthroughputestimator.h"
 #include "k3bgrowisofshandler.h"
 #include "k3bglobalsettings.h"
+#include "k3bprogressmatcher.h"
 #include "k3bdeviceglobals.h"
 #include "k3b_i18n.h"
 
@@ -431,6 +432,7 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
 {
     emit debuggingOutput( d->growisofsBin->name(), line );
 
+    K3b::ProgressMatcher::Captures cap;
     if( line.contains( "remaining" ) ) {
 
         if( !d->writingStarted ) {
@@ -439,10 +441,9 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
         }
 
         // parse progress
-        int pos = line.indexOf( '/' );
-        unsigned long long done = line.left( pos ).toULongLong();
-        bool ok = true;
-        d->overallSizeFromOutput = line.mid( pos+1, line.indexOf( '(', pos ) - pos - 1 ).toULongLong( &ok );
+        bool ok = K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::GrowisofsProgress ).match( line, cap );
+        unsigned long long done = cap.toLongLong( 0 );
+        d->overallSizeFromOutput = cap.toLongLong( 1 );
         if( d->firstSizeFromOutput == -1 )
             d->firstSizeFromOutput = done;
         done -= d->firstSizeFromOutput;
@@ -461,11 +462,9 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
             }
 
             // try parsing write speed (since growisofs 5.11)
-            pos = line.indexOf( '@' );
-            if( pos != -1 ) {
-                pos += 1;
-                double speed = line.mid( pos, line.indexOf( 'x', pos ) - pos ).toDouble(&ok);
-                if (ok) {
+            if( line.contains( '@' ) ) {
+                if( K3b::ProgressMatcher::matcher( K3b::ProgressMatcher::GrowisofsWriteSpeed ).match( line, cap ) ) {
+                    double speed = cap.toDouble( 0 );
                     if (d->lastWritingSpeed != speed) {
                         emit writeSpeed((int)(speed * d->speedMultiplicator()), d->speedMultiplicator());
                     }
@@ -473,7 +472,7 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
                 }
                 else
                     qDebug() << "(K3b::GrowisofsWriter) speed parsing failed: '"
-                             << line.mid( pos, line.indexOf( 'x', pos ) - pos ) << "'" << endl;
+                             << line << "'" << endl;
             }
             else {
                 d->speedEst->dataWritten( done/1024 );
@@ -481,7 +480,7 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
         }
         else
             qDebug() << "(K3b::GrowisofsWriter) progress parsing failed: '"
-                     << line.mid( pos+1, line.indexOf( '(', pos ) - pos - 1 ).trimmed() << "'" << endl;
+                     << line << "'" << endl;
     }
 
     //  else
@@ -25,6 +25,8 @@
 
 #include <QFileInfo>
 #include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 
 
@@ -145,7 +147,13 @@ bool K3b::MixedDoc::loadDocumentData( QDomElement* rootElem )
     if( nodes.item(3).nodeName() != "mixed" )
         return false;
 
-    QDomNodeList optionList = nodes.item(3).childNodes();
+    return loadMixedOptions( nodes.item(3).toElement() );
+}
+
+
+bool K3b::MixedDoc::loadMixedOptions( const QDomElement& mixedElem )
+{
+    QDomNodeList optionList = mixedElem.childNodes();
     for( int i = 0; i < optionList.count(); i++ ) {
 
         QDomElement e = optionList.item(i).toElement();
@@ -171,6 +179,37 @@ bool K3b::MixedDoc::loadDocumentData( QDomElement* rootElem )
 }
 
 
+bool K3b::MixedDoc::loadDocumentStream( QXmlStreamReader& xml )
+{
+    // the data part is streamed, everything else is small enough for DOM
+    QDomDocument doc;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "general" ) )
+        return false;
+    if( !readGeneralDocumentData( readDomElement( xml, doc ) ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "audio" ) )
+        return false;
+    if( !m_audioDoc->loadDocumentStream( xml ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "data" ) )
+        return false;
+    if( !m_dataDoc->loadDocumentStream( xml ) )
+        return false;
+
+    if( !xml.readNextStartElement() || xml.name() != QLatin1String( "mixed" ) )
+        return false;
+    if( !loadMixedOptions( readDomElement( xml, doc ) ) )
+        return false;
+
+    xml.skipCurrentElement();
+
+    return !xml.hasError();
+}
+
+
 bool K3b::MixedDoc::saveDocumentData( QDomElement* docElem )
 {
     QDomDocument doc = docElem->ownerDocument();
@@ -185,8 +224,44 @@ bool K3b::MixedDoc::saveDocumentData( QDomElement* docElem )
     docElem->appendChild( dataElem );
 
     QDomElement mixedElem = doc.createElement( "mixed" );
+    saveMixedOptions( mixedElem );
     docElem->appendChild( mixedElem );
 
+    setModified( false );
+
+    return true;
+}
+
+
+bool K3b::MixedDoc::saveDocumentStream( QXmlStreamWriter& xml )
+{
+    QDomDocument doc;
+    QDomElement sectionsElem = doc.createElement( "sections" );
+    saveGeneralDocumentData( &sectionsElem );
+    writeDomElement( xml, sectionsElem.firstChildElement() );
+
+    xml.writeStartElement( "audio" );
+    m_audioDoc->saveDocumentStream( xml );
+    xml.writeEndElement();
+
+    xml.writeStartElement( "data" );
+    m_dataDoc->saveDocumentStream( xml );
+    xml.writeEndElement();
+
+    QDomElement mixedElem = doc.createElement( "mixed" );
+    saveMixedOptions( mixedElem );
+    writeDomElement( xml, mixedElem );
+
+    setModified( false );
+
+    return !xml.hasError();
+}
+
+
+void K3b::MixedDoc::saveMixedOptions( QDomElement& mixedElem )
+{
+    QDomDocument doc = mixedElem.ownerDocument();
+
     QDomElement bufferFilesElem = doc.createElement( "remove_buffer_files" );
     bufferFilesElem.appendChild( doc.createTextNode( removeImages() ? "yes" : "no" ) );
     mixedElem.appendChild( bufferFilesElem );
@@ -208,10 +283,6 @@ bool K3b::MixedDoc::saveDocumentData( QDomElement* docElem )
         break;
     }
     mixedElem.appendChild( mixedTypeElem );
-
-    setModified( false );
-
-    return true;
 }
 
 
@@ -81,8 +81,13 @@ namespace K3b {
     protected:
         bool loadDocumentData( QDomElement* ) override;
         bool saveDocumentData( QDomElement* ) override;
+        bool loadDocumentStream( QXmlStreamReader& xml ) override;
+        bool saveDocumentStream( QXmlStreamWriter& xml ) override;
 
     private:
+        bool loadMixedOptions( const QDomElement& mixedElem );
+        void saveMixedOptions( QDomElement& mixedElem );
+
         DataDoc* m_dataDoc;
         AudioDoc* m_audioDoc;
 
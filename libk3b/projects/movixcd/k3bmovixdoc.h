@@ -115,6 +115,10 @@ namespace K3b {
         bool loadDocumentData( QDomElement* root ) override;
         /** reimplemented from Doc */
         bool saveDocumentData( QDomElement* ) override;
+        /** reimplemented from DataDoc to use the DOM based loading */
+        bool loadDocumentStream( QXmlStreamReader& xml ) override;
+        /** reimplemented from DataDoc to use the DOM based saving */
+        bool saveDocumentStream( QXmlStreamWriter& xml ) override;
 
     private:
         QList<MovixFileItem*> m_movixFiles;
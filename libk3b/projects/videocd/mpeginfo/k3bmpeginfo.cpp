@@ -15,11 +15,44 @@
 #include "k3bmpeginfo.h"
 #include "k3b_i18n.h"
 
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <string.h>
+#include <sys/stat.h>
+
 #ifdef Q_OS_WIN32
 #define ftello ftell
 #define fseeko fseek
 #endif
 
+namespace {
+    // parsing a big MPEG file takes a while, so remember the results
+    // for the files which have been added before
+    class ParseResult
+    {
+    public:
+        llong size;
+        qint64 mtime;
+        K3b::Mpeginfo info;
+        QString errorString;
+    };
+
+    const int s_maxCachedResults = 256;
+
+    QMutex s_resultCacheMutex;
+    QCache<QByteArray, ParseResult> s_resultCache( s_maxCachedResults );
+
+    qint64 modificationTime( FILE* file )
+    {
+        struct stat st;
+        if( ::fstat( fileno( file ), &st ) )
+            return -1;
+        return st.st_mtime;
+    }
+}
+
 static const double frame_rates[ 16 ] =
 {
     0.0, 24000.0 / 1001, 24.0, 25.0,
@@ -67,10 +100,32 @@ K3b::MpegInfo::MpegInfo( const char* filename )
         return ;
     }
 
+    const qint64 mtime = modificationTime( m_mpegfile );
+    {
+        QMutexLocker locker( &s_resultCacheMutex );
+        if ( ParseResult* result = s_resultCache.object( m_filename ) ) {
+            if ( result->size == m_filesize && result->mtime == mtime ) {
+                *mpeg_info = result->info;
+                m_error_string = result->errorString;
+                return ;
+            }
+        }
+    }
+
     m_buffer = new byte[ BUFFERSIZE ];
 
     MpegParsePacket ( );
 
+    if ( mtime != -1 ) {
+        ParseResult* result = new ParseResult;
+        result->size = m_filesize;
+        result->mtime = mtime;
+        result->info = *mpeg_info;
+        result->errorString = m_error_string;
+
+        QMutexLocker locker( &s_resultCacheMutex );
+        s_resultCache.insert( m_filename, result );
+    }
 }
 
 K3b::MpegInfo::~MpegInfo()
@@ -324,18 +379,22 @@ llong K3b::MpegInfo::MpegParsePacket ( llong offset )
     return offset;
 }
 
+bool K3b::MpegInfo::FillBuffer( llong start )
+{
+    if ( fseeko( m_mpegfile, start, SEEK_SET ) ) {
+        qDebug() << QString( "could not get seek to offset (%1) in file %2 (size:%3)" ).arg( start ).arg( m_filename ).arg( m_filesize );
+        return false;
+    }
+    unsigned long nread = fread( m_buffer, 1, BUFFERSIZE, m_mpegfile );
+    m_buffstart = start;
+    m_buffend = start + nread;
+    return nread > 0;
+}
+
 byte K3b::MpegInfo::GetByte( llong offset )
 {
-    unsigned long nread;
     if ( ( offset >= m_buffend ) || ( offset < m_buffstart ) ) {
-
-        if ( fseeko( m_mpegfile, offset, SEEK_SET ) ) {
-            qDebug() << QString( "could not get seek to offset (%1) in file %2 (size:%3)" ).arg( offset ).arg( m_filename ).arg( m_filesize );
-            return 0x11;
-        }
-        nread = fread( m_buffer, 1, BUFFERSIZE, m_mpegfile );
-        m_buffstart = offset;
-        m_buffend = offset + nread;
+        FillBuffer( offset );
         if ( ( offset >= m_buffend ) || ( offset < m_buffstart ) ) {
             // weird
             qDebug() << QString( "could not get offset %1 in file %2 [%3]" ).arg( offset ).arg( m_filename ).arg( m_filesize );
@@ -348,16 +407,13 @@ byte K3b::MpegInfo::GetByte( llong offset )
 // same as above but improved for backward search
 byte K3b::MpegInfo::bdGetByte( llong offset )
 {
-    unsigned long nread;
     if ( ( offset >= m_buffend ) || ( offset < m_buffstart ) ) {
-        llong start = offset - BUFFERSIZE + 1 ;
+        // keep a few bytes behind the offset so reading a whole start code
+        // does not refill the buffer on every step
+        llong start = offset - BUFFERSIZE + 4 ;
         start = start >= 0 ? start : 0;
 
-        fseeko( m_mpegfile, start, SEEK_SET );
-
-        nread = fread( m_buffer, 1, BUFFERSIZE, m_mpegfile );
-        m_buffstart = start;
-        m_buffend = start + nread;
+        FillBuffer( start );
         if ( ( offset >= m_buffend ) || ( offset < m_buffstart ) ) {
             // weird
             qDebug() << QString( "could not get offset %1 in file %2 [%3]" ).arg( offset ).arg( m_filename ).arg( m_filesize );
@@ -403,14 +459,35 @@ bool K3b::MpegInfo::EnsureMPEG( llong offset, byte mark )
 // find next 0x 00 00 01 xx sequence, returns offset or -1 on err
 llong K3b::MpegInfo::FindNextMarker( llong from )
 {
-    llong offset;
-    for ( offset = from; offset < ( m_filesize - 4 ); offset++ ) {
-        if (
-            ( GetByte( offset + 0 ) == 0x00 ) &&
-            ( GetByte( offset + 1 ) == 0x00 ) &&
-            ( GetByte( offset + 2 ) == 0x01 ) ) {
-            return offset;
+    // the start code needs to be followed by the marker byte
+    const llong end = m_filesize - 4;
+    llong offset = from < 0 ? 0 : from;
+
+    while ( offset < end ) {
+        if ( ( offset < m_buffstart ) || ( offset + 3 > m_buffend ) ) {
+            if ( !FillBuffer( offset ) || m_buffend - offset < 3 )
+                return -1;
+        }
+
+        // search the 0x01 and look back for the two zeros. memchr skips
+        // the bytes in between much faster than comparing them one by one.
+        const llong scanEnd = qMin( m_buffend, end + 2 ) - m_buffstart;
+        llong pos = offset + 2 - m_buffstart;
+        while ( pos < scanEnd ) {
+            const byte* p = static_cast<const byte*>( ::memchr( m_buffer + pos, 0x01, scanEnd - pos ) );
+            if ( !p )
+                break;
+            pos = p - m_buffer;
+            if ( m_buffer[ pos - 1 ] == 0x00 && m_buffer[ pos - 2 ] == 0x00 )
+                return m_buffstart + pos - 2;
+            // the 0x01 cannot be one of the zeros of the next code
+            pos += 3;
         }
+
+        // continue with the last two bytes which may start a code
+        offset = m_buffstart + scanEnd - 2;
+        if ( m_buffstart + scanEnd != m_buffend )
+            break;
     }
     return -1;
 }
@@ -449,29 +526,41 @@ llong K3b::MpegInfo::FindNextMarker( llong from, byte mark )
 
 llong K3b::MpegInfo::bdFindNextMarker( llong from, byte mark )
 {
-    llong offset;
-    for ( offset = from; offset >= 0; offset-- ) {
-        if (
-            ( bdGetByte( offset ) == 0x00 ) &&
-            ( bdGetByte( offset + 1 ) == 0x00 ) &&
-            ( bdGetByte( offset + 2 ) == 0x01 ) &&
-            ( bdGetByte( offset + 3 ) == mark ) ) {
+    llong offset = from;
+    while ( offset >= 0 ) {
+        byte found = 0;
+        offset = bdFindNextMarker( offset, &found );
+        if ( offset < 0 || found == mark )
             return offset;
-        }
+        offset--;
     }
     return -1;
 }
 
 llong K3b::MpegInfo::bdFindNextMarker( llong from, byte* mark )
 {
-    llong offset;
-    for ( offset = from; offset >= 0; offset-- ) {
-        if ( ( bdGetByte( offset ) == 0x00 ) &&
-             ( bdGetByte( offset + 1 ) == 0x00 ) &&
-             ( bdGetByte( offset + 2 ) == 0x01 ) ) {
-            *mark = bdGetByte( offset + 3 );
-            return offset;
+    // codes which do not fit into the file can never match
+    llong offset = qMin( from, m_filesize - 4 );
+    while ( offset >= 0 ) {
+        // load the block ending with the code at offset
+        if ( ( offset < m_buffstart ) || ( offset + 4 > m_buffend ) ) {
+            llong start = offset + 4 - BUFFERSIZE;
+            start = start >= 0 ? start : 0;
+            if ( !FillBuffer( start ) )
+                return -1;
         }
+
+        llong pos = qMin( offset, m_buffend - 4 ) - m_buffstart;
+        for ( ; pos >= 0; pos-- ) {
+            if ( m_buffer[ pos + 2 ] == 0x01 && m_buffer[ pos + 1 ] == 0x00 && m_buffer[ pos ] == 0x00 ) {
+                *mark = m_buffer[ pos + 3 ];
+                return m_buffstart + pos;
+            }
+        }
+
+        if ( m_buffstart == 0 )
+            break;
+        offset = m_buffstart - 1;
     }
     return -1;
 
@@ -18,7 +18,8 @@
 #include <stdio.h>
 
 // #define BUFFERSIZE   16384
-#define BUFFERSIZE   65536
+// #define BUFFERSIZE   65536
+#define BUFFERSIZE   262144
 
 #define MPEG_START_CODE_PATTERN  ((ulong) 0x00000100)
 #define MPEG_START_CODE_MASK     ((ulong) 0xffffff00)
@@ -51,6 +52,8 @@
 typedef unsigned char byte;
 typedef long long llong;
 
+#include "k3b_export.h"
+
 #include <QDebug>
 
 namespace K3b {
@@ -117,7 +120,7 @@ namespace K3b {
         audio_info audio[ 3 ];
     };
 
-    class MpegInfo
+    class LIBK3B_EXPORT MpegInfo
     {
     public:
         explicit MpegInfo( const char* filename );
@@ -138,6 +141,7 @@ namespace K3b {
 
     private:
         //  General ToolBox
+        bool FillBuffer( llong start );
         byte GetByte( llong offset );
         byte bdGetByte( llong offset );
         llong GetNBytes( llong, int );
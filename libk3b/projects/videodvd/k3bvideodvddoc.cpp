@@ -79,4 +79,10 @@ bool K3b::VideoDvdDoc::saveDocumentData(QDomElement*)
     return true;
 }
 
+bool K3b::VideoDvdDoc::saveDocumentStream( QXmlStreamWriter& xml )
+{
+    // go through saveDocumentData() like before
+    return K3b::Doc::saveDocumentStream( xml );
+}
+
 //#include "k3bdvddoc.moc"
@@ -38,6 +38,7 @@ namespace K3b {
 
         // TODO: implement load- and saveDocumentData since we do not need all those options
         bool saveDocumentData(QDomElement*) override;
+        bool saveDocumentStream( QXmlStreamWriter& xml ) override;
 
     private:
         DirItem* m_videoTsDir;
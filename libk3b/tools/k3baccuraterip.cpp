@@ -0,0 +1,558 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3baccuraterip.h"
+
+#include "k3btoc.h"
+#include "k3btrack.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <string.h>
+
+
+namespace {
+    const int s_samplesPerSector = 588;
+
+    // AccurateRip ignores the first and last five sectors of the disc
+    const qint64 s_skippedSamples = 5*s_samplesPerSector;
+
+    // the gap between the audio session and the data track of an enhanced CD
+    const long s_sessionGap = 11400;
+
+    quint32 s_crcTable[256];
+
+    void initCrcTable()
+    {
+        static bool s_initialized = false;
+        if( s_initialized )
+            return;
+
+        for( quint32 i = 0; i < 256; ++i ) {
+            quint32 c = i;
+            for( int k = 0; k < 8; ++k )
+                c = ( c & 1 ) ? ( 0xEDB88320U ^ ( c >> 1 ) ) : ( c >> 1 );
+            s_crcTable[i] = c;
+        }
+        s_initialized = true;
+    }
+
+    quint32 fromLittleEndian( const uchar* p )
+    {
+        return quint32( p[0] ) | quint32( p[1] ) << 8 | quint32( p[2] ) << 16 | quint32( p[3] ) << 24;
+    }
+
+    QString formatDiscId( int tracks, quint32 id1, quint32 id2, quint32 cddbId )
+    {
+        return QString::fromLatin1( "%1-%2-%3-%4" )
+            .arg( tracks, 3, 10, QChar( '0' ) )
+            .arg( id1, 8, 16, QChar( '0' ) )
+            .arg( id2, 8, 16, QChar( '0' ) )
+            .arg( cddbId, 8, 16, QChar( '0' ) );
+    }
+}
+
+
+class K3b::AccurateRipChecksum::Private
+{
+public:
+    struct TrackSum {
+        int tocTrack;
+        qint64 start;
+        qint64 end;
+        qint64 checkStart;
+        qint64 checkEnd;
+        quint32 sumLow;
+        quint32 sumHigh;
+        quint32 crc;
+        qint64 crcPos;
+        bool crcValid;
+        qint64 added;
+    };
+
+    void reset( TrackSum& t ) {
+        t.sumLow = t.sumHigh = 0;
+        t.crc = 0xFFFFFFFFU;
+        t.crcPos = t.start;
+        t.crcValid = true;
+        t.added = 0;
+    }
+
+    int trackAt( qint64 pos ) {
+        if( lastTrack >= 0 && tracks[lastTrack].start <= pos && pos < tracks[lastTrack].end )
+            return lastTrack;
+        for( int i = 0; i < tracks.count(); ++i ) {
+            if( tracks[i].start <= pos && pos < tracks[i].end )
+                return ( lastTrack = i );
+        }
+        return -1;
+    }
+
+    const TrackSum* track( int tocTrack ) const {
+        if( tocTrack > 0 && tocTrack <= audioIndex.count() && audioIndex[tocTrack-1] >= 0 )
+            return &tracks[audioIndex[tocTrack-1]];
+        return 0;
+    }
+
+    QVector<TrackSum> tracks;
+    QVector<int> audioIndex;
+    int lastTrack;
+    int readOffset;
+    QString discId;
+};
+
+
+K3b::AccurateRipChecksum::AccurateRipChecksum( const Device::Toc& toc )
+    : d( new Private() )
+{
+    initCrcTable();
+
+    d->lastTrack = -1;
+    d->readOffset = 0;
+
+    quint32 id1 = 0;
+    quint32 id2 = 0;
+    long leadOut = 0;
+    for( int i = 0; i < toc.count(); ++i ) {
+        const Device::Track& track = toc[i];
+        if( track.type() != Device::Track::TYPE_AUDIO ) {
+            // the data track of an enhanced CD marks the end of the audio session
+            if( !d->tracks.isEmpty() && leadOut > track.firstSector().lba() - s_sessionGap )
+                leadOut = track.firstSector().lba() - s_sessionGap;
+            d->audioIndex.append( -1 );
+            continue;
+        }
+
+        Private::TrackSum sum;
+        sum.tocTrack = i+1;
+        sum.start = qint64( track.firstSector().lba() ) * s_samplesPerSector;
+        sum.end = qint64( track.lastSector().lba() + 1 ) * s_samplesPerSector;
+        d->audioIndex.append( d->tracks.count() );
+        d->tracks.append( sum );
+
+        const quint32 offset = track.firstSector().lba();
+        id1 += offset;
+        id2 += qMax( offset, quint32( 1 ) ) * quint32( d->tracks.count() );
+        leadOut = track.lastSector().lba() + 1;
+    }
+
+    if( !d->tracks.isEmpty() ) {
+        d->tracks.last().end = qMin( d->tracks.last().end, qint64( leadOut ) * s_samplesPerSector );
+
+        id1 += leadOut;
+        id2 += quint32( leadOut ) * quint32( d->tracks.count() + 1 );
+    }
+
+    for( int i = 0; i < d->tracks.count(); ++i ) {
+        Private::TrackSum& t = d->tracks[i];
+        // the multiplier range of the samples which are summed up. Like the
+        // AccurateRip reference the multiplier starts at 1 and the first track
+        // is summed from 5*588 on, the last one up to its length minus 5*588.
+        t.checkStart = ( i == 0 ? s_skippedSamples : 0 );
+        t.checkEnd = ( i == d->tracks.count()-1 ? t.end - t.start - s_skippedSamples : t.end - t.start );
+        d->reset( t );
+    }
+
+    d->discId = formatDiscId( d->tracks.count(), id1, id2, toc.discId() );
+}
+
+
+K3b::AccurateRipChecksum::~AccurateRipChecksum()
+{
+    delete d;
+}
+
+
+void K3b::AccurateRipChecksum::setReadOffset( int samples )
+{
+    d->readOffset = samples;
+}
+
+
+int K3b::AccurateRipChecksum::readOffset() const
+{
+    return d->readOffset;
+}
+
+
+QString K3b::AccurateRipChecksum::discId() const
+{
+    return d->discId;
+}
+
+
+int K3b::AccurateRipChecksum::audioTrackCount() const
+{
+    return d->tracks.count();
+}
+
+
+int K3b::AccurateRipChecksum::audioTrackNumber( int track ) const
+{
+    if( track > 0 && track <= d->audioIndex.count() )
+        return d->audioIndex[track-1] + 1;
+    return 0;
+}
+
+
+void K3b::AccurateRipChecksum::addSamples( qint64 position, const char* data, int samples, bool bigEndian )
+{
+    static const uchar s_silence[4] = { 0, 0, 0, 0 };
+
+    for( int i = 0; i < samples; ) {
+        const qint64 pos = position + i;
+        const int index = d->trackAt( pos );
+        if( index < 0 ) {
+            // not part of any audio track
+            ++i;
+            continue;
+        }
+
+        Private::TrackSum& t = d->tracks[index];
+        const int n = int( qMin( qint64( samples - i ), t.end - pos ) );
+
+        if( t.crcPos != pos )
+            t.crcValid = false;
+
+        quint32 low = t.sumLow;
+        quint32 high = t.sumHigh;
+        quint32 crc = t.crc;
+        quint64 multiplier = pos - t.start + 1;
+        for( int j = 0; j < n; ++j, ++multiplier ) {
+            uchar sample[4];
+            const uchar* p = data ? reinterpret_cast<const uchar*>( data ) + 4*( i+j ) : s_silence;
+            if( bigEndian ) {
+                sample[0] = p[1];
+                sample[1] = p[0];
+                sample[2] = p[3];
+                sample[3] = p[2];
+            }
+            else {
+                ::memcpy( sample, p, 4 );
+            }
+
+            if( qint64( multiplier ) >= t.checkStart && qint64( multiplier ) <= t.checkEnd ) {
+                const quint64 product = quint64( fromLittleEndian( sample ) ) * multiplier;
+                low += quint32( product );
+                high += quint32( product >> 32 );
+            }
+
+            for( int k = 0; k < 4; ++k )
+                crc = s_crcTable[( crc ^ sample[k] ) & 0xFF] ^ ( crc >> 8 );
+        }
+
+        t.sumLow = low;
+        t.sumHigh = high;
+        t.crc = crc;
+        t.crcPos = pos + n;
+        t.added += n;
+        i += n;
+    }
+}
+
+
+void K3b::AccurateRipChecksum::addSector( long lba, const char* data, bool bigEndian )
+{
+    if( d->tracks.isEmpty() )
+        return;
+
+    const qint64 first = d->tracks.first().start;
+    const qint64 end = d->tracks.last().end;
+    const qint64 pos = qint64( lba ) * s_samplesPerSector - d->readOffset;
+
+    // samples before the start of the disc cannot be read
+    if( d->readOffset < 0 && pos + d->readOffset == first )
+        addSamples( first, 0, -d->readOffset );
+
+    addSamples( pos, data, s_samplesPerSector, bigEndian );
+
+    // neither can those after its end
+    if( d->readOffset > 0 && pos + d->readOffset + s_samplesPerSector == end )
+        addSamples( end - d->readOffset, 0, d->readOffset );
+}
+
+
+void K3b::AccurateRipChecksum::resetTrack( int track )
+{
+    if( track > 0 && track <= d->audioIndex.count() && d->audioIndex[track-1] >= 0 )
+        d->reset( d->tracks[d->audioIndex[track-1]] );
+}
+
+
+bool K3b::AccurateRipChecksum::isComplete( int track ) const
+{
+    const Private::TrackSum* t = d->track( track );
+    return t && t->added >= t->end - t->start;
+}
+
+
+quint32 K3b::AccurateRipChecksum::checksumV1( int track ) const
+{
+    const Private::TrackSum* t = d->track( track );
+    return t ? t->sumLow : 0;
+}
+
+
+quint32 K3b::AccurateRipChecksum::checksumV2( int track ) const
+{
+    const Private::TrackSum* t = d->track( track );
+    return t ? t->sumLow + t->sumHigh : 0;
+}
+
+
+quint32 K3b::AccurateRipChecksum::crc32( int track ) const
+{
+    const Private::TrackSum* t = d->track( track );
+    return ( t && t->crcValid ) ? ~t->crc : 0;
+}
+
+
+bool K3b::AccurateRipChecksum::crc32Valid( int track ) const
+{
+    const Private::TrackSum* t = d->track( track );
+    return t && t->crcValid;
+}
+
+
+
+class K3b::AccurateRipDatabase::Private
+{
+public:
+    enum Type {
+        AccurateRip,
+        Crc32
+    };
+
+    struct Entry {
+        int track;
+        Type type;
+        quint32 checksum;
+        int confidence;
+    };
+
+    void merge( const QString& discId, const Entry& entry ) {
+        QList<Entry>& list = entries[discId];
+        for( int i = 0; i < list.count(); ++i ) {
+            // response files are snapshots, importing one again must not add up
+            if( list[i].track == entry.track && list[i].type == entry.type && list[i].checksum == entry.checksum ) {
+                list[i].confidence = qMax( list[i].confidence, entry.confidence );
+                return;
+            }
+        }
+        list.append( entry );
+    }
+
+    int readText( QIODevice* dev ) {
+        int count = 0;
+        QTextStream s( dev );
+        while( !s.atEnd() ) {
+            const QString line = s.readLine().trimmed();
+            if( line.isEmpty() || line.startsWith( '#' ) )
+                continue;
+
+            const QStringList fields = line.split( ' ', QString::SkipEmptyParts );
+            bool ok = ( fields.count() == 5 );
+            Entry entry;
+            if( ok ) {
+                bool trackOk = false, sumOk = false, confOk = false;
+                entry.track = fields[1].toInt( &trackOk );
+                entry.checksum = fields[3].toUInt( &sumOk, 16 );
+                entry.confidence = fields[4].toInt( &confOk );
+                entry.type = ( fields[2] == QLatin1String( "crc32" ) ? Crc32 : AccurateRip );
+                ok = trackOk && sumOk && confOk && ( entry.type == Crc32 || fields[2] == QLatin1String( "ar" ) );
+            }
+
+            if( !ok ) {
+                qDebug() << "(K3b::AccurateRipDatabase) invalid line:" << line;
+                continue;
+            }
+
+            merge( fields[0], entry );
+            ++count;
+        }
+        return count;
+    }
+
+    //
+    // An AccurateRip response consists of one chunk per submission:
+    // track count (1 byte), disc id 1, disc id 2 and CDDB id (4 bytes each),
+    // followed by confidence (1 byte), checksum and frame 450 checksum
+    // (4 bytes each) for every track. All numbers are little endian.
+    //
+    int readResponse( const QByteArray& data ) {
+        int count = 0;
+        const uchar* p = reinterpret_cast<const uchar*>( data.constData() );
+        int pos = 0;
+        while( pos + 13 <= data.size() ) {
+            const int tracks = p[pos];
+            const QString discId = formatDiscId( tracks,
+                                                 fromLittleEndian( p + pos + 1 ),
+                                                 fromLittleEndian( p + pos + 5 ),
+                                                 fromLittleEndian( p + pos + 9 ) );
+            pos += 13;
+            if( pos + 9*tracks > data.size() ) {
+                qDebug() << "(K3b::AccurateRipDatabase) truncated response for" << discId;
+                return -1;
+            }
+
+            for( int i = 0; i < tracks; ++i, pos += 9 ) {
+                Entry entry;
+                entry.track = i+1;
+                entry.type = AccurateRip;
+                entry.confidence = p[pos];
+                entry.checksum = fromLittleEndian( p + pos + 1 );
+                merge( discId, entry );
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    QString filename;
+    QHash<QString, QList<Entry> > entries;
+};
+
+
+K3b::AccurateRipDatabase::AccurateRipDatabase( const QString& filename )
+    : d( new Private() )
+{
+    d->filename = filename;
+}
+
+
+K3b::AccurateRipDatabase::~AccurateRipDatabase()
+{
+    delete d;
+}
+
+
+QString K3b::AccurateRipDatabase::defaultFilename()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::GenericDataLocation ) + "/k3b/accuraterip.db";
+}
+
+
+QString K3b::AccurateRipDatabase::filename() const
+{
+    return d->filename;
+}
+
+
+bool K3b::AccurateRipDatabase::load()
+{
+    d->entries.clear();
+
+    QFile f( d->filename );
+    if( !f.exists() )
+        return true;
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        qDebug() << "(K3b::AccurateRipDatabase) could not open" << d->filename;
+        return false;
+    }
+
+    d->readText( &f );
+    qDebug() << "(K3b::AccurateRipDatabase) loaded" << d->entries.count() << "discs.";
+    return true;
+}
+
+
+bool K3b::AccurateRipDatabase::save() const
+{
+    QDir().mkpath( QFileInfo( d->filename ).absolutePath() );
+
+    QSaveFile f( d->filename );
+    if( !f.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QTextStream s( &f );
+    s << "# K3b track checksum database" << endl
+      << "# <disc id> <track> ar|crc32 <checksum> <confidence>" << endl;
+
+    QStringList discs = d->entries.keys();
+    discs.sort();
+    Q_FOREACH( const QString& disc, discs ) {
+        Q_FOREACH( const Private::Entry& entry, d->entries[disc] ) {
+            s << disc << ' ' << entry.track << ' '
+              << ( entry.type == Private::Crc32 ? "crc32" : "ar" ) << ' '
+              << QString::fromLatin1( "%1" ).arg( entry.checksum, 8, 16, QChar( '0' ) ) << ' '
+              << entry.confidence << endl;
+        }
+    }
+
+    s.flush();
+    return f.commit();
+}
+
+
+int K3b::AccurateRipDatabase::importFile( const QString& filename )
+{
+    QFile f( filename );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return -1;
+
+    const QString name = QFileInfo( filename ).fileName();
+    if( name.startsWith( QLatin1String( "dBAR" ) ) || name.endsWith( QLatin1String( ".bin" ) ) )
+        return d->readResponse( f.readAll() );
+    else
+        return d->readText( &f );
+}
+
+
+bool K3b::AccurateRipDatabase::contains( const QString& discId ) const
+{
+    return d->entries.contains( discId );
+}
+
+
+int K3b::AccurateRipDatabase::confidence( const AccurateRipChecksum& sum, int track ) const
+{
+    QHash<QString, QList<Private::Entry> >::const_iterator it = d->entries.constFind( sum.discId() );
+    if( it == d->entries.constEnd() )
+        return -1;
+
+    const int number = sum.audioTrackNumber( track );
+    if( number <= 0 || !sum.isComplete( track ) )
+        return 0;
+
+    int confidence = 0;
+    Q_FOREACH( const Private::Entry& entry, *it ) {
+        if( entry.track != number )
+            continue;
+
+        bool match = false;
+        if( entry.type == Private::AccurateRip )
+            match = ( entry.checksum == sum.checksumV1( track ) || entry.checksum == sum.checksumV2( track ) );
+        else
+            match = ( sum.crc32Valid( track ) && entry.checksum == sum.crc32( track ) );
+
+        if( match )
+            confidence = qMax( confidence, qMax( entry.confidence, 1 ) );
+    }
+
+    return confidence;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_ACCURATE_RIP_H_
+#define _K3B_ACCURATE_RIP_H_
+
+#include "k3b_export.h"
+
+#include <QString>
+
+
+namespace K3b {
+    namespace Device {
+        class Toc;
+    }
+
+    /**
+     * Computes the AccurateRip v1 and v2 checksums and a CRC32 of every
+     * audio track of a disc while it is being ripped.
+     *
+     * Samples are added with their position on the disc. The positions
+     * are corrected by the read offset, so data read across a track boundary
+     * is accounted to the track it belongs to. The AccurateRip checksums do
+     * not depend on the order of the samples; the CRC32 of a track is only
+     * valid if its samples were added in order.
+     *
+     * The CRC32 covers all samples of a track like the copy CRC of other
+     * secure rippers. It is used for databases which store plain track
+     * CRCs instead of AccurateRip checksums.
+     */
+    class LIBK3B_EXPORT AccurateRipChecksum
+    {
+    public:
+        explicit AccurateRipChecksum( const Device::Toc& toc );
+        ~AccurateRipChecksum();
+
+        /**
+         * Read offset of the drive in samples, see Device::Device::readOffset().
+         * Only used by addSector().
+         */
+        void setReadOffset( int samples );
+        int readOffset() const;
+
+        /**
+         * The AccurateRip disc id in the form used for the names of the
+         * AccurateRip response files: "TTT-xxxxxxxx-xxxxxxxx-xxxxxxxx".
+         */
+        QString discId() const;
+
+        /**
+         * The number of audio tracks taken into account.
+         */
+        int audioTrackCount() const;
+
+        /**
+         * The number of \p track among the audio tracks as used by AccurateRip.
+         * Track numbers are those of the Toc starting at 1.
+         *
+         * \return 0 if \p track is no audio track.
+         */
+        int audioTrackNumber( int track ) const;
+
+        /**
+         * Add samples which have already been corrected for the read offset.
+         *
+         * \param position The position of the first sample on the disc,
+         *                 i.e. the sector multiplied by 588.
+         * \param data 16 bit stereo samples. Pass 0 to add silence.
+         */
+        void addSamples( qint64 position, const char* data, int samples, bool bigEndian = false );
+
+        /**
+         * Add a sector as returned by the drive when reading sector \p lba.
+         * The read offset is applied. Since drives cannot read before the
+         * first or after the last audio sector, silence is added for the
+         * samples which the read offset moves out of that range.
+         */
+        void addSector( long lba, const char* data, bool bigEndian = false );
+
+        /**
+         * Forget everything added for \p track. Used before ripping it again.
+         */
+        void resetTrack( int track );
+
+        /**
+         * \return true once all samples of \p track have been added.
+         */
+        bool isComplete( int track ) const;
+
+        quint32 checksumV1( int track ) const;
+        quint32 checksumV2( int track ) const;
+
+        /**
+         * \return The CRC32 of the track. 0 if its samples were not added in order.
+         */
+        quint32 crc32( int track ) const;
+        bool crc32Valid( int track ) const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AccurateRipChecksum )
+    };
+
+
+    /**
+     * A local database of track checksums.
+     *
+     * The database is a text file with one checksum per line:
+     * \code
+     * <disc id> <track> ar|crc32 <checksum> <confidence>
+     * \endcode
+     * where the disc id is the one of AccurateRipChecksum::discId() and the
+     * track is counted among the audio tracks of the disc. No network access
+     * is done. Instead importFile() merges AccurateRip response files
+     * (dBAR-*.bin) and other database files into it.
+     */
+    class LIBK3B_EXPORT AccurateRipDatabase
+    {
+    public:
+        explicit AccurateRipDatabase( const QString& filename = defaultFilename() );
+        ~AccurateRipDatabase();
+
+        static QString defaultFilename();
+        QString filename() const;
+
+        bool load();
+        bool save() const;
+
+        /**
+         * Merges an AccurateRip response file or another database file.
+         *
+         * \return The number of checksums imported or -1 if the file
+         *         could not be read.
+         */
+        int importFile( const QString& filename );
+
+        /**
+         * \return true if the database has checksums for the disc.
+         */
+        bool contains( const QString& discId ) const;
+
+        /**
+         * Compares the checksums of \p track with the database.
+         *
+         * \return The highest confidence of a matching checksum, 0 if
+         *         none matches and -1 if the disc is not in the database.
+         */
+        int confidence( const AccurateRipChecksum& sum, int track ) const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AccurateRipDatabase )
+    };
+}
+
+#endif
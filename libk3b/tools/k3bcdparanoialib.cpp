@@ -28,6 +28,8 @@
 #include <QMutex>
 #include <QMutexLocker>
 
+#include <string.h>
+
 #ifdef Q_OS_WIN32
 typedef short int int16_t;
 #endif
@@ -148,6 +150,13 @@ extern "C" {
     long (*cdda_paranoia_seek)(cdrom_paranoia *p,long seek,int mode);
 }
 
+// audio data plus one C2 error bit for every byte
+#define C2_SECTOR_SIZE (CD_FRAMESIZE_RAW+294)
+
+// sectors read at once in the C2 fast path
+#define C2_READ_BLOCK 26
+
+
 // from cdda_paranoia.h
 #define PARANOIA_MODE_FULL        0xff
 #define PARANOIA_MODE_DISABLE     0
@@ -183,6 +192,17 @@ namespace K3b {
         long lastSector( int );
         long sector() const { return m_currentSector; }
 
+        /**
+         * Read audio sectors with C2 error pointers, C2_SECTOR_SIZE bytes each.
+         */
+        bool readC2( unsigned char* buffer, long start, int sectors );
+
+        /**
+         * Checks once per drive whether its C2 pointers can be trusted.
+         * The sectors between start and end are used for testing.
+         */
+        bool c2Reliable( long start, long end );
+
         static CdparanoiaLibData* data( Device::Device* dev )
         {
             QMap<Device::Device*, CdparanoiaLibData*>::const_iterator it = s_dataMap.constFind( dev );
@@ -207,10 +227,17 @@ namespace K3b {
             : m_device(dev),
               m_drive(0),
               m_paranoia(0),
-              m_currentSector(0)
+              m_currentSector(0),
+              m_c2State(C2_UNKNOWN)
         {
         }
 
+        enum C2State {
+            C2_UNKNOWN,
+            C2_UNRELIABLE,
+            C2_RELIABLE
+        };
+
         //
         // We have exactly one instance of CdparanoiaLibData per device
         //
@@ -223,6 +250,8 @@ namespace K3b {
 
         long m_currentSector;
 
+        C2State m_c2State;
+
         QMutex m_mutex;
     };
 }
@@ -319,6 +348,76 @@ long K3b::CdparanoiaLibData::lastSector( int track )
 }
 
 
+bool K3b::CdparanoiaLibData::readC2( unsigned char* buffer, long start, int sectors )
+{
+    QMutexLocker locker( &m_mutex );
+    return m_device->readCd( buffer, sectors*C2_SECTOR_SIZE,
+                             1,     // CD-DA
+                             false, // no dap
+                             start,
+                             sectors,
+                             false, // no sync
+                             false, // no header
+                             false, // no subheader
+                             true,  // user data
+                             false, // no edc/ecc
+                             1,     // one C2 bit per byte
+                             0 );   // no subchannel
+}
+
+
+bool K3b::CdparanoiaLibData::c2Reliable( long start, long end )
+{
+    if( m_c2State != C2_UNKNOWN )
+        return m_c2State == C2_RELIABLE;
+
+    m_c2State = C2_UNRELIABLE;
+
+    if( !m_device->supportsC2ErrorPointers() ) {
+        qDebug() << "(K3b::CdparanoiaLibData)" << m_device->blockDeviceName() << "does not report C2 errors.";
+        return false;
+    }
+
+    //
+    // Read the same sectors twice with a read of a distant area in between
+    // to get them from the medium again instead of the drive cache. Sectors
+    // which are reported error-free both times have to be identical, otherwise
+    // the C2 reporting of the drive cannot be trusted.
+    //
+    const int sectors = qMin( long( C2_READ_BLOCK ), end - start + 1 );
+    const long distant = qMax( start, end - 8*C2_READ_BLOCK );
+    const int distantSectors = qMin( long( 8*C2_READ_BLOCK ), end - distant + 1 );
+    if( sectors <= 0 )
+        return false;
+
+    QByteArray first( sectors*C2_SECTOR_SIZE, 0 );
+    QByteArray second( sectors*C2_SECTOR_SIZE, 0 );
+    QByteArray scratch( distantSectors*C2_SECTOR_SIZE, 0 );
+    if( !readC2( reinterpret_cast<unsigned char*>( first.data() ), start, sectors ) ||
+        !readC2( reinterpret_cast<unsigned char*>( scratch.data() ), distant, distantSectors ) ||
+        !readC2( reinterpret_cast<unsigned char*>( second.data() ), start, sectors ) ) {
+        qDebug() << "(K3b::CdparanoiaLibData)" << m_device->blockDeviceName() << "failed to read with C2 pointers.";
+        return false;
+    }
+
+    const QByteArray noErrors( 294, 0 );
+    for( int i = 0; i < sectors; ++i ) {
+        const char* a = first.constData() + i*C2_SECTOR_SIZE;
+        const char* b = second.constData() + i*C2_SECTOR_SIZE;
+        if( ::memcmp( a + CD_FRAMESIZE_RAW, noErrors.constData(), 294 ) == 0 &&
+            ::memcmp( b + CD_FRAMESIZE_RAW, noErrors.constData(), 294 ) == 0 &&
+            ::memcmp( a, b, CD_FRAMESIZE_RAW ) != 0 ) {
+            qDebug() << "(K3b::CdparanoiaLibData)" << m_device->blockDeviceName() << "reports wrong C2 pointers.";
+            return false;
+        }
+    }
+
+    qDebug() << "(K3b::CdparanoiaLibData)" << m_device->blockDeviceName() << "reports usable C2 pointers.";
+    m_c2State = C2_RELIABLE;
+    return true;
+}
+
+
 long K3b::CdparanoiaLibData::paranoiaSeek( long sector, int mode )
 {
     if( m_paranoia ) {
@@ -344,9 +443,36 @@ public:
           paranoiaLevel(0),
           neverSkip(true),
           maxRetries(5),
+          useC2(false),
+          c2Checked(false),
+          c2Active(false),
+          c2BufferStart(0),
+          c2BufferSectors(0),
+          paranoiaSectors(0),
           data(0) {
     }
 
+    // returns 0 if the sector has to be read via paranoia
+    char* readC2( long sector ) {
+        if( sector < c2BufferStart || sector >= c2BufferStart + c2BufferSectors ) {
+            c2BufferStart = sector;
+            c2BufferSectors = int( qMin( long( C2_READ_BLOCK ), lastSector - sector + 1 ) );
+            c2Buffer.resize( c2BufferSectors*C2_SECTOR_SIZE );
+            if( !data->readC2( reinterpret_cast<unsigned char*>( c2Buffer.data() ), c2BufferStart, c2BufferSectors ) ) {
+                // flag the whole block so it is not read again for every sector
+                c2Buffer.fill( char( 0xff ) );
+            }
+        }
+
+        char* sectorData = c2Buffer.data() + ( sector - c2BufferStart )*C2_SECTOR_SIZE;
+        const char* c2 = sectorData + CD_FRAMESIZE_RAW;
+        for( int i = 0; i < 294; ++i ) {
+            if( c2[i] )
+                return 0;
+        }
+        return sectorData;
+    }
+
     ~Private() {
     }
 
@@ -387,6 +513,14 @@ public:
     bool neverSkip;
     int maxRetries;
 
+    bool useC2;
+    bool c2Checked;
+    bool c2Active;
+    QByteArray c2Buffer;
+    long c2BufferStart;
+    int c2BufferSectors;
+    long paranoiaSectors;
+
     K3b::CdparanoiaLibData* data;
 };
 
@@ -695,6 +829,13 @@ bool K3b::CdparanoiaLib::initReading( long start, long end )
 
             // let the paranoia stuff point to the startSector
             d->data->paranoiaSeek( start, SEEK_SET );
+
+            // the settings may still change before the first read
+            d->c2Checked = false;
+            d->c2Active = false;
+            d->c2BufferSectors = 0;
+            d->paranoiaSectors = 0;
+
             return true;
         }
         else {
@@ -715,12 +856,46 @@ char* K3b::CdparanoiaLib::read( int* statusCode, unsigned int* track, bool littl
         qDebug() << "(K3b::CdparanoiaLib) finished ripping. read "
                  << (d->currentSector - d->startSector) << " sectors." << endl
                  << "                   current sector: " << d->currentSector << endl;
+        if( d->c2Active )
+            qDebug() << "(K3b::CdparanoiaLib)" << d->paranoiaSectors << "sectors flagged by C2 were read via paranoia.";
         d->status = S_OK;
         if( statusCode )
             *statusCode = d->status;
         return 0;
     }
 
+    //
+    // Clean sectors come straight from the drive. READ CD returns
+    // little endian samples.
+    //
+    if( !d->c2Checked ) {
+        d->c2Active = ( d->useC2 && d->paranoiaLevel > 0 &&
+                        d->data->c2Reliable( d->startSector, d->lastSector ) );
+        d->c2Checked = true;
+    }
+    if( d->c2Active ) {
+        if( char* c2Data = d->readC2( d->currentSector ) ) {
+            if( !littleEndian ) {
+                for( int i = 0; i < CD_FRAMESIZE_RAW-1; i+=2 )
+                    qSwap( c2Data[i], c2Data[i+1] );
+            }
+
+            d->status = S_OK;
+            if( statusCode )
+                *statusCode = d->status;
+            if( track )
+                *track = d->currentTrack;
+
+            d->currentSector++;
+            if( d->toc[d->currentTrack-1].lastSector() < d->currentSector )
+                d->currentTrack++;
+
+            return c2Data;
+        }
+
+        ++d->paranoiaSectors;
+    }
+
     if( d->currentSector != d->data->sector() ) {
         qDebug() << "(K3b::CdparanoiaLib) need to seek before read. Looks as if we are reusing the paranoia instance.";
         if( d->data->paranoiaSeek( d->currentSector, SEEK_SET ) == -1 )
@@ -804,3 +979,15 @@ void K3b::CdparanoiaLib::setMaxRetries( int r )
 {
     d->maxRetries = r;
 }
+
+
+void K3b::CdparanoiaLib::setUseC2Pointers( bool b )
+{
+    d->useC2 = b;
+}
+
+
+long K3b::CdparanoiaLib::paranoiaSectors() const
+{
+    return d->paranoiaSectors;
+}
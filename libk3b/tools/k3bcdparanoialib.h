@@ -78,6 +78,22 @@ namespace K3b {
         /** default: 5 */
         void setMaxRetries( int );
 
+        /**
+         * Read with C2 error pointers at full drive speed and only use
+         * paranoia for sectors the drive flags as erroneous. This is only
+         * done with paranoia modes above 0 and if the drive passed a one-time
+         * check of its C2 reporting. Otherwise all data is read via paranoia.
+         *
+         * default: false
+         */
+        void setUseC2Pointers( bool b );
+
+        /**
+         * The number of sectors which were read via paranoia although
+         * C2 pointers were used. Only valid after initReading().
+         */
+        long paranoiaSectors() const;
+
         /**
          * This will read the Toc and initialize some stuff.
          * It will also call paranoiaInit( const QString& )
@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bfanoutpipe.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <string.h>
+
+
+namespace {
+    const int s_defaultBufferSize = 32*1024*1024;
+
+    // the source is read in chunks of this size
+    const int s_pumpChunkSize = 256*1024;
+
+    // a sink hands back its part of the buffer at least this often
+    const qint64 s_maxSinkWrite = 1024*1024;
+}
+
+
+class K3b::FanOutPipe::Private
+{
+public:
+    class SinkThread : public QThread
+    {
+    public:
+        SinkThread( Private* d, int index )
+            : m_d( d ),
+              m_index( index ) {
+        }
+
+        void run() override {
+            m_d->feedSink( m_index );
+        }
+
+    private:
+        Private* m_d;
+        int m_index;
+    };
+
+
+    class PumpThread : public QThread
+    {
+    public:
+        explicit PumpThread( Private* d )
+            : m_d( d ) {
+        }
+
+        void run() override {
+            m_d->pumpSource();
+        }
+
+    private:
+        Private* m_d;
+    };
+
+
+    struct Sink {
+        QIODevice* device;
+        bool closeDevice;
+        quint64 readPos;
+        quint64 bytesWritten;
+        bool failed;
+        bool done;
+    };
+
+
+    Private( FanOutPipe* pipe )
+        : q( pipe ),
+          source( 0 ),
+          closeSource( false ),
+          bufferSize( s_defaultBufferSize ),
+          ring( 0 ),
+          writePos( 0 ),
+          endOfStream( false ),
+          aborted( false ),
+          runningSinks( 0 ),
+          pumpRunning( false ),
+          md5( QCryptographicHash::Md5 ),
+          pump( this ) {
+    }
+
+    // call with the mutex held
+    quint64 minReadPos() const {
+        quint64 pos = writePos;
+        for( int i = 0; i < sinks.count(); ++i ) {
+            if( !sinks[i].failed && !sinks[i].done )
+                pos = qMin( pos, sinks[i].readPos );
+        }
+        return pos;
+    }
+
+    // call with the mutex held
+    bool hasActiveSinks() const {
+        for( int i = 0; i < sinks.count(); ++i ) {
+            if( !sinks[i].failed && !sinks[i].done )
+                return true;
+        }
+        return false;
+    }
+
+    qint64 write( const char* data, qint64 len ) {
+        md5.addData( data, len );
+
+        qint64 done = 0;
+        QMutexLocker locker( &mutex );
+        while( done < len ) {
+            if( aborted || endOfStream || !hasActiveSinks() )
+                return -1;
+
+            const qint64 space = bufferSize - qint64( writePos - minReadPos() );
+            if( space <= 0 ) {
+                spaceAvailable.wait( &mutex );
+                continue;
+            }
+
+            const int offset = int( writePos % bufferSize );
+            const qint64 n = qMin( qMin( space, len - done ), qint64( bufferSize - offset ) );
+
+            // no sink reads the free part of the buffer and we are the only writer
+            locker.unlock();
+            ::memcpy( ring + offset, data + done, n );
+            locker.relock();
+
+            writePos += n;
+            done += n;
+            dataAvailable.wakeAll();
+        }
+
+        return len;
+    }
+
+    void finishStream() {
+        QMutexLocker locker( &mutex );
+        if( !endOfStream ) {
+            endOfStream = true;
+            checksum = md5.result().toHex();
+            dataAvailable.wakeAll();
+        }
+    }
+
+    void feedSink( int index ) {
+        Sink& sink = sinks[index];
+        QString errorString;
+        bool failedWriting = false;
+
+        QMutexLocker locker( &mutex );
+        while( true ) {
+            while( !aborted && !sink.failed && sink.readPos == writePos && !endOfStream )
+                dataAvailable.wait( &mutex );
+
+            if( aborted || sink.failed || sink.readPos == writePos )
+                break;
+
+            const int offset = int( sink.readPos % bufferSize );
+            const qint64 n = qMin( qMin( qint64( writePos - sink.readPos ), qint64( bufferSize - offset ) ),
+                                   s_maxSinkWrite );
+
+            // the producer does not touch this part of the buffer before we advance readPos
+            locker.unlock();
+            qint64 written = 0;
+            while( written < n ) {
+                const qint64 w = sink.device->write( ring + offset + written, n - written );
+                if( w <= 0 ) {
+                    errorString = sink.device->errorString();
+                    break;
+                }
+                written += w;
+            }
+            locker.relock();
+
+            sink.readPos += written;
+            sink.bytesWritten += written;
+            spaceAvailable.wakeAll();
+
+            if( written < n ) {
+                failedWriting = !sink.failed;
+                sink.failed = true;
+                break;
+            }
+        }
+
+        sink.done = true;
+        spaceAvailable.wakeAll();
+        locker.unlock();
+
+        if( failedWriting ) {
+            qDebug() << "(K3b::FanOutPipe) writing to sink" << index << "failed:" << errorString;
+            emit q->sinkFailed( index, errorString );
+        }
+
+        QMetaObject::invokeMethod( q, "_k_sinkFinished", Qt::QueuedConnection, Q_ARG( int, index ) );
+    }
+
+    void pumpSource() {
+        QByteArray chunk( s_pumpChunkSize, Qt::Uninitialized );
+        qint64 r = 0;
+        bool sinksLeft = true;
+        while( sinksLeft && ( r = source->read( chunk.data(), chunk.size() ) ) > 0 )
+            sinksLeft = ( write( chunk.constData(), r ) >= 0 );
+
+        if( r < 0 ) {
+            // do not let the writers burn a truncated stream
+            qDebug() << "(K3b::FanOutPipe) reading failed:" << source->errorString();
+            QMutexLocker locker( &mutex );
+            aborted = true;
+            dataAvailable.wakeAll();
+            spaceAvailable.wakeAll();
+        }
+        else if( sinksLeft ) {
+            finishStream();
+        }
+
+        QMetaObject::invokeMethod( q, "_k_pumpFinished", Qt::QueuedConnection );
+    }
+
+    void _k_sinkFinished( int index ) {
+        sinkThreads[index]->wait();
+        if( sinks[index].closeDevice && sinks[index].device->isOpen() )
+            sinks[index].device->close();
+
+        if( --runningSinks == 0 && !pumpRunning )
+            emit q->finished();
+    }
+
+    void _k_pumpFinished() {
+        pump.wait();
+        pumpRunning = false;
+        if( closeSource )
+            source->close();
+        q->QIODevice::close();
+
+        if( runningSinks == 0 )
+            emit q->finished();
+    }
+
+    FanOutPipe* q;
+
+    QIODevice* source;
+    bool closeSource;
+
+    int bufferSize;
+    QByteArray buffer;
+    char* ring;
+
+    QVector<Sink> sinks;
+    QVector<SinkThread*> sinkThreads;
+
+    // all below is protected by the mutex
+    quint64 writePos;
+    bool endOfStream;
+    bool aborted;
+    QByteArray checksum;
+
+    // only touched in the thread the pipe lives in
+    int runningSinks;
+    bool pumpRunning;
+
+    // only touched by the producer
+    QCryptographicHash md5;
+
+    mutable QMutex mutex;
+    QWaitCondition dataAvailable;
+    QWaitCondition spaceAvailable;
+
+    PumpThread pump;
+};
+
+
+K3b::FanOutPipe::FanOutPipe()
+{
+    d = new Private( this );
+}
+
+
+K3b::FanOutPipe::~FanOutPipe()
+{
+    abort();
+    d->pump.wait();
+    clearSinks();
+    delete d;
+}
+
+
+void K3b::FanOutPipe::setBufferSize( int bytes )
+{
+    d->bufferSize = qMax( bytes, 2048 );
+}
+
+
+void K3b::FanOutPipe::readFrom( QIODevice* dev, bool close )
+{
+    d->source = dev;
+    d->closeSource = close;
+}
+
+
+int K3b::FanOutPipe::addSink( QIODevice* dev, bool close )
+{
+    Private::Sink sink;
+    sink.device = dev;
+    sink.closeDevice = close;
+    sink.readPos = sink.bytesWritten = 0;
+    sink.failed = sink.done = false;
+    d->sinks.append( sink );
+    d->sinkThreads.append( new Private::SinkThread( d, d->sinks.count()-1 ) );
+    return d->sinks.count()-1;
+}
+
+
+void K3b::FanOutPipe::clearSinks()
+{
+    Q_FOREACH( Private::SinkThread* thread, d->sinkThreads ) {
+        thread->wait();
+        delete thread;
+    }
+    d->sinkThreads.clear();
+    d->sinks.clear();
+    d->runningSinks = 0;
+}
+
+
+int K3b::FanOutPipe::sinkCount() const
+{
+    return d->sinks.count();
+}
+
+
+void K3b::FanOutPipe::removeSink( int index )
+{
+    QMutexLocker locker( &d->mutex );
+    if( index >= 0 && index < d->sinks.count() && !d->sinks[index].done ) {
+        d->sinks[index].failed = true;
+        d->dataAvailable.wakeAll();
+        d->spaceAvailable.wakeAll();
+    }
+}
+
+
+bool K3b::FanOutPipe::isSinkFailed( int index ) const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->sinks[index].failed;
+}
+
+
+quint64 K3b::FanOutPipe::bytesWritten( int index ) const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->sinks[index].bytesWritten;
+}
+
+
+bool K3b::FanOutPipe::open()
+{
+    if( isRunning() || d->sinks.isEmpty() )
+        return false;
+
+    if( d->source && !d->source->isOpen() ) {
+        qDebug() << "Need to open source device:" << d->source;
+        if( !d->source->open( QIODevice::ReadOnly ) )
+            return false;
+    }
+
+    for( int i = 0; i < d->sinks.count(); ++i ) {
+        QIODevice* dev = d->sinks[i].device;
+        if( !dev->isOpen() ) {
+            qDebug() << "Need to open sink device:" << dev;
+            if( !dev->open( QIODevice::WriteOnly ) )
+                return false;
+        }
+    }
+
+    d->buffer.resize( d->bufferSize );
+    d->ring = d->buffer.data();
+    d->writePos = 0;
+    d->endOfStream = false;
+    d->aborted = false;
+    d->checksum.clear();
+    d->md5.reset();
+
+    for( int i = 0; i < d->sinks.count(); ++i ) {
+        Private::Sink& sink = d->sinks[i];
+        sink.readPos = sink.bytesWritten = 0;
+        sink.failed = sink.done = false;
+    }
+
+    QIODevice::open( WriteOnly|Unbuffered );
+
+    d->runningSinks = d->sinks.count();
+    Q_FOREACH( Private::SinkThread* thread, d->sinkThreads )
+        thread->start();
+
+    if( d->source ) {
+        d->pumpRunning = true;
+        d->pump.start();
+    }
+
+    qDebug() << "(K3b::FanOutPipe) writing to" << d->sinks.count() << "sinks.";
+
+    return true;
+}
+
+
+bool K3b::FanOutPipe::open( OpenMode mode )
+{
+    return QIODevice::open( mode );
+}
+
+
+void K3b::FanOutPipe::close()
+{
+    if( d->pumpRunning ) {
+        // the pump marks the end of the stream itself, closing early cancels it
+        abort();
+    }
+    else {
+        d->finishStream();
+    }
+
+    QIODevice::close();
+}
+
+
+void K3b::FanOutPipe::abort()
+{
+    QMutexLocker locker( &d->mutex );
+    d->aborted = true;
+    d->dataAvailable.wakeAll();
+    d->spaceAvailable.wakeAll();
+}
+
+
+bool K3b::FanOutPipe::isRunning() const
+{
+    return d->runningSinks > 0 || d->pumpRunning;
+}
+
+
+QByteArray K3b::FanOutPipe::checksum() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->checksum;
+}
+
+
+int K3b::FanOutPipe::bufferFill() const
+{
+    QMutexLocker locker( &d->mutex );
+    if( !d->bufferSize )
+        return 0;
+    return int( qint64( d->writePos - d->minReadPos() ) * 100 / d->bufferSize );
+}
+
+
+qint64 K3b::FanOutPipe::readData( char*, qint64 )
+{
+    return -1;
+}
+
+
+qint64 K3b::FanOutPipe::writeData( const char* data, qint64 max )
+{
+    return d->write( data, max );
+}
+
+#include "moc_k3bfanoutpipe.cpp"
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_FAN_OUT_PIPE_H_
+#define _K3B_FAN_OUT_PIPE_H_
+
+#include "k3b_export.h"
+
+#include <QIODevice>
+
+
+namespace K3b {
+    /**
+     * The fan-out pipe copies one data stream to several sinks at once.
+     *
+     * The data is kept in a shared ring buffer and every sink is fed by its
+     * own thread, so a sink which blocks for a moment does not stall the
+     * others as long as the buffer does not run full. The source is only
+     * slowed down to the pace of the slowest sink.
+     *
+     * A sink whose write fails is dropped from the pipe and sinkFailed() is
+     * emitted while the remaining sinks continue. Writing to the pipe only
+     * fails once all sinks have failed.
+     *
+     * Like the ActivePipe the fan-out pipe either pumps the data from a source
+     * set via readFrom() or serves as a conduit for a job that can only push
+     * data (like the DataTrackReader). Closing the pipe marks the end of the
+     * stream. The sinks are drained in the background and finished() is
+     * emitted once all of them are done.
+     *
+     * The MD5 sum of the stream is calculated on the way.
+     */
+    class LIBK3B_EXPORT FanOutPipe : public QIODevice
+    {
+        Q_OBJECT
+
+    public:
+        FanOutPipe();
+        ~FanOutPipe() override;
+
+        /**
+         * The size of the shared buffer. Default is 32 MB.
+         * Only has an effect before the pipe is opened.
+         */
+        void setBufferSize( int bytes );
+
+        /**
+         * Read from a QIODevice. The device will be opened QIODevice::ReadOnly.
+         *
+         * \param close If true the device will be closed once all data has been read.
+         */
+        void readFrom( QIODevice* dev, bool close = false );
+
+        /**
+         * Add a sink. The device will be opened QIODevice::WriteOnly.
+         *
+         * \param close If true the device will be closed once all data has been written.
+         *
+         * \return The index of the sink.
+         */
+        int addSink( QIODevice* dev, bool close = false );
+
+        /**
+         * Remove all sinks. Only allowed while the pipe is not running.
+         */
+        void clearSinks();
+
+        int sinkCount() const;
+
+        /**
+         * Drop a sink, for example because the writer behind it failed.
+         * The remaining data is not written to it anymore.
+         */
+        void removeSink( int index );
+
+        /**
+         * \return true if writing to the sink failed or the sink was removed.
+         */
+        bool isSinkFailed( int index ) const;
+
+        quint64 bytesWritten( int index ) const;
+
+        /**
+         * Opens the pipe and starts the sink threads. If a source is set
+         * pumping starts as well.
+         */
+        bool open();
+
+        /**
+         * Marks the end of the stream. Returns immediately, the sinks are
+         * drained in the background.
+         */
+        void close() override;
+
+        /**
+         * Stop all sinks without writing the remaining data.
+         */
+        void abort();
+
+        /**
+         * \return true while data is still written to any of the sinks.
+         */
+        bool isRunning() const;
+
+        /**
+         * The hex encoded MD5 sum of all data written to the pipe.
+         * Only valid after the end of the stream.
+         */
+        QByteArray checksum() const;
+
+        /**
+         * The filling of the shared buffer in percent.
+         */
+        int bufferFill() const;
+
+        bool isSequential() const override { return true; }
+
+    Q_SIGNALS:
+        /**
+         * Emitted when writing to a sink failed. Not emitted for sinks
+         * removed via removeSink().
+         */
+        void sinkFailed( int index, const QString& errorString );
+
+        /**
+         * Emitted once all sinks are done or failed.
+         */
+        void finished();
+
+    protected:
+        qint64 readData( char* data, qint64 max ) override;
+        qint64 writeData( const char* data, qint64 max ) override;
+
+        /**
+         * Hidden open method. Use open().
+         */
+        bool open( OpenMode mode ) override;
+
+    private:
+        class Private;
+        Private* d;
+
+        Q_PRIVATE_SLOT( d, void _k_sinkFinished( int ) )
+        Q_PRIVATE_SLOT( d, void _k_pumpFinished() )
+    };
+}
+
+#endif
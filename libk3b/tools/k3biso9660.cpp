@@ -19,12 +19,43 @@
 #include "k3biso9660backend.h"
 
 #include "k3bdevice.h"
+#include "k3bzisofs.h"
 
 #include "libisofs/isofs.h"
 
+#include <QCache>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QVector>
+
+
+namespace {
+    // the number of uncompressed blocks kept per compressed file
+    const int s_zisofsCacheSize = 8;
+
+    quint32 fromLe32( const char* p )
+    {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>( p );
+        return u[0] | u[1] << 8 | u[2] << 16 | (quint32)u[3] << 24;
+    }
+}
+
+
+class K3b::Iso9660File::ZisofsBlocks
+{
+public:
+    ZisofsBlocks()
+        : valid( false ),
+          blockSizeLog2( 0 ) {
+        cache.setMaxCost( s_zisofsCacheSize );
+    }
+
+    bool valid;
+    int blockSizeLog2;
+    QVector<quint32> pointers;
+    QCache<unsigned int, QByteArray> cache;
+};
 
 
 /* callback function for libisofs */
@@ -83,9 +114,10 @@ int K3b::Iso9660::isofs_callback( struct iso_directory_record *idr, void *udata
             path = QString::fromLocal8Bit( rr.name );
         symlink=rr.sl;
         access=rr.mode;
-        time=0;//rr.st_mtime;
-        adate=0;//rr.st_atime;
-        cdate=0;//rr.st_ctime;
+        // fall back to the recording date if there is no TF entry
+        time=rr.rr_st_mtime ? rr.rr_st_mtime : isodate_915(idr->date,0);
+        adate=rr.rr_st_atime ? rr.rr_st_atime : time;
+        cdate=rr.rr_st_ctime ? rr.rr_st_ctime : time;
         user.setNum(rr.uid);
         group.setNum(rr.gid);
         z_algo[0]=rr.z_algo[0];z_algo[1]=rr.z_algo[1];
@@ -187,6 +219,7 @@ K3b::Iso9660File::Iso9660File( K3b::Iso9660* archive,
                                 unsigned int pos,
                                 unsigned int size )
     : K3b::Iso9660Entry( archive, isoName, name, access, date, adate, cdate, user, group, symlink ),
+      m_zisofs( 0 ),
       m_startSector(pos),
       m_size(size)
 {
@@ -199,6 +232,7 @@ K3b::Iso9660File::Iso9660File( K3b::Iso9660* archive,
 
 K3b::Iso9660File::~Iso9660File()
 {
+    delete m_zisofs;
 }
 
 void K3b::Iso9660File::setZF(char algo[2],char parms[2],int realsize)
@@ -209,7 +243,97 @@ void K3b::Iso9660File::setZF(char algo[2],char parms[2],int realsize)
 }
 
 
+bool K3b::Iso9660File::isCompressed() const
+{
+    return( m_algo[0] == 'p' && m_algo[1] == 'z' && m_realsize != 0 );
+}
+
+
+unsigned int K3b::Iso9660File::dataSize() const
+{
+    return isCompressed() ? (unsigned int)m_realsize : m_size;
+}
+
+
 int K3b::Iso9660File::read( unsigned int pos, char* data, int maxlen ) const
+{
+    if( isCompressed() )
+        return readCompressed( pos, data, maxlen );
+    else
+        return readRaw( pos, data, maxlen );
+}
+
+
+int K3b::Iso9660File::readCompressed( unsigned int pos, char* data, int maxlen ) const
+{
+    if( pos >= dataSize() || maxlen <= 0 )
+        return 0;
+
+    if( !m_zisofs ) {
+        m_zisofs = new ZisofsBlocks();
+
+        char header[K3b::Zisofs::HEADER_SIZE];
+        if( readRaw( 0, header, K3b::Zisofs::HEADER_SIZE ) == K3b::Zisofs::HEADER_SIZE ) {
+            const int headerSize = (unsigned char)header[12] * 4;
+            m_zisofs->blockSizeLog2 = (unsigned char)header[13];
+            if( m_zisofs->blockSizeLog2 >= 15 && m_zisofs->blockSizeLog2 <= 17 ) {
+                const int blocks = ( ( (quint64)dataSize() + ( 1 << m_zisofs->blockSizeLog2 ) - 1 ) >> m_zisofs->blockSizeLog2 ) + 1;
+                QByteArray table( 4*blocks, Qt::Uninitialized );
+                if( readRaw( headerSize, table.data(), table.size() ) == table.size() ) {
+                    m_zisofs->pointers.resize( blocks );
+                    for( int i = 0; i < blocks; ++i )
+                        m_zisofs->pointers[i] = fromLe32( table.constData() + 4*i );
+                    m_zisofs->valid = true;
+                }
+            }
+        }
+
+        if( !m_zisofs->valid )
+            qDebug() << "(K3b::Iso9660File) invalid zisofs header in" << name();
+    }
+
+    if( !m_zisofs->valid )
+        return -1;
+
+    const unsigned int blockSize = 1 << m_zisofs->blockSizeLog2;
+    int done = 0;
+    while( done < maxlen && pos < dataSize() ) {
+        const unsigned int block = pos >> m_zisofs->blockSizeLog2;
+
+        QByteArray* uncompressed = m_zisofs->cache.object( block );
+        if( !uncompressed ) {
+            const quint32 start = m_zisofs->pointers[block];
+            const quint32 end = m_zisofs->pointers[block+1];
+            if( end < start || end > size() )
+                break;
+
+            QByteArray compressed( end - start, Qt::Uninitialized );
+            if( !compressed.isEmpty() &&
+                readRaw( start, compressed.data(), compressed.size() ) != compressed.size() )
+                break;
+
+            const int len = qMin<quint64>( blockSize, dataSize() - (quint64)block*blockSize );
+            uncompressed = new QByteArray( K3b::Zisofs::uncompressBlock( compressed, len ) );
+            if( uncompressed->isEmpty() ) {
+                delete uncompressed;
+                break;
+            }
+            m_zisofs->cache.insert( block, uncompressed );
+        }
+
+        const int offset = pos - block*blockSize;
+        const int len = qMin( uncompressed->size() - offset, maxlen - done );
+        ::memcpy( data + done, uncompressed->constData() + offset, len );
+        done += len;
+        pos += len;
+    }
+
+    // report errors with the next read
+    return done > 0 ? done : -1;
+}
+
+
+int K3b::Iso9660File::readRaw( unsigned int pos, char* data, int maxlen ) const
 {
     if( pos >= size() )
         return 0;
@@ -543,11 +667,20 @@ int K3b::Iso9660::read( unsigned int sector, char* data, int count )
 {
     if( count == 0 )
         return 0;
+    else if( !d->backend->isOpen() && !d->backend->open() )
+        return -1;
     else
         return d->backend->read( sector, data, count );
 }
 
 
+void K3b::Iso9660::releaseBackend()
+{
+    if( d->isOpen )
+        d->backend->close();
+}
+
+
 void K3b::Iso9660::addBoot(struct el_torito_boot_descriptor* bootdesc)
 {
     int i,size;
@@ -753,6 +886,8 @@ void K3b::Iso9660::createSimplePrimaryDesc( struct iso_primary_descriptor* desc
     d->primaryDesc.volumeSetNumber = isonum_723(desc->volume_set_size);
     d->primaryDesc.logicalBlockSize = isonum_723(desc->logical_block_size);
     d->primaryDesc.volumeSpaceSize = isonum_733(desc->volume_space_size);
+    // the last byte is the timezone offset
+    d->primaryDesc.creationDate = QString::fromLatin1( desc->creation_date, 16 );
 }
 
 
@@ -894,7 +1029,8 @@ bool K3b::operator==( const K3b::Iso9660SimplePrimaryDescriptor& d1,
             d1.volumeSetSize == d2.volumeSetSize &&
             d1.volumeSetNumber == d2.volumeSetNumber &&
             d1.logicalBlockSize == d2.logicalBlockSize &&
-            d1.volumeSpaceSize == d2.volumeSpaceSize );
+            d1.volumeSpaceSize == d2.volumeSpaceSize &&
+            d1.creationDate == d2.creationDate );
 }
 
 
@@ -910,5 +1046,6 @@ bool K3b::operator!=( const K3b::Iso9660SimplePrimaryDescriptor& d1,
             d1.volumeSetSize != d2.volumeSetSize ||
             d1.volumeSetNumber != d2.volumeSetNumber ||
             d1.logicalBlockSize != d2.logicalBlockSize ||
-            d1.volumeSpaceSize != d2.volumeSpaceSize );
+            d1.volumeSpaceSize != d2.volumeSpaceSize ||
+            d1.creationDate != d2.creationDate );
 }
@@ -63,6 +63,12 @@ namespace K3b {
         int volumeSetNumber;
         long logicalBlockSize;
         long long volumeSpaceSize;
+
+        /**
+         * The volume creation date as the 16 digits stored on the medium
+         * (YYYYMMDDhhmmsscc). All zeros if it is not set.
+         */
+        QString creationDate;
     };
 
 
@@ -274,16 +280,36 @@ namespace K3b {
                      unsigned int size );
         ~Iso9660File() override;
 
+        /**
+         * Buffer size to use with read() when reading a file sequentially.
+         * It is a multiple of the sector size so read() can fill the buffer
+         * directly instead of reading through a temporary one.
+         */
+        static const int ReadBufferSize = 2048*64;
+
         bool isFile() const override { return true; }
 
         void setZF( char algo[2], char parms[2], int realsize );
         int realsize() const { return m_realsize; }
 
         /**
-         * @return size in bytes.
+         * @return true if the file is stored in zisofs format as
+         * marked by a RockRidge ZF entry. read() and copyTo()
+         * decompress such files transparently.
+         */
+        bool isCompressed() const;
+
+        /**
+         * @return size in bytes as stored on the medium.
          */
         unsigned int size() const { return m_size; }
 
+        /**
+         * @return size in bytes of the file contents returned by read(),
+         * which is the uncompressed size for compressed files.
+         */
+        unsigned int dataSize() const;
+
         /**
          * Returns the startSector of the file.
          */
@@ -295,7 +321,7 @@ namespace K3b {
         unsigned long long startPostion() const { return (unsigned long long)m_startSector * 2048; }
 
         /**
-         * @param pos offset in bytes
+         * @param pos offset in bytes in the uncompressed data
          * @param len max number of bytes to read
          */
         int read( unsigned int pos, char* data, int len ) const;
@@ -306,10 +332,17 @@ namespace K3b {
         bool copyTo( const QString& url ) const;
 
     private:
+        int readRaw( unsigned int pos, char* data, int len ) const;
+        int readCompressed( unsigned int pos, char* data, int len ) const;
+
         char m_algo[2];
         char m_parms[2];
         int m_realsize;
 
+        // block pointers and recently uncompressed blocks of a compressed file
+        class ZisofsBlocks;
+        mutable ZisofsBlocks* m_zisofs;
+
         unsigned int m_curpos;
         unsigned int m_startSector;
         unsigned int m_size;
@@ -396,6 +429,12 @@ namespace K3b {
          */
         void close();
 
+        /**
+         * Closes the backend, for example to release the device, but keeps
+         * the entries which have been read. The next read() reopens it.
+         */
+        void releaseBackend();
+
         /**
          * @param sector startsector
          * @param len number of sectors
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3blinetokenizer.h"
+
+#include <string.h>
+
+
+K3b::LineTokenizer::LineTokenizer()
+    : m_pos( 0 ),
+      m_scanPos( 0 ),
+      m_suppressEmptyLines( true )
+{
+    // a reserved buffer keeps its capacity when it is emptied
+    m_buffer.reserve( 4096 );
+}
+
+
+void K3b::LineTokenizer::setSuppressEmptyLines( bool b )
+{
+    m_suppressEmptyLines = b;
+}
+
+
+void K3b::LineTokenizer::append( const char* data, int len )
+{
+    if( len <= 0 )
+        return;
+
+    // move the unfinished line to the front instead of reallocating
+    if( m_pos > 0 ) {
+        const int rest = m_buffer.size() - m_pos;
+        if( rest > 0 )
+            ::memmove( m_buffer.data(), m_buffer.constData() + m_pos, rest );
+        m_buffer.resize( rest );
+        m_scanPos -= m_pos;
+        m_pos = 0;
+    }
+
+    m_buffer.append( data, len );
+}
+
+
+bool K3b::LineTokenizer::nextLine( const char*& line, int& len )
+{
+    char* data = m_buffer.data();
+    const int size = m_buffer.size();
+
+    while( m_pos < size ) {
+        int i = m_scanPos;
+        for( ; i < size; ++i ) {
+            const char c = data[i];
+            if( c == '\n' || c == '\r' || c == '\b' )
+                break;
+            else if( c == '\t' )
+                data[i] = ' ';
+        }
+
+        const int start = m_pos;
+
+        if( i == size ) {
+            m_scanPos = size;
+            if( data[size-1] == '.' ) {
+                m_pos = size;
+                line = data + start;
+                len = size - start;
+                return true;
+            }
+            return false;
+        }
+
+        // multiple backspaces count as a single line break
+        int next = i + 1;
+        if( data[i] == '\b' ) {
+            while( next < size && data[next] == '\b' )
+                ++next;
+        }
+        m_pos = m_scanPos = next;
+
+        if( i == start && m_suppressEmptyLines )
+            continue;
+
+        line = data + start;
+        len = i - start;
+        return true;
+    }
+
+    return false;
+}
+
+
+void K3b::LineTokenizer::clear()
+{
+    m_buffer.resize( 0 );
+    m_pos = 0;
+    m_scanPos = 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_LINE_TOKENIZER_H_
+#define _K3B_LINE_TOKENIZER_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+
+
+namespace K3b {
+    /**
+     * Splits the raw output of an external program into lines.
+     *
+     * Carriage returns and runs of backspaces end a line just like line feeds,
+     * which is how cdrecord and friends redraw their progress. Tabs are
+     * replaced by a single space. The returned lines point into an internal
+     * buffer which is reused, so no memory is allocated once the buffer has
+     * grown to the size of the largest chunk.
+     *
+     * \code
+     * tokenizer.append( data.constData(), data.size() );
+     * const char* line;
+     * int len;
+     * while( tokenizer.nextLine( line, len ) )
+     *     handle( QString::fromLocal8Bit( line, len ) );
+     * \endcode
+     */
+    class LIBK3B_EXPORT LineTokenizer
+    {
+    public:
+        LineTokenizer();
+
+        /**
+         * default is true
+         */
+        void setSuppressEmptyLines( bool b );
+
+        /**
+         * Append a chunk of raw output. Invalidates all lines previously
+         * returned by nextLine().
+         */
+        void append( const char* data, int len );
+
+        /**
+         * Fetch the next complete line.
+         *
+         * A pending line ending in a dot is considered complete since
+         * some programs print messages like "Fixating..." without a newline.
+         *
+         * \return false if no complete line is available.
+         */
+        bool nextLine( const char*& line, int& len );
+
+        /**
+         * Drop all buffered data.
+         */
+        void clear();
+
+    private:
+        QByteArray m_buffer;
+        int m_pos;
+        int m_scanPos;
+        bool m_suppressEmptyLines;
+    };
+}
+
+#endif
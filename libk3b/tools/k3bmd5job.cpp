@@ -88,7 +88,7 @@ void K3b::Md5Job::start()
     d->readData = 0;
 
     if( d->isoFile ) {
-        d->imageSize = d->isoFile->size();
+        d->imageSize = d->isoFile->dataSize();
     }
     else if( !d->filename.isEmpty() ) {
         if( !QFile::exists( d->filename ) ) {
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bmimetyperesolver.h"
+
+#include <QHash>
+#include <QList>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QWriteLocker>
+
+
+namespace {
+    // the sniffed types are only needed until the items have picked them up
+    const int s_maxContentTypes = 4096;
+}
+
+
+class K3b::MimeTypeResolver::Private
+{
+public:
+    class SniffJob : public QRunnable
+    {
+    public:
+        SniffJob( MimeTypeResolver* r, const QString& p )
+            : resolver( r ),
+              path( p ) {
+        }
+
+        void run() override {
+            // QMimeDatabase is thread-safe
+            const QMimeType type = resolver->d->db.mimeTypeForFile( path, QMimeDatabase::MatchDefault );
+            {
+                QMutexLocker locker( &resolver->d->mutex );
+                if( resolver->d->contentTypes.count() >= s_maxContentTypes )
+                    resolver->d->contentTypes.clear();
+                resolver->d->contentTypes.insert( path, type );
+                resolver->d->pending.remove( path );
+            }
+            emit resolver->contentTypeResolved( path );
+        }
+
+    private:
+        MimeTypeResolver* resolver;
+        QString path;
+    };
+
+    QMimeDatabase db;
+    QMimeType defaultType;
+
+    // items are created in the GUI thread and in the jobs adding urls
+    QReadWriteLock suffixLock;
+    QHash<QString, QMimeType> suffixTypes;
+
+    QMutex mutex;
+    QHash<QString, QMimeType> contentTypes;
+    QSet<QString> pending;
+
+    QThreadPool pool;
+};
+
+
+K3b::MimeTypeResolver::MimeTypeResolver()
+    : QObject(),
+      d( new Private() )
+{
+    d->defaultType = d->db.mimeTypeForName( QLatin1String( "application/octet-stream" ) );
+
+    // sniffing is bound by the disk, not the CPU
+    d->pool.setMaxThreadCount( 2 );
+}
+
+
+K3b::MimeTypeResolver::~MimeTypeResolver()
+{
+    d->pool.clear();
+    d->pool.waitForDone();
+    delete d;
+}
+
+
+K3b::MimeTypeResolver* K3b::MimeTypeResolver::instance()
+{
+    static MimeTypeResolver s_instance;
+    return &s_instance;
+}
+
+
+QMimeType K3b::MimeTypeResolver::typeForFileName( const QString& fileName )
+{
+    // Only names with a single extension can be cached by extension since
+    // globs like *.tar.gz or Makefile depend on more than the last suffix.
+    const int dot = fileName.lastIndexOf( QLatin1Char( '.' ) );
+    const bool cacheable = ( dot > 0 && dot == fileName.indexOf( QLatin1Char( '.' ) ) );
+    QString suffix;
+    if( cacheable ) {
+        suffix = fileName.mid( dot + 1 ).toLower();
+        QReadLocker locker( &d->suffixLock );
+        QHash<QString, QMimeType>::const_iterator it = d->suffixTypes.constFind( suffix );
+        if( it != d->suffixTypes.constEnd() )
+            return it.value();
+    }
+
+    QMimeType type;
+    const QList<QMimeType> types = d->db.mimeTypesForFileName( fileName );
+    if( types.count() == 1 )
+        type = types.first();
+
+    if( cacheable ) {
+        QWriteLocker locker( &d->suffixLock );
+        d->suffixTypes.insert( suffix, type );
+    }
+
+    return type;
+}
+
+
+QMimeType K3b::MimeTypeResolver::typeForContent( const QString& path )
+{
+    QMutexLocker locker( &d->mutex );
+
+    QHash<QString, QMimeType>::const_iterator it = d->contentTypes.constFind( path );
+    if( it != d->contentTypes.constEnd() )
+        return it.value();
+
+    if( !d->pending.contains( path ) ) {
+        d->pending.insert( path );
+        d->pool.start( new Private::SniffJob( this, path ) );
+    }
+
+    return QMimeType();
+}
+
+
+QMimeType K3b::MimeTypeResolver::sniffContent( const QString& path )
+{
+    {
+        QMutexLocker locker( &d->mutex );
+        QHash<QString, QMimeType>::const_iterator it = d->contentTypes.constFind( path );
+        if( it != d->contentTypes.constEnd() )
+            return it.value();
+    }
+
+    // a pending SniffJob simply stores the same type again
+    const QMimeType type = d->db.mimeTypeForFile( path, QMimeDatabase::MatchDefault );
+
+    QMutexLocker locker( &d->mutex );
+    if( d->contentTypes.count() >= s_maxContentTypes )
+        d->contentTypes.clear();
+    d->contentTypes.insert( path, type );
+    return type;
+}
+
+
+QMimeType K3b::MimeTypeResolver::defaultType()
+{
+    return d->defaultType;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_MIME_TYPE_RESOLVER_H_
+#define _K3B_MIME_TYPE_RESOLVER_H_
+
+#include "k3b_export.h"
+
+#include <QMimeType>
+#include <QObject>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * Determines the mime type of local files while avoiding to read them.
+     *
+     * The type is determined from the file name first and cached per
+     * extension, so for most files this is a hash lookup. Only files whose
+     * name is not conclusive are sniffed, which happens in a background
+     * thread. contentTypeResolved() is emitted once such a type is known.
+     */
+    class LIBK3B_EXPORT MimeTypeResolver : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static MimeTypeResolver* instance();
+
+        /**
+         * \return The type matching \p fileName or an invalid type if the
+         *         name matches no type or more than one.
+         */
+        QMimeType typeForFileName( const QString& fileName );
+
+        /**
+         * \return The type determined from the contents of \p path or an
+         *         invalid type if it is not known yet. In the latter case the
+         *         file is sniffed in the background.
+         */
+        QMimeType typeForContent( const QString& path );
+
+        /**
+         * Like typeForContent() but sniffs \p path right away if its type is
+         * not known yet. Only meant for the rare cases in which the type is
+         * needed immediately, like when opening the file.
+         */
+        QMimeType sniffContent( const QString& path );
+
+        /**
+         * application/octet-stream
+         */
+        QMimeType defaultType();
+
+    Q_SIGNALS:
+        /**
+         * Emitted from the sniffing thread once typeForContent() knows
+         * the type of \p path.
+         */
+        void contentTypeResolved( const QString& path );
+
+    private:
+        MimeTypeResolver();
+        ~MimeTypeResolver() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bprogressmatcher.h"
+
+
+namespace {
+    inline ushort charCode( QChar c )
+    {
+        return c.unicode();
+    }
+
+    inline ushort charCode( char c )
+    {
+        return uchar( c );
+    }
+
+    inline bool isSpace( ushort c )
+    {
+        return c == ' ' || ( c >= '\t' && c <= '\r' );
+    }
+
+    inline bool isDigit( ushort c )
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool isCapture( const char* p )
+    {
+        return p[0] == '%' && ( p[1] == 'd' || p[1] == 'f' );
+    }
+
+    inline bool isSpecial( const char* p )
+    {
+        return *p == ' ' || *p == '*' || *p == '{' || *p == '}' || *p == '$' || isCapture( p );
+    }
+
+    template<typename Char>
+    inline bool matchesAt( const Char* line, int pos, const char* literal, int len )
+    {
+        for( int i = 0; i < len; ++i ) {
+            if( charCode( line[pos+i] ) != uchar( literal[i] ) )
+                return false;
+        }
+        return true;
+    }
+}
+
+
+K3b::ProgressMatcher::Captures::Captures()
+    : m_count( 0 )
+{
+    for( int i = 0; i < MaxCaptures; ++i ) {
+        m_integers[i] = 0;
+        m_reals[i] = 0.0;
+        m_valid[i] = false;
+    }
+}
+
+
+bool K3b::ProgressMatcher::Captures::isValid( int i ) const
+{
+    return i >= 0 && i < m_count && m_valid[i];
+}
+
+
+int K3b::ProgressMatcher::Captures::toInt( int i ) const
+{
+    return isValid( i ) ? int( m_integers[i] ) : 0;
+}
+
+
+qint64 K3b::ProgressMatcher::Captures::toLongLong( int i ) const
+{
+    return isValid( i ) ? m_integers[i] : 0;
+}
+
+
+double K3b::ProgressMatcher::Captures::toDouble( int i ) const
+{
+    return isValid( i ) ? m_reals[i] : 0.0;
+}
+
+
+K3b::ProgressMatcher::ProgressMatcher( const char* pattern )
+    : m_captureCount( 0 )
+{
+    int optionalBegin = -1;
+    const char* p = pattern;
+
+    while( *p ) {
+        Step step;
+        step.offset = 0;
+        step.length = 0;
+
+        if( *p == ' ' ) {
+            while( *p == ' ' )
+                ++p;
+            step.type = Step::Spaces;
+        }
+        else if( isCapture( p ) ) {
+            Q_ASSERT( m_captureCount < MaxCaptures );
+            step.type = ( p[1] == 'd' ? Step::Integer : Step::Real );
+            step.offset = m_captureCount++;
+            p += 2;
+        }
+        else if( *p == '{' ) {
+            Q_ASSERT( optionalBegin < 0 );
+            optionalBegin = m_steps.count();
+            step.type = Step::OptionalBegin;
+            ++p;
+        }
+        else if( *p == '}' ) {
+            Q_ASSERT( optionalBegin >= 0 );
+            m_steps[optionalBegin].length = m_steps.count();
+            optionalBegin = -1;
+            step.type = Step::OptionalEnd;
+            ++p;
+        }
+        else if( *p == '$' ) {
+            step.type = Step::End;
+            ++p;
+        }
+        else {
+            step.type = Step::Literal;
+            if( *p == '*' ) {
+                step.type = Step::SkipTo;
+                ++p;
+            }
+            step.offset = m_literals.size();
+            while( *p && !isSpecial( p ) ) {
+                m_literals.append( *p );
+                if( p[0] == '%' && p[1] == '%' )
+                    ++p;
+                ++p;
+            }
+            step.length = m_literals.size() - step.offset;
+
+            // a lone '*' skips nothing since trailing text is ignored anyway
+            if( step.length == 0 )
+                continue;
+        }
+
+        m_steps.append( step );
+    }
+
+    Q_ASSERT( optionalBegin < 0 );
+}
+
+
+bool K3b::ProgressMatcher::match( const QString& line, Captures& captures ) const
+{
+    return matchImpl( line.constData(), line.length(), captures );
+}
+
+
+bool K3b::ProgressMatcher::match( const char* line, int len, Captures& captures ) const
+{
+    return matchImpl( line, len, captures );
+}
+
+
+template<typename Char>
+bool K3b::ProgressMatcher::matchImpl( const Char* line, int len, Captures& captures ) const
+{
+    captures = Captures();
+    captures.m_count = m_captureCount;
+
+    const char* literals = m_literals.constData();
+    int pos = 0;
+    int optionalStep = -1;
+    int optionalPos = 0;
+
+    for( int i = 0; i < m_steps.count(); ++i ) {
+        const Step& step = m_steps[i];
+        bool ok = true;
+
+        switch( step.type ) {
+        case Step::Literal:
+            ok = ( len - pos >= step.length &&
+                   matchesAt( line, pos, literals + step.offset, step.length ) );
+            if( ok )
+                pos += step.length;
+            break;
+
+        case Step::Spaces:
+            while( pos < len && isSpace( charCode( line[pos] ) ) )
+                ++pos;
+            break;
+
+        case Step::Integer: {
+            int p = pos;
+            const bool negative = ( p < len && charCode( line[p] ) == '-' );
+            if( negative )
+                ++p;
+            const int digitsStart = p;
+            qint64 value = 0;
+            while( p < len && isDigit( charCode( line[p] ) ) ) {
+                value = value*10 + ( charCode( line[p] ) - '0' );
+                ++p;
+            }
+            ok = ( p > digitsStart );
+            if( ok ) {
+                if( negative )
+                    value = -value;
+                captures.m_integers[step.offset] = value;
+                captures.m_reals[step.offset] = double( value );
+                captures.m_valid[step.offset] = true;
+                pos = p;
+            }
+            break;
+        }
+
+        case Step::Real: {
+            int p = pos;
+            qint64 integer = 0;
+            while( p < len && isDigit( charCode( line[p] ) ) ) {
+                integer = integer*10 + ( charCode( line[p] ) - '0' );
+                ++p;
+            }
+            ok = ( p > pos );
+            if( ok ) {
+                double value = double( integer );
+                if( p + 1 < len &&
+                    ( charCode( line[p] ) == '.' || charCode( line[p] ) == ',' ) &&
+                    isDigit( charCode( line[p+1] ) ) ) {
+                    ++p;
+                    double scale = 0.1;
+                    while( p < len && isDigit( charCode( line[p] ) ) ) {
+                        value += scale * ( charCode( line[p] ) - '0' );
+                        scale /= 10.0;
+                        ++p;
+                    }
+                }
+                captures.m_integers[step.offset] = integer;
+                captures.m_reals[step.offset] = value;
+                captures.m_valid[step.offset] = true;
+                pos = p;
+            }
+            break;
+        }
+
+        case Step::SkipTo: {
+            const char* literal = literals + step.offset;
+            const ushort first = uchar( literal[0] );
+            ok = false;
+            for( int p = pos; p + step.length <= len; ++p ) {
+                if( charCode( line[p] ) == first &&
+                    matchesAt( line, p, literal, step.length ) ) {
+                    pos = p + step.length;
+                    ok = true;
+                    break;
+                }
+            }
+            break;
+        }
+
+        case Step::OptionalBegin:
+            optionalStep = i;
+            optionalPos = pos;
+            break;
+
+        case Step::OptionalEnd:
+            optionalStep = -1;
+            break;
+
+        case Step::End:
+            ok = ( pos == len );
+            break;
+        }
+
+        if( !ok ) {
+            if( optionalStep < 0 )
+                return false;
+
+            // drop what the optional group captured and continue behind it
+            const int optionalEnd = m_steps[optionalStep].length;
+            for( int j = optionalStep; j < optionalEnd; ++j ) {
+                if( m_steps[j].type == Step::Integer || m_steps[j].type == Step::Real )
+                    captures.m_valid[m_steps[j].offset] = false;
+            }
+            pos = optionalPos;
+            i = optionalEnd;
+            optionalStep = -1;
+        }
+    }
+
+    return true;
+}
+
+
+const K3b::ProgressMatcher& K3b::ProgressMatcher::matcher( Id id )
+{
+    // keep in sync with the Id enumeration
+    static const ProgressMatcher s_matchers[NumIds] = {
+        // Track 01:   12 of  600 MB written (fifo 100%) [buf  99%]  16.1x.
+        ProgressMatcher( "Track %d: %d of %d MB written {(fifo %d%%)} {[buf %d%%]}" ),
+        //  1409024/4697620480 ( 0.0%) @0.0x, remaining ??:?? RBU 100.0% UBU   0.0%
+        ProgressMatcher( " %d/%d (*remaining" ),
+        ProgressMatcher( "*@%fx" ),
+        ProgressMatcher( "*RBU %f%%{ UBU %f%%}" ),
+        // Wrote 12 of 600 MB (Buffers 100%  99%).
+        ProgressMatcher( "Wrote %d of %d MB" ),
+        ProgressMatcher( "*at speed %d" ),
+        //  12.34% done, estimate finish Tue Mar  3 12:00:00 2009
+        ProgressMatcher( " %f%% done, estimate" ),
+        // encoding=1 frame=1491 first=0 last=-1 fps=14.815 done=-1.000000 ...
+        ProgressMatcher( "encoding=%d frame=%d" ),
+        // encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05, ( 0| 0| 0)
+        ProgressMatcher( "encoding frames [%d-%d]" ),
+        // encoding frame [185],  24.02 fps, 93.0%, ETA: 0:00:00, ( 0| 0| 0)
+        ProgressMatcher( "encoding frame [%d]" ),
+        // [detectclipping#0] valid area: X: 5..719 Y: 72..507  -> -j 72,6,68,0
+        ProgressMatcher( "[detectclipping*-j %d,%d,%d,%d" )
+    };
+
+    return s_matchers[id];
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_PROGRESS_MATCHER_H_
+#define _K3B_PROGRESS_MATCHER_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+
+namespace K3b {
+    /**
+     * A precompiled matcher for the progress lines of the external programs.
+     *
+     * The pattern is compiled once into a table of match steps which is then
+     * run against each line without allocating memory or backtracking. The
+     * pattern language is intentionally tiny:
+     *
+     * \li <tt>' '</tt> matches any number of whitespace characters (including none)
+     * \li <tt>%d</tt> captures an integer with an optional minus sign
+     * \li <tt>%f</tt> captures a decimal number using '.' or ',' as decimal separator
+     * \li <tt>%%</tt> matches a literal percent sign
+     * \li <tt>*text</tt> skips ahead to the first occurrence of \em text
+     * \li <tt>{...}</tt> an optional group. Its captures are invalid if it did not match.
+     * \li <tt>$</tt> matches the end of the line
+     *
+     * All other characters match literally. Text following the pattern is ignored.
+     *
+     * \code
+     * static const ProgressMatcher rx( "Track %d: %d of %d MB written" );
+     * ProgressMatcher::Captures cap;
+     * if( rx.match( line, cap ) )
+     *     made = cap.toInt( 1 );
+     * \endcode
+     */
+    class LIBK3B_EXPORT ProgressMatcher
+    {
+    public:
+        enum { MaxCaptures = 8 };
+
+        class Captures
+        {
+        public:
+            Captures();
+
+            int count() const { return m_count; }
+            bool isValid( int i ) const;
+            int toInt( int i ) const;
+            qint64 toLongLong( int i ) const;
+            double toDouble( int i ) const;
+
+        private:
+            qint64 m_integers[MaxCaptures];
+            double m_reals[MaxCaptures];
+            bool m_valid[MaxCaptures];
+            int m_count;
+
+            friend class ProgressMatcher;
+        };
+
+        explicit ProgressMatcher( const char* pattern );
+
+        bool match( const QString& line, Captures& captures ) const;
+        bool match( const char* line, int len, Captures& captures ) const;
+
+        /**
+         * The precompiled matchers for the programs K3b parses.
+         */
+        enum Id {
+            CdrecordProgress,        /**< cdrecord and cdrskin: track, done MB, total MB, fifo, buffer */
+            GrowisofsProgress,       /**< done bytes, total bytes */
+            GrowisofsWriteSpeed,     /**< speed factor */
+            GrowisofsRingBuffer,     /**< ring buffer fill, device buffer fill */
+            CdrdaoWrote,             /**< done MB, total MB */
+            CdrdaoSpeed,             /**< speed factor */
+            MkisofsProgress,         /**< percent */
+            TranscodeProgress,       /**< transcode >= 1.1: encoding flag, frame */
+            TranscodeLegacyProgress, /**< first frame, last frame */
+            DetectClippingProgress,  /**< frame */
+            DetectClippingArea,      /**< top, left, bottom, right */
+            NumIds
+        };
+
+        static const ProgressMatcher& matcher( Id id );
+
+    private:
+        struct Step {
+            enum Type {
+                Literal,
+                Spaces,
+                Integer,
+                Real,
+                SkipTo,
+                OptionalBegin,
+                OptionalEnd,
+                End
+            };
+
+            Type type;
+            int offset;  // literal start in m_literals or capture index
+            int length;  // literal length or index of the matching OptionalEnd
+        };
+
+        template<typename Char>
+        bool matchImpl( const Char* line, int len, Captures& captures ) const;
+
+        QVector<Step> m_steps;
+        QByteArray m_literals;
+        int m_captureCount;
+    };
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bzisofs.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+
+namespace {
+    const unsigned char s_magic[8] = { 0x37, 0xE4, 0x53, 0x96, 0xC9, 0xDB, 0xD6, 0x07 };
+
+    // the number of blocks compressed to estimate the compressed size of a file
+    const int s_estimateSamples = 4;
+
+    // formats which do not get any smaller
+    const char* const s_compressedSuffixes[] = {
+        "7z", "aac", "ape", "avi", "bz2", "cab", "deb", "docx", "epub", "flac",
+        "flv", "gif", "gz", "iso", "jar", "jpeg", "jpg", "lz", "lzma", "m4a",
+        "m4v", "mkv", "mov", "mp3", "mp4", "mpc", "mpeg", "mpg", "odp", "ods",
+        "odt", "ogg", "ogv", "opus", "png", "pptx", "rar", "rpm", "tbz2", "tgz",
+        "txz", "vob", "webm", "webp", "wma", "wmv", "wv", "xlsx", "xz", "z",
+        "zip", "zst", 0
+    };
+
+    void setLe32( char* p, quint32 v )
+    {
+        p[0] = v & 0xff;
+        p[1] = ( v >> 8 ) & 0xff;
+        p[2] = ( v >> 16 ) & 0xff;
+        p[3] = ( v >> 24 ) & 0xff;
+    }
+
+    bool isZero( const QByteArray& data )
+    {
+        const char* p = data.constData();
+        for( int i = 0; i < data.size(); ++i )
+            if( p[i] )
+                return false;
+        return true;
+    }
+
+    // the zlib stream of a block as stored in zisofs files
+    QByteArray compressBlock( const QByteArray& data )
+    {
+        if( isZero( data ) )
+            return QByteArray();
+
+        // qCompress prepends the uncompressed size which zisofs does not store
+        return qCompress( data, 9 ).mid( 4 );
+    }
+
+    qint64 sectors( qint64 size )
+    {
+        return ( size + 2047 ) / 2048;
+    }
+
+    qint64 overhead( qint64 size )
+    {
+        const qint64 blocks = ( size + K3b::Zisofs::BLOCK_SIZE - 1 ) / K3b::Zisofs::BLOCK_SIZE;
+        return K3b::Zisofs::HEADER_SIZE + 4*( blocks + 1 );
+    }
+}
+
+
+bool K3b::Zisofs::isCandidate( const QString& path, qint64 size )
+{
+    // the header stores the size in 32 bits and smaller files cannot save a sector
+    if( size <= 2048 || size > 0xFFFFFFFFLL )
+        return false;
+
+    const QByteArray suffix = QFileInfo( path ).suffix().toLower().toLatin1();
+    for( int i = 0; s_compressedSuffixes[i]; ++i )
+        if( suffix == s_compressedSuffixes[i] )
+            return false;
+
+    return true;
+}
+
+
+K3b::Zisofs::Result K3b::Zisofs::compressFile( const QString& source, const QString& target,
+                                               const volatile bool* canceled )
+{
+    QFile in( source );
+    if( !in.open( QIODevice::ReadOnly ) ) {
+        qDebug() << "(K3b::Zisofs) could not open" << source;
+        return Error;
+    }
+
+    const qint64 size = in.size();
+    if( size > 0xFFFFFFFFLL )
+        return NotCompressible;
+
+    QFile out( target );
+    if( !out.open( QIODevice::WriteOnly ) ) {
+        qDebug() << "(K3b::Zisofs) could not open" << target << "for writing.";
+        return Error;
+    }
+
+    const int blocks = ( size + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+
+    char header[HEADER_SIZE];
+    ::memcpy( header, s_magic, 8 );
+    setLe32( header + 8, size );
+    header[12] = HEADER_SIZE/4;
+    header[13] = BLOCK_SIZE_LOG2;
+    header[14] = 0;
+    header[15] = 0;
+
+    // the block pointers are written once all blocks are known
+    QByteArray pointers( 4*( blocks + 1 ), '\0' );
+    bool success = ( out.write( header, HEADER_SIZE ) == HEADER_SIZE &&
+                     out.write( pointers ) == pointers.size() );
+
+    quint32 pos = HEADER_SIZE + pointers.size();
+    const qint64 maxSize = ( sectors( size ) - 1 ) * 2048;
+    setLe32( pointers.data(), pos );
+    for( int i = 0; success && i < blocks; ++i ) {
+        if( canceled && *canceled ) {
+            success = false;
+            break;
+        }
+
+        const QByteArray data = in.read( BLOCK_SIZE );
+        if( data.isEmpty() ) {
+            qDebug() << "(K3b::Zisofs) error while reading" << source;
+            success = false;
+            break;
+        }
+
+        const QByteArray block = compressBlock( data );
+        if( out.write( block ) != block.size() ) {
+            qDebug() << "(K3b::Zisofs) error while writing" << target;
+            success = false;
+            break;
+        }
+
+        pos += block.size();
+        setLe32( pointers.data() + 4*( i + 1 ), pos );
+
+        // give up as soon as it is clear that no sector is saved
+        if( pos > maxSize ) {
+            out.remove();
+            return NotCompressible;
+        }
+    }
+
+    success = success && out.seek( HEADER_SIZE ) && out.write( pointers ) == pointers.size();
+    out.close();
+
+    if( !success ) {
+        out.remove();
+        return Error;
+    }
+    else if( sectors( pos ) >= sectors( size ) ) {
+        out.remove();
+        return NotCompressible;
+    }
+    else if( !copyFileAttributes( source, target ) ) {
+        qDebug() << "(K3b::Zisofs) could not copy the attributes of" << source << "to" << target;
+        out.remove();
+        return Error;
+    }
+    else {
+        return Compressed;
+    }
+}
+
+
+bool K3b::Zisofs::copyFileAttributes( const QString& source, const QString& target )
+{
+    struct stat statBuf;
+    if( ::stat( QFile::encodeName( source ), &statBuf ) != 0 )
+        return false;
+
+    struct utimbuf tb;
+    tb.actime = statBuf.st_atime;
+    tb.modtime = statBuf.st_mtime;
+    return( ::chmod( QFile::encodeName( target ), statBuf.st_mode & 07777 ) == 0 &&
+            ::utime( QFile::encodeName( target ), &tb ) == 0 );
+}
+
+
+qint64 K3b::Zisofs::estimateCompressedSize( const QString& path )
+{
+    QFile f( path );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return -1;
+
+    const qint64 size = f.size();
+    const qint64 blocks = ( size + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+    const int samples = qMin<qint64>( blocks, s_estimateSamples );
+
+    qint64 raw = 0;
+    qint64 compressed = 0;
+    for( int i = 0; i < samples; ++i ) {
+        if( !f.seek( blocks * i / samples * BLOCK_SIZE ) )
+            return size;
+        const QByteArray data = f.read( BLOCK_SIZE );
+        raw += data.size();
+        compressed += compressBlock( data ).size();
+    }
+
+    if( raw == 0 )
+        return size;
+
+    const qint64 estimate = overhead( size ) + size * compressed / raw;
+    if( sectors( estimate ) >= sectors( size ) )
+        return size;
+    else
+        return estimate;
+}
+
+
+QByteArray K3b::Zisofs::uncompressBlock( const QByteArray& block, int size )
+{
+    if( block.isEmpty() )
+        return QByteArray( size, '\0' );
+
+    // qUncompress expects the uncompressed size in front of the zlib stream
+    QByteArray data( 4, '\0' );
+    data[0] = ( size >> 24 ) & 0xff;
+    data[1] = ( size >> 16 ) & 0xff;
+    data[2] = ( size >> 8 ) & 0xff;
+    data[3] = size & 0xff;
+    data.append( block );
+
+    QByteArray result = qUncompress( data );
+    if( result.size() != size ) {
+        qDebug() << "(K3b::Zisofs) invalid block of" << block.size() << "bytes.";
+        return QByteArray();
+    }
+    return result;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_ZISOFS_H_
+#define _K3B_ZISOFS_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * Helpers for the zisofs file format which mkisofs stores as is when
+     * called with -z and marks with a RockRidge ZF entry. Readers like
+     * the Linux kernel decompress such files transparently.
+     *
+     * A zisofs file starts with a 16 byte header followed by a table of
+     * block pointers. Each block of uncompressed data is stored as a zlib
+     * stream. An empty block stands for a block of zeros.
+     *
+     * Compressing runs in any thread, the functions do not share any state.
+     */
+    namespace Zisofs {
+        enum {
+            HEADER_SIZE = 16,
+            BLOCK_SIZE_LOG2 = 15,
+            BLOCK_SIZE = 1<<BLOCK_SIZE_LOG2
+        };
+
+        enum Result {
+            Compressed,
+            NotCompressible,  /**< compressing would not save a single sector */
+            Error
+        };
+
+        /**
+         * \return true if the file at \p path with \p size bytes is worth trying to
+         * compress. Small files, files which cannot be represented in zisofs and files
+         * which are compressed already (judged by their suffix) are skipped.
+         */
+        LIBK3B_EXPORT bool isCandidate( const QString& path, qint64 size );
+
+        /**
+         * Compresses \p source into the zisofs file \p target. The target is removed
+         * again unless the result is Compressed. A compressed target gets the
+         * permissions and times of \p source, see copyFileAttributes().
+         *
+         * \param canceled if not null compressing stops early with Error once it is set.
+         */
+        LIBK3B_EXPORT Result compressFile( const QString& source, const QString& target,
+                                           const volatile bool* canceled = 0 );
+
+        /**
+         * Estimates the size of \p path compressed to zisofs by compressing a few
+         * blocks spread over the file. \return the size of the uncompressed file if
+         * compressing is not worth it and -1 if the file cannot be read.
+         */
+        LIBK3B_EXPORT qint64 estimateCompressedSize( const QString& path );
+
+        /**
+         * Copies the permissions and the access and modification times of \p source
+         * to \p target. mkisofs takes the RockRidge attributes of a file from the
+         * compressed copy it is given instead of the original.
+         */
+        LIBK3B_EXPORT bool copyFileAttributes( const QString& source, const QString& target );
+
+        /**
+         * Uncompresses the zlib stream of one block as stored in a zisofs file.
+         * An empty \p block results in \p size zero bytes.
+         *
+         * \return an empty array on error.
+         */
+        LIBK3B_EXPORT QByteArray uncompressBlock( const QByteArray& block, int size );
+    }
+}
+
+#endif
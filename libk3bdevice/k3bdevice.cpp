@@ -124,7 +124,8 @@ public:
         : supportedProfiles(0),
           deviceHandle(HANDLE_DEFAULT_VALUE),
           openedReadWrite(false),
-          burnfree(false) {
+          burnfree(false),
+          transport(0) {
     }
 
     Solid::Device solidDevice;
@@ -135,6 +136,7 @@ public:
     int maxReadSpeed;
     int maxWriteSpeed;
     int currentWriteSpeed;
+    int readOffset;
 
     bool dvdMinusTestwrite;
 
@@ -152,6 +154,8 @@ public:
     bool openedReadWrite;
     bool burnfree;
 
+    ScsiTransport* transport;
+
     QMutex mutex;
     QMutex openCloseMutex;
 };
@@ -261,6 +265,22 @@ K3b::Device::Device::Device( const Solid::Device& dev )
     d->writeModes = {};
     d->maxWriteSpeed = 0;
     d->maxReadSpeed = 0;
+    d->readOffset = 0;
+    d->burnfree = false;
+    d->dvdMinusTestwrite = true;
+    d->bufferSize = 0;
+}
+
+
+K3b::Device::Device::Device( const QString& name, ScsiTransport* transport )
+{
+    d = new Private;
+    d->blockDevice = name;
+    d->transport = transport;
+    d->writeModes = {};
+    d->maxWriteSpeed = 0;
+    d->maxReadSpeed = 0;
+    d->readOffset = 0;
     d->burnfree = false;
     d->dvdMinusTestwrite = true;
     d->bufferSize = 0;
@@ -270,6 +290,7 @@ K3b::Device::Device::Device( const Solid::Device& dev )
 K3b::Device::Device::~Device()
 {
     close();
+    delete d->transport;
     delete d;
 }
 
@@ -328,6 +349,12 @@ int K3b::Device::Device::maxWriteSpeed() const
 }
 
 
+int K3b::Device::Device::readOffset() const
+{
+    return d->readOffset;
+}
+
+
 void K3b::Device::Device::setCurrentWriteSpeed( int s )
 {
     d->currentWriteSpeed = s;
@@ -346,6 +373,12 @@ void K3b::Device::Device::setMaxWriteSpeed( int s )
 }
 
 
+void K3b::Device::Device::setReadOffset( int samples )
+{
+    d->readOffset = samples;
+}
+
+
 Solid::Device K3b::Device::Device::solidDevice() const
 {
     return d->solidDevice;
@@ -452,6 +485,10 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
 
     close();
 
+    // a virtual device has no kernel driver to ask
+    if( d->transport )
+        return true;
+
     return furtherInit();
 }
 
@@ -1780,6 +1817,9 @@ K3b::Device::Device::Handle K3b::Device::Device::handle() const
 
 bool K3b::Device::Device::open( bool write ) const
 {
+    if( d->transport )
+        return true;
+
     if( d->openedReadWrite != write )
         close();
 
@@ -1814,7 +1854,13 @@ void K3b::Device::Device::close() const
 
 bool K3b::Device::Device::isOpen() const
 {
-    return ( d->deviceHandle != HANDLE_DEFAULT_VALUE);
+    return ( d->transport || d->deviceHandle != HANDLE_DEFAULT_VALUE);
+}
+
+
+K3b::Device::ScsiTransport* K3b::Device::Device::scsiTransport() const
+{
+    return d->transport;
 }
 
 
@@ -3143,6 +3189,19 @@ void K3b::Device::Device::checkWritingModes()
 }
 
 
+bool K3b::Device::Device::supportsC2ErrorPointers() const
+{
+    UByteArray data;
+
+    if( modeSense( data, 0x2A ) && data.size() >= 8 + 6 ) {
+        const mm_cap_page_2A* mm = (mm_cap_page_2A const*)&data.at(8);
+        return mm->c2_pointers && mm->cd_da_supported;
+    }
+
+    return false;
+}
+
+
 int K3b::Device::Device::getMaxWriteSpeedVia2A() const
 {
     int ret = 0;
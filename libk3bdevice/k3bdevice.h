@@ -47,6 +47,7 @@ namespace K3b {
     namespace Device
     {
         class Toc;
+        class ScsiTransport;
 
         typedef QVarLengthArray< unsigned char > UByteArray;
 
@@ -181,6 +182,12 @@ namespace K3b {
              */
             bool burnfree() const;
 
+            /**
+             * @return true if the device reports C2 error pointers with READ CD.
+             * This queries the device every time it is called.
+             */
+            bool supportsC2ErrorPointers() const;
+
             /**
              * Shortcut for \code writingModes() & WRITINGMODE_SAO \endcode
              *
@@ -226,6 +233,13 @@ namespace K3b {
 
             int maxWriteSpeed() const;
 
+            /**
+             * The read offset of the drive in audio samples as listed by
+             * AccurateRip. Audio extraction compensates for it by reading
+             * that many samples further into the disc. Default is 0.
+             */
+            int readOffset() const;
+
             /**
              * internal K3b value.
              * \deprecated This should not be handled here.
@@ -242,6 +256,8 @@ namespace K3b {
              */
             void setMaxWriteSpeed( int s );
 
+            void setReadOffset( int samples );
+
             /**
              * checks if unit is ready (medium inserted and ready for command)
              *
@@ -438,6 +454,14 @@ namespace K3b {
              */
             Handle handle() const;
 
+            /**
+             * \return The transport executing the commands of a virtual device
+             *         or 0 for a real device.
+             *
+             * \sa DeviceManager::addVirtualDevice()
+             */
+            ScsiTransport* scsiTransport() const;
+
             /**
              * \return \li -1 on error (no DVD)
              *         \li 1 (CSS/CPPM)
@@ -717,6 +741,12 @@ namespace K3b {
              */
             Device( const Solid::Device& dev );
 
+            /**
+             * Construct a virtual device which sends all commands to \p transport.
+             * The device takes ownership of the transport.
+             */
+            Device( const QString& name, ScsiTransport* transport );
+
             /**
              * Determines the device's capabilities. This needs to be called once before
              * using the device.
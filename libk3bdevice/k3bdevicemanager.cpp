@@ -318,6 +318,8 @@ bool K3b::Device::DeviceManager::readConfig( const KConfigGroup& c )
             dev->setMaxReadSpeed( list[0].toInt() );
             if( list.count() > 1 )
                 dev->setMaxWriteSpeed( list[1].toInt() );
+            if( list.count() > 2 )
+                dev->setReadOffset( list[2].toInt() );
         }
     }
 
@@ -345,7 +347,8 @@ bool K3b::Device::DeviceManager::saveConfig( KConfigGroup c )
         QString configEntryName = dev->vendor() + ' ' + dev->description();
         QStringList list;
         list << QString::number(dev->maxReadSpeed())
-             << QString::number(dev->maxWriteSpeed());
+             << QString::number(dev->maxWriteSpeed())
+             << QString::number(dev->readOffset());
 
         c.writeEntry( configEntryName, list );
     }
@@ -414,6 +417,18 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device*
 }
 
 
+K3b::Device::Device* K3b::Device::DeviceManager::addVirtualDevice( const QString& name, ScsiTransport* transport )
+{
+    if( findDevice( name ) ) {
+        qDebug() << "(K3b::Device::DeviceManager) dev " << name << " already found";
+        delete transport;
+        return 0;
+    }
+
+    return addDevice( new K3b::Device::Device( name, transport ) );
+}
+
+
 void K3b::Device::DeviceManager::removeDevice( const Solid::Device& dev )
 {
     if( const Solid::Block* blockDevice = dev.as<Solid::Block>() ) {
@@ -32,6 +32,7 @@ namespace K3b {
     namespace Device {
 
         class Device;
+        class ScsiTransport;
 
         /**
          * \brief Manages all devices.
@@ -183,6 +184,18 @@ namespace K3b {
              */
             virtual void clear();
 
+            /**
+             * Add a device which is emulated by \p transport, typically a
+             * VirtualDrive, instead of being accessed through a device node.
+             * This allows to test and benchmark without hardware.
+             *
+             * The device takes ownership of the transport.
+             *
+             * \return The initialized device or 0 if \p name is already in use
+             *         or the device could not be initialized.
+             */
+            Device* addVirtualDevice( const QString& name, ScsiTransport* transport );
+
         Q_SIGNALS:
             /**
              * Emitted if the device configuration changed, i.e. a device was added or removed.
@@ -207,3 +207,43 @@ K3b::Device::ScsiCommand::~ScsiCommand()
     delete d;
 }
 
+
+
+int K3b::Device::ScsiCommand::transport( TransportDirection dir,
+                                         void* data,
+                                         size_t len )
+{
+    ScsiTransport* scsiTransport = ( m_device ? m_device->scsiTransport() : 0 );
+    if( !scsiTransport )
+        return transportDevice( dir, data, len );
+
+    // MMC commands are at most 12 bytes long
+    unsigned char cdb[12];
+    for( int i = 0; i < 12; ++i )
+        cdb[i] = (*this)[i];
+
+    ScsiTransport::Sense sense = { 0, 0, 0 };
+    m_device->usageLock();
+    const bool success = scsiTransport->execute( cdb, dir, static_cast<unsigned char*>( data ), len, sense );
+    m_device->usageUnlock();
+
+    if( success )
+        return 0;
+
+    // fixed format sense data, current error
+    const int errorCode = 0x70;
+    debugError( cdb[0], errorCode, sense.senseKey, sense.asc, sense.ascq );
+
+    int errCode =
+        ((errorCode<<24)          & 0xF000) |
+        ((sense.senseKey<<16)     & 0x0F00) |
+        ((sense.asc<<8)           & 0x00F0) |
+        ((sense.ascq)             & 0x000F);
+
+    return( errCode != 0 ? errCode : 1 );
+}
+
+
+K3b::Device::ScsiTransport::~ScsiTransport()
+{
+}
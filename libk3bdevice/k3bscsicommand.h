@@ -85,6 +85,38 @@ namespace K3b {
             TR_DIR_WRITE
         };
 
+        /**
+         * A transport executes the commands of ScsiCommand instead of the
+         * device node of the Device. This allows to emulate a drive in-process.
+         *
+         * \sa VirtualDrive, DeviceManager::addVirtualDevice()
+         */
+        class LIBK3BDEVICE_EXPORT ScsiTransport
+        {
+        public:
+            struct Sense {
+                unsigned char senseKey;
+                unsigned char asc;
+                unsigned char ascq;
+            };
+
+            virtual ~ScsiTransport();
+
+            /**
+             * Execute a single command. Implementations need to be thread-safe.
+             *
+             * \param cdb The 12 bytes of the command descriptor block.
+             * \param data The transfer buffer of \p len bytes.
+             *
+             * \return true on success. Otherwise \p sense describes the error.
+             */
+            virtual bool execute( const unsigned char* cdb,
+                                  TransportDirection dir,
+                                  unsigned char* data,
+                                  size_t len,
+                                  Sense& sense ) = 0;
+        };
+
         class ScsiCommand
         {
         public:
@@ -125,6 +157,8 @@ namespace K3b {
                            size_t len = 0 );
 
         private:
+            int transportDevice( TransportDirection dir, void* data, size_t len );
+
             static QString senseKeyToString( int key );
             void debugError( int command, int errorCode, int senseKey, int asc, int ascq );
 
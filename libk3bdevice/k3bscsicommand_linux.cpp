@@ -88,7 +88,7 @@ unsigned char& K3b::Device::ScsiCommand::operator[]( size_t i )
 }
 
 
-int K3b::Device::ScsiCommand::transport( TransportDirection dir,
+int K3b::Device::ScsiCommand::transportDevice( TransportDirection dir,
                                          void* data,
                                          size_t len )
 {
@@ -0,0 +1,972 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bvirtualdrive.h"
+#include "k3bcrc.h"
+#include "k3bdeviceglobals.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <string.h>
+
+
+namespace {
+    const int DATA_SECTOR_SIZE = 2048;
+    const int RAW_SECTOR_SIZE = 2352;
+
+    // sense keys
+    const unsigned char NOT_READY = 0x2;
+    const unsigned char ILLEGAL_REQUEST = 0x5;
+
+    inline void set2Byte( unsigned char* p, quint32 v )
+    {
+        p[0] = v >> 8;
+        p[1] = v;
+    }
+
+    inline void set4Byte( unsigned char* p, quint32 v )
+    {
+        p[0] = v >> 24;
+        p[1] = v >> 16;
+        p[2] = v >> 8;
+        p[3] = v;
+    }
+
+    inline void lbaToMsf( int lba, unsigned char& m, unsigned char& s, unsigned char& f )
+    {
+        lba += 150;
+        m = lba / ( 60*75 );
+        s = ( lba / 75 ) % 60;
+        f = lba % 75;
+    }
+
+    // READ TOC and friends report addresses either as LBA or as MSF
+    inline void setAddress( unsigned char* p, int lba, bool msf )
+    {
+        if( msf ) {
+            p[0] = 0;
+            lbaToMsf( lba, p[1], p[2], p[3] );
+        }
+        else {
+            set4Byte( p, lba );
+        }
+    }
+
+    inline unsigned char bcd( int v )
+    {
+        return K3b::Device::toBcd( v );
+    }
+
+    // CRC table of the Mode 1 EDC field as defined in ECMA-130
+    class EdcTable
+    {
+    public:
+        EdcTable() {
+            for( quint32 i = 0; i < 256; ++i ) {
+                quint32 edc = i;
+                for( int j = 0; j < 8; ++j )
+                    edc = ( edc >> 1 ) ^ ( edc & 1 ? 0xD8018001 : 0 );
+                m_table[i] = edc;
+            }
+        }
+
+        quint32 operator[]( int i ) const { return m_table[i]; }
+
+    private:
+        quint32 m_table[256];
+    };
+
+    quint32 calcEdc( const unsigned char* data, int len )
+    {
+        // several drives may be read from different threads, the
+        // initialization of a local static is thread-safe
+        static const EdcTable s_table;
+
+        quint32 edc = 0;
+        while( len-- )
+            edc = ( edc >> 8 ) ^ s_table[( edc ^ *data++ ) & 0xFF];
+        return edc;
+    }
+
+    struct TrackEntry {
+        QFile* file;
+        bool audio;
+        int start;
+        int length;
+    };
+}
+
+
+class K3b::Device::VirtualDrive::Private
+{
+public:
+    Private()
+        : writeFile( 0 ),
+          capacity( 0 ),
+          written( 0 ),
+          closed( false ),
+          profile( -1 ),
+          latency( 0 ),
+          throughput( 0 ),
+          busyUntil( 0 ),
+          commands( 0 ) {
+        clock.start();
+    }
+
+    bool fail( Sense& sense, unsigned char key, unsigned char asc, unsigned char ascq = 0 ) {
+        sense.senseKey = key;
+        sense.asc = asc;
+        sense.ascq = ascq;
+        return false;
+    }
+
+    bool hasMedium() const {
+        return writeFile || !tracks.isEmpty();
+    }
+
+    int currentProfile() const {
+        if( !hasMedium() )
+            return 0;
+        else if( profile >= 0 )
+            return profile;
+        else
+            return writeFile ? 0x09 : 0x08;
+    }
+
+    bool isDvd() const {
+        return currentProfile() >= 0x10;
+    }
+
+    // A written medium consists of a single data track
+    int trackCount() const {
+        if( writeFile )
+            return written > 0 ? 1 : 0;
+        else
+            return tracks.count();
+    }
+
+    int trackStart( int i ) const {
+        return writeFile ? 0 : tracks[i].start;
+    }
+
+    int trackLength( int i ) const {
+        return writeFile ? written : tracks[i].length;
+    }
+
+    bool trackIsAudio( int i ) const {
+        return writeFile ? false : tracks[i].audio;
+    }
+
+    unsigned char trackControl( int i ) const {
+        return trackIsAudio( i ) ? 0x0 : 0x4;
+    }
+
+    int mediumSize() const {
+        const int n = trackCount();
+        return n > 0 ? trackStart( n-1 ) + trackLength( n-1 ) : 0;
+    }
+
+    int trackAt( int lba ) const {
+        for( int i = 0; i < trackCount(); ++i ) {
+            if( lba >= trackStart( i ) && lba < trackStart( i ) + trackLength( i ) )
+                return i;
+        }
+        return -1;
+    }
+
+    // reads count sectors of the track's native size, zero padding short files
+    bool readSectors( int track, int lba, int count, unsigned char* buf ) {
+        QFile* file = writeFile;
+        int sectorSize = DATA_SECTOR_SIZE;
+        if( !writeFile ) {
+            file = tracks[track].file;
+            sectorSize = tracks[track].audio ? RAW_SECTOR_SIZE : DATA_SECTOR_SIZE;
+        }
+
+        const qint64 size = qint64( count ) * sectorSize;
+        if( !file->seek( qint64( lba - trackStart( track ) ) * sectorSize ) )
+            return false;
+        const qint64 read = file->read( reinterpret_cast<char*>( buf ), size );
+        if( read < 0 )
+            return false;
+        if( read < size )
+            ::memset( buf + read, 0, size - read );
+        return true;
+    }
+
+    void buildQ( int track, int lba, unsigned char* q ) const {
+        unsigned char m, s, f;
+        q[0] = ( trackControl( track ) << 4 ) | 0x1;
+        q[1] = bcd( track + 1 );
+        q[2] = bcd( 1 );
+        lbaToMsf( lba - trackStart( track ) - 150, m, s, f );
+        q[3] = bcd( m );
+        q[4] = bcd( s );
+        q[5] = bcd( f );
+        q[6] = 0;
+        lbaToMsf( lba, m, s, f );
+        q[7] = bcd( m );
+        q[8] = bcd( s );
+        q[9] = bcd( f );
+        // Red Book stores the CRC inverted
+        const quint16 crc = calcX25( q, 10 );
+        q[10] = ( crc >> 8 ) ^ 0xFF;
+        q[11] = ( crc & 0xFF ) ^ 0xFF;
+    }
+
+    void buildMode1Sector( int lba, unsigned char* sector ) const {
+        sector[0] = 0x00;
+        ::memset( sector + 1, 0xFF, 10 );
+        sector[11] = 0x00;
+        unsigned char m, s, f;
+        lbaToMsf( lba, m, s, f );
+        sector[12] = bcd( m );
+        sector[13] = bcd( s );
+        sector[14] = bcd( f );
+        sector[15] = 0x01;
+        const quint32 edc = calcEdc( sector, 16 + DATA_SECTOR_SIZE );
+        sector[2064] = edc;
+        sector[2065] = edc >> 8;
+        sector[2066] = edc >> 16;
+        sector[2067] = edc >> 24;
+        // no ECC, the P and Q parity stays zero
+        ::memset( sector + 2068, 0, RAW_SECTOR_SIZE - 2068 );
+    }
+
+    bool inquiry( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool getConfiguration( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool getEventStatus( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool readCapacity( unsigned char* data, size_t len, Sense& sense );
+    bool read( int lba, int count, unsigned char* data, size_t len, Sense& sense );
+    bool readCd( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool readToc( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool readDiscInformation( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool readTrackInformation( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense );
+    bool write( const unsigned char* cdb, const unsigned char* data, size_t len, Sense& sense );
+
+    // copies the reply limited by the allocation length and the buffer
+    static void reply( const UByteArray& r, int allocation, unsigned char* data, size_t len ) {
+        const size_t n = qMin<size_t>( qMin<size_t>( r.size(), allocation ), len );
+        if( n > 0 )
+            ::memcpy( data, r.constData(), n );
+    }
+
+    QList<TrackEntry> tracks;
+
+    QFile* writeFile;
+    int capacity;
+    int written;
+    bool closed;
+
+    int profile;
+    int latency;
+    int throughput;
+
+    QElapsedTimer clock;
+    qint64 busyUntil;
+    qint64 commands;
+
+    QMutex mutex;
+};
+
+
+bool K3b::Device::VirtualDrive::Private::inquiry( const unsigned char* cdb, unsigned char* data, size_t len, Sense& )
+{
+    UByteArray r( 36 );
+    ::memset( r.data(), 0, r.size() );
+    r[0] = 0x05;  // CD/DVD device
+    r[1] = 0x80;  // removable
+    r[3] = 0x02;
+    r[4] = r.size() - 5;
+    ::memcpy( &r[8], "K3B     ", 8 );
+    ::memcpy( &r[16], "VIRTUAL DRIVE   ", 16 );
+    ::memcpy( &r[32], "1.0 ", 4 );
+    reply( r, cdb[4], data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::getConfiguration( const unsigned char* cdb, unsigned char* data, size_t len, Sense& )
+{
+    const int rt = cdb[1] & 0x3;
+    const int startFeature = from2Byte( &cdb[2] );
+    const int current = currentProfile();
+    const bool dvd = isDvd();
+    const bool medium = hasMedium();
+
+    UByteArray r( 8 );
+    ::memset( r.data(), 0, r.size() );
+    set2Byte( &r[6], current );
+
+    // feature code, current flag, feature dependent data
+    struct Feature {
+        int code;
+        bool current;
+        int dataLength;
+    };
+    const Feature features[] = {
+        { 0x0000, true, 0 },
+        { 0x0001, true, 8 },
+        { 0x0003, true, 4 },
+        { 0x0010, medium, 8 },
+        { 0x001E, medium && !dvd, 4 },
+        { 0x001F, medium && dvd, 4 },
+        { 0x002D, writeFile && !dvd, 4 },
+        { 0x002F, writeFile && dvd, 4 }
+    };
+
+    QList<int> profiles;
+    profiles << 0x08;
+    if( dvd )
+        profiles << 0x10;
+    if( current != 0 && !profiles.contains( current ) )
+        profiles << current;
+
+    for( unsigned int i = 0; i < sizeof(features)/sizeof(Feature); ++i ) {
+        const Feature& feature = features[i];
+        if( ( feature.code == 0x001E || feature.code == 0x001F ) && !feature.current )
+            continue;
+        if( ( feature.code == 0x002D || feature.code == 0x002F ) && !feature.current )
+            continue;
+        if( rt == 2 ? feature.code != startFeature : feature.code < startFeature )
+            continue;
+        if( rt == 1 && !feature.current )
+            continue;
+
+        const int dataLength = ( feature.code == 0x0000 ? profiles.count()*4 : feature.dataLength );
+        const int pos = r.size();
+        r.resize( pos + 4 + dataLength );
+        ::memset( &r[pos], 0, 4 + dataLength );
+        unsigned char* p = &r[pos];
+        set2Byte( p, feature.code );
+        p[2] = ( feature.code <= 0x0003 ? 0x2 : 0x0 ) | ( feature.current ? 0x1 : 0x0 );
+        p[3] = dataLength;
+
+        switch( feature.code ) {
+        case 0x0000:
+            for( int j = 0; j < profiles.count(); ++j ) {
+                set2Byte( &p[4 + j*4], profiles[j] );
+                p[6 + j*4] = ( profiles[j] == current ? 0x1 : 0x0 );
+            }
+            break;
+        case 0x0001:
+            set4Byte( &p[4], 0x2 );  // ATAPI
+            break;
+        case 0x0003:
+            p[4] = 0x29;  // tray, eject
+            break;
+        case 0x0010:
+            set4Byte( &p[4], DATA_SECTOR_SIZE );
+            set2Byte( &p[8], dvd ? 16 : 1 );
+            break;
+        case 0x001E:
+            p[4] = 0x2;  // C2 pointers
+            break;
+        case 0x002D:
+            p[4] = 0x4;  // test write
+            set2Byte( &p[6], 0x1 );  // Mode 1
+            break;
+        default:
+            break;
+        }
+
+        if( rt == 2 )
+            break;
+    }
+
+    set4Byte( &r[0], r.size() - 4 );
+    reply( r, from2Byte( &cdb[7] ), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::getEventStatus( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense )
+{
+    // only polling is supported
+    if( !( cdb[1] & 0x1 ) )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    UByteArray r;
+    if( cdb[4] & 0x10 ) {
+        r.resize( 8 );
+        ::memset( r.data(), 0, r.size() );
+        set2Byte( &r[0], 6 );
+        r[2] = 0x04;  // media class
+        r[3] = 0x10;
+        r[4] = 0x00;  // no change
+        r[5] = ( hasMedium() ? 0x02 : 0x00 );
+    }
+    else {
+        r.resize( 4 );
+        ::memset( r.data(), 0, r.size() );
+        set2Byte( &r[0], 2 );
+        r[2] = 0x80;  // no event available
+        r[3] = 0x10;
+    }
+
+    reply( r, from2Byte( &cdb[7] ), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::readCapacity( unsigned char* data, size_t len, Sense& sense )
+{
+    if( !hasMedium() )
+        return fail( sense, NOT_READY, 0x3A );
+
+    UByteArray r( 8 );
+    set4Byte( &r[0], qMax( 0, mediumSize() - 1 ) );
+    set4Byte( &r[4], DATA_SECTOR_SIZE );
+    reply( r, r.size(), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::read( int lba, int count, unsigned char* data, size_t len, Sense& sense )
+{
+    if( len < size_t( count ) * DATA_SECTOR_SIZE )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    while( count > 0 ) {
+        const int track = trackAt( lba );
+        if( track < 0 )
+            return fail( sense, ILLEGAL_REQUEST, 0x21 );
+        if( trackIsAudio( track ) )
+            return fail( sense, ILLEGAL_REQUEST, 0x64 );
+
+        const int n = qMin( count, trackStart( track ) + trackLength( track ) - lba );
+        if( !readSectors( track, lba, n, data ) )
+            return fail( sense, 0x3, 0x11 );  // unrecovered read error
+
+        data += n * DATA_SECTOR_SIZE;
+        lba += n;
+        count -= n;
+    }
+
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::readCd( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense )
+{
+    if( isDvd() )
+        return fail( sense, ILLEGAL_REQUEST, 0x64 );
+
+    const int expectedType = ( cdb[1] >> 2 ) & 0x7;
+    int lba = from4Byte( &cdb[2] );
+    const int count = ( cdb[6] << 16 ) | ( cdb[7] << 8 ) | cdb[8];
+    const int flags = cdb[9];
+    const int c2 = ( flags >> 1 ) & 0x3;
+    const int subChannel = cdb[10] & 0x7;
+
+    int c2Size = 0;
+    if( c2 == 1 )
+        c2Size = 294;
+    else if( c2 == 2 )
+        c2Size = 296;
+    else if( c2 != 0 )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    int subSize = 0;
+    if( subChannel == 1 || subChannel == 4 )
+        subSize = 96;
+    else if( subChannel == 2 )
+        subSize = 16;
+    else if( subChannel != 0 )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    if( expectedType > 2 )
+        return fail( sense, ILLEGAL_REQUEST, 0x64 );
+
+    unsigned char sector[RAW_SECTOR_SIZE];
+    unsigned char* end = data + len;
+
+    for( int i = 0; i < count; ++i, ++lba ) {
+        const int track = trackAt( lba );
+        if( track < 0 )
+            return fail( sense, ILLEGAL_REQUEST, 0x21 );
+        const bool audio = trackIsAudio( track );
+        if( ( expectedType == 1 && !audio ) || ( expectedType == 2 && audio ) )
+            return fail( sense, ILLEGAL_REQUEST, 0x64 );
+
+        // the main channel parts requested by the flags
+        int mainOffset = 0;
+        int mainSize = 0;
+        if( audio ) {
+            if( flags & 0xF8 )
+                mainSize = RAW_SECTOR_SIZE;
+        }
+        else {
+            const bool sync = flags & 0x80;
+            const bool header = flags & 0x20;
+            const bool userData = flags & 0x10;
+            const bool edcEcc = flags & 0x08;
+            mainOffset = ( sync ? 0 : header ? 12 : 16 );
+            int mainEnd = 0;
+            if( edcEcc )
+                mainEnd = RAW_SECTOR_SIZE;
+            else if( userData )
+                mainEnd = 16 + DATA_SECTOR_SIZE;
+            else if( header )
+                mainEnd = 16;
+            else if( sync )
+                mainEnd = 12;
+            mainSize = qMax( 0, mainEnd - mainOffset );
+        }
+
+        if( data + mainSize + c2Size + subSize > end )
+            return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+        if( mainSize > 0 ) {
+            if( audio ) {
+                if( !readSectors( track, lba, 1, data ) )
+                    return fail( sense, 0x3, 0x11 );
+            }
+            else {
+                if( !readSectors( track, lba, 1, sector + 16 ) )
+                    return fail( sense, 0x3, 0x11 );
+                buildMode1Sector( lba, sector );
+                ::memcpy( data, sector + mainOffset, mainSize );
+            }
+            data += mainSize;
+        }
+
+        // the emulated medium has no errors
+        if( c2Size > 0 ) {
+            ::memset( data, 0, c2Size );
+            data += c2Size;
+        }
+
+        if( subSize > 0 ) {
+            unsigned char q[12];
+            buildQ( track, lba, q );
+            ::memset( data, 0, subSize );
+            if( subChannel == 2 ) {
+                ::memcpy( data, q, 12 );
+            }
+            else if( subChannel == 1 ) {
+                // raw P-W: one bit of each channel per byte, Q is bit 6
+                for( int bit = 0; bit < 96; ++bit ) {
+                    if( q[bit/8] & ( 0x80 >> ( bit%8 ) ) )
+                        data[bit] |= 0x40;
+                }
+            }
+            data += subSize;
+        }
+    }
+
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::readToc( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense )
+{
+    const bool msf = cdb[1] & 0x2;
+    const int format = cdb[2] & 0xF;
+    const int startTrack = cdb[6];
+    const int n = trackCount();
+
+    if( n == 0 )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    UByteArray r( 4 );
+    r[2] = 1;
+    r[3] = ( format == 0 ? n : 1 );
+
+    if( format == 0 ) {
+        if( startTrack > n && startTrack != 0xAA )
+            return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+        for( int i = qMax( 0, startTrack - 1 ); i <= n; ++i ) {
+            if( i < n && startTrack == 0xAA )
+                continue;
+            const int pos = r.size();
+            r.resize( pos + 8 );
+            ::memset( &r[pos], 0, 8 );
+            r[pos+1] = 0x10 | trackControl( qMin( i, n-1 ) );
+            r[pos+2] = ( i < n ? i + 1 : 0xAA );
+            setAddress( &r[pos+4], i < n ? trackStart( i ) : mediumSize(), msf );
+        }
+    }
+    else if( format == 1 ) {
+        r.resize( 12 );
+        ::memset( &r[4], 0, 8 );
+        r[5] = 0x10 | trackControl( 0 );
+        r[6] = 1;
+        setAddress( &r[8], trackStart( 0 ), msf );
+    }
+    else if( format == 2 ) {
+        // A0, A1, A2 followed by the tracks
+        for( int i = -3; i < n; ++i ) {
+            const int pos = r.size();
+            r.resize( pos + 11 );
+            ::memset( &r[pos], 0, 11 );
+            r[pos] = 1;
+            unsigned char* p = &r[pos];
+            if( i == -3 ) {
+                p[1] = 0x10 | trackControl( 0 );
+                p[3] = 0xA0;
+                p[8] = 1;
+                p[9] = 0x00;  // CD-DA or CD-ROM
+            }
+            else if( i == -2 ) {
+                p[1] = 0x10 | trackControl( n-1 );
+                p[3] = 0xA1;
+                p[8] = n;
+            }
+            else if( i == -1 ) {
+                p[1] = 0x10 | trackControl( n-1 );
+                p[3] = 0xA2;
+                lbaToMsf( mediumSize(), p[8], p[9], p[10] );
+            }
+            else {
+                p[1] = 0x10 | trackControl( i );
+                p[3] = i + 1;
+                lbaToMsf( trackStart( i ), p[8], p[9], p[10] );
+            }
+        }
+    }
+    else {
+        // no PMA, ATIP or CD-Text on the emulated media
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+    }
+
+    set2Byte( &r[0], r.size() - 2 );
+    reply( r, from2Byte( &cdb[7] ), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::readDiscInformation( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense )
+{
+    if( !hasMedium() )
+        return fail( sense, NOT_READY, 0x3A );
+
+    UByteArray r( 34 );
+    ::memset( r.data(), 0, r.size() );
+    set2Byte( &r[0], r.size() - 2 );
+
+    int discStatus = 2;
+    int sessionState = 3;
+    if( writeFile && !closed ) {
+        discStatus = ( written > 0 ? 1 : 0 );
+        sessionState = ( written > 0 ? 1 : 0 );
+    }
+    r[2] = ( sessionState << 2 ) | discStatus;
+    r[3] = 1;
+    r[4] = 1;
+    r[5] = 1;
+    r[6] = qMax( 1, trackCount() );
+
+    if( discStatus == 2 ) {
+        set4Byte( &r[16], 0xFFFFFFFF );
+        set4Byte( &r[20], 0xFFFFFFFF );
+    }
+    else {
+        setAddress( &r[16], 0, !isDvd() );
+        setAddress( &r[20], capacity, !isDvd() );
+    }
+
+    reply( r, from2Byte( &cdb[7] ), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::readTrackInformation( const unsigned char* cdb, unsigned char* data, size_t len, Sense& sense )
+{
+    if( !hasMedium() )
+        return fail( sense, NOT_READY, 0x3A );
+
+    const int type = cdb[1] & 0x3;
+    const quint32 value = from4Byte( &cdb[2] );
+
+    int track = -1;
+    if( writeFile ) {
+        // the single, possibly still invisible, track
+        track = 0;
+    }
+    else if( type == 0 ) {
+        track = trackAt( value );
+    }
+    else if( type == 1 ) {
+        track = int( value ) - 1;
+    }
+    else if( type == 2 && value == 1 ) {
+        track = 0;
+    }
+    if( track < 0 || ( !writeFile && track >= trackCount() ) )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    UByteArray r( 36 );
+    ::memset( r.data(), 0, r.size() );
+    set2Byte( &r[0], r.size() - 2 );
+    r[2] = track + 1;
+    r[3] = 1;
+
+    if( writeFile ) {
+        r[5] = 0x4;
+        r[6] = ( written == 0 ? 0x40 : 0x00 ) | 0x1;
+        if( !closed ) {
+            r[6] |= 0x80;
+            r[7] = 0x1;  // NWA valid
+        }
+        set4Byte( &r[8], 0 );
+        set4Byte( &r[12], written );
+        set4Byte( &r[16], closed ? 0 : capacity - written );
+        set4Byte( &r[24], closed ? written : capacity );
+        set4Byte( &r[28], qMax( 0, written - 1 ) );
+    }
+    else {
+        r[5] = trackControl( track );
+        r[6] = ( trackIsAudio( track ) ? 0x0 : 0x1 );
+        set4Byte( &r[8], trackStart( track ) );
+        set4Byte( &r[24], trackLength( track ) );
+        set4Byte( &r[28], trackStart( track ) + trackLength( track ) - 1 );
+    }
+
+    reply( r, from2Byte( &cdb[7] ), data, len );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::Private::write( const unsigned char* cdb, const unsigned char* data, size_t len, Sense& sense )
+{
+    if( !writeFile || closed )
+        return fail( sense, 0x7, 0x27 );  // write protected
+
+    const int lba = from4Byte( &cdb[2] );
+    const int count = from2Byte( &cdb[7] );
+    if( lba < 0 || lba + count > capacity )
+        return fail( sense, ILLEGAL_REQUEST, 0x21 );
+
+    const qint64 size = qint64( count ) * DATA_SECTOR_SIZE;
+    if( len < size_t( size ) )
+        return fail( sense, ILLEGAL_REQUEST, 0x24 );
+
+    // seeking beyond the end leaves a hole in the file
+    if( !writeFile->seek( qint64( lba ) * DATA_SECTOR_SIZE ) ||
+        writeFile->write( reinterpret_cast<const char*>( data ), size ) != size )
+        return fail( sense, 0x3, 0x0C );  // write error
+
+    written = qMax( written, lba + count );
+    return true;
+}
+
+
+K3b::Device::VirtualDrive::VirtualDrive()
+    : d( new Private() )
+{
+}
+
+
+K3b::Device::VirtualDrive::~VirtualDrive()
+{
+    Q_FOREACH( const TrackEntry& track, d->tracks )
+        delete track.file;
+    delete d->writeFile;
+    delete d;
+}
+
+
+bool K3b::Device::VirtualDrive::addTrack( const QString& imageFile, Track::TrackType type )
+{
+    QFile* file = new QFile( imageFile );
+    if( !file->open( QIODevice::ReadOnly ) ) {
+        qDebug() << "(K3b::Device::VirtualDrive) could not open" << imageFile;
+        delete file;
+        return false;
+    }
+
+    const int sectorSize = ( type == Track::TYPE_AUDIO ? RAW_SECTOR_SIZE : DATA_SECTOR_SIZE );
+
+    QMutexLocker locker( &d->mutex );
+    TrackEntry track;
+    track.file = file;
+    track.audio = ( type == Track::TYPE_AUDIO );
+    track.start = d->mediumSize();
+    track.length = int( ( file->size() + sectorSize - 1 ) / sectorSize );
+    d->tracks.append( track );
+    return true;
+}
+
+
+bool K3b::Device::VirtualDrive::setWriteImage( const QString& imageFile, int capacity )
+{
+    QFile* file = new QFile( imageFile );
+    if( !file->open( QIODevice::ReadWrite|QIODevice::Truncate ) ) {
+        qDebug() << "(K3b::Device::VirtualDrive) could not open" << imageFile;
+        delete file;
+        return false;
+    }
+
+    QMutexLocker locker( &d->mutex );
+    delete d->writeFile;
+    d->writeFile = file;
+    d->capacity = capacity;
+    d->written = 0;
+    d->closed = false;
+    return true;
+}
+
+
+void K3b::Device::VirtualDrive::setProfile( int profile )
+{
+    QMutexLocker locker( &d->mutex );
+    d->profile = profile;
+}
+
+
+int K3b::Device::VirtualDrive::profile() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->currentProfile();
+}
+
+
+void K3b::Device::VirtualDrive::setLatency( int usecs )
+{
+    QMutexLocker locker( &d->mutex );
+    d->latency = qMax( 0, usecs );
+}
+
+
+void K3b::Device::VirtualDrive::setThroughput( int kbPerSecond )
+{
+    QMutexLocker locker( &d->mutex );
+    d->throughput = qMax( 0, kbPerSecond );
+}
+
+
+qint64 K3b::Device::VirtualDrive::commandCount() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->commands;
+}
+
+
+bool K3b::Device::VirtualDrive::execute( const unsigned char* cdb,
+                                         TransportDirection dir,
+                                         unsigned char* data,
+                                         size_t len,
+                                         Sense& sense )
+{
+    Q_UNUSED( dir );
+
+    qint64 delay = 0;
+    bool success = true;
+
+    {
+        QMutexLocker locker( &d->mutex );
+        ++d->commands;
+
+        switch( cdb[0] ) {
+        case MMC_TEST_UNIT_READY:
+            if( !d->hasMedium() )
+                success = d->fail( sense, NOT_READY, 0x3A );
+            break;
+
+        case MMC_INQUIRY:
+            success = d->inquiry( cdb, data, len, sense );
+            break;
+
+        case MMC_GET_CONFIGURATION:
+            success = d->getConfiguration( cdb, data, len, sense );
+            break;
+
+        case MMC_GET_EVENT_STATUS_NOTIFICATION:
+            success = d->getEventStatus( cdb, data, len, sense );
+            break;
+
+        case MMC_READ_CAPACITY:
+            success = d->readCapacity( data, len, sense );
+            break;
+
+        case MMC_READ_10:
+            success = d->read( from4Byte( &cdb[2] ), from2Byte( &cdb[7] ), data, len, sense );
+            break;
+
+        case MMC_READ_12:
+            success = d->read( from4Byte( &cdb[2] ), from4Byte( &cdb[6] ), data, len, sense );
+            break;
+
+        case MMC_READ_CD:
+            success = d->readCd( cdb, data, len, sense );
+            break;
+
+        case MMC_READ_TOC_PMA_ATIP:
+            success = d->readToc( cdb, data, len, sense );
+            break;
+
+        case MMC_READ_DISC_INFORMATION:
+            success = d->readDiscInformation( cdb, data, len, sense );
+            break;
+
+        case MMC_READ_TRACK_INFORMATION:
+            success = d->readTrackInformation( cdb, data, len, sense );
+            break;
+
+        case MMC_WRITE_10:
+            success = d->write( cdb, data, len, sense );
+            break;
+
+        case MMC_SYNCHRONIZE_CACHE:
+            if( d->writeFile )
+                d->writeFile->flush();
+            break;
+
+        case MMC_CLOSE_TRACK_SESSION:
+            if( d->writeFile && d->written > 0 )
+                d->closed = true;
+            break;
+
+        case MMC_SET_SPEED:
+        case MMC_SET_STREAMING:
+        case MMC_SET_READ_AHEAD:
+        case MMC_SEEK_10:
+        case MMC_START_STOP_UNIT:
+        case MMC_PREVENT_ALLOW_MEDIUM_REMOVAL:
+            break;
+
+        default:
+            success = d->fail( sense, ILLEGAL_REQUEST, 0x20 );
+            break;
+        }
+
+        // Keep a timeline instead of sleeping a fixed time per command so
+        // the configured throughput holds regardless of the request size.
+        qint64 cost = d->latency;
+        if( success && d->throughput > 0 )
+            cost += qint64( len ) * 1000000 / ( qint64( d->throughput ) * 1024 );
+        if( cost > 0 ) {
+            const qint64 now = d->clock.nsecsElapsed() / 1000;
+            d->busyUntil = qMax( d->busyUntil, now ) + cost;
+            delay = d->busyUntil - now;
+        }
+    }
+
+    if( delay > 0 )
+        QThread::usleep( delay );
+
+    return success;
+}
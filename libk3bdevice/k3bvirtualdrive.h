@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_VIRTUAL_DRIVE_H_
+#define _K3B_VIRTUAL_DRIVE_H_
+
+#include "k3bscsicommand.h"
+#include "k3btrack.h"
+
+#include <QString>
+
+
+namespace K3b {
+    namespace Device
+    {
+        /**
+         * An MMC drive emulated from image files.
+         *
+         * The medium is made up of tracks, each backed by a file: data tracks
+         * use 2048 byte sectors (Mode 1), audio tracks 2352 byte sectors. When
+         * a write image is set the medium is a blank writable one instead and
+         * WRITE (10) stores the sectors in that (sparse) file.
+         *
+         * Supported are TEST UNIT READY, INQUIRY, GET CONFIGURATION, GET EVENT
+         * STATUS NOTIFICATION, READ CAPACITY, READ (10), READ (12), READ CD
+         * including sub-channel data, READ TOC/PMA/ATIP (formats 0, 1 and 2),
+         * READ DISC INFORMATION, READ TRACK INFORMATION, WRITE (10),
+         * SYNCHRONIZE CACHE and CLOSE TRACK/SESSION. Speed and tray commands
+         * succeed without effect, everything else fails with ILLEGAL REQUEST.
+         *
+         * Latency and throughput can be configured to measure the code using
+         * the drive under reproducible conditions.
+         *
+         * \code
+         * VirtualDrive* drive = new VirtualDrive();
+         * drive->addTrack( "/tmp/image.iso", Track::TYPE_DATA );
+         * drive->setThroughput( 10 * 1385 );
+         * Device* dev = deviceManager->addVirtualDevice( "virtual:0", drive );
+         * \endcode
+         */
+        class LIBK3BDEVICE_EXPORT VirtualDrive : public ScsiTransport
+        {
+        public:
+            VirtualDrive();
+            ~VirtualDrive() override;
+
+            /**
+             * Append a track backed by \p imageFile to the medium.
+             *
+             * \return false if the file could not be opened.
+             */
+            bool addTrack( const QString& imageFile, Track::TrackType type );
+
+            /**
+             * Emulate a blank writable medium of \p capacity blocks whose
+             * written sectors are stored in \p imageFile.
+             */
+            bool setWriteImage( const QString& imageFile, int capacity );
+
+            /**
+             * The MMC profile reported as the current one. By default it
+             * is CD-ROM (0x08) or CD-R (0x09) when a write image is set.
+             * Use 0x10 (DVD-ROM) or 0x11 (DVD-R) to emulate DVD media.
+             */
+            void setProfile( int profile );
+            int profile() const;
+
+            /**
+             * Delay added to every command in microseconds. Default is 0.
+             */
+            void setLatency( int usecs );
+
+            /**
+             * Maximum transfer rate in KB/s. Default is 0, i.e. unlimited.
+             */
+            void setThroughput( int kbPerSecond );
+
+            /**
+             * The number of commands executed so far.
+             */
+            qint64 commandCount() const;
+
+            bool execute( const unsigned char* cdb,
+                          TransportDirection dir,
+                          unsigned char* data,
+                          size_t len,
+                          Sense& sense ) override;
+
+        private:
+            class Private;
+            Private* const d;
+
+            Q_DISABLE_COPY( VirtualDrive )
+        };
+    }
+}
+
+#endif
@@ -417,6 +417,40 @@ K3b::AudioDecoder* K3bFLACDecoderFactory::createDecoder( QObject* parent) const
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bFLACDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    return( head.format() == K3b::AudioFileHead::FORMAT_FLAC ? SNIFF_YES : SNIFF_NO );
+}
+
+
+bool K3bFLACDecoderFactory::canDecodeHead( const K3b::AudioFileHead& head )
+{
+    //
+    // The STREAMINFO block always comes first: after the magic number a metadata
+    // block header with type 0, then 16 bits min and max block size, 24 bits min and
+    // max frame size, 20 bits sample rate, 3 bits channels-1, 5 bits bits/sample-1.
+    //
+    const QByteArray data = head.head();
+    const unsigned char* buf = reinterpret_cast<const unsigned char*>( data.constData() );
+    if( data.size() < 8 + 34 || ( buf[4] & 0x7f ) != 0 )
+        return canDecode( head.url() );
+
+    const unsigned char* info = buf + 8;
+    const unsigned int channels = ( ( info[12] >> 1 ) & 0x7 ) + 1;
+    const unsigned int bitsPerSample = ( ( ( info[12] & 0x1 ) << 4 ) | ( info[13] >> 4 ) ) + 1;
+
+    if( channels <= 2 && bitsPerSample <= 16 ) {
+        return true;
+    }
+    else {
+        qDebug() << "(K3bFLACDecoder) " << head.url().toLocalFile() << ": wrong format:" << endl
+                 << "                channels:    " << channels << endl
+                 << "                bits/sample: " << bitsPerSample << endl;
+        return false;
+    }
+}
+
+
 bool K3bFLACDecoderFactory::canDecode( const QUrl& url )
 {
     // buffer large enough to read an ID3 tag header
@@ -27,6 +27,8 @@ public:
     ~K3bFLACDecoderFactory() override;
 
     bool canDecode( const QUrl& filename ) override;
+    SniffResult sniff( const K3b::AudioFileHead& head ) const override;
+    bool canDecodeHead( const K3b::AudioFileHead& head ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
 
@@ -206,6 +206,22 @@ K3b::AudioDecoder* K3bLibsndfileDecoderFactory::createDecoder( QObject* parent )
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bLibsndfileDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    // containers libsndfile does not read
+    switch( head.format() ) {
+    case K3b::AudioFileHead::FORMAT_MUSEPACK:
+    case K3b::AudioFileHead::FORMAT_MP4:
+    case K3b::AudioFileHead::FORMAT_ASF:
+    case K3b::AudioFileHead::FORMAT_APE:
+    case K3b::AudioFileHead::FORMAT_WAVPACK:
+        return SNIFF_NO;
+    default:
+        return SNIFF_MAYBE;
+    }
+}
+
+
 bool K3bLibsndfileDecoderFactory::canDecode( const QUrl& url )
 {
     SF_INFO infos;
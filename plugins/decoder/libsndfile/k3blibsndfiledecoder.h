@@ -28,6 +28,7 @@ public:
     ~K3bLibsndfileDecoderFactory() override;
 
     bool canDecode( const QUrl& filename ) override;
+    SniffResult sniff( const K3b::AudioFileHead& head ) const override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
 
@@ -466,6 +466,41 @@ K3b::AudioDecoder* K3bMadDecoderFactory::createDecoder( QObject* parent) const
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bMadDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    switch( head.format() ) {
+    case K3b::AudioFileHead::FORMAT_MPEG_AUDIO:
+        return SNIFF_YES;
+
+    case K3b::AudioFileHead::FORMAT_UNKNOWN: {
+        // libmad also finds frames after garbage at the start of a file
+        const QString ext = head.extension();
+        if( head.hasId3v2Tag() || head.hasId3v1Tag() || head.hasApeTag() ||
+            ext == "mp3" || ext == "mp2" || ext == "mpga" )
+            return SNIFF_MAYBE;
+        return SNIFF_NO;
+    }
+
+    default:
+        // some other format with a magic number
+        return SNIFF_NO;
+    }
+}
+
+
+bool K3bMadDecoderFactory::canDecodeHead( const K3b::AudioFileHead& head )
+{
+    if( head.format() == K3b::AudioFileHead::FORMAT_MPEG_AUDIO ) {
+        // only support layer III for now since otherwise some wave files
+        // are taken for layer I
+        return( head.mpegAudioLayer() == 3 );
+    }
+    else {
+        return canDecode( head.url() );
+    }
+}
+
+
 bool K3bMadDecoderFactory::canDecode( const QUrl& url )
 {
     //
@@ -33,6 +33,8 @@ public:
     ~K3bMadDecoderFactory() override;
 
     bool canDecode( const QUrl& filename ) override;
+    SniffResult sniff( const K3b::AudioFileHead& head ) const override;
+    bool canDecodeHead( const K3b::AudioFileHead& head ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
 
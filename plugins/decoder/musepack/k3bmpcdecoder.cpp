@@ -39,6 +39,12 @@ K3b::AudioDecoder* K3bMpcDecoderFactory::createDecoder( QObject* parent
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bMpcDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    return( head.format() == K3b::AudioFileHead::FORMAT_MUSEPACK ? SNIFF_YES : SNIFF_NO );
+}
+
+
 bool K3bMpcDecoderFactory::canDecode( const QUrl& url )
 {
     K3bMpcWrapper w;
@@ -30,6 +30,7 @@ public:
     ~K3bMpcDecoderFactory() override;
 
     bool canDecode( const QUrl& filename ) override;
+    SniffResult sniff( const K3b::AudioFileHead& head ) const override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
 
@@ -219,6 +219,35 @@ K3b::AudioDecoder* K3bOggVorbisDecoderFactory::createDecoder( QObject* parent )
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bOggVorbisDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    return( head.format() == K3b::AudioFileHead::FORMAT_OGG_VORBIS ? SNIFF_YES : SNIFF_NO );
+}
+
+
+bool K3bOggVorbisDecoderFactory::canDecodeHead( const K3b::AudioFileHead& head )
+{
+    //
+    // The first page only contains the identification header: packet type 1, "vorbis",
+    // 32 bits version, 8 bits channels, 32 bits sample rate
+    //
+    const QByteArray data = head.head();
+    const unsigned char* id = reinterpret_cast<const unsigned char*>( data.constData() ) + 28;
+    if( data.size() < 28 + 16 )
+        return canDecode( head.url() );
+
+    const quint32 version = id[7] | id[8] << 8 | id[9] << 16 | quint32( id[10] ) << 24;
+    const quint32 channels = id[11];
+    const quint32 rate = id[12] | id[13] << 8 | id[14] << 16 | quint32( id[15] ) << 24;
+    if( version != 0 || channels == 0 || rate == 0 ) {
+        qDebug() << "(K3bOggVorbisDecoder) not an Ogg-Vorbis file: " << head.url().toLocalFile();
+        return false;
+    }
+
+    return true;
+}
+
+
 bool K3bOggVorbisDecoderFactory::canDecode( const QUrl& url )
 {
     FILE* file = fopen( QFile::encodeName(url.toLocalFile()), "r" );
@@ -17,6 +17,7 @@
 
 #include <config-kylinburner.h>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QFile>
 
@@ -38,12 +39,19 @@ static unsigned long le_a_to_u_long( unsigned char* a ) {
 }
 
 
+static QString deviceName( QIODevice& f )
+{
+    QFile* file = qobject_cast<QFile*>( &f );
+    return file ? file->fileName() : QString( "file head" );
+}
+
+
 /**
  * Returns the length of the wave file in bytes
  * Otherwise 0 is returned.
  * leave file seek pointer past WAV header.
  */
-static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* channels = 0, int* samplesize = 0 )
+static unsigned long identifyWaveFile( QIODevice& f, int* samplerate = 0, int* channels = 0, int* samplesize = 0 )
 {
     typedef struct {
         unsigned char	ckid[4];
@@ -75,43 +83,43 @@ static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* chann
 
     // read riff chunk
     if( f.read( (char*)&chunk, sizeof(chunk) ) != sizeof(chunk) ) {
-        qDebug() << "(K3bWaveDecoder) unable to read from " << f.fileName();
+        qDebug() << "(K3bWaveDecoder) unable to read from " << deviceName( f );
         return 0;
     }
     if( qstrncmp( (char*)chunk.ckid, WAV_RIFF_MAGIC, 4 ) ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": not a RIFF file.";
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": not a RIFF file.";
         return 0;
     }
 
     // read wave chunk
     if( f.read( (char*)&riff, sizeof(riff) ) != sizeof(riff) ) {
-        qDebug() << "(K3bWaveDecoder) unable to read from " << f.fileName();
+        qDebug() << "(K3bWaveDecoder) unable to read from " << deviceName( f );
         return 0;
     }
     if( qstrncmp( (char*)riff.wave, WAV_WAVE_MAGIC, 4 ) ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": not a WAVE file.";
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": not a WAVE file.";
         return 0;
     }
 
 
     // read fmt chunk
     if( f.read( (char*)&chunk, sizeof(chunk) ) != sizeof(chunk) ) {
-        qDebug() << "(K3bWaveDecoder) unable to read from " << f.fileName();
+        qDebug() << "(K3bWaveDecoder) unable to read from " << deviceName( f );
         return 0;
     }
     if( qstrncmp( (char*)chunk.ckid, WAV_FMT_MAGIC, 4 ) ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": could not find format chunk.";
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": could not find format chunk.";
         return 0;
     }
     if( f.read( (char*)&fmt, sizeof(fmt) ) != sizeof(fmt) ) {
-        qDebug() << "(K3bWaveDecoder) unable to read from " << f.fileName();
+        qDebug() << "(K3bWaveDecoder) unable to read from " << deviceName( f );
         return 0;
     }
     if( le_a_to_u_short(fmt.fmt_tag) != 1 ||
         le_a_to_u_short(fmt.channels) > 2 ||
         ( le_a_to_u_short(fmt.bits_per_sample) != 16 &&
           le_a_to_u_short(fmt.bits_per_sample) != 8 ) ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": wrong format:" << endl
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": wrong format:" << endl
                  << "                format:      " << le_a_to_u_short(fmt.fmt_tag) << endl
                  << "                channels:    " << le_a_to_u_short(fmt.channels) << endl
                  << "                samplerate:  " << le_a_to_u_long(fmt.sample_rate) << endl
@@ -131,7 +139,7 @@ static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* chann
 
     // skip all other (unknown) format chunk fields
     if( !f.seek( f.pos() + le_a_to_u_long(chunk.cksize) - sizeof(fmt) ) ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": could not seek in file.";
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": could not seek in file.";
         return 0;
     }
 
@@ -140,7 +148,7 @@ static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* chann
     bool foundData = false;
     while( !foundData ) {
         if( f.read( (char*)&chunk, sizeof(chunk) ) != sizeof(chunk) ) {
-            qDebug() << "(K3bWaveDecoder) unable to read from " << f.fileName();
+            qDebug() << "(K3bWaveDecoder) unable to read from " << deviceName( f );
             return 0;
         }
 
@@ -148,7 +156,7 @@ static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* chann
         if( qstrncmp( (char*)chunk.ckid, WAV_DATA_MAGIC, 4 ) ) {
             qDebug() << "(K3bWaveDecoder) skipping chunk: " << (char*)chunk.ckid;
             if( !f.seek( f.pos() + le_a_to_u_long(chunk.cksize) ) ) {
-                qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": could not seek in file.";
+                qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": could not seek in file.";
                 return 0;
             }
         }
@@ -159,7 +167,7 @@ static unsigned long identifyWaveFile( QFile& f, int* samplerate = 0, int* chann
     // found data chunk
     unsigned long size = le_a_to_u_long(chunk.cksize);
     if( f.pos() + size > (unsigned long)f.size() ) {
-        qDebug() << "(K3bWaveDecoder) " << f.fileName() << ": file length " << f.size()
+        qDebug() << "(K3bWaveDecoder) " << deviceName( f ) << ": file length " << f.size()
                  << " does not match length from WAVE header " << f.pos() << " + " << size
                  << " - using actual length." << endl;
         size = (f.size() - f.pos());
@@ -376,5 +384,30 @@ bool K3bWaveDecoderFactory::canDecode( const QUrl& url )
 }
 
 
+K3b::AudioDecoderFactory::SniffResult K3bWaveDecoderFactory::sniff( const K3b::AudioFileHead& head ) const
+{
+    if( head.format() == K3b::AudioFileHead::FORMAT_WAVE && !head.hasId3v2Tag() && head.matches( "RIFF" ) )
+        return SNIFF_YES;
+    else
+        return SNIFF_NO;
+}
+
+
+bool K3bWaveDecoderFactory::canDecodeHead( const K3b::AudioFileHead& head )
+{
+    QByteArray data = head.head();
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    if( identifyWaveFile( buffer ) > 0 )
+        return true;
+
+    // the data chunk may come after the head
+    if( data.size() < head.size() )
+        return canDecode( head.url() );
+    else
+        return false;
+}
+
+
 
 #include "k3bwavedecoder.moc"
@@ -28,6 +28,8 @@ public:
     ~K3bWaveDecoderFactory() override;
 
     bool canDecode( const QUrl& filename ) override;
+    SniffResult sniff( const K3b::AudioFileHead& head ) const override;
+    bool canDecodeHead( const K3b::AudioFileHead& head ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
 
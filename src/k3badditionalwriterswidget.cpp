@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3badditionalwriterswidget.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bdevicemanager.h"
+
+#include <KLocalizedString>
+
+
+K3b::AdditionalWritersWidget::AdditionalWritersWidget( QWidget* parent )
+    : QListWidget( parent )
+{
+    setSelectionMode( QAbstractItemView::NoSelection );
+
+    connect( this, SIGNAL(itemChanged(QListWidgetItem*)),
+             this, SLOT(slotItemChanged(QListWidgetItem*)) );
+
+    setToolTip( i18n("Burn on these devices at the same time") );
+    setWhatsThis( i18n("<p>Each checked device writes a copy of the same data while the "
+                       "selected writer is burning. The source is only read once for "
+                       "all of them.</p>"
+                       "<p>A device which fails is not used for the remaining copies.") );
+}
+
+
+K3b::AdditionalWritersWidget::~AdditionalWritersWidget()
+{
+}
+
+
+QList<K3b::Device::Device*> K3b::AdditionalWritersWidget::selectedDevices() const
+{
+    QList<Device::Device*> devs;
+    for( int i = 0; i < count(); ++i ) {
+        QListWidgetItem* it = item( i );
+        if( it->checkState() == Qt::Checked ) {
+            if( Device::Device* dev = k3bcore->deviceManager()->findDevice( it->data( Qt::UserRole ).toString() ) )
+                devs.append( dev );
+        }
+    }
+    return devs;
+}
+
+
+void K3b::AdditionalWritersWidget::setDevices( const QList<K3b::Device::Device*>& devices )
+{
+    blockSignals( true );
+    clear();
+    Q_FOREACH( Device::Device* dev, devices ) {
+        QListWidgetItem* it = new QListWidgetItem( dev->vendor() + ' ' + dev->description(), this );
+        it->setData( Qt::UserRole, dev->blockDeviceName() );
+        it->setFlags( Qt::ItemIsEnabled|Qt::ItemIsUserCheckable );
+        it->setCheckState( m_checkedDevices.contains( dev->blockDeviceName() ) ? Qt::Checked : Qt::Unchecked );
+    }
+    blockSignals( false );
+}
+
+
+void K3b::AdditionalWritersWidget::saveConfig( KConfigGroup c )
+{
+    c.writeEntry( "additional_writers", m_checkedDevices );
+}
+
+
+void K3b::AdditionalWritersWidget::loadConfig( const KConfigGroup& c )
+{
+    m_checkedDevices = c.readEntry( "additional_writers", QStringList() );
+    blockSignals( true );
+    for( int i = 0; i < count(); ++i ) {
+        QListWidgetItem* it = item( i );
+        it->setCheckState( m_checkedDevices.contains( it->data( Qt::UserRole ).toString() ) ? Qt::Checked : Qt::Unchecked );
+    }
+    blockSignals( false );
+}
+
+
+void K3b::AdditionalWritersWidget::slotItemChanged( QListWidgetItem* item )
+{
+    const QString name = item->data( Qt::UserRole ).toString();
+    m_checkedDevices.removeAll( name );
+    if( item->checkState() == Qt::Checked )
+        m_checkedDevices.append( name );
+}
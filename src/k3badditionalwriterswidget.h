@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef _K3B_ADDITIONAL_WRITERS_WIDGET_H_
+#define _K3B_ADDITIONAL_WRITERS_WIDGET_H_
+
+#include <KConfigGroup>
+
+#include <QListWidget>
+
+
+namespace K3b {
+    namespace Device {
+        class Device;
+    }
+
+    /**
+     * A checkable list of burners which write the same data at the same
+     * time as the writer selected in the WriterSelectionWidget.
+     */
+    class AdditionalWritersWidget : public QListWidget
+    {
+        Q_OBJECT
+
+    public:
+        explicit AdditionalWritersWidget( QWidget* parent = 0 );
+        ~AdditionalWritersWidget() override;
+
+        /**
+         * The checked devices in the order they are listed.
+         */
+        QList<Device::Device*> selectedDevices() const;
+
+        void saveConfig( KConfigGroup );
+        void loadConfig( const KConfigGroup& );
+
+    public Q_SLOTS:
+        /**
+         * List \p devices. Devices which were listed before keep their
+         * check state.
+         */
+        void setDevices( const QList<K3b::Device::Device*>& devices );
+
+    private Q_SLOTS:
+        void slotItemChanged( QListWidgetItem* item );
+
+    private:
+        QStringList m_checkedDevices;
+    };
+}
+
+#endif
@@ -67,6 +67,14 @@ K3b::BurnProgressDialog::BurnProgressDialog( QWidget *parent, bool showSubProgre
 
     m_progressDeviceBuffer = new QProgressBar( m_frameExtraInfo );
     m_frameExtraInfoLayout->addWidget( m_progressDeviceBuffer, 2, 3 );
+
+    // only shown for jobs that report it
+    m_labelSourceThroughputTitle = new QLabel( i18n("Source read speed:"), m_frameExtraInfo );
+    m_frameExtraInfoLayout->addWidget( m_labelSourceThroughputTitle, 3, 2 );
+    m_labelSourceThroughput = new QLabel( m_frameExtraInfo );
+    m_frameExtraInfoLayout->addWidget( m_labelSourceThroughput, 3, 3 );
+    m_labelSourceThroughputTitle->hide();
+    m_labelSourceThroughput->hide();
     //m_frameExtraInfoLayout->addWidget( K3b::StdGuiItems::verticalLine( m_frameExtraInfo ), 1, 1, 2, 1 );
 
 }
@@ -89,9 +97,15 @@ void K3b::BurnProgressDialog::setBurnJob( K3b::BurnJob* burnJob )
 {
     K3b::JobProgressDialog::setJob(burnJob);
 
+    m_deviceStates.clear();
+    m_labelDevices->hide();
+
     if( burnJob ) {
         connect( burnJob, SIGNAL(bufferStatus(int)), this, SLOT(slotBufferStatus(int)) );
         connect( burnJob, SIGNAL(deviceBuffer(int)), this, SLOT(slotDeviceBuffer(int)) );
+        connect( burnJob, SIGNAL(sourceThroughput(int)), this, SLOT(slotSourceThroughput(int)) );
+        connect( burnJob, SIGNAL(devicePercent(K3b::Device::Device*,int)), this, SLOT(slotDevicePercent(K3b::Device::Device*,int)) );
+        connect( burnJob, SIGNAL(deviceFinished(K3b::Device::Device*,bool)), this, SLOT(slotDeviceFinished(K3b::Device::Device*,bool)) );
         connect( burnJob, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SLOT(slotWriteSpeed(int,K3b::Device::SpeedMultiplicator)) );
         connect( burnJob, SIGNAL(burning(bool)), m_progressWritingBuffer, SLOT(setEnabled(bool)) );
         connect( burnJob, SIGNAL(burning(bool)), m_progressDeviceBuffer, SLOT(setEnabled(bool)) );
@@ -151,6 +165,38 @@ void K3b::BurnProgressDialog::slotDeviceBuffer( int b )
 }
 
 
+void K3b::BurnProgressDialog::slotSourceThroughput( int s )
+{
+    m_labelSourceThroughputTitle->show();
+    m_labelSourceThroughput->show();
+    m_labelSourceThroughput->setText( QString("%1 KB/s").arg(s) );
+}
+
+
+void K3b::BurnProgressDialog::slotDevicePercent( K3b::Device::Device* dev, int p )
+{
+    m_deviceStates[dev->blockDeviceName()] = QString("%1%").arg(p);
+    updateDevicesLabel();
+}
+
+
+void K3b::BurnProgressDialog::slotDeviceFinished( K3b::Device::Device* dev, bool success )
+{
+    m_deviceStates[dev->blockDeviceName()] = success ? i18n("done") : i18n("failed");
+    updateDevicesLabel();
+}
+
+
+void K3b::BurnProgressDialog::updateDevicesLabel()
+{
+    QStringList states;
+    for( QMap<QString, QString>::const_iterator it = m_deviceStates.constBegin(); it != m_deviceStates.constEnd(); ++it )
+        states << i18nc( "device name and its writing progress", "%1: %2", it.key(), it.value() );
+    m_labelDevices->setText( states.join( "   " ) );
+    m_labelDevices->show();
+}
+
+
 void K3b::BurnProgressDialog::slotWriteSpeed( int s, K3b::Device::SpeedMultiplicator multiplicator )
 {
     m_labelWritingSpeed->setText( QString("%1 KB/s (%2x)").arg(s).arg(QLocale::system().toString((double)s/(double)multiplicator,'g',2)) );
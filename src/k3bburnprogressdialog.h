@@ -19,6 +19,8 @@
 #include "k3bjobprogressdialog.h"
 #include "k3bdevicetypes.h"
 
+#include <QMap>
+
 class QProgressBar;
 class QLabel;
 
@@ -45,6 +47,9 @@ namespace K3b {
         void slotWriteSpeed( int, K3b::Device::SpeedMultiplicator );
         void slotBufferStatus( int );
         void slotDeviceBuffer( int );
+        void slotSourceThroughput( int );
+        void slotDevicePercent( K3b::Device::Device*, int );
+        void slotDeviceFinished( K3b::Device::Device*, bool );
         void slotFinished(bool) override;
 
     protected:
@@ -52,6 +57,14 @@ namespace K3b {
         QProgressBar* m_progressWritingBuffer;
         QProgressBar* m_progressDeviceBuffer;
         QLabel* m_labelWritingSpeed;
+        QLabel* m_labelSourceThroughputTitle;
+        QLabel* m_labelSourceThroughput;
+
+    private:
+        void updateDevicesLabel();
+
+        // state of each device by block device name
+        QMap<QString, QString> m_deviceStates;
     };
 }
 
@@ -37,7 +37,9 @@ public:
     }
 
     bool stderrEnabled;
-    QMap<QString, QString> groups;
+
+    // append-only UTF-8 logs, half the size of QString storage
+    QMap<QString, QByteArray> groups;
     QMap<QString, QString> lastMessages;
     QMap<QString, int> lastMessageCount;
     int cacheSize;
@@ -95,18 +97,21 @@ void K3b::DebuggingOutputCache::addOutput( const QString& group, const QString&
     else {
         if ( d->lastMessageCount.contains( group ) &&
              d->lastMessageCount[group] > 1 ) {
-            d->groups[group].append( QString( "=== last message repeated %1 times. ===\n" ).arg( d->lastMessageCount[group]   ) );
+            d->groups[group].append( QString( "=== last message repeated %1 times. ===\n" ).arg( d->lastMessageCount[group]   ).toUtf8() );
         }
         d->lastMessageCount[group] = 1;
         d->lastMessages[group] = line;
 
-        d->cacheSize += line.length();
+        const QByteArray utf8 = line.toUtf8();
+        d->cacheSize += utf8.length();
         if ( d->cacheSize > s_maxCache &&
-            d->cacheSize - ( int )line.length() <= s_maxCache ) {
+            d->cacheSize - utf8.length() <= s_maxCache ) {
             d->groups[defaultGroup()].append( "=== K3b debugging output cache overflow ===\n" );
         }
         else if ( d->cacheSize <= s_maxCache ) {
-            d->groups[group].append( line + '\n' );
+            QByteArray& log = d->groups[group];
+            log.append( utf8 );
+            log.append( '\n' );
         }
     }
 }
@@ -122,13 +127,13 @@ K3b::DebuggingOutputCache& K3b::DebuggingOutputCache::operator<<( const QString&
 QString K3b::DebuggingOutputCache::toString() const
 {
     QString s;
-    for ( QMap<QString, QString>::const_iterator it = d->groups.constBegin();
+    for ( QMap<QString, QByteArray>::const_iterator it = d->groups.constBegin();
           it != d->groups.constEnd(); ++it ) {
         if ( !s.isEmpty() )
             s.append( '\n' );
         s.append( it.key() + '\n' );
         s.append( "-----------------------\n" );
-        s.append( *it );
+        s.append( QString::fromUtf8( *it ) );
     }
     return s;
 }
@@ -136,7 +141,12 @@ QString K3b::DebuggingOutputCache::toString() const
 
 QMap<QString, QString> K3b::DebuggingOutputCache::toGroups() const
 {
-    return d->groups;
+    QMap<QString, QString> groups;
+    for ( QMap<QString, QByteArray>::const_iterator it = d->groups.constBegin();
+          it != d->groups.constEnd(); ++it ) {
+        groups.insert( it.key(), QString::fromUtf8( *it ) );
+    }
+    return groups;
 }
 
 
@@ -80,3 +80,21 @@ void K3b::DebuggingOutputFile::addOutput( const QString& app, const QString& msg
 }
 
 
+
+
+void K3b::DebuggingOutputFile::addOutput( const QVector<JobTelemetry::DebuggingLine>& lines )
+{
+    if( lines.isEmpty() )
+        return;
+
+    if( !isOpen() )
+        open();
+
+    QTextStream s( this );
+    for( QVector<JobTelemetry::DebuggingLine>::const_iterator it = lines.constBegin();
+         it != lines.constEnd(); ++it ) {
+        s << "[" << it->group << "] " << it->line << '\n';
+    }
+    s.flush();
+    flush();
+}
@@ -15,8 +15,11 @@
 #ifndef _K3B_DEBUGGING_OUTPUT_FILE_H_
 #define _K3B_DEBUGGING_OUTPUT_FILE_H_
 
+#include "k3bjobtelemetry.h"
+
 #include <QFile>
 #include <QObject>
+#include <QVector>
 
 namespace K3b {
     class DebuggingOutputFile : public QFile
@@ -31,6 +34,11 @@ namespace K3b {
          */
         bool open( OpenMode mode = WriteOnly ) override;
 
+        /**
+         * Write a batch of lines with a single flush.
+         */
+        void addOutput( const QVector<JobTelemetry::DebuggingLine>& lines );
+
     public Q_SLOTS:
         void addOutput( const QString&, const QString& );
     };
@@ -22,6 +22,7 @@
 #include "k3bthemedlabel.h"
 #include "k3b.h"
 #include "k3bjob.h"
+#include "k3bjobtelemetry.h"
 #include "k3bdevice.h"
 #include "k3bdevicemanager.h"
 #include "k3bdeviceglobals.h"
@@ -73,6 +74,10 @@ public:
     QFrame* headerFrame;
     QFrame* progressHeaderFrame;
     QTreeWidget* viewInfo;
+
+    // samples the job's progress and debugging output at a fixed rate
+    // instead of updating the widgets for every single signal
+    K3b::JobTelemetry* telemetry;
 };
 
 
@@ -84,6 +89,14 @@ K3b::JobProgressDialog::JobProgressDialog( QWidget* parent,
     d = new Private;
     setupGUI();
 
+    d->telemetry = new K3b::JobTelemetry( this );
+    connect( d->telemetry, SIGNAL(percent(int)), m_progressPercent, SLOT(setValue(int)) );
+    connect( d->telemetry, SIGNAL(percent(int)), this, SLOT(slotProgress(int)) );
+    connect( d->telemetry, SIGNAL(subPercent(int)), m_progressSubPercent, SLOT(setValue(int)) );
+    connect( d->telemetry, SIGNAL(processedSubSize(int,int)), this, SLOT(slotProcessedSubSize(int,int)) );
+    connect( d->telemetry, SIGNAL(processedSize(int,int)), this, SLOT(slotProcessedSize(int,int)) );
+    connect( d->telemetry, SIGNAL(debuggingOutputAvailable()), this, SLOT(slotDebuggingOutputAvailable()) );
+
     if( !showSubProgress ) {
         m_progressSubPercent->hide();
     }
@@ -318,6 +331,13 @@ void K3b::JobProgressDialog::setupGUI()
     //m_progressPercent->setAlignment(Qt::AlignBottom | Qt::AlignVCenter);
     m_progressPercent->setStyleSheet(" background-color:#e9e9e9; border-radius:4px;font:12px;color:#FFFFFF;text-align: center;");
 
+    // only shown for jobs writing to several devices
+    m_labelDevices = new QLabel( this );
+    m_labelDevices->setStyleSheet("QLabel{font:12px;color:#888888}");
+    m_labelDevices->setWordWrap( true );
+    m_labelDevices->hide();
+    mainLayout->addWidget( m_labelDevices );
+
     //mainLayout->addWidget( d->viewInfo, 1 );
     layout4->addWidget( d->viewInfo );
     layout4->addWidget( m_labelProcessedSize );
@@ -492,7 +512,9 @@ void K3b::JobProgressDialog::slotInfoMessage( const QString& infoString, int typ
 void K3b::JobProgressDialog::slotFinished( bool success )
 {
     qDebug() << "received finished signal!";
-    
+
+    // deliver the final progress values and debugging output
+    d->telemetry->stop();
     m_logFile.close();
 
     const KColorScheme colorScheme( QPalette::Normal, KColorScheme::Window );
@@ -583,26 +605,19 @@ void K3b::JobProgressDialog::setJob( K3b::Job* job )
         disconnect( m_job );
     m_job = job;
 
+    // progress and debugging output are coalesced by the telemetry channel
+    d->telemetry->setJob( job );
+
     if( job ) {
         qDebug() << "connecting";
         connect( job, SIGNAL(infoMessage(QString,int)), this, SLOT(slotInfoMessage(QString,int)) );
 
-        connect( job, SIGNAL(percent(int)), m_progressPercent, SLOT(setValue(int)) );
-        connect( job, SIGNAL(percent(int)), this, SLOT(slotProgress(int)) );
-        connect( job, SIGNAL(subPercent(int)), m_progressSubPercent, SLOT(setValue(int)) );
-
-        connect( job, SIGNAL(processedSubSize(int,int)), this, SLOT(slotProcessedSubSize(int,int)) );
-        connect( job, SIGNAL(processedSize(int,int)), this, SLOT(slotProcessedSize(int,int)) );
-
         connect( job, SIGNAL(newTask(QString)), this, SLOT(slotNewTask(QString)) );
         connect( job, SIGNAL(newSubTask(QString)), this, SLOT(slotNewSubTask(QString)) );
         connect( job, SIGNAL(started()), this, SLOT(slotStarted()) );
         connect( job, SIGNAL(finished(bool)), this, SLOT(slotFinished(bool)) );
         connect( job, SIGNAL(canceled()), this, SLOT(slotCanceled()) );
 
-        connect( job, SIGNAL(debuggingOutput(QString,QString)),
-                 this, SLOT(slotDebuggingOutput(QString,QString)) );
-
         m_labelJob->setText( m_job->jobDescription() );
         m_labelJobDetails->setText( m_job->jobDetails() );
 
@@ -654,13 +669,18 @@ void K3b::JobProgressDialog::slotStarted()
     m_plainCaption = k3bappcore->k3bMainWindow()->windowTitle();
 
     m_logFile.open();
+    d->telemetry->start();
 }
 
 
-void K3b::JobProgressDialog::slotDebuggingOutput( const QString& type, const QString& output )
+void K3b::JobProgressDialog::slotDebuggingOutputAvailable()
 {
-    m_logCache.addOutput( type, output );
-    m_logFile.addOutput( type, output );
+    const QVector<K3b::JobTelemetry::DebuggingLine> lines = d->telemetry->takeDebuggingOutput();
+    for( QVector<K3b::JobTelemetry::DebuggingLine>::const_iterator it = lines.constBegin();
+         it != lines.constEnd(); ++it ) {
+        m_logCache.addOutput( it->group, it->line );
+    }
+    m_logFile.addOutput( lines );
 }
 
 
@@ -86,7 +86,7 @@ namespace K3b {
         virtual void slotProcessedSize( int processed, int size );
         virtual void slotProcessedSubSize( int processed, int size );
         virtual void slotInfoMessage( const QString& infoString, int type );
-        virtual void slotDebuggingOutput( const QString&, const QString& );
+        virtual void slotDebuggingOutputAvailable();
         virtual void slotNewSubTask(const QString& name);
         virtual void slotNewTask(const QString& name);
         virtual void slotFinished(bool);
@@ -123,6 +123,7 @@ namespace K3b {
         QProgressBar* m_progressSubPercent;
         QLabel* m_labelProcessedSize;
         QProgressBar* m_progressPercent;
+        QLabel* m_labelDevices;
         QFrame* m_frameExtraInfo;
         ThemedLabel* m_pixLabel;
         QPushButton* m_cancelButton;
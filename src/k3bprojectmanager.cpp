@@ -48,10 +48,9 @@
 #include <QHash>
 #include <QList>
 #include <QTemporaryFile>
-#include <QTextStream>
 #include <QUrl>
-#include <QDomDocument>
-#include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QCursor>
 #include <QApplication>
 
@@ -312,6 +311,7 @@ void K3b::ProjectManager::loadDefaults( K3b::Doc* doc )
         audioDoc->writeCdText( c.readEntry( "cd_text", true ) );
         audioDoc->setHideFirstTrack( c.readEntry( "hide_first_track", false ) );
         audioDoc->setNormalize( c.readEntry( "normalize-audio", false ) );
+        audioDoc->setVerifyData( c.readEntry( "verify data", false ) );
         audioDoc->setAudioRippingParanoiaMode( c.readEntry( "paranoia mode", 0 ) );
         audioDoc->setAudioRippingRetries( c.readEntry( "read retries", 128 ) );
         audioDoc->setAudioRippingIgnoreReadErrors( c.readEntry( "ignore read errors", false ) );
@@ -461,8 +461,8 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
 
     // ///////////////////////////////////////////////
     // first check if it's a store or an old plain xml file
-    bool success = false;
-    QDomDocument xmlDoc;
+    K3b::Doc* newDoc = 0;
+    bool isStore = false;
 
     // try opening a store
     KoStore* store = KoStore::createStore( tmpfile.fileName(), KoStore::Read );
@@ -470,10 +470,10 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
         if( !store->bad() ) {
             // try opening the document inside the store
             if( store->open( "maindata.xml" ) ) {
+                isStore = true;
                 QIODevice* dev = store->device();
                 dev->open( QIODevice::ReadOnly );
-                if( xmlDoc.setContent( dev ) )
-                    success = true;
+                newDoc = loadProjectData( dev );
                 dev->close();
                 store->close();
             }
@@ -482,18 +482,18 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
         delete store;
     }
 
-    if( !success ) {
+    if( !isStore ) {
         // try reading an old plain document
-        tmpfile.remove();
         if ( tmpfile.open() ) {
             //
             // First check if this is really an xml file beacuse if this is a very big file
-            // the setContent method blocks for a very long time
+            // parsing it would take a very long time
             //
             char test[5];
             if( tmpfile.read( test, 5 ) ) {
                 if( ::strncmp( test, "<?xml", 5 ) ) {
                     qDebug() << "(K3b::Doc) " << url.toLocalFile() << " seems to be no xml file.";
+                    tmpfile.remove();
                     QApplication::restoreOverrideCursor();
                     return 0;
                 }
@@ -501,43 +501,82 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
             }
             else {
                 qDebug() << "(K3b::Doc) could not read from file.";
+                tmpfile.remove();
                 QApplication::restoreOverrideCursor();
                 return 0;
             }
-            if( xmlDoc.setContent( &tmpfile ) )
-                success = true;
-            tmpfile.remove();
+            newDoc = loadProjectData( &tmpfile );
+            tmpfile.close();
         }
     }
 
+    tmpfile.remove();
+
     // ///////////////////////////////////////////////
-    if( !success ) {
+    if( newDoc ) {
+        newDoc->setURL( url );
+        newDoc->setSaved( true );
+        newDoc->setModified( false );
+
+        // ok, finish the doc setup, inform the others about the new project
+        //dcopInterface( newDoc );
+        addProject( newDoc );
+
+        // FIXME: find a better way to tell everyone (especially the projecttabwidget)
+        //        that the doc is not changed
+        emit projectSaved( newDoc );
+
+        qDebug() << "(K3b::ProjectManager) loading project done.";
+    }
+    else {
         qDebug() << "(K3b::Doc) could not open file " << url.toLocalFile();
-        QApplication::restoreOverrideCursor();
+    }
+
+    QApplication::restoreOverrideCursor();
+
+    return newDoc;
+}
+
+
+K3b::Doc* K3b::ProjectManager::loadProjectData( QIODevice* dev )
+{
+    QXmlStreamReader xml( dev );
+
+    // the DOCTYPE tells the project type
+    QString docType;
+    while( !xml.atEnd() ) {
+        xml.readNext();
+        if( xml.isDTD() )
+            docType = xml.dtdName().toString();
+        else if( xml.isStartElement() )
+            break;
+    }
+
+    if( !xml.isStartElement() ) {
+        qDebug() << "(K3b::Doc) no project found:" << xml.errorString();
         return 0;
     }
 
     // check the documents DOCTYPE
     K3b::Doc::Type type = K3b::Doc::AudioProject;
-    if( xmlDoc.doctype().name() == "k3b_audio_project" )
+    if( docType == "k3b_audio_project" )
         type = K3b::Doc::AudioProject;
-    else if( xmlDoc.doctype().name() == "k3b_data_project" )
+    else if( docType == "k3b_data_project" )
         type = K3b::Doc::DataProject;
-    else if( xmlDoc.doctype().name() == "k3b_vcd_project" )
+    else if( docType == "k3b_vcd_project" )
         type = K3b::Doc::VcdProject;
-    else if( xmlDoc.doctype().name() == "k3b_mixed_project" )
+    else if( docType == "k3b_mixed_project" )
         type = K3b::Doc::MixedProject;
-    else if( xmlDoc.doctype().name() == "k3b_movix_project" )
+    else if( docType == "k3b_movix_project" )
         type = K3b::Doc::MovixProject;
-    else if( xmlDoc.doctype().name() == "k3b_movixdvd_project" )
+    else if( docType == "k3b_movixdvd_project" )
         type = K3b::Doc::MovixProject; // backward compatibility
-    else if( xmlDoc.doctype().name() == "k3b_dvd_project" )
+    else if( docType == "k3b_dvd_project" )
         type = K3b::Doc::DataProject; // backward compatibility
-    else if( xmlDoc.doctype().name() == "k3b_video_dvd_project" ) {
+    else if( docType == "k3b_video_dvd_project" ) {
         type = K3b::Doc::VideoDvdProject;
     } else {
-        qDebug() << "(K3b::Doc) unknown doc type: " << xmlDoc.doctype().name();
-        QApplication::restoreOverrideCursor();
+        qDebug() << "(K3b::Doc) unknown doc type: " << docType;
         return 0;
     }
 
@@ -545,30 +584,14 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
     K3b::Doc* newDoc = createEmptyProject( type );
 
     // ---------
-    // load the data into the document
-    QDomElement root = xmlDoc.documentElement();
-    if( newDoc->loadDocumentData( &root ) ) {
-        newDoc->setURL( url );
-        newDoc->setSaved( true );
-        newDoc->setModified( false );
-
-        // ok, finish the doc setup, inform the others about the new project
-        //dcopInterface( newDoc );
-        addProject( newDoc );
-
-        // FIXME: find a better way to tell everyone (especially the projecttabwidget)
-        //        that the doc is not changed
-        emit projectSaved( newDoc );
-
-        qDebug() << "(K3b::ProjectManager) loading project done.";
-    }
-    else {
+    // load the data into the document while parsing
+    if( !newDoc->loadDocumentStream( xml ) || xml.hasError() ) {
+        if( xml.hasError() )
+            qDebug() << "(K3b::Doc) parse error in line" << xml.lineNumber() << ":" << xml.errorString();
         delete newDoc;
-        newDoc = 0;
+        return 0;
     }
 
-    QApplication::restoreOverrideCursor();
-
     return newDoc;
 }
 
@@ -591,19 +614,18 @@ bool K3b::ProjectManager::saveProject( K3b::Doc* doc, const QUrl& url )
             // open the document inside the store
             store->open( "maindata.xml" );
 
-            // save the data in the document
-            QDomDocument xmlDoc( "k3b_" + doc->typeString() + "_project" );
-
-            xmlDoc.appendChild( xmlDoc.createProcessingInstruction( "xml", "version=\"1.0\" encoding=\"UTF-8\"" ) );
-            QDomElement docElem = xmlDoc.createElement( "k3b_" + doc->typeString() + "_project" );
-            xmlDoc.appendChild( docElem );
-            success = doc->saveDocumentData( &docElem );
+            // save the data in the document while writing it
+            KoStoreDevice dev(store);
+            dev.open( QIODevice::WriteOnly );
+            QXmlStreamWriter xml( &dev );
+            xml.writeStartDocument();
+            xml.writeDTD( "<!DOCTYPE k3b_" + doc->typeString() + "_project>" );
+            xml.writeStartElement( "k3b_" + doc->typeString() + "_project" );
+            success = doc->saveDocumentStream( xml );
+            xml.writeEndElement();
+            xml.writeEndDocument();
+            success = success && !xml.hasError();
             if( success ) {
-                KoStoreDevice dev(store);
-                dev.open( QIODevice::WriteOnly );
-                QTextStream xmlStream( &dev );
-                xmlDoc.save( xmlStream, 0 );
-
                 doc->setURL( url );
                 doc->setModified( false );
             }
@@ -621,8 +643,15 @@ bool K3b::ProjectManager::saveProject( K3b::Doc* doc, const QUrl& url )
             }
         }
     }
-    KIO::CopyJob *copyJob = KIO::move(QUrl::fromLocalFile(tmpfile.fileName()), url);
-    copyJob->exec();
+
+    // do not replace the old project with a partially written one
+    if( success ) {
+        KIO::CopyJob *copyJob = KIO::move(QUrl::fromLocalFile(tmpfile.fileName()), url);
+        copyJob->exec();
+    }
+    else {
+        tmpfile.remove();
+    }
 
     return success;
 }
@@ -22,6 +22,7 @@
 #include <QObject>
 
 
+class QIODevice;
 class QUrl;
 
 namespace K3b {
@@ -82,6 +83,7 @@ namespace K3b {
     private:
         // used internal
         Doc* createEmptyProject( Doc::Type );
+        Doc* loadProjectData( QIODevice* dev );
 
         class Private;
         Private* d;
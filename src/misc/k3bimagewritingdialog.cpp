@@ -29,6 +29,7 @@
 #include "k3bdevicemanager.h"
 #include "k3bdevice.h"
 #include "k3bwriterselectionwidget.h"
+#include "k3badditionalwriterswidget.h"
 #include "k3bburnprogressdialog.h"
 #include "k3bstdguiitems.h"
 #include "k3bmd5job.h"
@@ -108,6 +109,8 @@ public:
     }
 
     WriterSelectionWidget* writerSelectionWidget;
+    QLabel* labelAdditionalWriters;
+    AdditionalWritersWidget* additionalWritersWidget;
     QCheckBox* checkDummy;
     QCheckBox* checkNoFix;
     QCheckBox* checkCacheImage;
@@ -591,6 +594,10 @@ void K3b::ImageWritingDialog::setupGui()
     d->writerSelectionWidget->setWantedMediumType( K3b::Device::MEDIA_WRITABLE );
     d->writerSelectionWidget->setWantedMediumState( K3b::Device::STATE_EMPTY );
 
+    d->labelAdditionalWriters = new QLabel( i18n("Also burn on:"), frame );
+    d->additionalWritersWidget = new K3b::AdditionalWritersWidget( frame );
+    d->additionalWritersWidget->setFixedSize( 368, 60 );
+
     // options
     // -----------------------------------------------------------------------
     //d->optionTabbed = new QTabWidget( frame );
@@ -643,6 +650,9 @@ void K3b::ImageWritingDialog::setupGui()
     d->checkVerify->setFont( label_font );
     d->checkVerify->setStyleSheet("color:#444444;");
 
+    d->labelAdditionalWriters->setFont( label_font );
+    d->labelAdditionalWriters->setStyleSheet("color:#444444;");
+
 //tmp
     d->tempDirSelectionWidget = new K3b::TempDirSelectionWidget( );
     QLabel *m_labeltmpPath = new QLabel( optionTab );
@@ -667,6 +677,9 @@ void K3b::ImageWritingDialog::setupGui()
     vlayout->addWidget( label_title );
     vlayout->addSpacing( 25 );
     vlayout->addWidget( d->writerSelectionWidget );
+    vlayout->addSpacing( 10 );
+    vlayout->addWidget( d->labelAdditionalWriters );
+    vlayout->addWidget( d->additionalWritersWidget );
     vlayout->addSpacing( 25 );
     vlayout->addWidget( d->checkDummy );
     vlayout->addSpacing( 11 );
@@ -912,6 +925,12 @@ void K3b::ImageWritingDialog::slotStartClicked()
         job_->setDataMode( d->dataModeWidget->dataMode() );
         job_->setImagePath( d->imageFile );
         job_->setCopies( d->checkDummy->isChecked() ? 1 : d->spinCopies->value() );
+        if( !d->checkDummy->isChecked() ) {
+            // one copy on each of the burners at least
+            const QList<K3b::Device::Device*> additionalDevices = d->additionalWritersWidget->selectedDevices();
+            job_->setAdditionalBurnDevices( additionalDevices );
+            job_->setCopies( qMax( d->spinCopies->value(), additionalDevices.count() + 1 ) );
+        }
 
         job = job_;
     }
@@ -1155,6 +1174,15 @@ void K3b::ImageWritingDialog::toggleAll()
                       && QFile::exists( d->imagePath() ) );
 
     // some stuff is only available for iso and opaque images
+    QList<K3b::Device::Device*> additionalDevices = d->writerSelectionWidget->allDevices();
+    additionalDevices.removeAll( d->writerSelectionWidget->writerDevice() );
+    d->additionalWritersWidget->setDevices( additionalDevices );
+    const bool showAdditionalWriters = ( d->currentImageType() == IMAGE_ISO || d->currentImageType() == IMAGE_RAW ) &&
+                                       !additionalDevices.isEmpty();
+    d->labelAdditionalWriters->setVisible( showAdditionalWriters );
+    d->additionalWritersWidget->setVisible( showAdditionalWriters );
+    d->additionalWritersWidget->setEnabled( !d->checkDummy->isChecked() );
+
     if (d->currentImageType() == IMAGE_ISO || d->currentImageType() == IMAGE_RAW) {
         d->checkVerify->show();
         if( !d->advancedTabVisible ) {
@@ -1319,6 +1347,7 @@ void K3b::ImageWritingDialog::loadSettings( const KConfigGroup& c )
     d->checkVerify->setChecked( c.readEntry( "verify_data", false ) );
 
     d->writerSelectionWidget->loadConfig( c );
+    d->additionalWritersWidget->loadConfig( c );
 
     if( !d->imageForced ) {
         QString image = c.readPathEntry( "image path", c.readPathEntry( "last written image", QString() ) );
@@ -1360,6 +1389,7 @@ void K3b::ImageWritingDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "verify_data", d->checkVerify->isChecked() );
 
     d->writerSelectionWidget->saveConfig( c );
+    d->additionalWritersWidget->saveConfig( c );
 
     c.writePathEntry( "image path", d->imagePath() );
 
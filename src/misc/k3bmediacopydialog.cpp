@@ -21,6 +21,7 @@
 #include "k3bdvdcopyjob.h"
 
 #include "k3bwriterselectionwidget.h"
+#include "k3badditionalwriterswidget.h"
 #include "k3btempdirselectionwidget.h"
 #include "k3bcore.h"
 #include "k3bstdguiitems.h"
@@ -133,6 +134,7 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_checkOnlyCreateImage = K3b::StdGuiItems::onlyCreateImagesCheckbox( groupOptions );
     m_checkDeleteImages = K3b::StdGuiItems::removeImagesCheckbox( groupOptions );
     m_checkVerifyData = K3b::StdGuiItems::verifyCheckBox( groupOptions );
+    m_additionalWritersWidget = new K3b::AdditionalWritersWidget( groupOptions );
     
 //******************************************
     m_checkCacheImage->setChecked( true );
@@ -158,6 +160,8 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     groupOptionsLayout->addWidget( m_checkOnlyCreateImage );
     groupOptionsLayout->addWidget( m_checkDeleteImages );
     groupOptionsLayout->addWidget( m_checkVerifyData );
+    groupOptionsLayout->addWidget( new QLabel( i18n("Also burn on:"), groupOptions ) );
+    groupOptionsLayout->addWidget( m_additionalWritersWidget );
 
     groupOptionsLayout->addWidget( m_labeltmpPath );
     groupOptionsLayout->addWidget( m_tmpPath );
@@ -215,13 +219,15 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_checkIgnoreAudioReadErrors = K3b::StdGuiItems::ignoreAudioReadErrorsCheckBox( m_groupAdvancedAudioOptions );
     m_comboParanoiaMode = K3b::StdGuiItems::paranoiaModeComboBox( m_groupAdvancedAudioOptions );
     m_checkReadCdText = new QCheckBox( i18n("Copy CD-Text"), m_groupAdvancedAudioOptions );
+    m_checkUseC2Pointers = new QCheckBox( i18n("Use C2 error pointers"), m_groupAdvancedAudioOptions );
     groupAdvancedAudioOptionsLayout->addWidget( new QLabel( i18n("Read retries:"), m_groupAdvancedAudioOptions ), 0, 0 );
     groupAdvancedAudioOptionsLayout->addWidget( m_spinAudioRetries, 0, 1 );
     groupAdvancedAudioOptionsLayout->addWidget( m_checkIgnoreAudioReadErrors, 1, 0, 1, 2 );
     groupAdvancedAudioOptionsLayout->addWidget( new QLabel( i18n("Paranoia mode:"), m_groupAdvancedAudioOptions ), 2, 0 );
     groupAdvancedAudioOptionsLayout->addWidget( m_comboParanoiaMode, 2, 1 );
     groupAdvancedAudioOptionsLayout->addWidget( m_checkReadCdText, 3, 0, 1, 2 );
-    groupAdvancedAudioOptionsLayout->setRowStretch( 4, 1 );
+    groupAdvancedAudioOptionsLayout->addWidget( m_checkUseC2Pointers, 4, 0, 1, 2 );
+    groupAdvancedAudioOptionsLayout->setRowStretch( 5, 1 );
 
     advancedTabGrid->addWidget( m_groupAdvancedDataOptions, 0, 1 );
     advancedTabGrid->addWidget( m_groupAdvancedAudioOptions, 0, 0 );
@@ -251,6 +257,7 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_checkIgnoreDataReadErrors->setToolTip( i18n("Skip unreadable data sectors") );
     m_checkNoCorrection->setToolTip( i18n("Disable the source drive's error correction") );
     m_checkReadCdText->setToolTip( i18n("Copy CD-Text from the source CD if available.") );
+    m_checkUseC2Pointers->setToolTip( i18n("Let the source drive report damaged audio sectors") );
 
     m_checkNoCorrection->setWhatsThis( i18n("<p>If this option is checked K3b will disable the "
                                             "source drive's ECC/EDC error correction. This way sectors "
@@ -260,6 +267,9 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_checkReadCdText->setWhatsThis( i18n("<p>If this option is checked K3b will search for CD-Text on the source CD. "
                                           "Disable it if your CD drive has problems with reading CD-Text or you want "
                                           "to stick to CDDB info.") );
+    m_checkUseC2Pointers->setWhatsThis( i18n("<p>If this option is checked and the source drive reliably reports "
+                                             "C2 errors, K3b reads the audio tracks at full speed and only runs "
+                                             "paranoia on the sectors the drive flags as damaged.") );
     m_checkIgnoreDataReadErrors->setWhatsThis( i18n("<p>If this option is checked and K3b is not able to read a data sector from the "
                                                     "source medium it will be replaced with zeros on the resulting copy.") );
 
@@ -421,6 +431,7 @@ qDebug() << "temp path:::" << m_tempDirSelectionWidget->tempPath() <<endl;
         job->setCopyCdText( m_checkReadCdText->isChecked() );
         job->setIgnoreDataReadErrors( m_checkIgnoreDataReadErrors->isChecked() );
         job->setIgnoreAudioReadErrors( m_checkIgnoreAudioReadErrors->isChecked() );
+        job->setUseC2Pointers( m_checkUseC2Pointers->isChecked() );
         job->setNoCorrection( m_checkNoCorrection->isChecked() );
         job->setWritingMode( m_writingModeWidget->writingMode() );
 
@@ -442,6 +453,12 @@ qDebug() << "temp path:::" << m_tempDirSelectionWidget->tempPath() <<endl;
         job->setIgnoreReadErrors( m_checkIgnoreDataReadErrors->isChecked() );
         job->setReadRetries( m_spinDataRetries->value() );
         job->setVerifyData( m_checkVerifyData->isChecked() );
+        if( !m_checkSimulate->isChecked() && !m_checkOnlyCreateImage->isChecked() ) {
+            // one copy on each of the writers at least
+            const QList<K3b::Device::Device*> additionalWriters = m_additionalWritersWidget->selectedDevices();
+            job->setAdditionalWriterDevices( additionalWriters );
+            job->setCopies( qMax( m_spinCopies->value(), additionalWriters.count() + 1 ) );
+        }
 
         burnJob = job;
     }
@@ -631,6 +648,15 @@ void K3b::MediaCopyDialog::toggleAll()
         }
     }
 
+    // only DVD and Blu-ray copies are written on several writers at once
+    QList<K3b::Device::Device*> additionalWriters = m_writerSelectionWidget->allDevices();
+    additionalWriters.removeAll( burnDev );
+    additionalWriters.removeAll( readDev );
+    m_additionalWritersWidget->setDevices( additionalWriters );
+    m_additionalWritersWidget->setEnabled( !K3b::Device::isCdMedia( sourceMedium.diskInfo().mediaType() ) &&
+                                           !m_checkSimulate->isChecked() &&
+                                           !m_checkOnlyCreateImage->isChecked() );
+
     m_groupAdvancedAudioOptions->setEnabled( sourceMedium.content() & K3b::Medium::ContentAudio && m_comboCopyMode->currentIndex() == 0 );
     m_groupAdvancedDataOptions->setEnabled( sourceMedium.content() & K3b::Medium::ContentData );
 
@@ -660,6 +686,7 @@ void K3b::MediaCopyDialog::updateOverrideDevice()
 void K3b::MediaCopyDialog::loadSettings( const KConfigGroup& c )
 {
     m_writerSelectionWidget->loadConfig( c );
+    m_additionalWritersWidget->loadConfig( c );
     m_comboSourceDevice->setSelectedDevice( k3bcore->deviceManager()->findDevice( c.readEntry( "source_device" ) ) );
     m_writingModeWidget->loadConfig( c );
     m_checkSimulate->setChecked( c.readEntry( "simulate", false ) );
@@ -681,6 +708,7 @@ void K3b::MediaCopyDialog::loadSettings( const KConfigGroup& c )
     m_checkReadCdText->setChecked( c.readEntry( "copy cdtext", true ) );
     m_checkIgnoreDataReadErrors->setChecked( c.readEntry( "ignore data read errors", false ) );
     m_checkIgnoreAudioReadErrors->setChecked( c.readEntry( "ignore audio read errors", true ) );
+    m_checkUseC2Pointers->setChecked( c.readEntry( "use c2 pointers", true ) );
     m_checkNoCorrection->setChecked( c.readEntry( "no correction", false ) );
 
     m_spinDataRetries->setValue( c.readEntry( "data retries", 128 ) );
@@ -702,6 +730,7 @@ void K3b::MediaCopyDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "verify data", m_checkVerifyData->isChecked() );
 
     m_writerSelectionWidget->saveConfig( c );
+    m_additionalWritersWidget->saveConfig( c );
     m_tempDirSelectionWidget->saveConfig( c );
 
     c.writeEntry( "source_device", m_comboSourceDevice->selectedDevice() ? m_comboSourceDevice->selectedDevice()->blockDeviceName() : QString() );
@@ -709,6 +738,7 @@ void K3b::MediaCopyDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "copy cdtext", m_checkReadCdText->isChecked() );
     c.writeEntry( "ignore data read errors", m_checkIgnoreDataReadErrors->isChecked() );
     c.writeEntry( "ignore audio read errors", m_checkIgnoreAudioReadErrors->isChecked() );
+    c.writeEntry( "use c2 pointers", m_checkUseC2Pointers->isChecked() );
     c.writeEntry( "no correction", m_checkNoCorrection->isChecked() );
     c.writeEntry( "data retries", m_spinDataRetries->value() );
     c.writeEntry( "audio retries", m_spinAudioRetries->value() );
@@ -29,6 +29,7 @@ namespace K3b {
     }
 
     class WriterSelectionWidget;
+    class AdditionalWritersWidget;
     class TempDirSelectionWidget;
     class MediaSelectionComboBox;
     class WritingModeWidget;
@@ -75,6 +76,7 @@ namespace K3b {
         KIO::filesize_t neededSize() const;
 
         WriterSelectionWidget* m_writerSelectionWidget;
+        AdditionalWritersWidget* m_additionalWritersWidget;
         TempDirSelectionWidget* m_tempDirSelectionWidget;
         QCheckBox* m_checkSimulate;
         //QCheckBox* m_checkCacheImage;
@@ -83,6 +85,7 @@ namespace K3b {
         QCheckBox* m_checkReadCdText;
         QCheckBox* m_checkIgnoreDataReadErrors;
         QCheckBox* m_checkIgnoreAudioReadErrors;
+        QCheckBox* m_checkUseC2Pointers;
         QCheckBox* m_checkNoCorrection;
         QCheckBox* m_checkVerifyData;
         MediaSelectionComboBox* m_comboSourceDevice;
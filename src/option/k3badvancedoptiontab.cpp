@@ -81,6 +81,29 @@ void K3b::AdvancedOptionTab::setupGui()
     groupMiscLayout->addWidget( m_checkEject );
     m_checkAutoErasingRewritable = new QCheckBox( i18n("Automatically erase CD-RWs and DVD-RWs"), groupMisc );
     groupMiscLayout->addWidget( m_checkAutoErasingRewritable );
+    QHBoxLayout* resamplingLayout = new QHBoxLayout();
+    QLabel* resamplingLabel = new QLabel( i18n("Audio &resampling quality:"), groupMisc );
+    m_comboResamplingQuality = new QComboBox( groupMisc );
+    m_comboResamplingQuality->addItem( i18n("Fast"), int( K3b::AudioResampler::QualityFast ) );
+    m_comboResamplingQuality->addItem( i18n("Medium"), int( K3b::AudioResampler::QualityMedium ) );
+    m_comboResamplingQuality->addItem( i18n("Best"), int( K3b::AudioResampler::QualityBest ) );
+    resamplingLabel->setBuddy( m_comboResamplingQuality );
+    resamplingLayout->addWidget( resamplingLabel );
+    resamplingLayout->addWidget( m_comboResamplingQuality );
+    resamplingLayout->addStretch( 1 );
+    groupMiscLayout->addLayout( resamplingLayout );
+    QHBoxLayout* audioCacheLayout = new QHBoxLayout();
+    QLabel* audioCacheLabel = new QLabel( i18n("Cache for &decoded audio tracks:"), groupMisc );
+    m_editAudioImageCacheSize = new QSpinBox( groupMisc );
+    m_editAudioImageCacheSize->setRange( 0, 100000 );
+    m_editAudioImageCacheSize->setSingleStep( 256 );
+    m_editAudioImageCacheSize->setSuffix( ' ' + i18n("MB") );
+    m_editAudioImageCacheSize->setSpecialValueText( i18n("Disabled") );
+    audioCacheLabel->setBuddy( m_editAudioImageCacheSize );
+    audioCacheLayout->addWidget( audioCacheLabel );
+    audioCacheLayout->addWidget( m_editAudioImageCacheSize );
+    audioCacheLayout->addStretch( 1 );
+    groupMiscLayout->addLayout( audioCacheLayout );
 
     groupAdvancedLayout->addWidget( groupWritingApp, 0, 0 );
     groupAdvancedLayout->addWidget( groupMisc, 1, 0 );
@@ -102,6 +125,8 @@ void K3b::AdvancedOptionTab::setupGui()
     m_checkAutoErasingRewritable->setToolTip( i18n("Automatically erase CD-RWs and DVD-RWs without asking") );
     m_checkEject->setToolTip( i18n("Do not eject the burn medium after a completed burn process") );
     m_checkForceUnsafeOperations->setToolTip( i18n("Force K3b to continue some operations otherwise deemed as unsafe") );
+    m_editAudioImageCacheSize->setToolTip( i18n("Disk space used to keep decoded audio tracks for further copies") );
+    m_comboResamplingQuality->setToolTip( i18n("Quality of the conversion of audio files to the 44100 Hz of Audio CDs") );
 
     m_checkShowForceGuiElements->setWhatsThis( i18n("<p>If this option is checked additional GUI "
                                                     "elements which allow one to influence the behavior of K3b are shown. "
@@ -132,6 +157,18 @@ void K3b::AdvancedOptionTab::setupGui()
                                                        "<p>If this option is checked the value specified will be used for both "
                                                        "CD and DVD burning.", 4, 32) );
 
+    m_comboResamplingQuality->setWhatsThis( i18n("<p>Audio files which are not sampled at 44100 Hz have to be converted "
+                                                 "before they can be written to an Audio CD."
+                                                 "<p>A higher quality removes more of the frequencies which cannot be "
+                                                 "represented on the CD but takes more processing time. <em>Fast</em> "
+                                                 "may help when writing on the fly on a slow system.") );
+
+    m_editAudioImageCacheSize->setWhatsThis( i18n("<p>Audio tracks decoded while burning an Audio CD are kept in the "
+                                                  "cache folder. Further copies and burning the same project again "
+                                                  "read the decoded tracks instead of decoding the files again."
+                                                  "<p>The least recently used tracks are removed once the cache "
+                                                  "exceeds this size. A size of 0 disables the cache.") );
+
     m_checkEject->setWhatsThis( i18n("<p>If this option is checked K3b will not eject the medium once the burn process "
                                      "finishes. This can be helpful in case one leaves the computer after starting the "
                                      "burning and does not want the tray to be open all the time."
@@ -161,6 +198,8 @@ void K3b::AdvancedOptionTab::readSettings()
     m_checkManualWritingBufferSize->setChecked( k3bcore->globalSettings()->useManualBufferSize() );
     if( k3bcore->globalSettings()->useManualBufferSize() )
         m_editWritingBufferSize->setValue( k3bcore->globalSettings()->bufferSize() );
+    m_comboResamplingQuality->setCurrentIndex( m_comboResamplingQuality->findData( int( k3bcore->globalSettings()->resamplingQuality() ) ) );
+    m_editAudioImageCacheSize->setValue( k3bcore->globalSettings()->audioImageCacheSize() );
 }
 
 
@@ -177,6 +216,8 @@ void K3b::AdvancedOptionTab::saveSettings()
     k3bcore->globalSettings()->setUseManualBufferSize( m_checkManualWritingBufferSize->isChecked() );
     k3bcore->globalSettings()->setBufferSize( m_editWritingBufferSize->value() );
     k3bcore->globalSettings()->setForce( m_checkForceUnsafeOperations->isChecked() );
+    k3bcore->globalSettings()->setResamplingQuality( static_cast<K3b::AudioResampler::Quality>( m_comboResamplingQuality->currentData().toInt() ) );
+    k3bcore->globalSettings()->setAudioImageCacheSize( m_editAudioImageCacheSize->value() );
 }
 
 
@@ -19,6 +19,7 @@
 #include <QWidget>
 
 class QCheckBox;
+class QComboBox;
 class QLabel;
 class QSpinBox;
 
@@ -50,6 +51,8 @@ namespace K3b {
         QSpinBox*     m_editWritingBufferSize;
         QCheckBox*    m_checkShowForceGuiElements;
         QCheckBox*    m_checkForceUnsafeOperations;
+        QComboBox*    m_comboResamplingQuality;
+        QSpinBox*     m_editAudioImageCacheSize;
     };
 }
 
@@ -170,7 +170,7 @@ void K3b::ExternalBinWidget::rescan()
 {
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
     saveSearchPath();
-    m_manager->search();
+    m_manager->search( false );
     load();
     QApplication::restoreOverrideCursor();
 }
@@ -61,6 +61,9 @@ K3b::AudioBurnDialog::AudioBurnDialog(K3b::AudioDoc* _doc, QWidget *parent )
               i18np("1 track (%2 minutes)", "%1 tracks (%2 minutes)",
                     m_doc->numOfTracks(),m_doc->length().toString()) );
 
+    m_checkVerify = K3b::StdGuiItems::verifyCheckBox( m_optionGroup );
+    m_optionGroupLayout->addWidget( m_checkVerify );
+
     QSpacerItem* spacer = new QSpacerItem( 20, 20, QSizePolicy::Minimum, QSizePolicy::Expanding );
     m_optionGroupLayout->addItem( spacer );
 
@@ -150,6 +153,7 @@ void K3b::AudioBurnDialog::saveSettingsToProject()
     m_doc->setTempDir( m_tempDirSelectionWidget->tempPath() );
     m_doc->setHideFirstTrack( m_checkHideFirstTrack->isChecked() );
     m_doc->setNormalize( m_checkNormalize->isChecked() );
+    m_doc->setVerifyData( m_checkVerify->isChecked() );
 
     // -- save Cd-Text ------------------------------------------------
     m_cdtextWidget->save( m_doc );
@@ -169,6 +173,7 @@ void K3b::AudioBurnDialog::readSettingsFromProject()
 
     m_checkHideFirstTrack->setChecked( m_doc->hideFirstTrack() );
     m_checkNormalize->setChecked( m_doc->normalize() );
+    m_checkVerify->setChecked( m_doc->verifyData() );
 
     // read CD-Text ------------------------------------------------------------
     m_cdtextWidget->load( m_doc );
@@ -192,6 +197,7 @@ void K3b::AudioBurnDialog::loadSettings( const KConfigGroup& c )
     m_cdtextWidget->setChecked( c.readEntry( "cd_text", true ) );
     m_checkHideFirstTrack->setChecked( c.readEntry( "hide_first_track", false ) );
     m_checkNormalize->setChecked( c.readEntry( "normalize-audio", false ) );
+    m_checkVerify->setChecked( c.readEntry( "verify data", false ) );
 
     m_comboParanoiaMode->setCurrentIndex( c.readEntry( "paranoia mode", 0 ) );
     m_checkAudioRippingIgnoreReadErrors->setChecked( c.readEntry( "ignore read errors", true ) );
@@ -208,6 +214,7 @@ void K3b::AudioBurnDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "cd_text", m_cdtextWidget->isChecked() );
     c.writeEntry( "hide_first_track", m_checkHideFirstTrack->isChecked() );
     c.writeEntry( "normalize-audio", m_checkNormalize->isChecked() );
+    c.writeEntry( "verify data", m_checkVerify->isChecked() );
 
     c.writeEntry( "paranoia mode", m_comboParanoiaMode->currentText() );
     c.writeEntry( "ignore read errors", m_checkAudioRippingIgnoreReadErrors->isChecked() );
@@ -250,6 +257,13 @@ void K3b::AudioBurnDialog::toggleAll()
                                 m_writingModeWidget->writingMode() != K3b::WritingModeTao );
     if( !cdText || m_writingModeWidget->writingMode() == K3b::WritingModeTao )
         m_cdtextWidget->setChecked(false);
+
+    if( m_checkSimulate->isChecked() || m_checkOnlyCreateImage->isChecked() ) {
+        m_checkVerify->setChecked(false);
+        m_checkVerify->setEnabled(false);
+    }
+    else
+        m_checkVerify->setEnabled(true);
 }
 
 
@@ -70,6 +70,7 @@ namespace K3b {
         QGroupBox* m_audioRippingGroup;
         QCheckBox* m_checkHideFirstTrack;
         QCheckBox* m_checkNormalize;
+        QCheckBox* m_checkVerify;
         QCheckBox* m_checkAudioRippingIgnoreReadErrors;
         QSpinBox* m_spinAudioRippingReadRetries;
         QComboBox* m_comboParanoiaMode;
@@ -17,6 +17,8 @@
 #include "k3bmsfedit.h"
 
 #include "k3baudiodatasource.h"
+#include "k3baudiofile.h"
+#include "k3baudiopeaksloader.h"
 
 #include <KLocalizedString>
 
@@ -31,6 +33,7 @@ K3b::AudioDataSourceEditWidget::AudioDataSourceEditWidget( QWidget* parent )
       m_source(0)
 {
     m_editor = new K3b::AudioEditorWidget( this );
+    m_peaksLoader = new K3b::AudioPeaksLoader( this );
     m_editStartOffset = new K3b::MsfEdit( this );
     m_editEndOffset = new K3b::MsfEdit( this );
 
@@ -58,6 +61,9 @@ K3b::AudioDataSourceEditWidget::AudioDataSourceEditWidget( QWidget* parent )
     connect( m_editEndOffset, SIGNAL(valueChanged(K3b::Msf)),
              this, SLOT(slotEndOffsetEdited(K3b::Msf)) );
 
+    connect( m_peaksLoader, SIGNAL(loaded()),
+             this, SLOT(slotPeaksLoaded()) );
+
     m_editor->setToolTip( i18n("Drag the edges of the highlighted area to define the portion of the "
                                "audio source you want to include in the Audio CD track. "
                                "You can also use the input windows to fine-tune your selection.") );
@@ -106,6 +112,14 @@ void K3b::AudioDataSourceEditWidget::loadSource( K3b::AudioDataSource* source )
 
     m_editStartOffset->setValue( startOffset() );
     m_editEndOffset->setValue( endOffset() );
+
+    // the waveform is only available for files, the editor spans the whole file
+    m_editor->setPeaks( K3b::AudioPeaks() );
+    m_editor->setPeaksError( QString() );
+    if( K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( source ) )
+        m_peaksLoader->load( file->filename() );
+    else
+        m_peaksLoader->cancel();
 }
 
 
@@ -154,6 +168,13 @@ void K3b::AudioDataSourceEditWidget::slotStartOffsetEdited( const K3b::Msf& msf
 }
 
 
+void K3b::AudioDataSourceEditWidget::slotPeaksLoaded()
+{
+    m_editor->setPeaks( m_peaksLoader->peaks() );
+    m_editor->setPeaksError( m_peaksLoader->errorString() );
+}
+
+
 void K3b::AudioDataSourceEditWidget::slotEndOffsetEdited( const K3b::Msf& msf )
 {
     if( m_source ) {
@@ -24,6 +24,7 @@ namespace K3b {
 }
 namespace K3b {
     class AudioEditorWidget;
+    class AudioPeaksLoader;
 }
 namespace K3b {
     class MsfEdit;
@@ -64,12 +65,14 @@ namespace K3b {
         void slotRangeModified( int, const K3b::Msf&, const K3b::Msf& );
         void slotStartOffsetEdited( const K3b::Msf& );
         void slotEndOffsetEdited( const K3b::Msf& );
+        void slotPeaksLoaded();
 
     private:
         AudioDataSource* m_source;
         int m_rangeId;
 
         AudioEditorWidget* m_editor;
+        AudioPeaksLoader* m_peaksLoader;
         MsfEdit* m_editStartOffset;
         MsfEdit* m_editEndOffset;
     };
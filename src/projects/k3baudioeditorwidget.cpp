@@ -26,6 +26,7 @@
 #include <QDesktopWidget>
 #include <QFrame>
 #include <QToolTip>
+#include <QWheelEvent>
 
 
 
@@ -127,6 +128,10 @@ public:
           margin(5) {
     }
 
+    K3b::Msf visibleLength() const {
+        return visibleLength_ > 0 ? visibleLength_ : length;
+    }
+
     QBrush selectedRangeBrush;
 
     bool allowOverlappingRanges;
@@ -148,6 +153,14 @@ public:
     bool draggingRangeEnd;
     Marker* draggedMarker;
 
+    K3b::AudioPeaks peaks;
+    K3b::Msf peaksOffset;
+    QString peaksError;
+
+    // a null length means everything is visible
+    K3b::Msf visibleStart;
+    K3b::Msf visibleLength_;
+
     /**
      * Margin around the timethingy
      */
@@ -182,8 +195,13 @@ QSize K3b::AudioEditorWidget::minimumSizeHint() const
 
     int maxWidth = QApplication::desktop()->width()*2/3;
     int wantedWidth = 2*d->margin + 2*frameWidth() + (d->length.totalFrames()/75/60 + 1) * fontMetrics().width( "000" );
+    int waveformHeight = 0;
+    if( !d->peaks.isEmpty() )
+        waveformHeight = 4*fontMetrics().height();
+    else if( !d->peaksError.isEmpty() )
+        waveformHeight = fontMetrics().height();
     return QSize( qMin( maxWidth, wantedWidth ),
-                  2*d->margin + 12 + 6 /*12 for the tickmarks and 6 for the markers */ + fontMetrics().height() + 2*frameWidth() );
+                  2*d->margin + 12 + 6 /*12 for the tickmarks and 6 for the markers */ + fontMetrics().height() + waveformHeight + 2*frameWidth() );
 }
 
 
@@ -196,6 +214,8 @@ QSize K3b::AudioEditorWidget::sizeHint() const
 void K3b::AudioEditorWidget::setLength( const K3b::Msf& length )
 {
     d->length = length;
+    d->visibleStart = 0;
+    d->visibleLength_ = 0;
     // TODO: remove markers beyond length
     // TODO: shorten ranges if nesseccary
     update();
@@ -208,6 +228,54 @@ const K3b::Msf K3b::AudioEditorWidget::length() const
 }
 
 
+void K3b::AudioEditorWidget::setPeaks( const K3b::AudioPeaks& peaks, const K3b::Msf& offset )
+{
+    const bool hadPeaks = !d->peaks.isEmpty();
+    d->peaks = peaks;
+    d->peaksOffset = offset;
+    if( hadPeaks != !peaks.isEmpty() )
+        updateGeometry();
+    update();
+}
+
+
+void K3b::AudioEditorWidget::setPeaksError( const QString& error )
+{
+    const bool hadError = !d->peaksError.isEmpty();
+    d->peaksError = error;
+    if( hadError != !error.isEmpty() )
+        updateGeometry();
+    update();
+}
+
+
+void K3b::AudioEditorWidget::setVisibleRange( const K3b::Msf& start, const K3b::Msf& length )
+{
+    if( length <= 0 || length >= d->length ) {
+        d->visibleStart = 0;
+        d->visibleLength_ = 0;
+    }
+    else {
+        // at least two frames are needed to map positions
+        d->visibleLength_ = qMax( length, K3b::Msf( 2 ) );
+        d->visibleStart = qBound( K3b::Msf(), start, d->length - d->visibleLength_ );
+    }
+    update();
+}
+
+
+K3b::Msf K3b::AudioEditorWidget::visibleStart() const
+{
+    return d->visibleStart;
+}
+
+
+K3b::Msf K3b::AudioEditorWidget::visibleLength() const
+{
+    return d->visibleLength();
+}
+
+
 void K3b::AudioEditorWidget::setSelectedRangeBrush( const QBrush& b )
 {
     d->selectedRangeBrush = b;
@@ -483,6 +551,12 @@ void K3b::AudioEditorWidget::paintEvent( QPaintEvent* e )
 
 void K3b::AudioEditorWidget::drawAll( QPainter* p, const QRect& drawRect )
 {
+    // ranges reaching beyond the visible part are cut at the edges
+    p->save();
+    p->setClipRect( drawRect.adjusted( 0, 0, 1, 1 ) );
+
+    drawWaveform( p, drawRect );
+
     // we simply draw the ranges one after the other.
     for( Range::List::const_iterator it = d->ranges.constBegin(); it != d->ranges.constEnd(); ++it )
         drawRange( p, drawRect, *it );
@@ -491,8 +565,12 @@ void K3b::AudioEditorWidget::drawAll( QPainter* p, const QRect& drawRect )
     if( Range* selectedRange = getRange( d->selectedRangeId ) )
         drawRange( p, drawRect, *selectedRange );
 
+    p->restore();
+
+    const K3b::Msf visibleEnd = d->visibleStart + d->visibleLength();
     for( Marker::List::const_iterator it = d->markers.constBegin(); it != d->markers.constEnd(); ++it )
-        drawMarker( p, drawRect, *it );
+        if( it->pos >= d->visibleStart && it->pos < visibleEnd )
+            drawMarker( p, drawRect, *it );
 
 
     // left vline
@@ -508,13 +586,13 @@ void K3b::AudioEditorWidget::drawAll( QPainter* p, const QRect& drawRect )
                  drawRect.right(), drawRect.bottom() );
 
     // draw minute markers every minute
-    int minute = 1;
+    int minute = qMax( 1, ( d->visibleStart.lba() + 60*75 - 1 ) / 60 / 75 );
     int minuteStep = 1;
     int markerVPos = drawRect.bottom();
     int maxMarkerWidth = fontMetrics().width( QString::number(d->length.minutes()) );
     int minNeededSpace = maxMarkerWidth + 1;
     int x = 0;
-    while( minute*60*75 < d->length ) {
+    while( minute*60*75 < visibleEnd ) {
         int newX = msfToPos( minute*60*75 );
 
         // only draw the mark if we have anough space
@@ -550,10 +628,15 @@ void K3b::AudioEditorWidget::drawRange( QPainter* p, const QRect& drawRect, cons
     int start = msfToPos( r.start );
     int end = msfToPos( r.end );
 
-    if( rangeSelectedEnabled() && r.id == d->selectedRangeId )
-        p->setBrush( selectedRangeBrush() );
-    else
-        p->setBrush( r.brush );
+    QBrush brush = ( rangeSelectedEnabled() && r.id == d->selectedRangeId ) ? selectedRangeBrush() : r.brush;
+
+    // keep the waveform below visible
+    if( !d->peaks.isEmpty() && brush.style() != Qt::NoBrush ) {
+        QColor color = brush.color();
+        color.setAlpha( color.alpha()/2 );
+        brush.setColor( color );
+    }
+    p->setBrush( brush );
 
     p->drawRect( start, drawRect.top()+6 , end-start+1-1, drawRect.height()-6-1 );
 
@@ -561,6 +644,50 @@ void K3b::AudioEditorWidget::drawRange( QPainter* p, const QRect& drawRect, cons
 }
 
 
+void K3b::AudioEditorWidget::drawWaveform( QPainter* p, const QRect& drawRect )
+{
+    if( d->peaks.isEmpty() ) {
+        if( !d->peaksError.isEmpty() ) {
+            p->save();
+            p->setPen( palette().color( QPalette::Disabled, QPalette::WindowText ) );
+            p->drawText( drawRect.adjusted( 0, 6, 0, -6 - fontMetrics().height() ),
+                         Qt::AlignCenter, fontMetrics().elidedText( d->peaksError, Qt::ElideMiddle, drawRect.width() ) );
+            p->restore();
+        }
+        return;
+    }
+
+    p->save();
+
+    QColor color = palette().color( QPalette::WindowText );
+    color.setAlpha( 128 );
+    p->setPen( color );
+
+    // leave room for the marker heads and the minute labels
+    const int top = drawRect.top() + 6;
+    const int height = drawRect.bottom() - 6 - fontMetrics().height() - top;
+    const int center = top + height/2;
+    if( height <= 0 ) {
+        p->restore();
+        return;
+    }
+
+    // one peak query per pixel, independent of the length of the source
+    for( int x = drawRect.left(); x <= drawRect.right(); ++x ) {
+        const K3b::Msf start = posToMsf( x );
+        const K3b::Msf end = qMax( posToMsf( x+1 ), start+1 );
+        const K3b::AudioPeaks::Peak peak = d->peaks.peak( start + d->peaksOffset, end + d->peaksOffset );
+        if( peak.min == 0 && peak.max == 0 )
+            continue;
+
+        p->drawLine( x, center - peak.max * height / 65536,
+                     x, center - peak.min * height / 65536 );
+    }
+
+    p->restore();
+}
+
+
 void K3b::AudioEditorWidget::drawMarker( QPainter* p, const QRect& drawRect, const K3b::AudioEditorWidget::Marker& m )
 {
     p->save();
@@ -746,6 +873,38 @@ void K3b::AudioEditorWidget::mouseMoveEvent( QMouseEvent* e )
     QFrame::mouseMoveEvent(e);
 }
 
+void K3b::AudioEditorWidget::wheelEvent( QWheelEvent* e )
+{
+    const int steps = e->angleDelta().y() / 120;
+    const int w = contentsRect().width() - 2*d->margin;
+    if( steps == 0 || d->length < 2 || w <= 0 ) {
+        QFrame::wheelEvent( e );
+        return;
+    }
+
+    const K3b::Msf visibleLength = d->visibleLength();
+    if( e->modifiers() & Qt::ControlModifier ) {
+        // zoom around the position under the mouse, down to one frame per pixel
+        const K3b::Msf anchor = qBound( K3b::Msf(), posToMsf( e->pos().x() ), d->length-1 );
+        qint64 newLength = visibleLength.lba();
+        for( int i = 0; i < qAbs( steps ); ++i )
+            newLength = ( steps > 0 ? newLength/2 : newLength*2 );
+        newLength = qBound<qint64>( qMin( w, d->length.lba() ), newLength, d->length.lba() );
+
+        const qint64 start = anchor.lba() - ( anchor - d->visibleStart ).lba() * newLength / visibleLength.lba();
+        setVisibleRange( (int)start, (int)newLength );
+        e->accept();
+    }
+    else if( visibleLength < d->length ) {
+        setVisibleRange( d->visibleStart - steps * qMax( 1, visibleLength.lba()/8 ), visibleLength );
+        e->accept();
+    }
+    else {
+        QFrame::wheelEvent( e );
+    }
+}
+
+
 bool K3b::AudioEditorWidget::event( QEvent* e )
 {
     if( e->type() == QEvent::ToolTip ) {
@@ -864,16 +1023,18 @@ K3b::Msf K3b::AudioEditorWidget::posToMsf( int p ) const
 {
     int w = contentsRect().width() - 2*d->margin;
     int x = qMin( p-frameWidth()-d->margin, w );
-    return ( (int)((double)(d->length.lba()-1) / (double)w * (double)x) );
+    return d->visibleStart + (int)((double)(d->visibleLength().lba()-1) / (double)w * (double)x);
 }
 
 
-// returns widget coordinates
+// returns widget coordinates, positions outside the visible part end up in the margins
 int K3b::AudioEditorWidget::msfToPos( const K3b::Msf& msf ) const
 {
     int w = contentsRect().width() - 2*d->margin;
-    int pos = (int)((double)w / (double)(d->length.lba()-1) * (double)msf.lba());
-    return frameWidth() + d->margin + qMin( pos, w-1 );
+    if( msf >= d->visibleStart + d->visibleLength() )
+        return frameWidth() + d->margin + w;
+    int pos = (int)((double)w / (double)(d->visibleLength().lba()-1) * (double)(msf - d->visibleStart).lba());
+    return frameWidth() + d->margin + qBound( -1, pos, w-1 );
 }
 
 
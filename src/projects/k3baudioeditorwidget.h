@@ -17,6 +17,7 @@
 #define _K3B_AUDIO_EDITOR_WIDGET_H_
 
 #include "k3bmsf.h"
+#include "k3baudiopeaks.h"
 
 #include <QList>
 #include <QMouseEvent>
@@ -45,6 +46,30 @@ public:
 
     const K3b::Msf length() const;
 
+    /**
+     * Draw the waveform described by \p peaks behind the ranges. \p offset is the
+     * position in the peaks which corresponds to the start of the editor.
+     * Pass empty peaks to remove the waveform.
+     */
+    void setPeaks( const K3b::AudioPeaks& peaks, const K3b::Msf& offset = K3b::Msf() );
+
+    /**
+     * Show \p error in place of the waveform. Pass an empty string to remove it.
+     */
+    void setPeaksError( const QString& error );
+
+    /**
+     * Zoom into the part of length \p length starting at \p start. A null
+     * length shows everything, which is the default.
+     *
+     * The user zooms with the mouse wheel while holding Ctrl and scrolls
+     * with the mouse wheel.
+     */
+    void setVisibleRange( const K3b::Msf& start, const K3b::Msf& length );
+
+    K3b::Msf visibleStart() const;
+    K3b::Msf visibleLength() const;
+
     /**
      * Add a user editable range.
      * @param startFixed if true the range's start cannot be changed by the user, only with modifyRange
@@ -176,6 +201,7 @@ protected:
     void mouseReleaseEvent( QMouseEvent* e ) override;
     void mouseDoubleClickEvent( QMouseEvent* e ) override;
     void mouseMoveEvent( QMouseEvent* e ) override;
+    void wheelEvent( QWheelEvent* e ) override;
     bool event( QEvent* e ) override;
 
 private:
@@ -189,6 +215,7 @@ private:
     void drawAll( QPainter*, const QRect& );
     void drawRange( QPainter* p, const QRect&, const Range& r );
     void drawMarker( QPainter* p, const QRect&, const Marker& m );
+    void drawWaveform( QPainter* p, const QRect& );
 
     /**
      * Makes sure that \a r does not overlap any other range by modifying and
@@ -15,6 +15,8 @@
 #include "k3baudiotracksplitdialog.h"
 #include "k3baudiotrack.h"
 #include "k3baudioeditorwidget.h"
+#include "k3baudiofile.h"
+#include "k3baudiopeaksloader.h"
 
 #include "k3bmsf.h"
 #include "k3bmsfedit.h"
@@ -80,6 +82,15 @@ K3b::AudioTrackSplitDialog::AudioTrackSplitDialog( K3b::AudioTrack* track, QWidg
     m_editorWidget->addRange( 0, mid-1 );
     m_editorWidget->addRange( mid, m_track->length()-1 );
 
+    // show the waveform of tracks made of a single file
+    m_peaksLoader = new K3b::AudioPeaksLoader( this );
+    connect( m_peaksLoader, SIGNAL(loaded()),
+             this, SLOT(slotPeaksLoaded()) );
+    if( m_track->numberSources() == 1 ) {
+        if( K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( m_track->firstSource() ) )
+            m_peaksLoader->load( file->filename() );
+    }
+
     QDialogButtonBox* buttonBox = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this );
     connect( buttonBox, SIGNAL(accepted()), SLOT(accept()) );
     connect( buttonBox, SIGNAL(rejected()), SLOT(reject()) );
@@ -185,6 +196,14 @@ bool K3b::AudioTrackSplitDialog::eventFilter( QObject* o, QEvent* e )
 }
 
 
+void K3b::AudioTrackSplitDialog::slotPeaksLoaded()
+{
+    // the editor starts at the start offset of the source
+    m_editorWidget->setPeaks( m_peaksLoader->peaks(), m_track->firstSource()->startOffset() );
+    m_editorWidget->setPeaksError( m_peaksLoader->errorString() );
+}
+
+
 void K3b::AudioTrackSplitDialog::slotSplitHere()
 {
     splitAt( m_lastClickPosition );
@@ -28,6 +28,7 @@ namespace K3b {
 
 class AudioTrack;
 class AudioEditorWidget;
+class AudioPeaksLoader;
 class Msf;
 class MsfEdit;
     
@@ -53,11 +54,13 @@ private Q_SLOTS:
     void slotSplitHere();
     void slotRemoveRange();
     void splitAt( const QPoint& p );
+    void slotPeaksLoaded();
 
 private:
     void setupActions();
 
     AudioEditorWidget* m_editorWidget;
+    AudioPeaksLoader* m_peaksLoader;
     MsfEdit* m_msfEditStart;
     MsfEdit* m_msfEditEnd;
     AudioTrack* m_track;
@@ -65,6 +65,7 @@ void K3b::DataAdvancedImageSettingsDialog::load( const K3b::IsoOptions& options
     // RR settings
     m_checkCreateTransTbl->setChecked( options.createTRANS_TBL() );
     m_checkHideTransTbl->setChecked( options.hideTRANS_TBL() );
+    m_checkZisofsCompression->setChecked( options.zisofsCompression() );
 
     // iso9660 settings
     m_checkAllowUntranslatedFilenames->setChecked( options.ISOuntranslatedFilenames() );
@@ -105,6 +106,7 @@ void K3b::DataAdvancedImageSettingsDialog::save( K3b::IsoOptions& options )
 
     options.setCreateTRANS_TBL( m_checkCreateTransTbl->isChecked() );
     options.setHideTRANS_TBL( m_checkHideTransTbl->isChecked() );
+    options.setZisofsCompression( m_checkZisofsCompression->isChecked() );
     options.setISOuntranslatedFilenames( m_checkAllowUntranslatedFilenames->isChecked() );
     options.setISOallow31charFilenames( m_checkAllow31CharFilenames->isChecked() );
     options.setISOmaxFilenameLength( m_checkAllowMaxLengthFilenames->isChecked() );
@@ -81,6 +81,7 @@ static bool compareAdvancedOptions( const K3b::IsoOptions& o1, const K3b::IsoOpt
              o1.ISOuntranslatedFilenames() == o2.ISOuntranslatedFilenames() &&
              o1.createTRANS_TBL() == o2.createTRANS_TBL() &&
              o1.hideTRANS_TBL() == o2.hideTRANS_TBL() &&
+             o1.zisofsCompression() == o2.zisofsCompression() &&
              o1.jolietLong() == o2.jolietLong() &&
              o1.ISOLevel() == o2.ISOLevel() &&
              o1.preserveFilePermissions() == o2.preserveFilePermissions() &&
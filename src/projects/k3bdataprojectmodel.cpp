@@ -20,6 +20,7 @@
 #include "k3bdiritem.h"
 #include "k3bfileitem.h"
 #include "k3bisooptions.h"
+#include "k3bmimetyperesolver.h"
 #include "k3bspecialdataitem.h"
 
 #include <KUrlMimeData>
@@ -31,6 +32,8 @@
 #include <QFont>
 #include <QBrush>
 #include <QBitmap>
+#include <QMultiHash>
+#include <QPersistentModelIndex>
 
 
 class K3b::DataProjectModel::Private
@@ -43,13 +46,18 @@ public:
 
     K3b::DataDoc* project;
 
+    // files whose type is sniffed in the background, keyed by local path
+    QMultiHash<QString, QPersistentModelIndex> pendingMimeTypes;
+
     K3b::DataItem* getChild( K3b::DirItem* dir, int offset );
     int findChildIndex( K3b::DataItem* item );
+    QMimeType mimeType( K3b::DataItem* item, const QModelIndex& index );
     void _k_itemsAboutToBeInserted( K3b::DirItem* parent, int start, int end );
     void _k_itemsAboutToBeRemoved( K3b::DirItem* parent, int start, int end );
     void _k_itemsInserted( K3b::DirItem* parent, int start, int end );
     void _k_itemsRemoved( K3b::DirItem* parent, int start, int end );
     void _k_volumeIdChanged();
+    void _k_mimeTypeResolved( const QString& path );
 
 private:
     DataProjectModel* q;
@@ -81,6 +89,19 @@ int K3b::DataProjectModel::Private::findChildIndex( K3b::DataItem* item )
 }
 
 
+QMimeType K3b::DataProjectModel::Private::mimeType( K3b::DataItem* item, const QModelIndex& index )
+{
+    const QMimeType type = item->mimeType();
+    if( item->isFile() ) {
+        K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
+        if( !fileItem->isMimeTypeResolved() &&
+            !pendingMimeTypes.contains( fileItem->localPath(), index.sibling( index.row(), 0 ) ) )
+            pendingMimeTypes.insert( fileItem->localPath(), index.sibling( index.row(), 0 ) );
+    }
+    return type;
+}
+
+
 void K3b::DataProjectModel::Private::_k_itemsAboutToBeInserted( K3b::DirItem* parent, int start, int end )
 {
         qDebug() << q->indexForItem( parent ) << start << end;
@@ -117,6 +138,22 @@ void K3b::DataProjectModel::Private::_k_volumeIdChanged()
 }
 
 
+void K3b::DataProjectModel::Private::_k_mimeTypeResolved( const QString& path )
+{
+    const QList<QPersistentModelIndex> indexes = pendingMimeTypes.values( path );
+    pendingMimeTypes.remove( path );
+    Q_FOREACH( const QPersistentModelIndex& index, indexes ) {
+        // the item might have been removed in the meantime
+        if( index.isValid() ) {
+            K3b::DataItem* item = q->itemForIndex( index );
+            if( item && item->isFile() )
+                static_cast<K3b::FileItem*>( item )->updateMimeType();
+            emit q->dataChanged( index, index.sibling( index.row(), DataProjectModel::TypeColumn ) );
+        }
+    }
+}
+
+
 K3b::DataProjectModel::DataProjectModel( K3b::DataDoc* doc, QObject* parent )
     : QAbstractItemModel( parent ),
       d( new Private(this) )
@@ -133,6 +170,8 @@ K3b::DataProjectModel::DataProjectModel( K3b::DataDoc* doc, QObject* parent )
              this, SLOT(_k_itemsRemoved(K3b::DirItem*,int,int)), Qt::DirectConnection );
     connect( doc, SIGNAL(volumeIdChanged()),
              this, SLOT(_k_volumeIdChanged()), Qt::DirectConnection );
+    connect( K3b::MimeTypeResolver::instance(), SIGNAL(contentTypeResolved(QString)),
+             this, SLOT(_k_mimeTypeResolved(QString)), Qt::QueuedConnection );
 }
 
 
@@ -222,7 +261,7 @@ QVariant K3b::DataProjectModel::data( const QModelIndex& index, int role ) const
                     iconName = "media-optical-data";
                 }
                 else {
-                    iconName = item->mimeType().iconName();
+                    iconName = d->mimeType( item, index ).iconName();
                 }
 
                 if( item->isSymLink() )
@@ -258,7 +297,7 @@ QVariant K3b::DataProjectModel::data( const QModelIndex& index, int role ) const
                     return static_cast<K3b::SpecialDataItem*>( item )->specialType();
                 }
                 else {
-                    return item->mimeType().comment();
+                    return d->mimeType( item, index ).comment();
                 }
             }
             if( role == Qt::SizeHintRole ){
@@ -394,6 +433,33 @@ int K3b::DataProjectModel::rowCount( const QModelIndex& parent ) const
 }
 
 
+bool K3b::DataProjectModel::hasChildren( const QModelIndex& parent ) const
+{
+    // folders imported from an old session are filled on demand
+    if( canFetchMore( parent ) )
+        return true;
+    else
+        return QAbstractItemModel::hasChildren( parent );
+}
+
+
+bool K3b::DataProjectModel::canFetchMore( const QModelIndex& parent ) const
+{
+    if( parent.isValid() && parent.column() == 0 ) {
+        if( K3b::DirItem* dir = dynamic_cast<K3b::DirItem*>( itemForIndex( parent ) ) )
+            return d->project->isImportedDirPending( dir );
+    }
+    return false;
+}
+
+
+void K3b::DataProjectModel::fetchMore( const QModelIndex& parent )
+{
+    if( K3b::DirItem* dir = dynamic_cast<K3b::DirItem*>( itemForIndex( parent ) ) )
+        d->project->expandImportedDir( dir );
+}
+
+
 bool K3b::DataProjectModel::setData( const QModelIndex& index, const QVariant& value, int role )
 {
     if ( index.isValid() ) {
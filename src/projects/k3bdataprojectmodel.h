@@ -71,6 +71,9 @@ namespace K3b {
         QModelIndex index( int row, int column, const QModelIndex& parent = QModelIndex() ) const override;
         QModelIndex parent( const QModelIndex& index ) const override;
         int rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+        bool hasChildren( const QModelIndex& parent = QModelIndex() ) const override;
+        bool canFetchMore( const QModelIndex& parent ) const override;
+        void fetchMore( const QModelIndex& parent ) override;
         bool setData( const QModelIndex& index, const QVariant& value, int role = Qt::EditRole ) override;
         QMimeData* mimeData( const QModelIndexList& indexes ) const override;
         Qt::DropActions supportedDropActions() const override;
@@ -92,6 +95,7 @@ namespace K3b {
         Q_PRIVATE_SLOT( d, void _k_itemsInserted( K3b::DirItem* parent, int start, int end ) )
         Q_PRIVATE_SLOT( d, void _k_itemsRemoved( K3b::DirItem* parent, int start, int end ) )
         Q_PRIVATE_SLOT( d, void _k_volumeIdChanged() )
+        Q_PRIVATE_SLOT( d, void _k_mimeTypeResolved( const QString& path ) )
     };
 }
 
@@ -29,6 +29,31 @@ DataProjectSortProxyModel::DataProjectSortProxyModel( QObject* parent )
 }
 
 
+namespace {
+    bool isNumber( const QVariant& v )
+    {
+        switch( v.userType() ) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // the insertion time and the size are numbers, everything else is text
+    bool sortValueLessThan( const QVariant& left, const QVariant& right )
+    {
+        if( isNumber( left ) && isNumber( right ) )
+            return left.toULongLong() < right.toULongLong();
+        else
+            return left.toString() < right.toString();
+    }
+}
+
+
 bool DataProjectSortProxyModel::lessThan( const QModelIndex& left, const QModelIndex& right ) const
 {
     const int leftType = left.data( DataProjectModel::ItemTypeRole ).toInt();
@@ -41,8 +66,8 @@ bool DataProjectSortProxyModel::lessThan( const QModelIndex& left, const QModelI
     else
     */
         //return QSortFilterProxyModel::lessThan( right, left );
-        return left.data( DataProjectModel::SortRole ).toString() <
-                right.data( DataProjectModel::SortRole ).toString();
+        return sortValueLessThan( left.data( DataProjectModel::SortRole ),
+                                  right.data( DataProjectModel::SortRole ) );
         //DisplayRole
         //return QSortFilterProxyModel::lessThan( left, right );
 }
@@ -359,6 +359,10 @@ K3b::DataView::DataView( K3b::DataDoc* doc, QWidget* parent )
     toolBox()->addWidget( label_action );
     toolBox()->addWidget( labelFileFilter );
     toolBox()->addAction( actionCollection()->action( "project_volume_name" ) );
+    toolBox()->addSeparator();
+    toolBox()->addAction( actionCollection()->action( "project_data_import_session" ) );
+    toolBox()->addAction( actionCollection()->action( "project_data_sync_folder" ) );
+    toolBox()->addAction( actionCollection()->action( "project_data_span_discs" ) );
     btnFileFilter->hide();
 
 
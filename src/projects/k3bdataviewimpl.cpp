@@ -22,8 +22,15 @@
 #include "k3bdataprojectmodel.h"
 #include "k3bdataprojectsortproxymodel.h"
 #include "k3bdatapropertiesdialog.h"
+#include "k3bdataspanningjob.h"
+#include "k3bdatasyncjob.h"
 #include "k3bdataurladdingdialog.h"
+#include "k3bburnprogressdialog.h"
 #include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bglobals.h"
+#include "k3bjobprogressdialog.h"
+#include "k3bmimetyperesolver.h"
 #include "k3bview.h"
 #include "k3bviewcolumnadjuster.h"
 #include "k3bvolumenamewidget.h"
@@ -69,6 +76,20 @@ private:
     K3b::DataDoc* m_doc;
 };
 
+// Files with an inconclusive name are only sniffed in the background,
+// opening them cannot wait for that.
+QMimeType openMimeType( K3b::DataItem* item )
+{
+    if( item->isFile() ) {
+        K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
+        if( !fileItem->isMimeTypeResolved() ) {
+            K3b::MimeTypeResolver::instance()->sniffContent( fileItem->localPath() );
+            fileItem->updateMimeType();
+        }
+    }
+    return item->mimeType();
+}
+
 } // namespace
 
 
@@ -186,6 +207,17 @@ K3b::DataViewImpl::DataViewImpl( View* view, DataDoc* doc, KActionCollection* ac
     actionCollection->addAction( "project_data_clear_imported_session", m_actionClearSession );
     connect( m_actionClearSession, SIGNAL(triggered(bool)), this, SLOT(slotClearImportedSession()) );
 
+    m_actionSyncFolder = new QAction( QIcon::fromTheme( "folder-sync" ), i18n("&Synchronize Folder..."), m_view );
+    m_actionSyncFolder->setToolTip( i18n("Add only the files of a folder which changed since the imported session") );
+    m_actionSyncFolder->setEnabled( m_doc->importedSession() > -1 );
+    actionCollection->addAction( "project_data_sync_folder", m_actionSyncFolder );
+    connect( m_actionSyncFolder, SIGNAL(triggered(bool)), this, SLOT(slotSyncFolder()) );
+
+    m_actionSpanDiscs = new QAction( QIcon::fromTheme( "media-optical-data" ), i18n("&Write to Several Discs..."), m_view );
+    m_actionSpanDiscs->setToolTip( i18n("Split a project which does not fit on one medium across several discs") );
+    actionCollection->addAction( "project_data_span_discs", m_actionSpanDiscs );
+    connect( m_actionSpanDiscs, SIGNAL(triggered(bool)), this, SLOT(slotSpanDiscs()) );
+
     m_actionEditBootImages = new QAction( QIcon::fromTheme( "document-properties" ), i18n("&Edit Boot Images..."), m_view );
     m_actionEditBootImages->setToolTip( i18n("Modify the bootable settings of the current project") );
     actionCollection->addAction( "project_data_edit_boot_images", m_actionEditBootImages );
@@ -416,7 +448,7 @@ void K3b::DataViewImpl::slotOpen()
        QUrl url = QUrl::fromLocalFile( item->localPath() );
        //KRun::displayOpenWithDialog( QList<QUrl>() << url, m_view );
        bool a = KRun::runUrl( url,
-                   item->mimeType().name(),
+                   openMimeType( item ).name(),
                    m_view,
                    KRun::RunFlags());
        if (!a) KRun::displayOpenWithDialog( QList<QUrl>() << url, m_view );
@@ -425,9 +457,9 @@ void K3b::DataViewImpl::slotOpen()
     if( !item->isFile() ) {
         QUrl url = QUrl::fromLocalFile( item->localPath() );
         if( !KRun::isExecutableFile( url,
-                                    item->mimeType().name() ) ) {
+                                    openMimeType( item ).name() ) ) {
             bool a = KRun::runUrl( url,
-                        item->mimeType().name(),
+                        openMimeType( item ).name(),
                         m_view,
                         KRun::RunFlags());
             if (!a) KRun::displayOpenWithDialog( QList<QUrl>() << url, m_view );
@@ -545,7 +577,7 @@ void K3b::DataViewImpl::slotItemActivated( const QModelIndex& index )
        QUrl url = QUrl::fromLocalFile( d->localPath() );
        //KRun::displayOpenWithDialog( QList<QUrl>() << url, m_view );
        bool a = KRun::runUrl( url,
-                   d->mimeType().name(),
+                   openMimeType( d ).name(),
                    m_view,
                    KRun::RunFlags());
        if (!a) KRun::displayOpenWithDialog( QList<QUrl>() << url, m_view );
@@ -571,6 +603,49 @@ void K3b::DataViewImpl::slotClearImportedSession()
 }
 
 
+void K3b::DataViewImpl::slotSyncFolder()
+{
+    const QString folder = QFileDialog::getExistingDirectory( m_view, i18n("Synchronize Folder") );
+    if( folder.isEmpty() )
+        return;
+
+    // the local folder corresponds to the folder currently shown
+    const QModelIndex parent = m_sortModel->mapToSource( m_fileView->rootIndex() );
+    DirItem* parentDir = 0;
+    if( parent.isValid() )
+        parentDir = dynamic_cast<DirItem*>( m_model->itemForIndex( parent ) );
+
+    JobProgressDialog dlg( m_view );
+    DataSyncJob job( m_doc, &dlg );
+    job.setLocalFolder( folder );
+    job.setProjectFolder( parentDir ? parentDir->k3bPath() : QString() );
+    job.setCompareContents( true );
+    dlg.startJob( &job );
+}
+
+
+void K3b::DataViewImpl::slotSpanDiscs()
+{
+    QStringList sizes;
+    sizes << i18n("BD (25 GB)")
+          << i18n("BD Dual Layer (50 GB)")
+          << i18n("DVD (4.4 GiB)")
+          << i18n("DVD Double Layer (8.0 GiB)");
+    const int capacities[] = { MediaSizeBluRay25Gb, MediaSizeBluRay50Gb, MediaSizeDvd4Gb, MediaSizeDvd8Gb };
+
+    bool ok = false;
+    const QString size = QInputDialog::getItem( m_view, i18n("Write to Several Discs"), i18n("Size of the discs:"),
+                                                sizes, 0, false, &ok );
+    if( !ok )
+        return;
+
+    BurnProgressDialog dlg( m_view );
+    DataSpanningJob job( m_doc, &dlg );
+    job.setCapacity( capacities[sizes.indexOf( size )] );
+    dlg.startJob( &job );
+}
+
+
 void K3b::DataViewImpl::slotEditBootImages()
 {
     BootImageDialog dlg( m_doc );
@@ -583,6 +658,7 @@ void K3b::DataViewImpl::slotImportedSessionChanged( int importedSession )
 {
     const QModelIndex parent = m_fileView->rootIndex();
     //m_actionClearSession->setEnabled( importedSession > -1 );
+    m_actionSyncFolder->setEnabled( importedSession > -1 );
     emit dataChange(parent, m_sortModel);
 }
 
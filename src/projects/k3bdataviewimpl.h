@@ -85,6 +85,8 @@ namespace K3b {
         void slotEnterPressed();
         void slotImportSession();
         void slotClearImportedSession();
+        void slotSyncFolder();
+        void slotSpanDiscs();
         void slotEditBootImages();
         void slotImportedSessionChanged( int importedSession );
         void slotAddUrlsRequested( QList<QUrl> urls, K3b::DirItem* targetDir );
@@ -110,6 +112,8 @@ namespace K3b {
         QAction* m_actionOpen;
         QAction* m_actionImportSession;
         QAction* m_actionClearSession;
+        QAction* m_actionSyncFolder;
+        QAction* m_actionSpanDiscs;
         QAction* m_actionEditBootImages;
     };
 
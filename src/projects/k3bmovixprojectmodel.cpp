@@ -17,12 +17,15 @@
 #include "k3bmovixprojectmodel.h"
 #include "k3bmovixdoc.h"
 #include "k3bmovixfileitem.h"
+#include "k3bmimetyperesolver.h"
 
 #include <KUrlMimeData>
 #include <KLocalizedString>
 
 #include <QUrl>
 #include <QMimeData>
+#include <QMultiHash>
+#include <QPersistentModelIndex>
 #include <QDataStream>
 #include <QIcon>
 
@@ -37,6 +40,30 @@ class MovixProjectModel::Private
 
         MovixDoc* project;
 
+        // rows showing the name-based type of a file which is still being sniffed
+        QMultiHash<QString, QPersistentModelIndex> pendingMimeTypes;
+
+        QMimeType mimeType( FileItem* item, const QModelIndex& index )
+        {
+            if( !item->isMimeTypeResolved() &&
+                !pendingMimeTypes.contains( item->localPath(), index.sibling( index.row(), 0 ) ) )
+                pendingMimeTypes.insert( item->localPath(), index.sibling( index.row(), 0 ) );
+            return item->mimeType();
+        }
+
+        void _k_mimeTypeResolved( const QString& path )
+        {
+            const QList<QPersistentModelIndex> indexes = pendingMimeTypes.values( path );
+            pendingMimeTypes.remove( path );
+            Q_FOREACH( const QPersistentModelIndex& index, indexes ) {
+                // the item might have been removed in the meantime
+                if( index.isValid() ) {
+                    static_cast<FileItem*>( index.internalPointer() )->updateMimeType();
+                    emit q->dataChanged( index, index.sibling( index.row(), TypeColumn ) );
+                }
+            }
+        }
+
         void _k_itemsAboutToBeInserted( int pos, int count )
         {
             q->beginInsertRows( QModelIndex(), pos, pos + count - 1 );
@@ -106,6 +133,9 @@ MovixProjectModel::MovixProjectModel( MovixDoc* doc, QObject* parent )
              this, SLOT(_k_subTitleAboutToBeRemoved(K3b::MovixFileItem*)), Qt::DirectConnection );
     connect( doc, SIGNAL(subTitleRemoved()),
              this, SLOT(_k_subTitleRemoved()), Qt::DirectConnection );
+
+    connect( K3b::MimeTypeResolver::instance(), SIGNAL(contentTypeResolved(QString)),
+             this, SLOT(_k_mimeTypeResolved(QString)), Qt::QueuedConnection );
 }
 
 
@@ -260,7 +290,7 @@ QVariant MovixProjectModel::data( const QModelIndex& index, int role ) const
                 }
                 else if ( role == Qt::DecorationRole )
                 {
-                    return QIcon::fromTheme( item->mimeType().iconName() );
+                    return QIcon::fromTheme( d->mimeType( item, index ).iconName() );
                 }
                 break;
             case TypeColumn:
@@ -268,9 +298,9 @@ QVariant MovixProjectModel::data( const QModelIndex& index, int role ) const
                     role == Qt::EditRole )
                 {
                     if( item->isSymLink() )
-                        return i18n("Link to %1", item->mimeType().comment());
+                        return i18n("Link to %1", d->mimeType( item, index ).comment());
                     else
-                        return item->mimeType().comment();
+                        return d->mimeType( item, index ).comment();
                 }
                 break;
             case SizeColumn:
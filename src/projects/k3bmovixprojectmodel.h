@@ -76,6 +76,7 @@ namespace K3b {
         Q_PRIVATE_SLOT( d, void _k_subTitleInserted() )
         Q_PRIVATE_SLOT( d, void _k_subTitleAboutToBeRemoved(K3b::MovixFileItem*) )
         Q_PRIVATE_SLOT( d, void _k_subTitleRemoved() )
+        Q_PRIVATE_SLOT( d, void _k_mimeTypeResolved( const QString& path ) )
     };
 }
 
@@ -16,6 +16,7 @@
 
 #include "k3baudioripjob.h"
 
+#include "k3baccuraterip.h"
 #include "k3bcdparanoialib.h"
 #include "k3bcore.h"
 #include "k3bdevice.h"
@@ -26,6 +27,11 @@
 
 #include <KLocalizedString>
 
+#include <QDebug>
+#include <QSet>
+
+#include <string.h>
+
 
 namespace K3b {
 
@@ -36,13 +42,22 @@ public:
     Private()
         : paranoiaRetries(5),
           neverSkip(false),
+          useC2Pointers(true),
+          fastVerified(true),
           paranoiaLib(0),
           device(0),
-          useIndex0(false) {
+          useIndex0(false),
+          readOffset(0),
+          audioStart(0),
+          audioEnd(0),
+          checksum(0),
+          discVerifiable(false) {
     }
     int paranoiaMode;
     int paranoiaRetries;
     int neverSkip;
+    bool useC2Pointers;
+    bool fastVerified;
 
     CdparanoiaLib* paranoiaLib;
 
@@ -50,9 +65,32 @@ public:
     Device::Device* device;
 
     bool useIndex0;
+
+    int readOffset;
+
+    // the readable audio sectors of the disc
+    long audioStart;
+    long audioEnd;
+
+    AccurateRipChecksum* checksum;
+    AccurateRipDatabase database;
+    bool discVerifiable;
+    int confidence( int trackIndex ) const;
+
+    // tracks which may be ripped without paranoia
+    QSet<int> fastTracks;
+    QSet<int> fastRipped;
 };
 
 
+int AudioRipJob::Private::confidence( int trackIndex ) const
+{
+    if( !checksum )
+        return -1;
+    return database.confidence( *checksum, trackIndex );
+}
+
+
 namespace {
 
 class AudioCdReader : public QIODevice
@@ -70,13 +108,37 @@ protected:
 private:
     int m_trackIndex;
     AudioRipJob::Private* d;
+
+    // the next sample to return, corrected by the read offset
+    qint64 m_pos;
+    qint64 m_end;
+
+    // the sectors which are actually read
+    long m_readFirst;
+    long m_readLast;
+
+    long m_sector;
+    const char* m_sectorData;
 };
 
 
+// rounds towards negative infinity
+long sectorOf( qint64 sample )
+{
+    return long( sample >= 0 ? sample / 588 : ( sample - 587 ) / 588 );
+}
+
+
 AudioCdReader::AudioCdReader( int trackIndex, AudioRipJob::Private* priv, QObject* parent )
     : QIODevice( parent ),
       m_trackIndex( trackIndex ),
-      d( priv )
+      d( priv ),
+      m_pos( 0 ),
+      m_end( 0 ),
+      m_readFirst( 0 ),
+      m_readLast( -1 ),
+      m_sector( 0 ),
+      m_sectorData( 0 )
 {
 }
 
@@ -91,7 +153,28 @@ bool AudioCdReader::open( OpenMode mode )
                         ? tt.firstSector().lba() + tt.index0().lba() - 1
                         : tt.lastSector().lba() );
 
-        if( d->paranoiaLib->initReading( tt.firstSector().lba(), endSec ) ) {
+        m_pos = qint64( tt.firstSector().lba() ) * 588;
+        m_end = qint64( endSec + 1 ) * 588;
+
+        // the drive returns the samples shifted by the read offset and it
+        // cannot read outside the audio area, silence is used there instead
+        m_readFirst = qMax( sectorOf( m_pos + d->readOffset ), d->audioStart );
+        m_readLast = qMin( sectorOf( m_end + d->readOffset - 1 ), d->audioEnd );
+        m_sector = m_readFirst - 1;
+        m_sectorData = 0;
+
+        const bool fast = ( d->discVerifiable && d->fastTracks.contains( m_trackIndex ) );
+        if( fast )
+            d->fastRipped.insert( m_trackIndex );
+        else
+            d->fastRipped.remove( m_trackIndex );
+        d->paranoiaLib->setParanoiaMode( fast ? 0 : d->paranoiaMode );
+
+        if( d->checksum )
+            d->checksum->resetTrack( m_trackIndex );
+
+        if( m_readFirst > m_readLast ||
+            d->paranoiaLib->initReading( m_readFirst, m_readLast ) ) {
             return QIODevice::open( mode );
         }
         else {
@@ -123,23 +206,39 @@ qint64 AudioCdReader::writeData( const char* /*data*/, qint64 /*len*/ )
 }
 
 
-qint64 AudioCdReader::readData( char* data, qint64 /*maxlen*/ )
+qint64 AudioCdReader::readData( char* data, qint64 maxlen )
 {
-    int status = 0;
-    char* buf = d->paranoiaLib->read( &status );
-    if( status == CdparanoiaLib::S_OK ) {
-        if( buf == 0 ) {
-            return -1;
+    qint64 read = 0;
+    while( m_pos < m_end && maxlen - read >= 4 ) {
+        const qint64 pos = m_pos + d->readOffset;
+        const long sector = sectorOf( pos );
+        const int first = int( pos - qint64( sector ) * 588 );
+        const int samples = int( qMin( qMin( qint64( 588 - first ), m_end - m_pos ), ( maxlen - read ) / 4 ) );
+
+        if( sector >= m_readFirst && sector <= m_readLast ) {
+            while( m_sector < sector ) {
+                int status = 0;
+                m_sectorData = d->paranoiaLib->read( &status );
+                if( status != CdparanoiaLib::S_OK || !m_sectorData ) {
+                    setErrorString( i18n("Unrecoverable error while ripping track %1.",m_trackIndex) );
+                    return read > 0 ? read : -1;
+                }
+                ++m_sector;
+            }
+            ::memcpy( data + read, m_sectorData + 4*first, 4*samples );
         }
         else {
-            ::memcpy( data, buf, CD_FRAMESIZE_RAW );
-            return CD_FRAMESIZE_RAW;
+            ::memset( data + read, 0, 4*samples );
         }
+
+        if( d->checksum )
+            d->checksum->addSamples( m_pos, data + read, samples );
+
+        m_pos += samples;
+        read += 4*samples;
     }
-    else {
-        setErrorString( i18n("Unrecoverable error while ripping track %1.",m_trackIndex) );
-        return -1;
-    }
+
+    return read > 0 ? read : -1;
 }
 
 } // namespace
@@ -155,6 +254,7 @@ AudioRipJob::AudioRipJob( JobHandler* hdl, QObject* parent )
 AudioRipJob::~AudioRipJob()
 {
     delete d->paranoiaLib;
+    delete d->checksum;
 }
 
 
@@ -176,12 +276,24 @@ void AudioRipJob::setNeverSkip( bool b )
 }
 
 
+void AudioRipJob::setUseC2Pointers( bool b )
+{
+    d->useC2Pointers = b;
+}
+
+
 void AudioRipJob::setUseIndex0( bool b )
 {
     d->useIndex0 = b;
 }
 
 
+void AudioRipJob::setFastVerifiedRipping( bool b )
+{
+    d->fastVerified = b;
+}
+
+
 void AudioRipJob::setDevice( Device::Device* device )
 {
     d->device = device;
@@ -255,6 +367,7 @@ bool AudioRipJob::init()
     d->paranoiaLib->setParanoiaMode( d->paranoiaMode );
     d->paranoiaLib->setNeverSkip( d->neverSkip );
     d->paranoiaLib->setMaxRetries( d->paranoiaRetries );
+    d->paranoiaLib->setUseC2Pointers( d->useC2Pointers );
 
 
     if( d->useIndex0 ) {
@@ -262,6 +375,43 @@ bool AudioRipJob::init()
         d->device->indexScan( d->toc );
     }
 
+    // the audio area as read by CdparanoiaLib::initReading()
+    d->audioStart = d->audioEnd = 0;
+    bool audioFound = false;
+    Q_FOREACH( const Device::Track& track, d->toc ) {
+        if( track.type() == Device::Track::TYPE_AUDIO ) {
+            if( !audioFound )
+                d->audioStart = track.firstSector().lba();
+            d->audioEnd = track.lastSector().lba();
+            audioFound = true;
+        }
+        else if( audioFound ) {
+            break;
+        }
+    }
+
+    d->readOffset = d->device->readOffset();
+    if( d->readOffset != 0 )
+        emit infoMessage( i18n("Correcting the drive read offset of %1 samples.", d->readOffset), Job::MessageInfo );
+
+    delete d->checksum;
+    d->checksum = new AccurateRipChecksum( d->toc );
+    d->database.load();
+    d->discVerifiable = d->database.contains( d->checksum->discId() );
+    qDebug() << "(K3b::AudioRipJob) AccurateRip disc id" << d->checksum->discId() << "known:" << d->discVerifiable;
+    if( d->discVerifiable )
+        emit infoMessage( i18n("Found the disc in the AccurateRip database."), Job::MessageInfo );
+
+    // only tracks which have a file of their own can be ripped again
+    d->fastTracks.clear();
+    d->fastRipped.clear();
+    if( d->fastVerified && d->paranoiaMode > 0 && !d->useIndex0 ) {
+        for( Tracks::const_iterator it = trackList().constBegin(); it != trackList().constEnd(); ++it ) {
+            if( trackList().count( it.key() ) == 1 )
+                d->fastTracks.insert( it.value() );
+        }
+    }
+
     emit infoMessage( i18n("Starting digital audio extraction (ripping)."), Job::MessageInfo );
     return true;
 }
@@ -305,6 +455,33 @@ void AudioRipJob::trackStarted(int trackIndex)
 void AudioRipJob::trackFinished( int trackIndex, const QString& filename )
 {
     emit infoMessage( i18n("Successfully ripped track %1 to %2.", trackIndex, filename), Job::MessageInfo );
+
+    if( !d->checksum || !d->checksum->isComplete( trackIndex ) )
+        return;
+
+    emit infoMessage( i18n("Track %1: AccurateRip checksum %2 (v1) %3 (v2), CRC32 %4.",
+                           trackIndex,
+                           QString::number( d->checksum->checksumV1( trackIndex ), 16 ).rightJustified( 8, '0' ),
+                           QString::number( d->checksum->checksumV2( trackIndex ), 16 ).rightJustified( 8, '0' ),
+                           QString::number( d->checksum->crc32( trackIndex ), 16 ).rightJustified( 8, '0' ) ),
+                      Job::MessageInfo );
+
+    const int confidence = d->confidence( trackIndex );
+    if( confidence > 0 )
+        emit infoMessage( i18n("Track %1 was ripped accurately (confidence %2).", trackIndex, confidence), Job::MessageSuccess );
+    else if( confidence == 0 && !d->fastRipped.contains( trackIndex ) )
+        emit infoMessage( i18n("Track %1 does not match the AccurateRip database.", trackIndex), Job::MessageWarning );
+}
+
+
+bool AudioRipJob::retryTrack( int trackIndex )
+{
+    if( !d->fastRipped.contains( trackIndex ) || d->confidence( trackIndex ) > 0 )
+        return false;
+
+    emit infoMessage( i18n("Track %1 could not be verified. Ripping it again with paranoia.", trackIndex), Job::MessageWarning );
+    d->fastTracks.remove( trackIndex );
+    return true;
 }
 
 
@@ -39,8 +39,16 @@ namespace K3b {
         void setParanoiaMode( int mode );
         void setMaxRetries( int retries );
         void setNeverSkip( bool b );
+        void setUseC2Pointers( bool b );
         void setUseIndex0( bool b );
 
+        /**
+         * Rip tracks without paranoia if the disc is in the AccurateRip
+         * database. A track which does not match is ripped again with the
+         * configured paranoia mode. Default: true
+         */
+        void setFastVerifiedRipping( bool b );
+
         void setDevice( Device::Device* device );
 
         QString jobDescription() const override;
@@ -66,6 +74,8 @@ namespace K3b {
 
         void trackFinished( int trackIndex, const QString& filename ) override;
 
+        bool retryTrack( int trackIndex ) override;
+
     private:
         QScopedPointer<Private> d;
     };
@@ -29,6 +29,8 @@
 #include "k3bpluginmanager.h"
 #include "k3baudioencoder.h"
 #include "k3bmediacache.h"
+#include "k3baccuraterip.h"
+#include "k3bdevice.h"
 
 #include <KComboBox>
 #include <KConfig>
@@ -40,6 +42,7 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QFileDialog>
 #include <QHash>
 #include <QList>
 #include <QPair>
@@ -177,15 +180,25 @@ void K3b::AudioRippingDialog::setupGui()
     m_comboParanoiaMode = K3b::StdGuiItems::paranoiaModeComboBox( advancedPage );
     m_spinRetries = new QSpinBox( advancedPage );
     m_checkIgnoreReadErrors = new QCheckBox( i18n("Ignore read errors"), advancedPage );
+    m_checkUseC2Pointers = new QCheckBox( i18n("Use C2 error pointers"), advancedPage );
     m_checkUseIndex0 = new QCheckBox( i18n("Do not read pregaps"), advancedPage );
+    m_spinReadOffset = new QSpinBox( advancedPage );
+    m_spinReadOffset->setRange( -3000, 3000 );
+    m_checkFastVerified = new QCheckBox( i18n("Rip verifiable tracks without paranoia"), advancedPage );
+    QPushButton* importButton = new QPushButton( i18n("Import AccurateRip Data..."), advancedPage );
 
     advancedPageLayout->addWidget( new QLabel( i18n("Paranoia mode:"), advancedPage ), 0, 0 );
     advancedPageLayout->addWidget( m_comboParanoiaMode, 0, 1 );
     advancedPageLayout->addWidget( new QLabel( i18n("Read retries:"), advancedPage ), 1, 0 );
     advancedPageLayout->addWidget( m_spinRetries, 1, 1 );
     advancedPageLayout->addWidget( m_checkIgnoreReadErrors, 2, 0, 0, 1 );
-    advancedPageLayout->addWidget( m_checkUseIndex0, 3, 0, 0, 1 );
-    advancedPageLayout->setRowStretch( 4, 1 );
+    advancedPageLayout->addWidget( m_checkUseC2Pointers, 3, 0, 0, 1 );
+    advancedPageLayout->addWidget( m_checkUseIndex0, 4, 0, 0, 1 );
+    advancedPageLayout->addWidget( new QLabel( i18n("Read offset:"), advancedPage ), 5, 0 );
+    advancedPageLayout->addWidget( m_spinReadOffset, 5, 1 );
+    advancedPageLayout->addWidget( m_checkFastVerified, 6, 0, 1, 2 );
+    advancedPageLayout->addWidget( importButton, 7, 0 );
+    advancedPageLayout->setRowStretch( 8, 1 );
     advancedPageLayout->setColumnStretch( 2, 1 );
 
     // -------------------------------------------------------------------------------------------
@@ -198,6 +211,7 @@ void K3b::AudioRippingDialog::setupGui()
     setStartButtonText( i18n( "Start Ripping" ), i18n( "Starts copying the selected tracks") );
 
     connect( m_checkUseIndex0, SIGNAL(toggled(bool)), this, SLOT(refresh()) );
+    connect( importButton, SIGNAL(clicked()), this, SLOT(slotImportAccurateRip()) );
     connect( m_optionWidget, SIGNAL(changed()), this, SLOT(refresh()) );
 }
 
@@ -209,6 +223,11 @@ void K3b::AudioRippingDialog::setupContextHelp()
                                       "read a sector of audio data from the cd. After that "
                                       "K3b will either skip the sector if the <em>Ignore Read Errors</em> "
                                       "option is enabled or stop the process.") );
+    m_checkUseC2Pointers->setToolTip( i18n("Let the drive report damaged sectors") );
+    m_checkUseC2Pointers->setWhatsThis( i18n("<p>If this option is checked and the drive reliably reports "
+                                             "C2 errors, K3b reads the audio data at full speed and only runs "
+                                             "paranoia on the sectors the drive flags as damaged.</p>"
+                                             "<p>Uncheck it for drives which do not report all errors.</p>") );
     m_checkUseIndex0->setToolTip( i18n("Do not read the pregaps at the end of every track") );
     m_checkUseIndex0->setWhatsThis( i18n("<p>If this option is checked K3b will not rip the audio "
                                          "data in the pregaps. Most audio tracks contain an empty "
@@ -217,6 +236,17 @@ void K3b::AudioRippingDialog::setupContextHelp()
                                          "software is to include the pregaps for most CDs, it makes more "
                                          "sense to ignore them. In any case, when creating a K3b audio "
                                          "project, the pregaps will be regenerated.</p>") );
+    m_spinReadOffset->setToolTip( i18n("Read offset of the drive in samples") );
+    m_spinReadOffset->setWhatsThis( i18n("<p>Most drives return the audio data slightly shifted. "
+                                         "Enter the read offset of the drive as listed by AccurateRip "
+                                         "to rip the tracks exactly as they were mastered. The offset is "
+                                         "stored for each drive model.</p>") );
+    m_checkFastVerified->setToolTip( i18n("Skip paranoia for tracks which match the AccurateRip database") );
+    m_checkFastVerified->setWhatsThis( i18n("<p>If this option is checked and the disc is found in the "
+                                            "local AccurateRip database, the tracks are first ripped at full "
+                                            "speed without paranoia. Only tracks whose checksums do not match "
+                                            "the database are ripped again with the selected paranoia mode.</p>"
+                                            "<p>AccurateRip data can be imported with the button below.</p>") );
 }
 
 
@@ -290,8 +320,11 @@ void K3b::AudioRippingDialog::slotStartClicked()
     job->setParanoiaMode( m_comboParanoiaMode->currentText().toInt() );
     job->setMaxRetries( m_spinRetries->value() );
     job->setNeverSkip( !m_checkIgnoreReadErrors->isChecked() );
+    job->setUseC2Pointers( m_checkUseC2Pointers->isChecked() );
     job->setEncoder( encoder );
     job->setUseIndex0( m_checkUseIndex0->isChecked() );
+    job->setFastVerifiedRipping( m_checkFastVerified->isChecked() );
+    m_medium.device()->setReadOffset( m_spinReadOffset->value() );
     job->setWriteCueFile( m_optionWidget->createSingleFile() && m_optionWidget->createCueFile() );
     if( m_optionWidget->createPlaylist() )
         job->setWritePlaylist( d->playlistFilename, m_optionWidget->playlistRelativePath() );
@@ -434,6 +467,35 @@ void K3b::AudioRippingDialog::refresh()
 }
 
 
+void K3b::AudioRippingDialog::slotImportAccurateRip()
+{
+    const QStringList files = QFileDialog::getOpenFileNames( this,
+                                                             i18n("Import AccurateRip Data"),
+                                                             QString(),
+                                                             i18n("AccurateRip data (*.bin *.db);;All Files (*)") );
+    if( files.isEmpty() )
+        return;
+
+    K3b::AccurateRipDatabase db;
+    db.load();
+
+    int count = 0;
+    Q_FOREACH( const QString& file, files ) {
+        const int imported = db.importFile( file );
+        if( imported < 0 ) {
+            KMessageBox::error( this, i18n("Could not read '%1'.", file) );
+            return;
+        }
+        count += imported;
+    }
+
+    if( db.save() )
+        KMessageBox::information( this, i18np("Imported 1 checksum.", "Imported %1 checksums.", count) );
+    else
+        KMessageBox::error( this, i18n("Could not write '%1'.", db.filename()) );
+}
+
+
 void K3b::AudioRippingDialog::setStaticDir( const QString& path )
 {
     m_optionWidget->setBaseDir( path );
@@ -445,7 +507,10 @@ void K3b::AudioRippingDialog::loadSettings( const KConfigGroup& c )
     m_comboParanoiaMode->setCurrentIndex( c.readEntry( "paranoia_mode", 0 ) );
     m_spinRetries->setValue( c.readEntry( "read_retries", 5 ) );
     m_checkIgnoreReadErrors->setChecked( !c.readEntry( "never_skip", true ) );
+    m_checkUseC2Pointers->setChecked( c.readEntry( "use_c2_pointers", true ) );
     m_checkUseIndex0->setChecked( c.readEntry( "use_index0", false ) );
+    m_checkFastVerified->setChecked( c.readEntry( "accuraterip_fast", true ) );
+    m_spinReadOffset->setValue( m_medium.device()->readOffset() );
 
     m_optionWidget->loadConfig( c );
     m_patternWidget->loadConfig( c );
@@ -459,7 +524,9 @@ void K3b::AudioRippingDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "paranoia_mode", m_comboParanoiaMode->currentText().toInt() );
     c.writeEntry( "read_retries", m_spinRetries->value() );
     c.writeEntry( "never_skip", !m_checkIgnoreReadErrors->isChecked() );
+    c.writeEntry( "use_c2_pointers", m_checkUseC2Pointers->isChecked() );
     c.writeEntry( "use_index0", m_checkUseIndex0->isChecked() );
+    c.writeEntry( "accuraterip_fast", m_checkFastVerified->isChecked() );
 
     m_optionWidget->saveConfig( c );
     m_patternWidget->saveConfig( c );
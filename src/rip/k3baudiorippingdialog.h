@@ -57,6 +57,7 @@ namespace K3b {
 
     private Q_SLOTS:
         void slotStartClicked() override;
+        void slotImportAccurateRip();
 
     private:
         Medium m_medium;
@@ -66,7 +67,10 @@ namespace K3b {
         QComboBox* m_comboParanoiaMode;
         QSpinBox* m_spinRetries;
         QCheckBox* m_checkIgnoreReadErrors;
+        QCheckBox* m_checkUseC2Pointers;
         QCheckBox* m_checkUseIndex0;
+        QSpinBox* m_spinReadOffset;
+        QCheckBox* m_checkFastVerified;
 
         CddbPatternWidget* m_patternWidget;
         AudioConvertingOptionWidget* m_optionWidget;
@@ -245,8 +245,22 @@ bool MassAudioEncodingJob::run()
     QString lastFilename;
     std::vector<Task>::const_iterator currentTask;
     for( currentTask = tasks.begin(); success && currentTask != tasks.end(); ++currentTask ) {
-        success = encodeTrack( currentTask->track.value(), currentTask->track.key(), lastFilename );
-        lastFilename = currentTask->track.key();
+        const int trackIndex = currentTask->track.value();
+        const QString& filename = currentTask->track.key();
+        success = encodeTrack( trackIndex, filename, lastFilename );
+
+        if( success && !canceled() && d->tracks.count( filename ) == 1 && retryTrack( trackIndex ) ) {
+            if( d->encoder )
+                d->encoder->closeFile();
+            if( d->waveFileWriter )
+                d->waveFileWriter->close();
+            QFile::remove( filename );
+
+            d->overallBytesRead -= trackLength( trackIndex ).audioBytes();
+            success = encodeTrack( trackIndex, filename, QString() );
+        }
+
+        lastFilename = filename;
     }
 
     if( d->encoder )
@@ -278,6 +292,12 @@ bool MassAudioEncodingJob::run()
 }
 
 
+bool MassAudioEncodingJob::retryTrack( int )
+{
+    return false;
+}
+
+
 bool K3b::MassAudioEncodingJob::encodeTrack( int trackIndex, const QString& filename, const QString& prevFilename )
 {
     QScopedPointer<QIODevice> source( createReader( trackIndex ) );
@@ -120,6 +120,13 @@ namespace K3b {
          * Prints information about previously processed track
          */
         virtual void trackFinished( int trackIndex, const QString& filename ) = 0;
+
+        /**
+         * Called after a track which is written to a file of its own has been
+         * encoded. Returning true encodes it once more, for example because its
+         * data could not be verified. The default implementation returns false.
+         */
+        virtual bool retryTrack( int trackIndex );
         
     private:
         bool run() override;
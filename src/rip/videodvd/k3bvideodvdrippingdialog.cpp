@@ -457,6 +457,7 @@ void K3b::VideoDVDRippingDialog::loadSettings( const KConfigGroup& c )
     d->w->m_checkAudioResampling->setChecked( c.readEntry( "audio resampling", false ) );
     d->w->m_checkAutoClipping->setChecked( c.readEntry( "auto clipping", false ) );
     d->w->m_checkLowPriority->setChecked( c.readEntry( "low priority", true ) );
+    d->w->m_checkParallelRipping->setChecked( c.readEntry( "parallel ripping", false ) );
     d->w->m_checkAudioVBR->setChecked( c.readEntry( "vbr audio", true ) );
     d->w->setSelectedAudioBitrate( c.readEntry( "audio bitrate", 128 ) );
     d->w->setSelectedVideoCodec( videoCodecFromId( c.readEntry( "video codec", videoCodecId( K3b::VideoDVDTitleTranscodingJob::VIDEO_CODEC_FFMPEG_MPEG4 ) ) ) );
@@ -475,6 +476,7 @@ void K3b::VideoDVDRippingDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "audio resampling", d->w->m_checkAudioResampling->isChecked() );
     c.writeEntry( "auto clipping", d->w->m_checkAutoClipping->isChecked() );
     c.writeEntry( "low priority", d->w->m_checkLowPriority->isChecked() );
+    c.writeEntry( "parallel ripping", d->w->m_checkParallelRipping->isChecked() );
     c.writeEntry( "vbr audio", d->w->m_checkAudioVBR->isChecked() );
     c.writeEntry( "audio bitrate", d->w->selectedAudioBitrate() );
     c.writeEntry( "video codec", videoCodecId( d->w->selectedVideoCodec() ) );
@@ -558,6 +560,7 @@ void K3b::VideoDVDRippingDialog::slotStartClicked()
     job->setVideoCodec( d->w->selectedVideoCodec() );
     job->setAudioCodec( d->w->selectedAudioCodec() );
     job->setLowPriority( d->w->m_checkLowPriority->isChecked() );
+    job->setParallelRipping( d->w->m_checkParallelRipping->isChecked() );
     job->setAudioBitrate( d->w->selectedAudioBitrate() );
     job->setAudioVBR( d->w->m_checkAudioVBR->isChecked() );
 
@@ -16,8 +16,10 @@
 
 #include "k3bvideodvdtitletranscodingjob.h"
 #include "k3bvideodvdtitledetectclippingjob.h"
+#include "k3bvideodvdtitlecachejob.h"
 
 #include <QDebug>
+#include <QThread>
 #include <KLocalizedString>
 
 
@@ -63,11 +65,24 @@ K3b::VideoDVDRippingJob::TitleRipInfo::TitleRipInfo( int _title,
 class K3b::VideoDVDRippingJob::Private {
 public:
     Private()
-        : autoClipping( true ) {
+        : autoClipping( true ),
+          parallelRipping( false ),
+          cacheJob( 0 ),
+          cacheProgressPart( 0.0 ),
+          cacheProgress( 0 ),
+          runningTitles( 0 ) {
+    }
+
+    int maxRunningTitles() const {
+        // transcoding from the drive in parallel would only make it seek
+        if( inputPath.isEmpty() )
+            return 1;
+        return qMax( 1, QThread::idealThreadCount() );
     }
 
     int currentTitleInfoIndex;
     bool autoClipping;
+    bool parallelRipping;
 
     bool canceled;
 
@@ -77,6 +92,17 @@ public:
 
     QVector<double> titleProgressParts;
     QVector<double> titleClippingProgressParts;
+
+    // parallel ripping
+    VideoDVDTitleCacheJob* cacheJob;
+    QString inputPath;
+    double cacheProgressPart;
+    int cacheProgress;
+    QVector<int> titleProgress;
+    QVector<int> titleClippingProgress;
+    QList<int> pendingTitles;
+    QList<Job*> runningJobs;
+    int runningTitles;
 };
 
 
@@ -127,7 +153,9 @@ void K3b::VideoDVDRippingJob::start()
 
     initProgressInfo();
 
-    if( d->autoClipping )
+    if( d->parallelRipping )
+        startParallelRipping();
+    else if( d->autoClipping )
         startDetectClipping( 0 );
     else
         startTranscoding( 0 );
@@ -141,14 +169,7 @@ void K3b::VideoDVDRippingJob::slotTranscodingJobFinished( bool success )
         jobFinished( false );
     }
     else {
-        if( success )
-            emit infoMessage( i18n("Successfully ripped title %1 to '%2'",
-                                   m_titleRipInfos[d->currentTitleInfoIndex].title,
-                                   m_titleRipInfos[d->currentTitleInfoIndex].filename ), MessageSuccess );
-        else {
-            d->failedTitles++;
-            emit infoMessage( i18n("Failed to rip title %1", m_titleRipInfos[d->currentTitleInfoIndex].title), MessageError );
-        }
+        titleFinished( d->currentTitleInfoIndex, success );
 
         ++d->currentTitleInfoIndex ;
         if( d->currentTitleInfoIndex < m_titleRipInfos.count() ) {
@@ -171,34 +192,53 @@ void K3b::VideoDVDRippingJob::slotDetectClippingJobFinished( bool success )
         jobFinished( false );
     }
     else {
-        m_titleRipInfos[d->currentTitleInfoIndex].clipTop = 0;
-        m_titleRipInfos[d->currentTitleInfoIndex].clipLeft = 0;
-        m_titleRipInfos[d->currentTitleInfoIndex].clipBottom = 0;
-        m_titleRipInfos[d->currentTitleInfoIndex].clipRight = 0;
-
-        if( success ) {
-            emit infoMessage( i18n("Determined clipping values for title %1",m_titleRipInfos[d->currentTitleInfoIndex].title), MessageSuccess );
-            emit infoMessage( i18n("Top: %1, Bottom: %2", m_detectClippingJob->clippingTop(), m_detectClippingJob->clippingBottom()), MessageInfo );
-            emit infoMessage( i18n("Left: %1, Right: %2", m_detectClippingJob->clippingLeft(), m_detectClippingJob->clippingRight()), MessageInfo );
-
-            // let's see if the clipping values make sense
-            if( m_detectClippingJob->clippingTop() + m_detectClippingJob->clippingBottom()
-                >= (int)m_dvd[d->currentTitleInfoIndex].videoStream().pictureHeight() ||
-                m_detectClippingJob->clippingLeft() + m_detectClippingJob->clippingRight()
-                >= (int)m_dvd[d->currentTitleInfoIndex].videoStream().pictureWidth() ) {
-                emit infoMessage( i18n("Insane clipping values. No clipping will be done at all."), MessageWarning );
-            }
-            else {
-                m_titleRipInfos[d->currentTitleInfoIndex].clipTop = m_detectClippingJob->clippingTop();
-                m_titleRipInfos[d->currentTitleInfoIndex].clipLeft = m_detectClippingJob->clippingLeft();
-                m_titleRipInfos[d->currentTitleInfoIndex].clipBottom = m_detectClippingJob->clippingBottom();
-                m_titleRipInfos[d->currentTitleInfoIndex].clipRight = m_detectClippingJob->clippingRight();
-            }
+        applyClipping( d->currentTitleInfoIndex, success ? m_detectClippingJob : 0 );
+        startTranscoding( d->currentTitleInfoIndex );
+    }
+}
+
+
+void K3b::VideoDVDRippingJob::applyClipping( int ripInfoIndex, K3b::VideoDVDTitleDetectClippingJob* job )
+{
+    TitleRipInfo& info = m_titleRipInfos[ripInfoIndex];
+    info.clipTop = 0;
+    info.clipLeft = 0;
+    info.clipBottom = 0;
+    info.clipRight = 0;
+
+    if( job ) {
+        emit infoMessage( i18n("Determined clipping values for title %1",info.title), MessageSuccess );
+        emit infoMessage( i18n("Top: %1, Bottom: %2", job->clippingTop(), job->clippingBottom()), MessageInfo );
+        emit infoMessage( i18n("Left: %1, Right: %2", job->clippingLeft(), job->clippingRight()), MessageInfo );
+
+        // let's see if the clipping values make sense
+        if( job->clippingTop() + job->clippingBottom()
+            >= (int)m_dvd[info.title-1].videoStream().pictureHeight() ||
+            job->clippingLeft() + job->clippingRight()
+            >= (int)m_dvd[info.title-1].videoStream().pictureWidth() ) {
+            emit infoMessage( i18n("Insane clipping values. No clipping will be done at all."), MessageWarning );
         }
-        else
-            emit infoMessage( i18n("Failed to determine clipping values for title %1",m_titleRipInfos[d->currentTitleInfoIndex].title), MessageError );
+        else {
+            info.clipTop = job->clippingTop();
+            info.clipLeft = job->clippingLeft();
+            info.clipBottom = job->clippingBottom();
+            info.clipRight = job->clippingRight();
+        }
+    }
+    else
+        emit infoMessage( i18n("Failed to determine clipping values for title %1",info.title), MessageError );
+}
 
-        startTranscoding( d->currentTitleInfoIndex );
+
+void K3b::VideoDVDRippingJob::titleFinished( int ripInfoIndex, bool success )
+{
+    if( success )
+        emit infoMessage( i18n("Successfully ripped title %1 to '%2'",
+                               m_titleRipInfos[ripInfoIndex].title,
+                               m_titleRipInfos[ripInfoIndex].filename ), MessageSuccess );
+    else {
+        d->failedTitles++;
+        emit infoMessage( i18n("Failed to rip title %1", m_titleRipInfos[ripInfoIndex].title), MessageError );
     }
 }
 
@@ -285,10 +325,209 @@ void K3b::VideoDVDRippingJob::slotDetectClippingProgress( int p )
 }
 
 
+void K3b::VideoDVDRippingJob::startParallelRipping()
+{
+    d->pendingTitles.clear();
+    QList<int> titles;
+    for( int i = 0; i < m_titleRipInfos.count(); ++i ) {
+        d->pendingTitles.append( i );
+        titles.append( m_titleRipInfos[i].title );
+    }
+    d->titleProgress.fill( 0, m_titleRipInfos.count() );
+    d->titleClippingProgress.fill( 0, m_titleRipInfos.count() );
+    d->cacheProgress = 0;
+    d->runningTitles = 0;
+    d->inputPath.clear();
+
+    if( !d->cacheJob ) {
+        d->cacheJob = new K3b::VideoDVDTitleCacheJob( this, this );
+        connectSubJob( d->cacheJob,
+                       SLOT(slotCacheJobFinished(bool)),
+                       SIGNAL(newTask(QString)),
+                       SIGNAL(newSubTask(QString)),
+                       SLOT(slotCacheProgress(int)),
+                       SIGNAL(subPercent(int)),
+                       SIGNAL(processedSize(int,int)),
+                       0 );
+    }
+
+    d->cacheJob->setVideoDVD( m_dvd );
+    d->cacheJob->setTitles( titles );
+    d->cacheJob->start();
+}
+
+
+void K3b::VideoDVDRippingJob::slotCacheJobFinished( bool success )
+{
+    if( d->canceled ) {
+        d->cacheJob->removeCache();
+        emit canceled();
+        jobFinished( false );
+        return;
+    }
+
+    if( success ) {
+        d->inputPath = d->cacheJob->cacheFolder();
+    }
+    else {
+        emit infoMessage( i18n("Titles will be read from the Video DVD one at a time."), MessageWarning );
+    }
+    d->cacheProgress = 100;
+
+    emit newTask( i18np("Transcoding 1 title", "Transcoding %1 titles", m_titleRipInfos.count()) );
+    startNextTitles();
+}
+
+
+void K3b::VideoDVDRippingJob::slotCacheProgress( int p )
+{
+    d->cacheProgress = p;
+    updateParallelProgress();
+}
+
+
+void K3b::VideoDVDRippingJob::startNextTitles()
+{
+    while( !d->canceled &&
+           !d->pendingTitles.isEmpty() &&
+           d->runningTitles < d->maxRunningTitles() ) {
+        const int index = d->pendingTitles.takeFirst();
+        ++d->runningTitles;
+        if( d->autoClipping )
+            startParallelDetectClipping( index );
+        else
+            startParallelTranscoding( index );
+    }
+
+    if( d->runningTitles == 0 ) {
+        d->cacheJob->removeCache();
+        if( d->canceled ) {
+            emit canceled();
+            jobFinished( false );
+        }
+        else {
+            jobFinished( d->failedTitles == 0 );
+        }
+    }
+}
+
+
+void K3b::VideoDVDRippingJob::connectParallelJob( K3b::Job* job, int ripInfoIndex )
+{
+    const int title = m_titleRipInfos[ripInfoIndex].title;
+    connect( job, &Job::infoMessage, this, [this, title]( const QString& msg, int type ) {
+        emit infoMessage( i18nc( "@info title number and message", "Title %1: %2", title, msg ), type );
+    } );
+    connect( job, &Job::debuggingOutput, this, [this, title]( const QString& group, const QString& line ) {
+        emit debuggingOutput( QString::fromLatin1( "%1 (title %2)" ).arg( group ).arg( title ), line );
+    } );
+    d->runningJobs.append( job );
+}
+
+
+void K3b::VideoDVDRippingJob::startParallelDetectClipping( int ripInfoIndex )
+{
+    K3b::VideoDVDTitleDetectClippingJob* job = new K3b::VideoDVDTitleDetectClippingJob( this, this );
+    job->setVideoDVD( m_dvd );
+    job->setTitle( m_titleRipInfos[ripInfoIndex].title );
+    job->setInputPath( d->inputPath );
+    job->setLowPriority( m_transcodingJob->lowPriority() );
+
+    connectParallelJob( job, ripInfoIndex );
+    connect( job, &Job::percent, this, [this, ripInfoIndex]( int p ) {
+        d->titleClippingProgress[ripInfoIndex] = p;
+        updateParallelProgress();
+    } );
+    connect( job, &Job::finished, this, [this, job, ripInfoIndex]( bool success ) {
+        d->runningJobs.removeOne( job );
+        job->deleteLater();
+
+        if( d->canceled ) {
+            --d->runningTitles;
+            startNextTitles();
+        }
+        else {
+            d->titleClippingProgress[ripInfoIndex] = 100;
+            applyClipping( ripInfoIndex, success ? job : 0 );
+            startParallelTranscoding( ripInfoIndex );
+        }
+    } );
+
+    emit newSubTask( i18n("Detecting clipping values for title %1", m_titleRipInfos[ripInfoIndex].title) );
+    job->start();
+}
+
+
+void K3b::VideoDVDRippingJob::startParallelTranscoding( int ripInfoIndex )
+{
+    const TitleRipInfo& info = m_titleRipInfos[ripInfoIndex];
+
+    K3b::VideoDVDTitleTranscodingJob* job = new K3b::VideoDVDTitleTranscodingJob( this, this );
+    job->setVideoDVD( m_dvd );
+    job->setTitle( info.title );
+    job->setAudioStream( info.audioStream );
+    job->setClipping( info.clipTop, info.clipLeft, info.clipBottom, info.clipRight );
+    job->setSize( info.width, info.height );
+    job->setFilename( info.filename );
+    job->setInputPath( d->inputPath );
+    job->setVideoBitrate( info.videoBitrate > 0 ? info.videoBitrate : d->videoBitrate );
+
+    // the codec settings are kept in m_transcodingJob
+    job->setVideoCodec( m_transcodingJob->videoCodec() );
+    job->setTwoPassEncoding( m_transcodingJob->twoPassEncoding() );
+    job->setAudioCodec( m_transcodingJob->audioCodec() );
+    job->setAudioBitrate( m_transcodingJob->audioBitrate() );
+    job->setAudioVBR( m_transcodingJob->audioVBR() );
+    job->setResampleAudioTo44100( m_transcodingJob->resampleAudioTo44100() );
+    job->setLowPriority( m_transcodingJob->lowPriority() );
+
+    connectParallelJob( job, ripInfoIndex );
+    connect( job, &Job::percent, this, [this, ripInfoIndex]( int p ) {
+        d->titleProgress[ripInfoIndex] = p;
+        updateParallelProgress();
+    } );
+    connect( job, &Job::finished, this, [this, job, ripInfoIndex]( bool success ) {
+        d->runningJobs.removeOne( job );
+        job->deleteLater();
+
+        if( !d->canceled ) {
+            d->titleProgress[ripInfoIndex] = 100;
+            titleFinished( ripInfoIndex, success );
+            updateParallelProgress();
+        }
+
+        --d->runningTitles;
+        startNextTitles();
+    } );
+
+    emit newSubTask( i18n("Transcoding title %1", info.title) );
+    job->start();
+}
+
+
+void K3b::VideoDVDRippingJob::updateParallelProgress()
+{
+    double doneParts = (double)d->cacheProgress/100.0*d->cacheProgressPart;
+    for( int i = 0; i < m_titleRipInfos.count(); ++i ) {
+        doneParts += (double)d->titleProgress[i]/100.0*d->titleProgressParts[i];
+        if( d->autoClipping )
+            doneParts += (double)d->titleClippingProgress[i]/100.0*d->titleClippingProgressParts[i];
+    }
+
+    emit percent( (int)( 100.0*doneParts ) );
+}
+
+
 void K3b::VideoDVDRippingJob::cancel()
 {
     d->canceled = true;
-    if( m_transcodingJob->active() )
+    if( d->parallelRipping ) {
+        if( d->cacheJob && d->cacheJob->active() )
+            d->cacheJob->cancel();
+        Q_FOREACH( K3b::Job* job, d->runningJobs )
+            job->cancel();
+    }
+    else if( m_transcodingJob->active() )
         m_transcodingJob->cancel();
     else if( m_detectClippingJob && m_detectClippingJob->active() )
         m_detectClippingJob->cancel();
@@ -349,6 +588,12 @@ void K3b::VideoDVDRippingJob::setAutoClipping( bool b )
 }
 
 
+void K3b::VideoDVDRippingJob::setParallelRipping( bool b )
+{
+    d->parallelRipping = b;
+}
+
+
 void K3b::VideoDVDRippingJob::initProgressInfo()
 {
     d->titleProgressParts.resize( m_titleRipInfos.count() );
@@ -367,6 +612,15 @@ void K3b::VideoDVDRippingJob::initProgressInfo()
             totalFrames += m_dvd[m_titleRipInfos[i].title-1].numChapters() * 200;
     }
 
+    // reading the titles into the cache is a lot faster than a transcoding pass
+    unsigned long long cacheFrames = 0ULL;
+    if( d->parallelRipping ) {
+        for( int i = 0; i < m_titleRipInfos.count(); ++i )
+            cacheFrames += m_dvd[m_titleRipInfos[i].title-1].playbackTime().totalFrames() / 4;
+        totalFrames += cacheFrames;
+    }
+    d->cacheProgressPart = totalFrames ? (double)cacheFrames/(double)totalFrames : 0.0;
+
     for( int i = 0; i < m_titleRipInfos.count(); ++i ) {
         unsigned long long titleFrames = m_dvd[m_titleRipInfos[i].title-1].playbackTime().totalFrames();
         if( m_transcodingJob->twoPassEncoding() )
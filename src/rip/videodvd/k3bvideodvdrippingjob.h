@@ -81,16 +81,36 @@ namespace K3b {
         void setLowPriority( bool b );
         void setAutoClipping( bool b );
 
+        /**
+         * If true the titles are read from the Video DVD once into a temporary
+         * folder and clipping detection and transcoding of several titles run
+         * at the same time, up to the number of processor cores.
+         *
+         * The default is false.
+         */
+        void setParallelRipping( bool b );
+
     private Q_SLOTS:
         void slotTranscodingJobFinished( bool );
         void slotDetectClippingJobFinished( bool );
         void slotTranscodingProgress( int );
         void slotDetectClippingProgress( int );
+        void slotCacheJobFinished( bool );
+        void slotCacheProgress( int );
 
     private:
         void startTranscoding( int ripInfoIndex );
         void startDetectClipping( int ripInfoIndex );
         void initProgressInfo();
+        void applyClipping( int ripInfoIndex, VideoDVDTitleDetectClippingJob* job );
+        void titleFinished( int ripInfoIndex, bool success );
+
+        void startParallelRipping();
+        void startNextTitles();
+        void startParallelTranscoding( int ripInfoIndex );
+        void startParallelDetectClipping( int ripInfoIndex );
+        void connectParallelJob( Job* job, int ripInfoIndex );
+        void updateParallelProgress();
 
         VideoDVD::VideoDVD m_dvd;
         QVector<TitleRipInfo> m_titleRipInfos;
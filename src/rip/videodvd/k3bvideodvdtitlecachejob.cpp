@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "k3bvideodvdtitlecachejob.h"
+
+#include "k3bglobals.h"
+#include "k3biso9660.h"
+#include "k3bdevice.h"
+
+#include <KDiskFreeSpaceInfo>
+#include <KIO/Global>
+#include <KLocalizedString>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+
+#include <algorithm>
+
+
+namespace {
+    bool startSectorLessThan( const K3b::Iso9660File* a, const K3b::Iso9660File* b )
+    {
+        return a->startSector() < b->startSector();
+    }
+}
+
+
+class K3b::VideoDVDTitleCacheJob::Private
+{
+public:
+    VideoDVD::VideoDVD dvd;
+    QList<int> titles;
+    QString tempPath;
+    QString folder;
+};
+
+
+K3b::VideoDVDTitleCacheJob::VideoDVDTitleCacheJob( K3b::JobHandler* hdl, QObject* parent )
+    : K3b::ThreadJob( hdl, parent ),
+      d( new Private() )
+{
+}
+
+
+K3b::VideoDVDTitleCacheJob::~VideoDVDTitleCacheJob()
+{
+    delete d;
+}
+
+
+QString K3b::VideoDVDTitleCacheJob::jobDescription() const
+{
+    return i18n("Reading Video DVD Titles");
+}
+
+
+QString K3b::VideoDVDTitleCacheJob::cacheFolder() const
+{
+    return d->folder;
+}
+
+
+void K3b::VideoDVDTitleCacheJob::removeCache()
+{
+    if( !d->folder.isEmpty() ) {
+        QDir( d->folder ).removeRecursively();
+        d->folder.clear();
+    }
+}
+
+
+void K3b::VideoDVDTitleCacheJob::setVideoDVD( const K3b::VideoDVD::VideoDVD& dvd )
+{
+    d->dvd = dvd;
+}
+
+
+void K3b::VideoDVDTitleCacheJob::setTitles( const QList<int>& titles )
+{
+    d->titles = titles;
+}
+
+
+void K3b::VideoDVDTitleCacheJob::setTempPath( const QString& path )
+{
+    d->tempPath = path;
+}
+
+
+bool K3b::VideoDVDTitleCacheJob::run()
+{
+    emit newTask( i18n("Reading titles from Video DVD") );
+
+    K3b::Iso9660 iso( d->dvd.device() );
+    if( !iso.open() ) {
+        emit infoMessage( i18n("Unable to read the file system of the Video DVD."), MessageError );
+        return false;
+    }
+
+    const K3b::Iso9660Entry* videoTsEntry = iso.firstIsoDirEntry()->entry( "VIDEO_TS" );
+    if( !videoTsEntry || !videoTsEntry->isDirectory() ) {
+        emit infoMessage( i18n("Could not find the VIDEO_TS folder on the Video DVD."), MessageError );
+        return false;
+    }
+    const K3b::Iso9660Directory* videoTs = static_cast<const K3b::Iso9660Directory*>( videoTsEntry );
+
+    //
+    // libdvdread needs the video manager and the title sets of the titles. The menu VOBs
+    // (VTS_XX_0.VOB and VIDEO_TS.VOB) are not needed for ripping.
+    //
+    QStringList names;
+    names << "VIDEO_TS.IFO";
+    QSet<unsigned int> titleSets;
+    Q_FOREACH( int title, d->titles ) {
+        const unsigned int titleSet = d->dvd[title-1].titleSet();
+        if( titleSets.contains( titleSet ) )
+            continue;
+        titleSets.insert( titleSet );
+
+        const QString prefix = QString( "VTS_%1_" ).arg( titleSet, 2, 10, QChar('0') );
+        names << prefix + "0.IFO";
+        for( int i = 1; i <= 9; ++i )
+            names << prefix + QString( "%1.VOB" ).arg( i );
+    }
+
+    QList<const K3b::Iso9660File*> files;
+    KIO::filesize_t totalSize = 0;
+    Q_FOREACH( const QString& name, names ) {
+        const K3b::Iso9660Entry* entry = videoTs->entry( name );
+        if( entry && entry->isFile() ) {
+            const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>( entry );
+            files.append( file );
+            totalSize += file->size();
+        }
+        else if( name.endsWith( QLatin1String( ".IFO" ) ) ) {
+            emit infoMessage( i18n("Could not find file %1 on the Video DVD.", name), MessageError );
+            return false;
+        }
+    }
+
+    // read the medium front to back
+    std::sort( files.begin(), files.end(), startSectorLessThan );
+
+    d->folder = K3b::findTempFile( QString(), d->tempPath );
+    if( !QDir().mkpath( d->folder + "/VIDEO_TS" ) ) {
+        emit infoMessage( i18n("Unable to create folder '%1'", d->folder), MessageError );
+        d->folder.clear();
+        return false;
+    }
+
+    KDiskFreeSpaceInfo free = KDiskFreeSpaceInfo::freeSpaceInfo( d->folder );
+    if( free.isValid() && free.available() < totalSize ) {
+        emit infoMessage( i18n("Not enough space in %1 to store a copy of the titles (%2 needed).",
+                               d->folder, KIO::convertSize( totalSize ) ), MessageError );
+        removeCache();
+        return false;
+    }
+
+    qDebug() << "(K3b::VideoDVDTitleCacheJob) caching" << files.count() << "files with" << totalSize << "bytes in" << d->folder;
+
+    QByteArray buffer( K3b::Iso9660File::ReadBufferSize, Qt::Uninitialized );
+    KIO::filesize_t done = 0;
+    Q_FOREACH( const K3b::Iso9660File* file, files ) {
+        QFile out( d->folder + "/VIDEO_TS/" + file->name() );
+        if( !out.open( QIODevice::WriteOnly ) ) {
+            emit infoMessage( i18n("Unable to open '%1' for writing.", out.fileName()), MessageError );
+            removeCache();
+            return false;
+        }
+
+        emit newSubTask( i18n("Reading %1", file->name()) );
+
+        unsigned int pos = 0;
+        while( pos < file->size() ) {
+            if( canceled() ) {
+                removeCache();
+                return false;
+            }
+
+            const int read = file->read( pos, buffer.data(), buffer.size() );
+            if( read <= 0 ) {
+                emit infoMessage( i18n("Error while reading file %1 from the Video DVD.", file->name()), MessageError );
+                removeCache();
+                return false;
+            }
+
+            if( out.write( buffer.constData(), read ) != read ) {
+                emit infoMessage( i18n("Error while writing to '%1'.", out.fileName()), MessageError );
+                removeCache();
+                return false;
+            }
+
+            pos += read;
+            done += read;
+
+            emit subPercent( 100ULL*pos/file->size() );
+            emit percent( 100ULL*done/totalSize );
+            emit processedSize( done/1024ULL/1024ULL, totalSize/1024ULL/1024ULL );
+        }
+    }
+
+    return true;
+}
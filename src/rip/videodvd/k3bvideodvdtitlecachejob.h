@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020  KylinSoft Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _K3B_VIDEODVD_TITLE_CACHE_JOB_H_
+#define _K3B_VIDEODVD_TITLE_CACHE_JOB_H_
+
+#include "k3bthreadjob.h"
+#include "k3bvideodvd.h"
+
+#include <QList>
+
+
+namespace K3b {
+    /**
+     * Copies the files needed to play a set of Video DVD titles to a
+     * local folder in a single pass over the medium.
+     *
+     * The folder gets a VIDEO_TS folder with VIDEO_TS.IFO and the IFO and
+     * title VOB files of the title sets the titles belong to. Menus are
+     * skipped. The files are read in the order of their position on the
+     * medium, so the drive never seeks back. Encrypted Video DVDs are
+     * decrypted using libdvdcss while reading.
+     *
+     * The resulting folder can be passed to transcode in place of the device,
+     * see VideoDVDTitleTranscodingJob::setInputPath().
+     */
+    class VideoDVDTitleCacheJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        VideoDVDTitleCacheJob( JobHandler* hdl, QObject* parent );
+        ~VideoDVDTitleCacheJob() override;
+
+        QString jobDescription() const override;
+
+        /**
+         * The folder containing the VIDEO_TS folder.
+         * Only valid after the job finished successfully.
+         */
+        QString cacheFolder() const;
+
+        /**
+         * Removes the cache folder and everything in it.
+         */
+        void removeCache();
+
+    public Q_SLOTS:
+        void setVideoDVD( const K3b::VideoDVD::VideoDVD& dvd );
+
+        /**
+         * The numbers of the titles to cache, starting at 1.
+         */
+        void setTitles( const QList<int>& titles );
+
+        /**
+         * The folder in which the cache folder is created.
+         * Defaults to the K3b temporary folder.
+         */
+        void setTempPath( const QString& path );
+
+    private:
+        bool run() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif